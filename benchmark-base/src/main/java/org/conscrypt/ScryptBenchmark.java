@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package org.conscrypt;
+
+import java.nio.charset.StandardCharsets;
+
+/**
+ * Benchmark for scrypt key derivation with the lanes run one after another by BoringSSL versus
+ * spread over native threads with reused scratch memory.
+ */
+public final class ScryptBenchmark {
+    public enum Mode {
+        SERIAL,
+        PARALLEL
+    }
+
+    /**
+     * Provider for the benchmark configuration
+     */
+    interface Config {
+        int costParameter();
+        int blockSize();
+        int parallelizationParameter();
+        Mode mode();
+    }
+
+    private static final int KEY_LENGTH = 32;
+
+    private final byte[] password = "correct horse battery staple".getBytes(StandardCharsets.UTF_8);
+    private final byte[] salt = TestUtils.newTextMessage(16);
+    private final Mode mode;
+    private final int n;
+    private final int r;
+    private final int p;
+
+    ScryptBenchmark(Config config) {
+        mode = config.mode();
+        n = config.costParameter();
+        r = config.blockSize();
+        p = config.parallelizationParameter();
+    }
+
+    byte[] deriveKey() {
+        switch (mode) {
+            case SERIAL:
+                return NativeCrypto.Scrypt_generate_key(password, salt, n, r, p, KEY_LENGTH);
+            case PARALLEL:
+                return NativeCrypto.Scrypt_generate_key(password, salt, n, r, p, KEY_LENGTH, p);
+            default:
+                throw new IllegalStateException("Unexpected mode: " + mode);
+        }
+    }
+}
@@ -0,0 +1,76 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package org.conscrypt;
+
+import java.nio.ByteBuffer;
+import java.security.Key;
+import javax.crypto.Cipher;
+import javax.crypto.spec.GCMParameterSpec;
+import org.openjdk.jmh.annotations.Benchmark;
+import org.openjdk.jmh.annotations.Fork;
+import org.openjdk.jmh.annotations.Level;
+import org.openjdk.jmh.annotations.Param;
+import org.openjdk.jmh.annotations.Scope;
+import org.openjdk.jmh.annotations.Setup;
+import org.openjdk.jmh.annotations.State;
+import org.openjdk.jmh.annotations.Threads;
+
+/**
+ * Benchmark for AES-GCM decryption between direct ByteBuffers. Small messages are dominated
+ * by the fixed per-call cost of the native AEAD path rather than by the cipher itself.
+ */
+@State(Scope.Benchmark)
+@Fork(1)
+@Threads(1)
+public class JmhAeadDirectBufferBenchmark {
+    private static final int TAG_LENGTH_BITS = 128;
+
+    @Param({"16", "64", "256", "1024"})
+    public int a_messageSize;
+
+    @Param
+    public OpenJdkCipherFactory b_provider;
+
+    private Cipher cipher;
+    private ByteBuffer ciphertext;
+    private ByteBuffer plaintext;
+
+    @Setup(Level.Iteration)
+    public void setup() throws Exception {
+        Key key = Transformation.AES_GCM_NO.newEncryptKey();
+        byte[] iv = new byte[12];
+        GCMParameterSpec spec = new GCMParameterSpec(TAG_LENGTH_BITS, iv);
+
+        Cipher encrypt = b_provider.newCipher(Transformation.AES_GCM_NO.toFormattedString());
+        encrypt.init(Cipher.ENCRYPT_MODE, key, spec);
+        byte[] sealed = encrypt.doFinal(TestUtils.newTextMessage(a_messageSize));
+        ciphertext = ByteBuffer.allocateDirect(sealed.length);
+        ciphertext.put(sealed);
+        plaintext = ByteBuffer.allocateDirect(a_messageSize);
+
+        // Decryption may repeat the same key and IV, so the cipher is only initialized once.
+        cipher = b_provider.newCipher(Transformation.AES_GCM_NO.toFormattedString());
+        cipher.init(Cipher.DECRYPT_MODE, key, spec);
+    }
+
+    @Benchmark
+    public int open() throws Exception {
+        ciphertext.flip();
+        plaintext.clear();
+        return cipher.doFinal(ciphertext, plaintext);
+    }
+}
@@ -0,0 +1,84 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package org.conscrypt;
+
+import org.conscrypt.DigestBatchBenchmark.Config;
+import org.openjdk.jmh.annotations.Benchmark;
+import org.openjdk.jmh.annotations.Fork;
+import org.openjdk.jmh.annotations.Level;
+import org.openjdk.jmh.annotations.Param;
+import org.openjdk.jmh.annotations.Scope;
+import org.openjdk.jmh.annotations.Setup;
+import org.openjdk.jmh.annotations.State;
+import org.openjdk.jmh.annotations.Threads;
+import org.openjdk.jmh.infra.Blackhole;
+
+/**
+ * Benchmark comparing per-message and batched hashing of small messages.
+ */
+@State(Scope.Benchmark)
+@Fork(1)
+@Threads(1)
+public class JmhDigestBatchBenchmark {
+    private final JmhConfig config = new JmhConfig();
+
+    @Param({"SHA-1", "SHA-256", "SHA-512"})
+    public String a_algorithm;
+
+    @Param({"64", "1024", "4096"})
+    public int b_messageSize;
+
+    @Param({"16", "1024"})
+    public int c_batchSize;
+
+    @Param
+    public DigestBatchBenchmark.Mode d_mode;
+
+    private DigestBatchBenchmark benchmark;
+
+    @Setup(Level.Iteration)
+    public void setup() throws Exception {
+        benchmark = new DigestBatchBenchmark(config);
+    }
+
+    @Benchmark
+    public void digest(Blackhole bh) throws Exception {
+        bh.consume(benchmark.digest());
+    }
+
+    private final class JmhConfig implements Config {
+        @Override
+        public String algorithm() {
+            return a_algorithm;
+        }
+
+        @Override
+        public int messageSize() {
+            return b_messageSize;
+        }
+
+        @Override
+        public int batchSize() {
+            return c_batchSize;
+        }
+
+        @Override
+        public DigestBatchBenchmark.Mode mode() {
+            return d_mode;
+        }
+    }
+}
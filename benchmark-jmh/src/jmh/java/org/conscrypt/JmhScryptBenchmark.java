@@ -0,0 +1,84 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package org.conscrypt;
+
+import org.conscrypt.ScryptBenchmark.Config;
+import org.openjdk.jmh.annotations.Benchmark;
+import org.openjdk.jmh.annotations.Fork;
+import org.openjdk.jmh.annotations.Level;
+import org.openjdk.jmh.annotations.Param;
+import org.openjdk.jmh.annotations.Scope;
+import org.openjdk.jmh.annotations.Setup;
+import org.openjdk.jmh.annotations.State;
+import org.openjdk.jmh.annotations.Threads;
+import org.openjdk.jmh.infra.Blackhole;
+
+/**
+ * Benchmark comparing serial and parallel scrypt key derivation.
+ */
+@State(Scope.Benchmark)
+@Fork(1)
+@Threads(1)
+public class JmhScryptBenchmark {
+    private final JmhConfig config = new JmhConfig();
+
+    @Param({"16384", "32768"})
+    public int a_n;
+
+    @Param({"8"})
+    public int b_r;
+
+    @Param({"1", "4"})
+    public int c_p;
+
+    @Param
+    public ScryptBenchmark.Mode d_mode;
+
+    private ScryptBenchmark benchmark;
+
+    @Setup(Level.Iteration)
+    public void setup() throws Exception {
+        benchmark = new ScryptBenchmark(config);
+    }
+
+    @Benchmark
+    public void deriveKey(Blackhole bh) throws Exception {
+        bh.consume(benchmark.deriveKey());
+    }
+
+    private final class JmhConfig implements Config {
+        @Override
+        public int costParameter() {
+            return a_n;
+        }
+
+        @Override
+        public int blockSize() {
+            return b_r;
+        }
+
+        @Override
+        public int parallelizationParameter() {
+            return c_p;
+        }
+
+        @Override
+        public ScryptBenchmark.Mode mode() {
+            return d_mode;
+        }
+    }
+}
@@ -0,0 +1,786 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Microbenchmarks for the native code behind NativeCrypto, timed from C++ so that results are
+ * not mixed with JIT and GC noise from a Java harness.
+ *
+ * The engine transport benchmarks drive BoringSSL over conscrypt's transport BIO pair and need
+ * no JVM. The others call the registered JNI natives directly: an embedded JVM supplies the
+ * JNIEnv, and the function pointers are captured from NativeCrypto::registerNativeMethods()
+ * instead of being registered, so no Java code runs while timing. They are skipped unless
+ * --classpath names the Conscrypt classes.
+ *
+ * Allocations are native heap allocations on the benchmark thread, both through BoringSSL
+ * (where it honours the OPENSSL_memory_* hooks, i.e. on ELF platforms) and through operator
+ * new. Java heap allocations made by the natives are not counted.
+ *
+ * Results are printed as a table and, with --json, written in the JMH JSON result format so
+ * that benchmark-graphs can plot them with its NativeBenchmark.json template.
+ */
+
+#include <conscrypt/jniutil.h>
+#include <conscrypt/native_crypto.h>
+#include <conscrypt/transport_bio.h>
+#include <jni.h>
+#include <openssl/bio.h>
+#include <openssl/ec_key.h>
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#include <openssl/mem.h>
+#include <openssl/nid.h>
+#include <openssl/ssl.h>
+#include <openssl/x509.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <new>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// Allocation counts for the thread they happen on, so that JVM threads don't add to them.
+thread_local uint64_t tAllocations;
+thread_local uint64_t tAllocatedBytes;
+
+// Room in front of each BoringSSL allocation for its size, keeping the payload 16-byte aligned.
+constexpr size_t kSizeHeader = 16;
+
+}  // namespace
+
+// BoringSSL calls these for every OPENSSL_malloc(), OPENSSL_free() and OPENSSL_realloc() when
+// they are defined.
+extern "C" void* OPENSSL_memory_alloc(size_t size) {
+    uint8_t* block = static_cast<uint8_t*>(malloc(size + kSizeHeader));
+    if (block == nullptr) {
+        return nullptr;
+    }
+    memcpy(block, &size, sizeof(size));
+    tAllocations++;
+    tAllocatedBytes += size;
+    return block + kSizeHeader;
+}
+
+extern "C" void OPENSSL_memory_free(void* ptr) {
+    if (ptr != nullptr) {
+        free(static_cast<uint8_t*>(ptr) - kSizeHeader);
+    }
+}
+
+extern "C" size_t OPENSSL_memory_get_size(void* ptr) {
+    size_t size;
+    memcpy(&size, static_cast<uint8_t*>(ptr) - kSizeHeader, sizeof(size));
+    return size;
+}
+
+// Kept out of line so that compilers don't flag the free() of memory from operator new.
+__attribute__((noinline)) void* operator new(size_t size) {
+    void* ptr = malloc(size == 0 ? 1 : size);
+    if (ptr == nullptr) {
+        throw std::bad_alloc();
+    }
+    tAllocations++;
+    tAllocatedBytes += size;
+    return ptr;
+}
+
+__attribute__((noinline)) void operator delete(void* ptr) noexcept {
+    free(ptr);
+}
+
+__attribute__((noinline)) void operator delete(void* ptr, size_t) noexcept {
+    free(ptr);
+}
+
+namespace {
+
+using Params = std::vector<std::pair<std::string, std::string>>;
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+    int warmupIterations = 5;
+    int iterations = 10;
+    int iterationMillis = 200;
+    std::string filter;
+    std::string jsonPath;
+    std::string classPath;
+};
+
+struct Result {
+    std::string benchmark;
+    Params params;
+    std::vector<double> nsPerOp;
+    double allocationsPerOp;
+    double bytesPerOp;
+};
+
+bool allocationsCounted = false;
+
+double nanosSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+}
+
+/**
+ * Times op, which returns false if it failed, and appends the result unless the benchmark is
+ * filtered out. Each iteration runs op in batches that take at least a millisecond so that
+ * reading the clock doesn't show up in the result. Returns false if op failed.
+ */
+bool measure(const Options& options, const std::string& name, const Params& params,
+             const std::function<bool()>& op, std::vector<Result>* results) {
+    if (name.find(options.filter) == std::string::npos) {
+        return true;
+    }
+
+    uint64_t batch = 1;
+    while (true) {
+        Clock::time_point start = Clock::now();
+        for (uint64_t i = 0; i < batch; i++) {
+            if (!op()) {
+                return false;
+            }
+        }
+        if (nanosSince(start) >= 1e6 || batch >= UINT64_C(1) << 30) {
+            break;
+        }
+        batch *= 2;
+    }
+
+    Result result;
+    result.benchmark = name;
+    result.params = params;
+    result.nsPerOp.reserve(options.iterations);
+    const double iterationNanos = options.iterationMillis * 1e6;
+    uint64_t totalOps = 0;
+    uint64_t allocationsBefore = 0;
+    uint64_t bytesBefore = 0;
+    for (int iteration = -options.warmupIterations; iteration < options.iterations;
+         iteration++) {
+        if (iteration == 0) {
+            allocationsBefore = tAllocations;
+            bytesBefore = tAllocatedBytes;
+        }
+        uint64_t ops = 0;
+        double elapsed = 0;
+        Clock::time_point start = Clock::now();
+        while (elapsed < iterationNanos) {
+            for (uint64_t i = 0; i < batch; i++) {
+                if (!op()) {
+                    return false;
+                }
+            }
+            ops += batch;
+            elapsed = nanosSince(start);
+        }
+        if (iteration >= 0) {
+            result.nsPerOp.push_back(elapsed / static_cast<double>(ops));
+            totalOps += ops;
+        }
+    }
+    result.allocationsPerOp =
+            static_cast<double>(tAllocations - allocationsBefore) / static_cast<double>(totalOps);
+    result.bytesPerOp =
+            static_cast<double>(tAllocatedBytes - bytesBefore) / static_cast<double>(totalOps);
+    results->push_back(std::move(result));
+    return true;
+}
+
+double mean(const std::vector<double>& values) {
+    double sum = 0;
+    for (double value : values) {
+        sum += value;
+    }
+    return sum / static_cast<double>(values.size());
+}
+
+// Half-width of the 99.9% confidence interval of the mean, as JMH reports for scoreError,
+// using the normal approximation.
+double scoreError(const std::vector<double>& values) {
+    if (values.size() < 2) {
+        return 0;
+    }
+    double m = mean(values);
+    double squares = 0;
+    for (double value : values) {
+        squares += (value - m) * (value - m);
+    }
+    double stddev = std::sqrt(squares / static_cast<double>(values.size() - 1));
+    return 3.291 * stddev / std::sqrt(static_cast<double>(values.size()));
+}
+
+std::string paramsString(const Params& params) {
+    std::string out;
+    for (const auto& param : params) {
+        if (!out.empty()) {
+            out += ',';
+        }
+        out += param.first + '=' + param.second;
+    }
+    return out;
+}
+
+void printTable(const std::vector<Result>& results) {
+    printf("%-36s %-32s %14s %10s %10s %12s\n", "Benchmark", "Params", "ns/op", "error",
+           "allocs/op", "bytes/op");
+    for (const Result& result : results) {
+        printf("%-36s %-32s %14.1f %10.1f", result.benchmark.c_str(),
+               paramsString(result.params).c_str(), mean(result.nsPerOp),
+               scoreError(result.nsPerOp));
+        if (allocationsCounted) {
+            printf(" %10.1f %12.1f\n", result.allocationsPerOp, result.bytesPerOp);
+        } else {
+            printf(" %10s %12s\n", "n/a", "n/a");
+        }
+    }
+}
+
+void writeMetric(FILE* out, const char* name, double score, double error, const char* unit,
+                 const std::vector<double>* rawData) {
+    fprintf(out, "\"%s\" : { \"score\" : %.3f, \"scoreError\" : %.3f, \"scoreUnit\" : \"%s\"",
+            name, score, error, unit);
+    if (rawData != nullptr) {
+        fprintf(out, ", \"rawData\" : [ [ ");
+        for (size_t i = 0; i < rawData->size(); i++) {
+            fprintf(out, "%s%.3f", i == 0 ? "" : ", ", (*rawData)[i]);
+        }
+        fprintf(out, " ] ]");
+    }
+    fprintf(out, " }");
+}
+
+bool writeJson(const Options& options, const std::vector<Result>& results) {
+    FILE* out = fopen(options.jsonPath.c_str(), "w");
+    if (out == nullptr) {
+        fprintf(stderr, "Unable to open %s\n", options.jsonPath.c_str());
+        return false;
+    }
+    fprintf(out, "[\n");
+    for (size_t i = 0; i < results.size(); i++) {
+        const Result& result = results[i];
+        fprintf(out, "  {\n    \"benchmark\" : \"NativeBenchmark.%s\",\n",
+                result.benchmark.c_str());
+        fprintf(out, "    \"mode\" : \"avgt\",\n    \"threads\" : 1,\n    \"forks\" : 0,\n");
+        fprintf(out, "    \"warmupIterations\" : %d,\n    \"measurementIterations\" : %d,\n",
+                options.warmupIterations, options.iterations);
+        fprintf(out, "    \"params\" : {");
+        for (size_t p = 0; p < result.params.size(); p++) {
+            fprintf(out, "%s \"%s\" : \"%s\"", p == 0 ? "" : ",",
+                    result.params[p].first.c_str(), result.params[p].second.c_str());
+        }
+        fprintf(out, " },\n    ");
+        writeMetric(out, "primaryMetric", mean(result.nsPerOp), scoreError(result.nsPerOp),
+                    "ns/op", &result.nsPerOp);
+        fprintf(out, ",\n    \"secondaryMetrics\" : {");
+        if (allocationsCounted) {
+            fprintf(out, "\n      ");
+            writeMetric(out, "allocations", result.allocationsPerOp, 0, "allocs/op", nullptr);
+            fprintf(out, ",\n      ");
+            writeMetric(out, "allocatedBytes", result.bytesPerOp, 0, "B/op", nullptr);
+            fprintf(out, "\n    ");
+        }
+        fprintf(out, "}\n  }%s\n", i + 1 < results.size() ? "," : "");
+    }
+    fprintf(out, "]\n");
+    return fclose(out) == 0;
+}
+
+/**
+ * Two ECDSA P-256 certificates, a leaf issued by a self-signed root, used as the server chain.
+ */
+struct Credentials {
+    bssl::UniquePtr<EVP_PKEY> leafKey;
+    bssl::UniquePtr<X509> leaf;
+    bssl::UniquePtr<X509> root;
+};
+
+bssl::UniquePtr<EVP_PKEY> newP256Key() {
+    bssl::UniquePtr<EC_KEY> ecKey(EC_KEY_new_by_curve_name(NID_X9_62_prime256v1));
+    bssl::UniquePtr<EVP_PKEY> key(EVP_PKEY_new());
+    if (!ecKey || !key || !EC_KEY_generate_key(ecKey.get()) ||
+        !EVP_PKEY_assign_EC_KEY(key.get(), ecKey.release())) {
+        return nullptr;
+    }
+    return key;
+}
+
+bssl::UniquePtr<X509> newCertificate(const char* subject, EVP_PKEY* key, const char* issuer,
+                                     EVP_PKEY* issuerKey, long serial) {  // NOLINT(runtime/int)
+    bssl::UniquePtr<X509> cert(X509_new());
+    bssl::UniquePtr<X509_NAME> subjectName(X509_NAME_new());
+    bssl::UniquePtr<X509_NAME> issuerName(X509_NAME_new());
+    if (!cert || !subjectName || !issuerName || !X509_set_version(cert.get(), X509_VERSION_3) ||
+        !ASN1_INTEGER_set(X509_get_serialNumber(cert.get()), serial) ||
+        !X509_gmtime_adj(X509_getm_notBefore(cert.get()), -3600) ||
+        !X509_gmtime_adj(X509_getm_notAfter(cert.get()), 86400) ||
+        !X509_NAME_add_entry_by_txt(subjectName.get(), "CN", MBSTRING_ASC,
+                                    reinterpret_cast<const uint8_t*>(subject), -1, -1, 0) ||
+        !X509_NAME_add_entry_by_txt(issuerName.get(), "CN", MBSTRING_ASC,
+                                    reinterpret_cast<const uint8_t*>(issuer), -1, -1, 0) ||
+        !X509_set_subject_name(cert.get(), subjectName.get()) ||
+        !X509_set_issuer_name(cert.get(), issuerName.get()) ||
+        !X509_set_pubkey(cert.get(), key) || !X509_sign(cert.get(), issuerKey, EVP_sha256())) {
+        return nullptr;
+    }
+    return cert;
+}
+
+bool newCredentials(Credentials* credentials) {
+    bssl::UniquePtr<EVP_PKEY> rootKey = newP256Key();
+    credentials->leafKey = newP256Key();
+    if (!rootKey || !credentials->leafKey) {
+        return false;
+    }
+    credentials->root = newCertificate("Benchmark Root", rootKey.get(), "Benchmark Root",
+                                       rootKey.get(), 1);
+    credentials->leaf = newCertificate("localhost", credentials->leafKey.get(), "Benchmark Root",
+                                       rootKey.get(), 2);
+    return credentials->root && credentials->leaf;
+}
+
+std::vector<uint8_t> toDer(X509* cert) {
+    uint8_t* der = nullptr;
+    int len = i2d_X509(cert, &der);
+    if (len <= 0) {
+        return std::vector<uint8_t>();
+    }
+    std::vector<uint8_t> out(der, der + len);
+    OPENSSL_free(der);
+    return out;
+}
+
+/**
+ * Client and server contexts pinned to one protocol version. The client doesn't verify the
+ * server, matching a handshake whose verification happens in Java.
+ */
+struct TlsContexts {
+    bssl::UniquePtr<SSL_CTX> client;
+    bssl::UniquePtr<SSL_CTX> server;
+};
+
+bool newTlsContexts(const Credentials& credentials, uint16_t version, TlsContexts* contexts) {
+    contexts->client.reset(SSL_CTX_new(TLS_method()));
+    contexts->server.reset(SSL_CTX_new(TLS_method()));
+    if (!contexts->client || !contexts->server) {
+        return false;
+    }
+    for (SSL_CTX* ctx : {contexts->client.get(), contexts->server.get()}) {
+        if (!SSL_CTX_set_min_proto_version(ctx, version) ||
+            !SSL_CTX_set_max_proto_version(ctx, version)) {
+            return false;
+        }
+        // Same as NativeCrypto_SSL_new, so that TLS 1.3 servers don't send tickets.
+        SSL_CTX_set_options(ctx, SSL_OP_NO_TICKET);
+        SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_OFF);
+    }
+    SSL_CTX_set_verify(contexts->client.get(), SSL_VERIFY_NONE, nullptr);
+    return SSL_CTX_use_certificate(contexts->server.get(), credentials.leaf.get()) &&
+           SSL_CTX_add1_chain_cert(contexts->server.get(), credentials.root.get()) &&
+           SSL_CTX_use_PrivateKey(contexts->server.get(), credentials.leafKey.get());
+}
+
+/**
+ * One engine-style connection: each SSL reads and writes its internal end of a transport pair
+ * and the benchmark moves bytes between the network ends, as ConscryptEngine does through its
+ * ByteBuffers.
+ */
+struct Connection {
+    bssl::UniquePtr<SSL> client;
+    bssl::UniquePtr<SSL> server;
+    bssl::UniquePtr<BIO> clientNetwork;
+    bssl::UniquePtr<BIO> serverNetwork;
+};
+
+bool attachTransport(SSL* ssl, bssl::UniquePtr<BIO>* network) {
+    BIO* internalBio;
+    BIO* networkBio;
+    if (!conscrypt::transportbio::newPair(&internalBio, &networkBio)) {
+        return false;
+    }
+    SSL_set_bio(ssl, internalBio, internalBio);
+    network->reset(networkBio);
+    return true;
+}
+
+bool newConnection(const TlsContexts& contexts, Connection* connection) {
+    connection->client.reset(SSL_new(contexts.client.get()));
+    connection->server.reset(SSL_new(contexts.server.get()));
+    if (!connection->client || !connection->server) {
+        return false;
+    }
+    SSL_set_connect_state(connection->client.get());
+    SSL_set_accept_state(connection->server.get());
+    return attachTransport(connection->client.get(), &connection->clientNetwork) &&
+           attachTransport(connection->server.get(), &connection->serverNetwork);
+}
+
+// Moves whatever from's peer has written across to to, as far as to has room.
+bool transfer(BIO* from, BIO* to) {
+    uint8_t buffer[conscrypt::transportbio::kCapacity];
+    size_t pending;
+    while ((pending = BIO_ctrl_pending(from)) > 0) {
+        size_t len = std::min({pending, BIO_ctrl_get_write_guarantee(to), sizeof(buffer)});
+        if (len == 0) {
+            return true;
+        }
+        int read = BIO_read(from, buffer, static_cast<int>(len));
+        if (read <= 0 || BIO_write(to, buffer, read) != read) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool step(SSL* ssl, bool* done) {
+    int ret = SSL_do_handshake(ssl);
+    *done = ret == 1;
+    return *done || SSL_get_error(ssl, ret) == SSL_ERROR_WANT_READ;
+}
+
+bool handshake(Connection* connection) {
+    for (int round = 0; round < 8; round++) {
+        bool clientDone;
+        bool serverDone;
+        if (!step(connection->client.get(), &clientDone) ||
+            !transfer(connection->clientNetwork.get(), connection->serverNetwork.get()) ||
+            !step(connection->server.get(), &serverDone) ||
+            !transfer(connection->serverNetwork.get(), connection->clientNetwork.get())) {
+            return false;
+        }
+        if (clientDone && serverDone) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Sends len bytes of application data from client to server.
+bool sendMessage(Connection* connection, const uint8_t* message, uint8_t* received, int len) {
+    if (SSL_write(connection->client.get(), message, len) != len ||
+        !transfer(connection->clientNetwork.get(), connection->serverNetwork.get())) {
+        return false;
+    }
+    int total = 0;
+    while (total < len) {
+        int read = SSL_read(connection->server.get(), received + total, len - total);
+        if (read <= 0) {
+            return false;
+        }
+        total += read;
+    }
+    return true;
+}
+
+const char* versionName(uint16_t version) {
+    return version == TLS1_3_VERSION ? "TLSv1.3" : "TLSv1.2";
+}
+
+bool runTransportBenchmarks(const Options& options, const Credentials& credentials,
+                            std::vector<Result>* results) {
+    for (uint16_t version : {TLS1_2_VERSION, TLS1_3_VERSION}) {
+        TlsContexts contexts;
+        if (!newTlsContexts(credentials, version, &contexts)) {
+            return false;
+        }
+        if (!measure(options, "engineHandshake", {{"protocol", versionName(version)}},
+                     [&]() {
+                         Connection connection;
+                         return newConnection(contexts, &connection) && handshake(&connection);
+                     },
+                     results)) {
+            return false;
+        }
+
+        Connection connection;
+        if (!newConnection(contexts, &connection) || !handshake(&connection)) {
+            return false;
+        }
+        for (int size : {64, 512, 4096, 16384}) {
+            std::vector<uint8_t> message(size, 'm');
+            std::vector<uint8_t> received(size);
+            if (!measure(options, "engineWrap",
+                         {{"protocol", versionName(version)},
+                          {"messageSize", std::to_string(size)}},
+                         [&]() {
+                             return sendMessage(&connection, message.data(), received.data(),
+                                                size);
+                         },
+                         results)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Every native registered by NativeCrypto::registerNativeMethods, by name. Overloads keep the
+// first registration.
+std::unordered_map<std::string, void*> gNatives;
+
+jint JNICALL captureNatives(JNIEnv*, jclass, const JNINativeMethod* methods, jint count) {
+    for (jint i = 0; i < count; i++) {
+        gNatives.emplace(methods[i].name, methods[i].fnPtr);
+    }
+    return JNI_OK;
+}
+
+/**
+ * Starts a JVM on classPath to provide a JNIEnv, initializes jniutil from it and captures the
+ * native function pointers. The natives are never registered with the JVM.
+ */
+bool startJvm(const std::string& classPath, JNIEnv** env, jclass* nativeCryptoClass) {
+    std::string classPathOption = "-Djava.class.path=" + classPath;
+    JavaVMOption jvmOptions[1];
+    jvmOptions[0].optionString = const_cast<char*>(classPathOption.c_str());
+    jvmOptions[0].extraInfo = nullptr;
+    JavaVMInitArgs args;
+    args.version = JNI_VERSION_1_6;
+    args.nOptions = 1;
+    args.options = jvmOptions;
+    args.ignoreUnrecognized = JNI_FALSE;
+    JavaVM* vm;
+    if (JNI_CreateJavaVM(&vm, reinterpret_cast<void**>(env), &args) != JNI_OK) {
+        fprintf(stderr, "Unable to start the JVM\n");
+        return false;
+    }
+
+    conscrypt::jniutil::init(vm, *env);
+    JNINativeInterface_ functions = *(*env)->functions;
+    functions.RegisterNatives = captureNatives;
+    JNIEnv capturingEnv;
+    capturingEnv.functions = &functions;
+    conscrypt::NativeCrypto::registerNativeMethods(&capturingEnv);
+
+    *nativeCryptoClass =
+            (*env)->FindClass(TO_STRING(JNI_JARJAR_PREFIX) "org/conscrypt/NativeCrypto");
+    return *nativeCryptoClass != nullptr;
+}
+
+template <typename F>
+F nativeFunction(const char* name) {
+    auto it = gNatives.find(name);
+    if (it == gNatives.end()) {
+        fprintf(stderr, "No native named %s\n", name);
+        abort();
+    }
+    return reinterpret_cast<F>(it->second);
+}
+
+bool succeeded(JNIEnv* env) {
+    if (env->ExceptionCheck()) {
+        env->ExceptionDescribe();
+        env->ExceptionClear();
+        return false;
+    }
+    return true;
+}
+
+jbyteArray newByteArray(JNIEnv* env, const std::vector<uint8_t>& bytes) {
+    jbyteArray array = env->NewByteArray(static_cast<jsize>(bytes.size()));
+    if (array != nullptr) {
+        env->SetByteArrayRegion(array, 0, static_cast<jsize>(bytes.size()),
+                                reinterpret_cast<const jbyte*>(bytes.data()));
+    }
+    return array;
+}
+
+using AeadFn = jlong (*)(JNIEnv*, jclass);
+using AeadOpFn = jint (*)(JNIEnv*, jclass, jlong, jbyteArray, jint, jbyteArray, jint, jbyteArray,
+                          jbyteArray, jint, jint, jbyteArray);
+using PeerCertificatesFn = jobjectArray (*)(JNIEnv*, jclass, jlong, jobject);
+using DecodeX509Fn = jlong (*)(JNIEnv*, jclass, jbyteArray);
+
+bool runAeadBenchmarks(const Options& options, JNIEnv* env, jclass cls,
+                       std::vector<Result>* results) {
+    AeadOpFn seal = nativeFunction<AeadOpFn>("EVP_AEAD_CTX_seal");
+    AeadOpFn open = nativeFunction<AeadOpFn>("EVP_AEAD_CTX_open");
+    const struct {
+        const char* name;
+        const char* native;
+        size_t keyLength;
+    } aeads[] = {
+            {"AES-128-GCM", "EVP_aead_aes_128_gcm", 16},
+            {"ChaCha20-Poly1305", "EVP_aead_chacha20_poly1305", 32},
+    };
+    const int kTagLength = 16;
+    for (const auto& aead : aeads) {
+        jlong evpAead = nativeFunction<AeadFn>(aead.native)(env, cls);
+        jbyteArray key = newByteArray(env, std::vector<uint8_t>(aead.keyLength, 'k'));
+        jbyteArray nonce = newByteArray(env, std::vector<uint8_t>(12, 'n'));
+        for (int size : {16, 1024, 16384}) {
+            jbyteArray plaintext = newByteArray(env, std::vector<uint8_t>(size, 'p'));
+            jbyteArray ciphertext = env->NewByteArray(size + kTagLength);
+            jbyteArray opened = env->NewByteArray(size);
+            if (!succeeded(env)) {
+                return false;
+            }
+            Params params = {{"aead", aead.name}, {"messageSize", std::to_string(size)}};
+            if (!measure(options, "aeadSeal", params,
+                         [&]() {
+                             seal(env, cls, evpAead, key, kTagLength, ciphertext, 0, nonce,
+                                  plaintext, 0, size, nullptr);
+                             return succeeded(env);
+                         },
+                         results) ||
+                !measure(options, "aeadOpen", params,
+                         [&]() {
+                             open(env, cls, evpAead, key, kTagLength, opened, 0, nonce,
+                                  ciphertext, 0, size + kTagLength, nullptr);
+                             return succeeded(env);
+                         },
+                         results)) {
+                return false;
+            }
+            env->DeleteLocalRef(plaintext);
+            env->DeleteLocalRef(ciphertext);
+            env->DeleteLocalRef(opened);
+        }
+        env->DeleteLocalRef(key);
+        env->DeleteLocalRef(nonce);
+    }
+    return true;
+}
+
+bool runCertificateBenchmarks(const Options& options, JNIEnv* env, jclass cls,
+                              const Credentials& credentials, std::vector<Result>* results) {
+    // The peer chain of a live client SSL, converted with CryptoBuffersToObjectArray.
+    TlsContexts contexts;
+    Connection connection;
+    if (!newTlsContexts(credentials, TLS1_3_VERSION, &contexts) ||
+        !newConnection(contexts, &connection) || !handshake(&connection)) {
+        return false;
+    }
+    PeerCertificatesFn peerCertificates =
+            nativeFunction<PeerCertificatesFn>("SSL_get0_peer_certificates");
+    jlong client = static_cast<jlong>(reinterpret_cast<uintptr_t>(connection.client.get()));
+    if (!measure(options, "peerCertificates", {{"chainLength", "2"}},
+                 [&]() {
+                     jobjectArray chain = peerCertificates(env, cls, client, nullptr);
+                     if (chain == nullptr) {
+                         return false;
+                     }
+                     env->DeleteLocalRef(chain);
+                     return succeeded(env);
+                 },
+                 results)) {
+        return false;
+    }
+
+    DecodeX509Fn decodeX509 = nativeFunction<DecodeX509Fn>("d2i_X509");
+    jbyteArray leaf = newByteArray(env, toDer(credentials.leaf.get()));
+    if (!succeeded(env)) {
+        return false;
+    }
+    bool ok = measure(options, "x509Decode", {},
+                      [&]() {
+                          jlong x509 = decodeX509(env, cls, leaf);
+                          X509_free(reinterpret_cast<X509*>(static_cast<uintptr_t>(x509)));
+                          return x509 != 0 && succeeded(env);
+                      },
+                      results);
+    env->DeleteLocalRef(leaf);
+    return ok;
+}
+
+bool parseInt(const char* value, int* out) {
+    char* end;
+    long parsed = strtol(value, &end, 10);  // NOLINT(runtime/int)
+    if (*value == '\0' || *end != '\0' || parsed < 0 || parsed > 1000000) {
+        return false;
+    }
+    *out = static_cast<int>(parsed);
+    return true;
+}
+
+bool parseOptions(int argc, char** argv, Options* options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        size_t eq = arg.find('=');
+        std::string name = arg.substr(0, eq);
+        const char* value = eq == std::string::npos ? "" : argv[i] + eq + 1;
+        bool ok = eq != std::string::npos;
+        if (name == "--filter") {
+            options->filter = value;
+        } else if (name == "--json") {
+            options->jsonPath = value;
+        } else if (name == "--classpath") {
+            options->classPath = value;
+        } else if (name == "--warmup") {
+            ok = ok && parseInt(value, &options->warmupIterations);
+        } else if (name == "--iterations") {
+            ok = ok && parseInt(value, &options->iterations) && options->iterations > 0;
+        } else if (name == "--time") {
+            ok = ok && parseInt(value, &options->iterationMillis) && options->iterationMillis > 0;
+        } else {
+            ok = false;
+        }
+        if (!ok) {
+            fprintf(stderr,
+                    "Usage: %s [--classpath=<conscrypt classes>] [--json=<output file>]\n"
+                    "       [--filter=<benchmark name substring>] [--warmup=<iterations>]\n"
+                    "       [--iterations=<iterations>] [--time=<milliseconds per iteration>]\n",
+                    argv[0]);
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, &options)) {
+        return 2;
+    }
+
+    uint64_t before = tAllocations;
+    OPENSSL_free(OPENSSL_malloc(1));
+    allocationsCounted = tAllocations != before;
+
+    Credentials credentials;
+    std::vector<Result> results;
+    bool ok = newCredentials(&credentials) &&
+              runTransportBenchmarks(options, credentials, &results);
+
+    if (ok && !options.classPath.empty()) {
+        JNIEnv* env;
+        jclass nativeCryptoClass;
+        ok = startJvm(options.classPath, &env, &nativeCryptoClass) &&
+             runAeadBenchmarks(options, env, nativeCryptoClass, &results) &&
+             runCertificateBenchmarks(options, env, nativeCryptoClass, credentials, &results);
+    } else if (ok) {
+        fprintf(stderr, "No --classpath given, skipping the JNI benchmarks\n");
+    }
+    if (!ok) {
+        fprintf(stderr, "Benchmark failed\n");
+        ERR_print_errors_fp(stderr);
+        return 1;
+    }
+
+    printTable(results);
+    if (!options.jsonPath.empty() && !writeJson(options, results)) {
+        return 1;
+    }
+    return 0;
+}
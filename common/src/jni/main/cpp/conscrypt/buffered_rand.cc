@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <conscrypt/buffered_rand.h>
+#include <openssl/crypto.h>
+#include <openssl/rand.h>
+#include <string.h>
+
+#include <atomic>
+
+#if !defined(_WIN32)
+#include <pthread.h>
+#endif
+
+namespace conscrypt {
+namespace bufferedrand {
+
+namespace {
+
+std::atomic<bool> enabled(false);
+
+// Bumped in the child of every fork(), and whenever buffering is switched, so that a block
+// filled before either is never used after it.
+std::atomic<uint64_t> blockGeneration(0);
+
+#if !defined(_WIN32)
+void onForkChild() {
+    blockGeneration.fetch_add(1, std::memory_order_relaxed);
+}
+#endif
+
+// Installs the fork handler, once, before the first block is filled.
+void registerForkHandler() {
+#if !defined(_WIN32)
+    static const bool registered = pthread_atfork(nullptr, nullptr, onForkChild) == 0;
+    (void)registered;
+#endif
+}
+
+/**
+ * One thread's block of randomness. The unused bytes are the last available_ of data_.
+ */
+class Block {
+ public:
+    Block() : available_(0), generation_(0) {}
+    ~Block() {
+        OPENSSL_cleanse(data_, sizeof(data_));
+    }
+
+    bool take(uint8_t* out, size_t len) {
+        if (generation_ != blockGeneration.load(std::memory_order_relaxed)) {
+            discard();
+        }
+        if (available_ < len && !refill()) {
+            return false;
+        }
+        uint8_t* start = data_ + (sizeof(data_) - available_);
+        memcpy(out, start, len);
+        OPENSSL_cleanse(start, len);
+        available_ -= len;
+        return true;
+    }
+
+ private:
+    bool refill() {
+        registerForkHandler();
+        generation_ = blockGeneration.load(std::memory_order_relaxed);
+        if (RAND_bytes(data_, sizeof(data_)) <= 0) {
+            discard();
+            return false;
+        }
+        available_ = sizeof(data_);
+        return true;
+    }
+
+    void discard() {
+        OPENSSL_cleanse(data_, sizeof(data_));
+        available_ = 0;
+    }
+
+    uint8_t data_[kBlockBytes];
+    size_t available_;
+    uint64_t generation_;
+
+    // Disallow copy and assignment.
+    Block(const Block&);
+    void operator=(const Block&);
+};
+
+thread_local Block threadBlock;
+
+// The DRBG's output stays unbuffered in FIPS mode. FIPS_mode() does not change once the
+// library is loaded, so it only needs asking once.
+bool fipsMode() {
+    static const bool fips = FIPS_mode() != 0;
+    return fips;
+}
+
+}  // namespace
+
+void setEnabled(bool enable) {
+    if (enabled.exchange(enable, std::memory_order_relaxed) != enable) {
+        blockGeneration.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+bool bytes(uint8_t* out, size_t len) {
+    if (len <= kMaxBufferedRequest && enabled.load(std::memory_order_relaxed) && !fipsMode()) {
+        return threadBlock.take(out, len);
+    }
+    return RAND_bytes(out, len) > 0;
+}
+
+}  // namespace bufferedrand
+}  // namespace conscrypt
@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <conscrypt/certificate_map.h>
+
+#include <string.h>
+
+namespace conscrypt {
+
+namespace {
+
+/**
+ * Returns name in lower case without a trailing dot.
+ */
+std::string normalize(const char* name, size_t length) {
+    if (length > 0 && name[length - 1] == '.') {
+        length--;
+    }
+    std::string result(name, length);
+    for (char& c : result) {
+        if (c >= 'A' && c <= 'Z') {
+            c = static_cast<char>(c - 'A' + 'a');
+        }
+    }
+    return result;
+}
+
+}  // namespace
+
+bool ServerCredential::install(SSL* ssl) const {
+    std::vector<CRYPTO_BUFFER*> buffers(chain.size());
+    for (size_t i = 0; i < chain.size(); i++) {
+        buffers[i] = chain[i].get();
+    }
+    if (!SSL_set_chain_and_key(ssl, buffers.data(), buffers.size(), privateKey.get(), nullptr)) {
+        return false;
+    }
+    if (!ocspResponse.empty() &&
+        !SSL_set_ocsp_response(ssl, ocspResponse.data(), ocspResponse.size())) {
+        return false;
+    }
+    if (!signedCertTimestampList.empty() &&
+        !SSL_set_signed_cert_timestamp_list(ssl, signedCertTimestampList.data(),
+                                            signedCertTimestampList.size())) {
+        return false;
+    }
+    return true;
+}
+
+bool CertificateMap::replace(const Entries& entries) {
+    std::shared_ptr<Table> table = std::make_shared<Table>();
+    table->exact.reserve(entries.size());
+    for (const auto& entry : entries) {
+        std::string name = normalize(entry.first.data(), entry.first.size());
+        bool isWildcard = name.compare(0, 2, "*.") == 0;
+        if (isWildcard) {
+            name.erase(0, 2);
+        }
+        if (name.empty() || name.find('*') != std::string::npos) {
+            return false;
+        }
+        auto& names = isWildcard ? table->wildcard : table->exact;
+        names[name] = entry.second;
+    }
+    size_t size = table->exact.size() + table->wildcard.size();
+
+    std::shared_ptr<const Table> oldTable;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        oldTable = std::move(table_);
+        table_ = std::move(table);
+        size_.store(size, std::memory_order_relaxed);
+    }
+    // oldTable is released outside the lock, since freeing a large table takes a while.
+    // Handshakes still holding a snapshot of it keep it alive until they are done.
+    return true;
+}
+
+std::shared_ptr<const CertificateMap::Table> CertificateMap::snapshot() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return table_;
+}
+
+std::shared_ptr<const ServerCredential> CertificateMap::lookup(const char* hostName) const {
+    std::shared_ptr<const Table> table = snapshot();
+    if (table == nullptr || hostName == nullptr) {
+        return nullptr;
+    }
+    std::string name = normalize(hostName, strlen(hostName));
+    auto exact = table->exact.find(name);
+    if (exact != table->exact.end()) {
+        return exact->second;
+    }
+    // A wildcard stands for exactly one non-empty leading label.
+    size_t dot = name.find('.');
+    if (dot == 0 || dot == std::string::npos || dot + 1 == name.size() ||
+        table->wildcard.empty()) {
+        return nullptr;
+    }
+    auto wildcard = table->wildcard.find(name.substr(dot + 1));
+    if (wildcard != table->wildcard.end()) {
+        return wildcard->second;
+    }
+    return nullptr;
+}
+
+}  // namespace conscrypt
@@ -0,0 +1,431 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <conscrypt/event_trace.h>
+#include <conscrypt/macros.h>
+
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>  // NOLINT(build/c++11)
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <unordered_map>
+#include <utility>
+
+#if defined(__linux__)
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace conscrypt {
+namespace eventtrace {
+
+std::atomic<uint32_t> g_enabledCategories(0);
+
+namespace {
+
+constexpr size_t kSlotWords = 7;
+constexpr size_t kDataBytesPerSlot = kSlotWords * sizeof(uint64_t);
+// Marks the slots that carry packet data after an event's first slot.
+constexpr uint64_t kContinuation = UINT64_C(1) << 63;
+// Rings of threads that have exited are kept for dumps, up to this many.
+constexpr size_t kMaxRetiredRings = 64;
+constexpr size_t kRecordHeaderBytes = 56;
+
+uint64_t nowNanos() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                         std::chrono::steady_clock::now().time_since_epoch())
+                                         .count());
+}
+
+void put16(std::vector<uint8_t>* out, uint16_t v) {
+    out->push_back(static_cast<uint8_t>(v));
+    out->push_back(static_cast<uint8_t>(v >> 8));
+}
+
+void put32(std::vector<uint8_t>* out, uint32_t v) {
+    put16(out, static_cast<uint16_t>(v));
+    put16(out, static_cast<uint16_t>(v >> 16));
+}
+
+void put64(std::vector<uint8_t>* out, uint64_t v) {
+    put32(out, static_cast<uint32_t>(v));
+    put32(out, static_cast<uint32_t>(v >> 32));
+}
+
+void put16be(std::vector<uint8_t>* out, uint16_t v) {
+    out->push_back(static_cast<uint8_t>(v >> 8));
+    out->push_back(static_cast<uint8_t>(v));
+}
+
+void put32be(std::vector<uint8_t>* out, uint32_t v) {
+    put16be(out, static_cast<uint16_t>(v >> 16));
+    put16be(out, static_cast<uint16_t>(v));
+}
+
+/**
+ * One slot of a ring. seq is 0 while the slot is being written, and otherwise the position of
+ * the slot in the ring's history plus one, with kContinuation set for packet data. Readers
+ * treat it as a sequence lock: a slot is only used if seq reads the same before and after its
+ * words are copied.
+ *
+ * The first slot of an event holds the timestamp, the SSL, the event id, the number of data
+ * bytes and the four args. Data follows in the next slots, kDataBytesPerSlot at a time.
+ */
+struct Slot {
+    std::atomic<uint64_t> seq;
+    std::atomic<uint64_t> words[kSlotWords];
+};
+
+struct Record {
+    uint64_t timestamp;
+    uint64_t ssl;
+    uint32_t threadId;
+    uint16_t event;
+    uint64_t args[4];
+    std::vector<uint8_t> data;
+};
+
+uint32_t currentThreadId(CONSCRYPT_UNUSED uint32_t fallback) {
+#if defined(__linux__)
+    return static_cast<uint32_t>(syscall(SYS_gettid));
+#else
+    return fallback;
+#endif
+}
+
+class Ring {
+ public:
+    explicit Ring(uint32_t threadId)
+        : threadId_(threadId),
+          slots_(new Slot[kSlotsPerThread]),
+          next_(0),
+          published_(0),
+          retired_(false) {
+        for (size_t i = 0; i < kSlotsPerThread; i++) {
+            slots_[i].seq.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    // Called only by the owning thread.
+    void write(uint16_t event, uint64_t ssl, const uint64_t args[4], const uint8_t* data,
+               size_t len) {
+        uint64_t head[kSlotWords] = {nowNanos(), ssl,
+                                     event | (static_cast<uint64_t>(len) << 32),
+                                     args[0], args[1], args[2], args[3]};
+        writeSlot(next_, next_ + 1, head);
+        for (size_t offset = 0; offset < len; offset += kDataBytesPerSlot) {
+            uint64_t words[kSlotWords] = {};
+            memcpy(words, data + offset, std::min(kDataBytesPerSlot, len - offset));
+            writeSlot(next_ + 1, (next_ + 2) | kContinuation, words);
+            next_++;
+        }
+        next_++;
+        published_.store(next_, std::memory_order_release);
+    }
+
+    // Called by any thread; appends the events newer than since.
+    void read(uint64_t since, std::vector<Record>* out) const {
+        uint64_t end = published_.load(std::memory_order_acquire);
+        uint64_t position = end > kSlotsPerThread ? end - kSlotsPerThread : 0;
+        while (position < end) {
+            uint64_t head[kSlotWords];
+            if (!readSlot(position, position + 1, head)) {
+                position++;
+                continue;
+            }
+            size_t len = static_cast<size_t>(head[2] >> 32);
+            size_t dataSlots = (len + kDataBytesPerSlot - 1) / kDataBytesPerSlot;
+            if (position + 1 + dataSlots > end) {
+                break;
+            }
+            Record record;
+            record.timestamp = head[0];
+            record.ssl = head[1];
+            record.threadId = threadId_;
+            record.event = static_cast<uint16_t>(head[2]);
+            memcpy(record.args, &head[3], sizeof(record.args));
+            record.data.resize(dataSlots * kDataBytesPerSlot);
+            bool complete = true;
+            for (size_t i = 0; i < dataSlots && complete; i++) {
+                uint64_t p = position + 1 + i;
+                uint64_t words[kSlotWords];
+                complete = readSlot(p, (p + 1) | kContinuation, words);
+                memcpy(&record.data[i * kDataBytesPerSlot], words, kDataBytesPerSlot);
+            }
+            position += 1 + dataSlots;
+            if (!complete || record.timestamp < since) {
+                continue;
+            }
+            record.data.resize(len);
+            out->push_back(std::move(record));
+        }
+    }
+
+    void retire() {
+        retired_.store(true, std::memory_order_relaxed);
+    }
+
+    bool retired() const {
+        return retired_.load(std::memory_order_relaxed);
+    }
+
+ private:
+    void writeSlot(uint64_t position, uint64_t seq, const uint64_t words[kSlotWords]) {
+        Slot& slot = slots_[position % kSlotsPerThread];
+        slot.seq.store(0, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < kSlotWords; i++) {
+            slot.words[i].store(words[i], std::memory_order_relaxed);
+        }
+        slot.seq.store(seq, std::memory_order_release);
+    }
+
+    bool readSlot(uint64_t position, uint64_t seq, uint64_t words[kSlotWords]) const {
+        const Slot& slot = slots_[position % kSlotsPerThread];
+        if (slot.seq.load(std::memory_order_acquire) != seq) {
+            return false;
+        }
+        for (size_t i = 0; i < kSlotWords; i++) {
+            words[i] = slot.words[i].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return slot.seq.load(std::memory_order_relaxed) == seq;
+    }
+
+    const uint32_t threadId_;
+    std::unique_ptr<Slot[]> slots_;
+    uint64_t next_;
+    std::atomic<uint64_t> published_;
+    std::atomic<bool> retired_;
+
+    // Disallow copy and assignment.
+    Ring(const Ring&);
+    void operator=(const Ring&);
+};
+
+std::mutex g_mutex;
+std::vector<std::shared_ptr<Ring>>* g_rings;
+uint32_t g_nextRingId;
+// Events older than this were dropped by clear().
+std::atomic<uint64_t> g_clearedBefore(0);
+
+std::shared_ptr<Ring> newRing() {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    if (g_rings == nullptr) {
+        g_rings = new std::vector<std::shared_ptr<Ring>>();
+    }
+    size_t retired = 0;
+    for (const auto& ring : *g_rings) {
+        retired += ring->retired() ? 1 : 0;
+    }
+    for (auto it = g_rings->begin(); retired >= kMaxRetiredRings && it != g_rings->end();) {
+        if ((*it)->retired()) {
+            it = g_rings->erase(it);
+            retired--;
+        } else {
+            ++it;
+        }
+    }
+    std::shared_ptr<Ring> ring = std::make_shared<Ring>(currentThreadId(++g_nextRingId));
+    g_rings->push_back(ring);
+    return ring;
+}
+
+// The calling thread's ring, created on its first event and retired when it exits.
+struct ThreadRing {
+    ~ThreadRing() {
+        if (ring != nullptr) {
+            ring->retire();
+        }
+    }
+
+    std::shared_ptr<Ring> ring;
+};
+
+thread_local ThreadRing t_ring;
+
+Ring* threadRing() {
+    if (t_ring.ring == nullptr) {
+        t_ring.ring = newRing();
+    }
+    return t_ring.ring.get();
+}
+
+void collect(std::vector<Record>* records) {
+    std::vector<std::shared_ptr<Ring>> rings;
+    {
+        std::lock_guard<std::mutex> lock(g_mutex);
+        if (g_rings != nullptr) {
+            rings = *g_rings;
+        }
+    }
+    uint64_t since = g_clearedBefore.load(std::memory_order_relaxed);
+    for (const auto& ring : rings) {
+        ring->read(since, records);
+    }
+    std::stable_sort(records->begin(), records->end(),
+                     [](const Record& a, const Record& b) { return a.timestamp < b.timestamp; });
+}
+
+int64_t unixOffsetNanos() {
+    int64_t unixNanos = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                std::chrono::system_clock::now().time_since_epoch())
+                                .count();
+    return unixNanos - static_cast<int64_t>(nowNanos());
+}
+
+uint16_t ipChecksum(const uint8_t* header, size_t len) {
+    uint32_t sum = 0;
+    for (size_t i = 0; i + 1 < len; i += 2) {
+        sum += (static_cast<uint32_t>(header[i]) << 8) | header[i + 1];
+    }
+    while (sum >> 16) {
+        sum = (sum & 0xffff) + (sum >> 16);
+    }
+    return static_cast<uint16_t>(~sum);
+}
+
+}  // namespace
+
+void setEnabledCategories(uint32_t categories) {
+    g_enabledCategories.store(categories & kAllCategories, std::memory_order_relaxed);
+}
+
+void record(Event event, const void* ssl, uint64_t arg0, uint64_t arg1, uint64_t arg2,
+            uint64_t arg3) {
+    const uint64_t args[4] = {arg0, arg1, arg2, arg3};
+    threadRing()->write(event, reinterpret_cast<uintptr_t>(ssl), args, nullptr, 0);
+}
+
+void recordPacket(const void* ssl, char direction, const void* data, size_t len) {
+    const uint64_t args[4] = {len, static_cast<uint64_t>(direction), 0, 0};
+    threadRing()->write(kEventPacket, reinterpret_cast<uintptr_t>(ssl), args,
+                        static_cast<const uint8_t*>(data), std::min(len, kMaxPacketBytes));
+}
+
+void clear() {
+    g_clearedBefore.store(nowNanos(), std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(g_mutex);
+    if (g_rings != nullptr) {
+        g_rings->erase(std::remove_if(g_rings->begin(), g_rings->end(),
+                                      [](const std::shared_ptr<Ring>& ring) {
+                                          return ring->retired();
+                                      }),
+                       g_rings->end());
+    }
+}
+
+void dump(std::vector<uint8_t>* out) {
+    std::vector<Record> records;
+    collect(&records);
+
+    out->insert(out->end(), {'C', 'T', 'R', 'C'});
+    put32(out, 1);
+    put64(out, static_cast<uint64_t>(unixOffsetNanos()));
+    put32(out, static_cast<uint32_t>(records.size()));
+    put32(out, 0);
+    for (const Record& record : records) {
+        size_t start = out->size();
+        put64(out, record.timestamp);
+        put64(out, record.ssl);
+        put32(out, record.threadId);
+        put16(out, record.event);
+        put16(out, static_cast<uint16_t>(record.data.size()));
+        for (uint64_t arg : record.args) {
+            put64(out, arg);
+        }
+        out->insert(out->end(), record.data.begin(), record.data.end());
+        out->resize(start + kRecordHeaderBytes + (record.data.size() + 7) / 8 * 8, 0);
+    }
+}
+
+void dumpPcap(std::vector<uint8_t>* out) {
+    std::vector<Record> records;
+    collect(&records);
+    const int64_t offset = unixOffsetNanos();
+
+    // pcap header with nanosecond timestamps and LINKTYPE_IPV4.
+    put32(out, 0xa1b23c4d);
+    put16(out, 2);
+    put16(out, 4);
+    put32(out, 0);
+    put32(out, 0);
+    put32(out, 65535);
+    put32(out, 228);
+
+    // Each SSL is a stream between 10.0.0.1 on port 443 and 10.0.0.2 on its own port, with
+    // 'O' records flowing from the former. Sequence numbers advance by the full record length
+    // so that truncated records show up as such.
+    struct Stream {
+        uint16_t port;
+        uint32_t seq[2];
+    };
+    std::unordered_map<uint64_t, Stream> streams;
+    for (const Record& record : records) {
+        if (record.event != kEventPacket) {
+            continue;
+        }
+        auto found = streams.find(record.ssl);
+        if (found == streams.end()) {
+            Stream stream = {static_cast<uint16_t>(1024 + streams.size() % 64000), {1, 1}};
+            found = streams.emplace(record.ssl, stream).first;
+        }
+        Stream& stream = found->second;
+        const bool outbound = record.args[1] == 'O';
+        const uint32_t recordLength = static_cast<uint32_t>(
+                std::min<uint64_t>(record.args[0], 65535 - 40));
+
+        uint64_t unixNanos = record.timestamp + static_cast<uint64_t>(offset);
+        put32(out, static_cast<uint32_t>(unixNanos / 1000000000));
+        put32(out, static_cast<uint32_t>(unixNanos % 1000000000));
+        put32(out, static_cast<uint32_t>(40 + record.data.size()));
+        put32(out, 40 + recordLength);
+
+        std::vector<uint8_t> ip;
+        ip.push_back(0x45);
+        ip.push_back(0);
+        put16be(&ip, static_cast<uint16_t>(40 + recordLength));
+        put32be(&ip, 0x00004000);  // Id 0, don't fragment.
+        ip.push_back(64);
+        ip.push_back(6);  // TCP
+        put16be(&ip, 0);
+        put32be(&ip, outbound ? 0x0a000001 : 0x0a000002);
+        put32be(&ip, outbound ? 0x0a000002 : 0x0a000001);
+        uint16_t checksum = ipChecksum(ip.data(), ip.size());
+        ip[10] = static_cast<uint8_t>(checksum >> 8);
+        ip[11] = static_cast<uint8_t>(checksum);
+        out->insert(out->end(), ip.begin(), ip.end());
+
+        uint32_t& seq = stream.seq[outbound ? 0 : 1];
+        put16be(out, outbound ? 443 : stream.port);
+        put16be(out, outbound ? stream.port : 443);
+        put32be(out, seq);
+        put32be(out, stream.seq[outbound ? 1 : 0]);
+        out->push_back(0x50);  // Header length 20.
+        out->push_back(0x18);  // PSH, ACK
+        put16be(out, 65535);
+        put16be(out, 0);  // Checksum, left for tools to ignore.
+        put16be(out, 0);
+        seq += recordLength;
+
+        out->insert(out->end(), record.data.begin(), record.data.end());
+    }
+}
+
+}  // namespace eventtrace
+}  // namespace conscrypt
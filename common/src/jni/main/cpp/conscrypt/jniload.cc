@@ -36,14 +36,22 @@ jint libconscrypt_JNI_OnLoad(JavaVM* vm, void*) {
         return JNI_ERR;
     }
 
+    uint64_t start = conscrypt::jniutil::startupNanos();
+
     // Initialize the JNI constants.
     conscrypt::jniutil::init(vm, env);
 
-    // Register all of the native JNI methods.
+    // Register all of the native JNI methods. The table is registered in one go: the VM
+    // would otherwise look each method up by its exported symbol name, which we don't export.
+    uint64_t registerStart = conscrypt::jniutil::startupNanos();
     NativeCrypto::registerNativeMethods(env);
+    conscrypt::jniutil::recordStartupTiming(conscrypt::jniutil::kStartupRegisterNanos,
+                                            conscrypt::jniutil::startupNanos() - registerStart);
 
     // Perform static initialization of the close monitor (if required on this platform).
     CompatibilityCloseMonitor::init();
+    conscrypt::jniutil::recordStartupTiming(conscrypt::jniutil::kStartupOnLoadNanos,
+                                            conscrypt::jniutil::startupNanos() - start);
     return CONSCRYPT_JNI_VERSION;
 }
 
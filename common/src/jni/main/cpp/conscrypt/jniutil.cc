@@ -18,82 +18,193 @@
 
 #include <conscrypt/compat.h>
 #include <conscrypt/trace.h>
+#include <atomic>
+#include <chrono>
 #include <cstdlib>
+#include <string>
 #include <errno.h>
 
 namespace conscrypt {
 namespace jniutil {
 
 JavaVM *gJavaVM;
-jclass cryptoUpcallsClass;
-jclass openSslInputStreamClass;
+LazyClass cryptoUpcallsClass(TO_STRING(JNI_JARJAR_PREFIX) "org/conscrypt/CryptoUpcalls");
+LazyClass openSslInputStreamClass(
+        TO_STRING(JNI_JARJAR_PREFIX) "org/conscrypt/OpenSSLBIOInputStream");
 jclass nativeRefClass;
-jclass nativeRefHpkeCtxClass;
+LazyClass nativeRefHpkeCtxClass(
+        TO_STRING(JNI_JARJAR_PREFIX) "org/conscrypt/NativeRef$EVP_HPKE_CTX");
 
 jclass byteArrayClass;
-jclass calendarClass;
+LazyClass calendarClass("java/util/Calendar");
 jclass objectClass;
 jclass objectArrayClass;
-jclass integerClass;
-jclass inputStreamClass;
-jclass outputStreamClass;
+LazyClass integerClass("java/lang/Integer");
+LazyClass inputStreamClass("java/io/InputStream");
+LazyClass outputStreamClass("java/io/OutputStream");
 jclass stringClass;
 jclass byteBufferClass;
 static jclass bufferClass;
 static jclass fileDescriptorClass;
-static jclass sslHandshakeCallbacksClass;
+static LazyClass sslHandshakeCallbacksClass(
+        TO_STRING(JNI_JARJAR_PREFIX) "org/conscrypt/NativeCrypto$SSLHandshakeCallbacks");
 
 jfieldID nativeRef_address;
+jfieldID buffer_positionField;
+jfieldID buffer_limitField;
 static jfieldID fileDescriptor_fd;
 
-jmethodID calendar_setMethod;
-jmethodID inputStream_readMethod;
-jmethodID integer_valueOfMethod;
-jmethodID openSslInputStream_readLineMethod;
-jmethodID outputStream_writeMethod;
-jmethodID outputStream_flushMethod;
+LazyMethod calendar_setMethod(&calendarClass, "set", "(IIIIII)V");
+LazyMethod inputStream_readMethod(&inputStreamClass, "read", "([BII)I");
+LazyMethod integer_valueOfMethod(&integerClass, "valueOf", "(I)Ljava/lang/Integer;",
+                                 /* isStatic= */ true);
+LazyMethod openSslInputStream_readLineMethod(&openSslInputStreamClass, "gets", "([BI)I");
+LazyMethod outputStream_writeMethod(&outputStreamClass, "write", "([BII)V");
+LazyMethod outputStream_flushMethod(&outputStreamClass, "flush", "()V");
 jmethodID buffer_positionMethod;
 jmethodID buffer_limitMethod;
-jmethodID buffer_isDirectMethod;
-jmethodID cryptoUpcallsClass_rawSignMethod;
-jmethodID cryptoUpcallsClass_rsaSignMethod;
-jmethodID cryptoUpcallsClass_rsaDecryptMethod;
-jmethodID nativeRefHpkeCtxClass_constructor;
-jmethodID sslHandshakeCallbacks_verifyCertificateChain;
-jmethodID sslHandshakeCallbacks_onSSLStateChange;
-jmethodID sslHandshakeCallbacks_clientCertificateRequested;
-jmethodID sslHandshakeCallbacks_serverCertificateRequested;
-jmethodID sslHandshakeCallbacks_clientPSKKeyRequested;
-jmethodID sslHandshakeCallbacks_serverPSKKeyRequested;
-jmethodID sslHandshakeCallbacks_onNewSessionEstablished;
-jmethodID sslHandshakeCallbacks_selectApplicationProtocol;
-jmethodID sslHandshakeCallbacks_serverSessionRequested;
+LazyMethod cryptoUpcallsClass_rawSignMethod(&cryptoUpcallsClass, "ecSignDigestWithPrivateKey",
+                                            "(Ljava/security/PrivateKey;[B)[B",
+                                            /* isStatic= */ true);
+LazyMethod cryptoUpcallsClass_rsaSignMethod(&cryptoUpcallsClass, "rsaSignDigestWithPrivateKey",
+                                            "(Ljava/security/PrivateKey;I[B)[B",
+                                            /* isStatic= */ true);
+LazyMethod cryptoUpcallsClass_rsaDecryptMethod(&cryptoUpcallsClass, "rsaDecryptWithPrivateKey",
+                                               "(Ljava/security/PrivateKey;I[B)[B",
+                                               /* isStatic= */ true);
+LazyMethod nativeRefHpkeCtxClass_constructor(&nativeRefHpkeCtxClass, "<init>", "(J)V");
+LazyMethod sslHandshakeCallbacks_verifyCertificateChain(
+        &sslHandshakeCallbacksClass, "verifyCertificateChain", "([[BLjava/lang/String;)V");
+LazyMethod sslHandshakeCallbacks_onSSLStateChange(&sslHandshakeCallbacksClass,
+                                                  "onSSLStateChange", "(II)V");
+LazyMethod sslHandshakeCallbacks_clientCertificateRequested(
+        &sslHandshakeCallbacksClass, "clientCertificateRequested", "([B[I[[B)V");
+LazyMethod sslHandshakeCallbacks_serverCertificateRequested(
+        &sslHandshakeCallbacksClass, "serverCertificateRequested", "()V");
+LazyMethod sslHandshakeCallbacks_clientPSKKeyRequested(
+        &sslHandshakeCallbacksClass, "clientPSKKeyRequested", "(Ljava/lang/String;[B[B)I");
+LazyMethod sslHandshakeCallbacks_serverPSKKeyRequested(
+        &sslHandshakeCallbacksClass, "serverPSKKeyRequested",
+        "(Ljava/lang/String;Ljava/lang/String;[B)I");
+LazyMethod sslHandshakeCallbacks_onNewSessionEstablished(
+        &sslHandshakeCallbacksClass, "onNewSessionEstablished", "(J)V");
+LazyMethod sslHandshakeCallbacks_selectApplicationProtocol(
+        &sslHandshakeCallbacksClass, "selectApplicationProtocol", "([B)I");
+LazyMethod sslHandshakeCallbacks_serverSessionRequested(
+        &sslHandshakeCallbacksClass, "serverSessionRequested", "([B)J");
+
+static std::atomic<uint64_t> gLoadStartNanos(0);
+static std::atomic<uint64_t> gStartupTimings[kStartupTimingCount] = {};
+
+uint64_t startupNanos() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                         std::chrono::steady_clock::now().time_since_epoch())
+                                         .count());
+}
+
+void recordStartupTiming(StartupTiming timing, uint64_t value) {
+    gStartupTimings[timing].fetch_add(value, std::memory_order_relaxed);
+}
+
+void getStartupTimings(uint64_t out[kStartupTimingCount]) {
+    for (size_t i = 0; i < kStartupTimingCount; i++) {
+        out[i] = gStartupTimings[i].load(std::memory_order_relaxed);
+    }
+    out[kStartupNanosSinceLoad] =
+            startupNanos() - gLoadStartNanos.load(std::memory_order_relaxed);
+}
+
+/**
+ * Loads the class through the class loader that loaded Conscrypt. FindClass on a thread
+ * attached from native code only searches the system class loader, which does not see
+ * Conscrypt when an application class loader loaded it. Returns nullptr, with no exception
+ * pending, if that also fails.
+ */
+static jclass loadClassWithConscryptLoader(JNIEnv* env, const char* name) {
+    ScopedLocalRef<jclass> classClass(env, env->GetObjectClass(nativeRefClass));
+    jmethodID getClassLoader =
+            env->GetMethodID(classClass.get(), "getClassLoader", "()Ljava/lang/ClassLoader;");
+    ScopedLocalRef<jobject> loader(env, env->CallObjectMethod(nativeRefClass, getClassLoader));
+    if (env->ExceptionCheck() || loader.get() == nullptr) {
+        env->ExceptionClear();
+        return nullptr;
+    }
+    std::string binaryName(name);
+    for (char& c : binaryName) {
+        if (c == '/') {
+            c = '.';
+        }
+    }
+    ScopedLocalRef<jclass> loaderClass(env, env->GetObjectClass(loader.get()));
+    jmethodID loadClass = env->GetMethodID(loaderClass.get(), "loadClass",
+                                           "(Ljava/lang/String;)Ljava/lang/Class;");
+    ScopedLocalRef<jstring> nameString(env, env->NewStringUTF(binaryName.c_str()));
+    if (loadClass == nullptr || nameString.get() == nullptr) {
+        env->ExceptionClear();
+        return nullptr;
+    }
+    jobject result = env->CallObjectMethod(loader.get(), loadClass, nameString.get());
+    if (env->ExceptionCheck()) {
+        env->ExceptionClear();
+        return nullptr;
+    }
+    return reinterpret_cast<jclass>(result);
+}
+
+jclass LazyClass::resolve(JNIEnv* env) {
+    uint64_t start = startupNanos();
+    ScopedLocalRef<jclass> localClass(env, env->FindClass(name_));
+    if (localClass.get() == nullptr) {
+        env->ExceptionClear();
+        localClass.reset(loadClassWithConscryptLoader(env, name_));
+    }
+    jclass globalRef = reinterpret_cast<jclass>(env->NewGlobalRef(localClass.get()));
+    if (globalRef == nullptr) {
+        CONSCRYPT_LOG_ERROR("failed to find class %s", name_);
+        abort();
+    }
+    jclass expected = nullptr;
+    if (!class_.compare_exchange_strong(expected, globalRef, std::memory_order_acq_rel)) {
+        // Another thread got there first.
+        env->DeleteGlobalRef(globalRef);
+        globalRef = expected;
+    }
+    recordStartupTiming(kStartupLazyResolutions, 1);
+    recordStartupTiming(kStartupLazyResolutionNanos, startupNanos() - start);
+    return globalRef;
+}
+
+jmethodID LazyMethod::resolve(JNIEnv* env) {
+    jclass clazz = class_->get(env);
+    uint64_t start = startupNanos();
+    jmethodID method = isStatic_ ? env->GetStaticMethodID(clazz, name_, signature_)
+                                 : env->GetMethodID(clazz, name_, signature_);
+    if (method == nullptr) {
+        CONSCRYPT_LOG_ERROR("could not find method %s", name_);
+        abort();
+    }
+    // Method IDs are stable, so a racing thread can only store the same value.
+    method_.store(method, std::memory_order_release);
+    recordStartupTiming(kStartupLazyResolutions, 1);
+    recordStartupTiming(kStartupLazyResolutionNanos, startupNanos() - start);
+    return method;
+}
 
 void init(JavaVM* vm, JNIEnv* env) {
+    uint64_t start = startupNanos();
+    gLoadStartNanos.store(start, std::memory_order_relaxed);
     gJavaVM = vm;
 
     byteArrayClass = findClass(env, "[B");
-    calendarClass = findClass(env, "java/util/Calendar");
-    inputStreamClass = findClass(env, "java/io/InputStream");
-    integerClass = findClass(env, "java/lang/Integer");
     objectClass = findClass(env, "java/lang/Object");
     objectArrayClass = findClass(env, "[Ljava/lang/Object;");
-    outputStreamClass = findClass(env, "java/io/OutputStream");
     stringClass = findClass(env, "java/lang/String");
     byteBufferClass = findClass(env, "java/nio/ByteBuffer");
     bufferClass = findClass(env, "java/nio/Buffer");
     fileDescriptorClass = findClass(env, "java/io/FileDescriptor");
 
-    cryptoUpcallsClass = getGlobalRefToClass(
-            env, TO_STRING(JNI_JARJAR_PREFIX) "org/conscrypt/CryptoUpcalls");
     nativeRefClass = getGlobalRefToClass(
             env, TO_STRING(JNI_JARJAR_PREFIX) "org/conscrypt/NativeRef");
-    nativeRefHpkeCtxClass = getGlobalRefToClass(
-            env, TO_STRING(JNI_JARJAR_PREFIX) "org/conscrypt/NativeRef$EVP_HPKE_CTX");
-    openSslInputStreamClass = getGlobalRefToClass(
-            env, TO_STRING(JNI_JARJAR_PREFIX) "org/conscrypt/OpenSSLBIOInputStream");
-    sslHandshakeCallbacksClass = getGlobalRefToClass(
-            env, TO_STRING(JNI_JARJAR_PREFIX) "org/conscrypt/NativeCrypto$SSLHandshakeCallbacks");
 
     nativeRef_address = getFieldRef(env, nativeRefClass, "address", "J");
 #if defined(ANDROID) && !defined(CONSCRYPT_OPENJDK)
@@ -102,52 +213,15 @@ void init(JavaVM* vm, JNIEnv* env) {
     fileDescriptor_fd = getFieldRef(env, fileDescriptorClass, "fd", "I");
 #endif
 
-    calendar_setMethod = getMethodRef(env, calendarClass, "set", "(IIIIII)V");
-    inputStream_readMethod = getMethodRef(env, inputStreamClass, "read", "([B)I");
-    integer_valueOfMethod =
-            env->GetStaticMethodID(integerClass, "valueOf", "(I)Ljava/lang/Integer;");
-    openSslInputStream_readLineMethod =
-            getMethodRef(env, openSslInputStreamClass, "gets", "([B)I");
-    outputStream_writeMethod = getMethodRef(env, outputStreamClass, "write", "([B)V");
-    outputStream_flushMethod = getMethodRef(env, outputStreamClass, "flush", "()V");
     buffer_positionMethod = getMethodRef(env, bufferClass, "position", "()I");
     buffer_limitMethod = getMethodRef(env, bufferClass, "limit", "()I");
-    buffer_isDirectMethod = getMethodRef(env, bufferClass, "isDirect", "()Z");
-    sslHandshakeCallbacks_verifyCertificateChain =
-	    getMethodRef(env, sslHandshakeCallbacksClass, "verifyCertificateChain", "([[BLjava/lang/String;)V");
-    sslHandshakeCallbacks_onSSLStateChange =
-            getMethodRef(env, sslHandshakeCallbacksClass, "onSSLStateChange", "(II)V");
-    sslHandshakeCallbacks_clientCertificateRequested = getMethodRef(
-            env, sslHandshakeCallbacksClass, "clientCertificateRequested", "([B[I[[B)V");
-    sslHandshakeCallbacks_serverCertificateRequested =
-            getMethodRef(env, sslHandshakeCallbacksClass, "serverCertificateRequested", "()V");
-    sslHandshakeCallbacks_clientPSKKeyRequested = getMethodRef(
-            env, sslHandshakeCallbacksClass, "clientPSKKeyRequested", "(Ljava/lang/String;[B[B)I");
-    sslHandshakeCallbacks_serverPSKKeyRequested =
-            getMethodRef(env, sslHandshakeCallbacksClass, "serverPSKKeyRequested",
-                         "(Ljava/lang/String;Ljava/lang/String;[B)I");
-    sslHandshakeCallbacks_onNewSessionEstablished =
-            getMethodRef(env, sslHandshakeCallbacksClass, "onNewSessionEstablished", "(J)V");
-    sslHandshakeCallbacks_serverSessionRequested =
-            getMethodRef(env, sslHandshakeCallbacksClass, "serverSessionRequested", "([B)J");
-    sslHandshakeCallbacks_selectApplicationProtocol =
-            getMethodRef(env, sslHandshakeCallbacksClass, "selectApplicationProtocol", "([B)I");
-    cryptoUpcallsClass_rawSignMethod = env->GetStaticMethodID(
-            cryptoUpcallsClass, "ecSignDigestWithPrivateKey", "(Ljava/security/PrivateKey;[B)[B");
-    if (cryptoUpcallsClass_rawSignMethod == nullptr) {
-        env->FatalError("Could not find ecSignDigestWithPrivateKey");
-    }
-    cryptoUpcallsClass_rsaSignMethod = env->GetStaticMethodID(
-            cryptoUpcallsClass, "rsaSignDigestWithPrivateKey", "(Ljava/security/PrivateKey;I[B)[B");
-    if (cryptoUpcallsClass_rsaSignMethod == nullptr) {
-        env->FatalError("Could not find rsaSignDigestWithPrivateKey");
-    }
-    cryptoUpcallsClass_rsaDecryptMethod = env->GetStaticMethodID(
-            cryptoUpcallsClass, "rsaDecryptWithPrivateKey", "(Ljava/security/PrivateKey;I[B)[B");
-    if (cryptoUpcallsClass_rsaDecryptMethod == nullptr) {
-        env->FatalError("Could not find rsaDecryptWithPrivateKey");
-    }
-    nativeRefHpkeCtxClass_constructor = env->GetMethodID(nativeRefHpkeCtxClass, "<init>", "(J)V");
+#if !defined(ANDROID) || defined(CONSCRYPT_OPENJDK)
+    // Reading these directly saves a call into Java for every direct buffer operation. ART
+    // restricts access to non-SDK fields, so there only the accessor methods are used.
+    buffer_positionField = getOptionalFieldRef(env, bufferClass, "position", "I");
+    buffer_limitField = getOptionalFieldRef(env, bufferClass, "limit", "I");
+#endif
+    recordStartupTiming(kStartupInitNanos, startupNanos() - start);
 }
 
 void jniRegisterNativeMethods(JNIEnv* env, const char* className, const JNINativeMethod* gMethods,
@@ -186,7 +260,22 @@ extern bool isDirectByteBufferInstance(JNIEnv* env, jobject buffer) {
     if (!env->IsInstanceOf(buffer, conscrypt::jniutil::byteBufferClass)) {
         return false;
     }
-    return env->CallBooleanMethod(buffer, conscrypt::jniutil::buffer_isDirectMethod) == JNI_TRUE;
+    // Heap buffers have no direct address, so this answers isDirect() without calling into Java.
+    return env->GetDirectBufferAddress(buffer) != nullptr;
+}
+
+uint8_t* getDirectBufferRemaining(JNIEnv* env, jobject buffer, size_t* length) {
+    uint8_t* address = reinterpret_cast<uint8_t*>(env->GetDirectBufferAddress(buffer));
+    if (address == nullptr) {
+        return nullptr;
+    }
+    jint position = getBufferPosition(env, buffer);
+    jint limit = getBufferLimit(env, buffer);
+    if (position < 0 || limit < position) {
+        return nullptr;
+    }
+    *length = static_cast<size_t>(limit - position);
+    return address + position;
 }
 
 bool isGetByteArrayElementsLikelyToReturnACopy(size_t size) {
@@ -200,6 +289,17 @@ bool isGetByteArrayElementsLikelyToReturnACopy(size_t size) {
 #endif
 }
 
+static std::atomic<size_t> gCriticalArrayThreshold(0);
+
+void setCriticalArrayThreshold(size_t threshold) {
+    gCriticalArrayThreshold.store(threshold, std::memory_order_relaxed);
+}
+
+bool useCriticalArrayAccess(size_t length) {
+    size_t threshold = gCriticalArrayThreshold.load(std::memory_order_relaxed);
+    return threshold != 0 && length >= threshold;
+}
+
 int throwException(JNIEnv* env, const char* className, const char* msg) {
     jclass exceptionClass = env->FindClass(className);
 
@@ -0,0 +1,475 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <conscrypt/ktls.h>
+#include <conscrypt/trace.h>
+
+#include <errno.h>
+#include <string.h>
+
+#include <openssl/crypto.h>
+#include <openssl/hkdf.h>
+#include <openssl/nid.h>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/tls.h>)
+#define CONSCRYPT_HAVE_KTLS
+#endif
+#endif
+
+#ifdef CONSCRYPT_HAVE_KTLS
+#include <linux/tls.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#endif  // CONSCRYPT_HAVE_KTLS
+
+namespace conscrypt {
+namespace ktls {
+
+#ifdef CONSCRYPT_HAVE_KTLS
+
+#ifndef SOL_TLS
+#define SOL_TLS 282
+#endif
+#ifndef TCP_ULP
+#define TCP_ULP 31
+#endif
+
+namespace {
+
+constexpr uint8_t kRecordTypeAlert = 21;
+constexpr uint8_t kRecordTypeHandshake = 22;
+constexpr uint8_t kRecordTypeApplicationData = 23;
+constexpr uint8_t kAlertCloseNotify = 0;
+constexpr uint8_t kHandshakeNewSessionTicket = 4;
+
+constexpr size_t kMaxKeyLength = 32;
+constexpr size_t kMaxIvLength = 12;
+
+/**
+ * The traffic key of one direction, and its nonce: the 4-byte implicit part for AES-GCM in
+ * TLS 1.2, the full 12-byte nonce mask otherwise.
+ */
+struct TrafficKey {
+    uint8_t key[kMaxKeyLength];
+    size_t keyLength = 0;
+    uint8_t iv[kMaxIvLength];
+    size_t ivLength = 0;
+    uint64_t sequence = 0;
+
+    ~TrafficKey() {
+        OPENSSL_cleanse(key, sizeof(key));
+        OPENSSL_cleanse(iv, sizeof(iv));
+    }
+};
+
+union CryptoInfo {
+    tls_crypto_info info;
+    tls12_crypto_info_aes_gcm_128 aesGcm128;
+    tls12_crypto_info_aes_gcm_256 aesGcm256;
+#ifdef TLS_CIPHER_CHACHA20_POLY1305
+    tls12_crypto_info_chacha20_poly1305 chacha20Poly1305;
+#endif
+};
+
+void storeBigEndian64(uint8_t out[8], uint64_t value) {
+    for (int i = 7; i >= 0; i--) {
+        out[i] = static_cast<uint8_t>(value);
+        value >>= 8;
+    }
+}
+
+/**
+ * Returns the key length for the AEAD nid if the kernel can offload it, otherwise 0.
+ */
+size_t keyLengthForCipher(int nid) {
+    switch (nid) {
+        case NID_aes_128_gcm:
+            return TLS_CIPHER_AES_GCM_128_KEY_SIZE;
+        case NID_aes_256_gcm:
+            return TLS_CIPHER_AES_GCM_256_KEY_SIZE;
+#ifdef TLS_CIPHER_CHACHA20_POLY1305
+        case NID_chacha20_poly1305:
+            return TLS_CIPHER_CHACHA20_POLY1305_KEY_SIZE;
+#endif
+        default:
+            return 0;
+    }
+}
+
+/**
+ * HKDF-Expand-Label from RFC 8446, section 7.1, with an empty context.
+ */
+bool expandLabel(uint8_t* out, size_t outLength, const EVP_MD* digest, const uint8_t* secret,
+                 size_t secretLength, const char* label) {
+    static const char kPrefix[] = "tls13 ";
+    size_t prefixLength = sizeof(kPrefix) - 1;
+    size_t labelLength = strlen(label);
+    uint8_t info[2 + 1 + 255 + 1];
+    size_t infoLength = 0;
+    info[infoLength++] = static_cast<uint8_t>(outLength >> 8);
+    info[infoLength++] = static_cast<uint8_t>(outLength);
+    info[infoLength++] = static_cast<uint8_t>(prefixLength + labelLength);
+    memcpy(info + infoLength, kPrefix, prefixLength);
+    infoLength += prefixLength;
+    memcpy(info + infoLength, label, labelLength);
+    infoLength += labelLength;
+    info[infoLength++] = 0;
+    return HKDF_expand(out, outLength, digest, secret, secretLength, info, infoLength) == 1;
+}
+
+/**
+ * Derives the read and write keys of a TLS 1.3 connection from its traffic secrets.
+ */
+bool tls13Keys(const SSL* ssl, size_t keyLength, TrafficKey* read, TrafficKey* write) {
+    bssl::Span<const uint8_t> readSecret;
+    bssl::Span<const uint8_t> writeSecret;
+    if (!bssl::SSL_get_traffic_secrets(ssl, &readSecret, &writeSecret)) {
+        return false;
+    }
+    const EVP_MD* digest = SSL_CIPHER_get_handshake_digest(SSL_get_current_cipher(ssl));
+    if (digest == nullptr) {
+        return false;
+    }
+    TrafficKey* keys[] = {read, write};
+    const bssl::Span<const uint8_t>* secrets[] = {&readSecret, &writeSecret};
+    for (size_t i = 0; i < 2; i++) {
+        keys[i]->keyLength = keyLength;
+        keys[i]->ivLength = kMaxIvLength;
+        if (!expandLabel(keys[i]->key, keyLength, digest, secrets[i]->data(),
+                         secrets[i]->size(), "key") ||
+            !expandLabel(keys[i]->iv, kMaxIvLength, digest, secrets[i]->data(),
+                         secrets[i]->size(), "iv")) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Extracts the read and write keys of a TLS 1.2 connection from its key block, which for an
+ * AEAD cipher is laid out as client key, server key, client IV and server IV.
+ */
+bool tls12Keys(const SSL* ssl, size_t keyLength, TrafficKey* read, TrafficKey* write) {
+    size_t blockLength = SSL_get_key_block_len(ssl);
+    if (blockLength % 2 != 0 || blockLength / 2 <= keyLength ||
+        blockLength / 2 - keyLength > kMaxIvLength) {
+        return false;
+    }
+    size_t ivLength = blockLength / 2 - keyLength;
+    uint8_t block[2 * (kMaxKeyLength + kMaxIvLength)];
+    if (!SSL_generate_key_block(ssl, block, blockLength)) {
+        return false;
+    }
+    TrafficKey* client = SSL_is_server(ssl) ? read : write;
+    TrafficKey* server = SSL_is_server(ssl) ? write : read;
+    memcpy(client->key, block, keyLength);
+    memcpy(server->key, block + keyLength, keyLength);
+    memcpy(client->iv, block + 2 * keyLength, ivLength);
+    memcpy(server->iv, block + 2 * keyLength + ivLength, ivLength);
+    client->keyLength = server->keyLength = keyLength;
+    client->ivLength = server->ivLength = ivLength;
+    OPENSSL_cleanse(block, sizeof(block));
+    return true;
+}
+
+/**
+ * Fills info with key for the kernel. Returns the length of the structure, or 0 if the
+ * combination is not supported.
+ */
+socklen_t fillCryptoInfo(CryptoInfo* info, int nid, uint16_t version, const TrafficKey& key) {
+    memset(info, 0, sizeof(*info));
+    info->info.version = version == TLS1_3_VERSION ? TLS_1_3_VERSION : TLS_1_2_VERSION;
+    uint8_t sequence[8];
+    storeBigEndian64(sequence, key.sequence);
+    switch (nid) {
+        case NID_aes_128_gcm:
+        case NID_aes_256_gcm: {
+            // The kernel takes the nonce as a 4-byte salt and an 8-byte IV. In TLS 1.2, which
+            // BoringSSL runs with the sequence number as the explicit nonce, the IV is where
+            // the explicit nonces start.
+            uint8_t explicitIv[8];
+            if (version == TLS1_3_VERSION) {
+                if (key.ivLength != 12) {
+                    return 0;
+                }
+                memcpy(explicitIv, key.iv + 4, 8);
+            } else {
+                if (key.ivLength != 4) {
+                    return 0;
+                }
+                memcpy(explicitIv, sequence, 8);
+            }
+            if (nid == NID_aes_128_gcm) {
+                info->info.cipher_type = TLS_CIPHER_AES_GCM_128;
+                memcpy(info->aesGcm128.key, key.key, TLS_CIPHER_AES_GCM_128_KEY_SIZE);
+                memcpy(info->aesGcm128.salt, key.iv, TLS_CIPHER_AES_GCM_128_SALT_SIZE);
+                memcpy(info->aesGcm128.iv, explicitIv, TLS_CIPHER_AES_GCM_128_IV_SIZE);
+                memcpy(info->aesGcm128.rec_seq, sequence, TLS_CIPHER_AES_GCM_128_REC_SEQ_SIZE);
+                return sizeof(info->aesGcm128);
+            }
+            info->info.cipher_type = TLS_CIPHER_AES_GCM_256;
+            memcpy(info->aesGcm256.key, key.key, TLS_CIPHER_AES_GCM_256_KEY_SIZE);
+            memcpy(info->aesGcm256.salt, key.iv, TLS_CIPHER_AES_GCM_256_SALT_SIZE);
+            memcpy(info->aesGcm256.iv, explicitIv, TLS_CIPHER_AES_GCM_256_IV_SIZE);
+            memcpy(info->aesGcm256.rec_seq, sequence, TLS_CIPHER_AES_GCM_256_REC_SEQ_SIZE);
+            return sizeof(info->aesGcm256);
+        }
+#ifdef TLS_CIPHER_CHACHA20_POLY1305
+        case NID_chacha20_poly1305: {
+            if (key.ivLength != TLS_CIPHER_CHACHA20_POLY1305_IV_SIZE) {
+                return 0;
+            }
+            info->info.cipher_type = TLS_CIPHER_CHACHA20_POLY1305;
+            memcpy(info->chacha20Poly1305.key, key.key, TLS_CIPHER_CHACHA20_POLY1305_KEY_SIZE);
+            memcpy(info->chacha20Poly1305.iv, key.iv, TLS_CIPHER_CHACHA20_POLY1305_IV_SIZE);
+            memcpy(info->chacha20Poly1305.rec_seq, sequence,
+                   TLS_CIPHER_CHACHA20_POLY1305_REC_SEQ_SIZE);
+            return sizeof(info->chacha20Poly1305);
+        }
+#endif
+        default:
+            return 0;
+    }
+}
+
+bool installKey(int fd, int direction, int nid, uint16_t version, const TrafficKey& key) {
+    CryptoInfo info;
+    socklen_t length = fillCryptoInfo(&info, nid, version, key);
+    bool installed = length != 0 &&
+                     setsockopt(fd, SOL_TLS, direction == kTx ? TLS_TX : TLS_RX, &info,
+                                length) == 0;
+    OPENSSL_cleanse(&info, sizeof(info));
+    return installed;
+}
+
+/**
+ * Consumes the len bytes of a non-data record content read from the kernel. Returns false
+ * with errno set if the connection cannot continue; otherwise the caller reads again.
+ */
+bool consumeControlRecord(State* state, uint8_t type, const uint8_t* data, size_t len) {
+    if (type == kRecordTypeAlert) {
+        while (len > 0 && state->alertBytes < sizeof(state->alert)) {
+            state->alert[state->alertBytes++] = *data++;
+            len--;
+        }
+        if (state->alertBytes < sizeof(state->alert)) {
+            return true;
+        }
+        if (state->alert[1] == kAlertCloseNotify) {
+            state->peerClosed = true;
+            return true;
+        }
+        JNI_TRACE("ktls: received alert %d", state->alert[1]);
+        errno = EPROTO;
+        return false;
+    }
+    if (type != kRecordTypeHandshake || state->version != TLS1_3_VERSION) {
+        errno = EPROTO;
+        return false;
+    }
+    // Skip NewSessionTicket messages; the session cache never sees them once the kernel
+    // decrypts the records. Anything else, notably KeyUpdate, would need the SSL.
+    while (len > 0) {
+        if (state->handshakeHeaderBytes < sizeof(state->handshakeHeader)) {
+            state->handshakeHeader[state->handshakeHeaderBytes++] = *data++;
+            len--;
+            if (state->handshakeHeaderBytes < sizeof(state->handshakeHeader)) {
+                continue;
+            }
+            if (state->handshakeHeader[0] != kHandshakeNewSessionTicket) {
+                JNI_TRACE("ktls: received handshake message %d", state->handshakeHeader[0]);
+                errno = EPROTO;
+                return false;
+            }
+            state->handshakeBodyRemaining = (static_cast<size_t>(state->handshakeHeader[1]) << 16) |
+                                            (static_cast<size_t>(state->handshakeHeader[2]) << 8) |
+                                            state->handshakeHeader[3];
+        } else {
+            size_t skip = len < state->handshakeBodyRemaining ? len : state->handshakeBodyRemaining;
+            data += skip;
+            len -= skip;
+            state->handshakeBodyRemaining -= skip;
+        }
+        if (state->handshakeHeaderBytes == sizeof(state->handshakeHeader) &&
+            state->handshakeBodyRemaining == 0) {
+            state->handshakeHeaderBytes = 0;
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+bool isSupported() {
+    return true;
+}
+
+int enable(SSL* ssl, int fd, State* state) {
+    if (!SSL_is_init_finished(ssl) || SSL_in_early_data(ssl) || SSL_in_false_start(ssl)) {
+        return 0;
+    }
+    uint16_t version = SSL_version(ssl);
+    if (version != TLS1_2_VERSION && version != TLS1_3_VERSION) {
+        return 0;
+    }
+    const SSL_CIPHER* cipher = SSL_get_current_cipher(ssl);
+    if (cipher == nullptr) {
+        return 0;
+    }
+    int nid = SSL_CIPHER_get_cipher_nid(cipher);
+    size_t keyLength = keyLengthForCipher(nid);
+    if (keyLength == 0) {
+        return 0;
+    }
+
+    TrafficKey read;
+    TrafficKey write;
+    bool haveKeys = version == TLS1_3_VERSION ? tls13Keys(ssl, keyLength, &read, &write)
+                                              : tls12Keys(ssl, keyLength, &read, &write);
+    if (!haveKeys) {
+        return 0;
+    }
+    read.sequence = SSL_get_read_sequence(ssl);
+    write.sequence = SSL_get_write_sequence(ssl);
+
+    // Fails with ENOENT when the tls module is not loaded, and EEXIST if already attached.
+    static const char kUlp[] = "tls";
+    if (setsockopt(fd, IPPROTO_TCP, TCP_ULP, kUlp, sizeof(kUlp)) != 0) {
+        JNI_TRACE("ssl=%p ktls::enable TCP_ULP failed: %s", ssl, strerror(errno));
+        return 0;
+    }
+
+    // Until keys are installed the socket behaves as before. Records the SSL has already
+    // buffered could never be returned once the kernel reads the socket, so receive stays in
+    // user space while there are any. Send is only offloaded together with receive: an SSL
+    // that still reads records answers some of them (KeyUpdate, alerts) with records of its
+    // own, which the kernel would encrypt a second time.
+    if (SSL_has_pending(ssl) || !installKey(fd, kRx, nid, version, read)) {
+        JNI_TRACE("ssl=%p ktls::enable fd=%d => receive stays in user space", ssl, fd);
+        return 0;
+    }
+    int directions = kRx;
+    if (installKey(fd, kTx, nid, version, write)) {
+        directions |= kTx;
+    }
+    JNI_TRACE("ssl=%p ktls::enable fd=%d => %d", ssl, fd, directions);
+    state->directions = directions;
+    state->version = version;
+    return directions;
+}
+
+int read(int fd, State* state, void* buf, size_t len) {
+    while (!state->peerClosed) {
+        union {
+            char buf[CMSG_SPACE(sizeof(unsigned char))];
+            struct cmsghdr align;
+        } control;
+        struct iovec iov;
+        iov.iov_base = buf;
+        iov.iov_len = len;
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control.buf;
+        msg.msg_controllen = sizeof(control.buf);
+
+        ssize_t result = recvmsg(fd, &msg, MSG_DONTWAIT);
+        if (result <= 0) {
+            return static_cast<int>(result);
+        }
+        uint8_t type = kRecordTypeApplicationData;
+        struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+        if (cmsg != nullptr && cmsg->cmsg_level == SOL_TLS &&
+            cmsg->cmsg_type == TLS_GET_RECORD_TYPE) {
+            type = *reinterpret_cast<unsigned char*>(CMSG_DATA(cmsg));
+        }
+        if (type == kRecordTypeApplicationData) {
+            return static_cast<int>(result);
+        }
+        if (!consumeControlRecord(state, type, static_cast<const uint8_t*>(buf),
+                                  static_cast<size_t>(result))) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+int write(int fd, const void* buf, size_t len) {
+    return static_cast<int>(send(fd, buf, len, MSG_DONTWAIT | MSG_NOSIGNAL));
+}
+
+bool sendCloseNotify(int fd) {
+    // Warning level, close_notify.
+    uint8_t alert[2] = {1, kAlertCloseNotify};
+    union {
+        char buf[CMSG_SPACE(sizeof(unsigned char))];
+        struct cmsghdr align;
+    } control;
+    memset(&control, 0, sizeof(control));
+    struct iovec iov;
+    iov.iov_base = alert;
+    iov.iov_len = sizeof(alert);
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof(control.buf);
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_TLS;
+    cmsg->cmsg_type = TLS_SET_RECORD_TYPE;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(unsigned char));
+    *reinterpret_cast<unsigned char*>(CMSG_DATA(cmsg)) = kRecordTypeAlert;
+    ssize_t result;
+    do {
+        result = sendmsg(fd, &msg, MSG_NOSIGNAL);
+    } while (result == -1 && errno == EINTR);
+    return result == static_cast<ssize_t>(sizeof(alert));
+}
+
+#else  // !CONSCRYPT_HAVE_KTLS
+
+bool isSupported() {
+    return false;
+}
+
+int enable(SSL*, int, State*) {
+    return 0;
+}
+
+int read(int, State*, void*, size_t) {
+    errno = ENOSYS;
+    return -1;
+}
+
+int write(int, const void*, size_t) {
+    errno = ENOSYS;
+    return -1;
+}
+
+bool sendCloseNotify(int) {
+    errno = ENOSYS;
+    return false;
+}
+
+#endif  // CONSCRYPT_HAVE_KTLS
+
+}  // namespace ktls
+}  // namespace conscrypt
@@ -0,0 +1,138 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <conscrypt/mapped_file.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace conscrypt {
+
+#ifdef _WIN32
+
+MappedFile* MappedFile::open(const char* path) {
+    int fd = _open(path, _O_RDONLY | _O_BINARY);
+    if (fd == -1) {
+        return nullptr;
+    }
+    MappedFile* file = openFd(fd);
+    int savedErrno = errno;
+    _close(fd);
+    errno = savedErrno;
+    return file;
+}
+
+MappedFile* MappedFile::openFd(int fd) {
+    struct _stat64 st;
+    if (_fstat64(fd, &st) == -1) {
+        return nullptr;
+    }
+    if (_lseeki64(fd, 0, SEEK_SET) == -1) {
+        return nullptr;
+    }
+    size_t size = static_cast<size_t>(st.st_size);
+    uint8_t* data = static_cast<uint8_t*>(malloc(size == 0 ? 1 : size));
+    if (data == nullptr) {
+        errno = ENOMEM;
+        return nullptr;
+    }
+    size_t done = 0;
+    while (done < size) {
+        unsigned int chunk = size - done > 0x40000000 ? 0x40000000
+                                                      : static_cast<unsigned int>(size - done);
+        int n = _read(fd, data + done, chunk);
+        if (n == -1) {
+            int savedErrno = errno;
+            free(data);
+            errno = savedErrno;
+            return nullptr;
+        }
+        if (n == 0) {
+            // Truncated underneath us; parse what was there.
+            break;
+        }
+        done += static_cast<size_t>(n);
+    }
+    return new MappedFile(data, done, false);
+}
+
+MappedFile::~MappedFile() {
+    (void)mapped_;
+    free(const_cast<uint8_t*>(data_));
+}
+
+#else  // !_WIN32
+
+MappedFile* MappedFile::open(const char* path) {
+    int fd;
+    do {
+        fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    } while (fd == -1 && errno == EINTR);
+    if (fd == -1) {
+        return nullptr;
+    }
+    MappedFile* file = openFd(fd);
+    int savedErrno = errno;
+    close(fd);
+    errno = savedErrno;
+    return file;
+}
+
+MappedFile* MappedFile::openFd(int fd) {
+    struct stat st;
+    if (fstat(fd, &st) == -1) {
+        return nullptr;
+    }
+    if (!S_ISREG(st.st_mode)) {
+        errno = EINVAL;
+        return nullptr;
+    }
+    size_t size = static_cast<size_t>(st.st_size);
+    if (size == 0) {
+        // mmap() rejects empty mappings.
+        static const uint8_t kEmpty = 0;
+        return new MappedFile(&kEmpty, 0, false);
+    }
+    void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) {
+        return nullptr;
+    }
+    // Entries are parsed front to back and copied out, so let the kernel read ahead and drop
+    // pages behind the cursor under memory pressure.
+    (void)madvise(data, size, MADV_SEQUENTIAL);
+    return new MappedFile(static_cast<const uint8_t*>(data), size, true);
+}
+
+MappedFile::~MappedFile() {
+    if (mapped_) {
+        munmap(const_cast<uint8_t*>(data_), size_);
+    }
+}
+
+#endif  // _WIN32
+
+}  // namespace conscrypt
@@ -19,15 +19,29 @@
 #include <conscrypt/bio_input_stream.h>
 #include <conscrypt/bio_output_stream.h>
 #include <conscrypt/bio_stream.h>
+#include <conscrypt/buffered_rand.h>
+#include <conscrypt/certificate_map.h>
 #include <conscrypt/compat.h>
 #include <conscrypt/compatibility_close_monitor.h>
+#include <conscrypt/event_trace.h>
 #include <conscrypt/jniutil.h>
+#include <conscrypt/ktls.h>
 #include <conscrypt/logging.h>
 #include <conscrypt/macros.h>
+#include <conscrypt/mapped_file.h>
 #include <conscrypt/native_crypto.h>
 #include <conscrypt/netutil.h>
+#include <conscrypt/public_key_cache.h>
 #include <conscrypt/scoped_ssl_bio.h>
+#include <conscrypt/scrypt.h>
+#include <conscrypt/server_session_cache.h>
 #include <conscrypt/ssl_error.h>
+#include <conscrypt/ssl_poller.h>
+#include <conscrypt/ticket_keys.h>
+#include <conscrypt/transport_bio.h>
+#include <conscrypt/verified_chain_cache.h>
+#include <conscrypt/worker_pool.h>
+#include <ctype.h>
 #include <limits.h>
 #include <nativehelper/scoped_primitive_array.h>
 #include <nativehelper/scoped_utf_chars.h>
@@ -50,9 +64,15 @@
 #include <openssl/ssl.h>
 #include <openssl/x509v3.h>
 
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <initializer_list>
 #include <limits>
+#include <mutex>
 #include <optional>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
 using conscrypt::AppData;
@@ -355,8 +375,36 @@ jbyteArray CryptoBufferToByteArray(JNIEnv* env, const CRYPTO_BUFFER* buf) {
     return ret;
 }
 
+namespace {
+
+// Process-wide pool shared by every SSL_CTX so that identical certificates (local chains,
+// intermediates, CA principals and peer chains) are stored once. CRYPTO_BUFFER_POOL is
+// internally locked, so the pool itself can be used from any thread.
+CRYPTO_BUFFER_POOL* g_crypto_buffer_pool;
+std::once_flag g_crypto_buffer_pool_once;
+
+// Number of certificates passed in from Java that were looked up in the pool. BoringSSL
+// does not report whether CRYPTO_BUFFER_new returned an existing buffer, so hits are not
+// counted.
+std::atomic<uint64_t> g_crypto_buffer_pool_requests;
+
+void init_crypto_buffer_pool() {
+    g_crypto_buffer_pool = CRYPTO_BUFFER_POOL_new();
+}
+
+}  // namespace
+
+/**
+ * Returns the process-wide CRYPTO_BUFFER_POOL, creating it on first use. The pool lives for
+ * the lifetime of the process.
+ */
+static CRYPTO_BUFFER_POOL* GetSharedCryptoBufferPool() {
+    std::call_once(g_crypto_buffer_pool_once, init_crypto_buffer_pool);
+    return g_crypto_buffer_pool;
+}
+
 bssl::UniquePtr<CRYPTO_BUFFER> ByteArrayToCryptoBuffer(JNIEnv* env, const jbyteArray array,
-                                                       CONSCRYPT_UNUSED CRYPTO_BUFFER_POOL* pool) {
+                                                       CRYPTO_BUFFER_POOL* pool) {
     if (array == nullptr) {
         JNI_TRACE("array was null");
         conscrypt::jniutil::throwNullPointerException(env, "array == null");
@@ -370,12 +418,15 @@ bssl::UniquePtr<CRYPTO_BUFFER> ByteArrayToCryptoBuffer(JNIEnv* env, const jbyteA
     }
 
     bssl::UniquePtr<CRYPTO_BUFFER> ret(CRYPTO_BUFFER_new(
-            reinterpret_cast<const uint8_t*>(arrayRo.get()), arrayRo.size(), nullptr));
+            reinterpret_cast<const uint8_t*>(arrayRo.get()), arrayRo.size(), pool));
     if (!ret) {
         JNI_TRACE("failed to allocate CRYPTO_BUFFER");
         conscrypt::jniutil::throwOutOfMemory(env, "failed to allocate CRYPTO_BUFFER");
         return nullptr;
     }
+    if (pool != nullptr && pool == g_crypto_buffer_pool) {
+        g_crypto_buffer_pool_requests.fetch_add(1, std::memory_order_relaxed);
+    }
 
     return ret;
 }
@@ -529,8 +580,9 @@ static jbyteArray ecSignDigestWithPrivateKey(JNIEnv* env, jobject privateKey, co
     }
 
     return reinterpret_cast<jbyteArray>(env->CallStaticObjectMethod(
-            conscrypt::jniutil::cryptoUpcallsClass,
-            conscrypt::jniutil::cryptoUpcallsClass_rawSignMethod, privateKey, messageArray.get()));
+            conscrypt::jniutil::cryptoUpcallsClass.get(env),
+            conscrypt::jniutil::cryptoUpcallsClass_rawSignMethod.get(env), privateKey,
+            messageArray.get()));
 }
 
 static jbyteArray rsaSignDigestWithPrivateKey(JNIEnv* env, jobject privateKey, jint padding,
@@ -556,10 +608,10 @@ static jbyteArray rsaSignDigestWithPrivateKey(JNIEnv* env, jobject privateKey, j
         memcpy(messageBytes.get(), message, message_len);
     }
 
-    return reinterpret_cast<jbyteArray>(
-            env->CallStaticObjectMethod(conscrypt::jniutil::cryptoUpcallsClass,
-                                        conscrypt::jniutil::cryptoUpcallsClass_rsaSignMethod,
-                                        privateKey, padding, messageArray.get()));
+    return reinterpret_cast<jbyteArray>(env->CallStaticObjectMethod(
+            conscrypt::jniutil::cryptoUpcallsClass.get(env),
+            conscrypt::jniutil::cryptoUpcallsClass_rsaSignMethod.get(env), privateKey, padding,
+            messageArray.get()));
 }
 
 // rsaDecryptWithPrivateKey uses privateKey to decrypt |ciphertext_len| bytes
@@ -589,10 +641,10 @@ static jbyteArray rsaDecryptWithPrivateKey(JNIEnv* env, jobject privateKey, jint
         memcpy(ciphertextBytes.get(), ciphertext, ciphertext_len);
     }
 
-    return reinterpret_cast<jbyteArray>(
-            env->CallStaticObjectMethod(conscrypt::jniutil::cryptoUpcallsClass,
-                                        conscrypt::jniutil::cryptoUpcallsClass_rsaDecryptMethod,
-                                        privateKey, padding, ciphertextArray.get()));
+    return reinterpret_cast<jbyteArray>(env->CallStaticObjectMethod(
+            conscrypt::jniutil::cryptoUpcallsClass.get(env),
+            conscrypt::jniutil::cryptoUpcallsClass_rsaDecryptMethod.get(env), privateKey, padding,
+            ciphertextArray.get()));
 }
 
 // *********************************************
@@ -818,13 +870,43 @@ void init_engine_globals() {
 #define THROW_SSLEXCEPTION (-2)
 #define THROW_SOCKETTIMEOUTEXCEPTION (-3)
 #define THROWN_EXCEPTION (-4)
+#define WOULD_BLOCK_READ (-5)
+#define WOULD_BLOCK_WRITE (-6)
+#define THROW_EARLYDATAREJECTEDEXCEPTION (-7)
+
+// Timeout passed to sslRead() and sslWrite() to return WOULD_BLOCK_READ or WOULD_BLOCK_WRITE
+// instead of waiting in sslSelect() when the socket isn't ready.
+#define NON_BLOCKING_TIMEOUT (-1)
 
 /**
  * Initialization phase for every OpenSSL job: Loads the Error strings, the
  * crypto algorithms and reset the OpenSSL library
  */
 static void NativeCrypto_clinit(JNIEnv*, jclass) {
+    uint64_t start = conscrypt::jniutil::startupNanos();
     CRYPTO_library_init();
+    conscrypt::jniutil::recordStartupTiming(conscrypt::jniutil::kStartupClinitNanos,
+                                            conscrypt::jniutil::startupNanos() - start);
+}
+
+/**
+ * public static native long[] get_startup_timings();
+ */
+static jlongArray NativeCrypto_get_startup_timings(JNIEnv* env, jclass) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    JNI_TRACE("get_startup_timings");
+    uint64_t timings[conscrypt::jniutil::kStartupTimingCount];
+    conscrypt::jniutil::getStartupTimings(timings);
+    jlong values[conscrypt::jniutil::kStartupTimingCount];
+    for (size_t i = 0; i < conscrypt::jniutil::kStartupTimingCount; i++) {
+        values[i] = static_cast<jlong>(timings[i]);
+    }
+    jlongArray result = env->NewLongArray(conscrypt::jniutil::kStartupTimingCount);
+    if (result == nullptr) {
+        return nullptr;
+    }
+    env->SetLongArrayRegion(result, 0, conscrypt::jniutil::kStartupTimingCount, values);
+    return result;
 }
 
 /**
@@ -1162,6 +1244,12 @@ static jint NativeCrypto_EVP_PKEY_cmp(JNIEnv* env, jclass, jobject pkey1Ref, job
     }
     JNI_TRACE("EVP_PKEY_cmp(%p, %p) <- ptr", pkey1, pkey2);
 
+    // Keys from the public key cache are shared, so equal keys are often the same object.
+    if (pkey1 == pkey2) {
+        JNI_TRACE("EVP_PKEY_cmp(%p, %p) => 1 (same key)", pkey1, pkey2);
+        return 1;
+    }
+
     int result = EVP_PKEY_cmp(pkey1, pkey2);
     JNI_TRACE("EVP_PKEY_cmp(%p, %p) => %d", pkey1, pkey2, result);
     return result;
@@ -1309,6 +1397,26 @@ static jlong NativeCrypto_EVP_parse_public_key(JNIEnv* env, jclass, jbyteArray k
 
     CBS cbs;
     CBS_init(&cbs, reinterpret_cast<const uint8_t*>(bytes.get()), bytes.size());
+
+    // The cache key covers only the SubjectPublicKeyInfo itself, not any trailing bytes.
+    conscrypt::publickeycache::Key cacheKey;
+    bool useCache = false;
+    if (conscrypt::publickeycache::isEnabled()) {
+        CBS spki = cbs;
+        CBS element;
+        if (CBS_get_asn1_element(&spki, &element, CBS_ASN1_SEQUENCE)) {
+            conscrypt::publickeycache::computeKey(CBS_data(&element), CBS_len(&element),
+                                                  &cacheKey);
+            bssl::UniquePtr<EVP_PKEY> cached = conscrypt::publickeycache::lookup(cacheKey);
+            if (cached) {
+                JNI_TRACE("bytes=%p EVP_parse_public_key => %p (cached)", keyJavaBytes,
+                          cached.get());
+                return reinterpret_cast<uintptr_t>(cached.release());
+            }
+            useCache = true;
+        }
+    }
+
     bssl::UniquePtr<EVP_PKEY> pkey(EVP_parse_public_key(&cbs));
     // We intentionally do not check that cbs is exhausted, as JCA providers typically
     // allow parsing keys from buffers that are larger than the contained key structure
@@ -1319,6 +1427,9 @@ static jlong NativeCrypto_EVP_parse_public_key(JNIEnv* env, jclass, jbyteArray k
         JNI_TRACE("bytes=%p EVP_parse_public_key => threw exception", keyJavaBytes);
         return 0;
     }
+    if (useCache) {
+        pkey = conscrypt::publickeycache::intern(cacheKey, std::move(pkey));
+    }
 
     JNI_TRACE("bytes=%p EVP_parse_public_key => %p", keyJavaBytes, pkey.get());
     return reinterpret_cast<uintptr_t>(pkey.release());
@@ -1728,6 +1839,68 @@ static void NativeCrypto_chacha20_encrypt_decrypt(JNIEnv* env, jclass, jbyteArra
             blockCounter);
 }
 
+/**
+ * Returns whether [a, a + aLength) and [b, b + bLength) share any byte. Equal pointers count
+ * as overlapping, so callers check for exact in-place operation first.
+ */
+static bool buffersOverlap(const uint8_t* a, size_t aLength, const uint8_t* b, size_t bLength) {
+    uintptr_t aStart = reinterpret_cast<uintptr_t>(a);
+    uintptr_t bStart = reinterpret_cast<uintptr_t>(b);
+    return aLength > 0 && bLength > 0 && aStart < bStart + bLength && bStart < aStart + aLength;
+}
+
+/*
+ *  public static native void chacha20_encrypt_decryptDirect(long inPtr, long outPtr, int length,
+ *          byte[] key, byte[] nonce, int blockCounter);
+ */
+static void NativeCrypto_chacha20_encrypt_decryptDirect(JNIEnv* env, jclass, jlong inPtr,
+                                                        jlong outPtr, jint length,
+                                                        jbyteArray keyBytes, jbyteArray nonceBytes,
+                                                        jint blockCounter) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    const uint8_t* in = reinterpret_cast<const uint8_t*>(inPtr);
+    uint8_t* out = reinterpret_cast<uint8_t*>(outPtr);
+    JNI_TRACE("chacha20_encrypt_decryptDirect(%p, %p, %d)", in, out, length);
+
+    if (in == nullptr || out == nullptr) {
+        conscrypt::jniutil::throwNullPointerException(env, nullptr);
+        return;
+    }
+    if (length < 0) {
+        conscrypt::jniutil::throwException(env, "java/lang/ArrayIndexOutOfBoundsException",
+                                           "length < 0");
+        return;
+    }
+    ScopedByteArrayRO key(env, keyBytes);
+    if (key.get() == nullptr) {
+        JNI_TRACE("chacha20_encrypt_decryptDirect => threw exception: could not read key bytes");
+        return;
+    }
+    ScopedByteArrayRO nonce(env, nonceBytes);
+    if (nonce.get() == nullptr) {
+        JNI_TRACE("chacha20_encrypt_decryptDirect => threw exception: could not read nonce bytes");
+        return;
+    }
+    if (key.size() != 32 || nonce.size() != 12) {
+        conscrypt::jniutil::throwException(env, "java/lang/IllegalArgumentException",
+                                           "Invalid key or nonce length");
+        return;
+    }
+
+    // CRYPTO_chacha_20 allows in == out, but not buffers that only partly overlap.
+    size_t len = static_cast<size_t>(length);
+    std::unique_ptr<uint8_t[]> inCopy;
+    if (in != out && buffersOverlap(in, len, out, len)) {
+        inCopy.reset(new uint8_t[len]);
+        memcpy(inCopy.get(), in, len);
+        in = inCopy.get();
+    }
+
+    CRYPTO_chacha_20(out, in, len, reinterpret_cast<const uint8_t*>(key.get()),
+                     reinterpret_cast<const uint8_t*>(nonce.get()),
+                     static_cast<uint32_t>(blockCounter));
+}
+
 static jlong NativeCrypto_EC_GROUP_new_by_curve_name(JNIEnv* env, jclass, jstring curveNameJava) {
     CHECK_ERROR_QUEUE_ON_RETURN;
     JNI_TRACE("EC_GROUP_new_by_curve_name(%p)", curveNameJava);
@@ -2501,6 +2674,173 @@ static jint NativeCrypto_ECDSA_verify(JNIEnv* env, jclass, jbyteArray data, jbyt
     return static_cast<jint>(result);
 }
 
+/**
+ * A public key parsed once for verifying many signatures: the EC_KEY for ECDSA, whose point is
+ * already decoded and checked against the curve, or the raw Ed25519 key.
+ */
+struct PreparedVerifier {
+    int type;
+    bssl::UniquePtr<EC_KEY> ecKey;
+    uint8_t ed25519Key[ED25519_PUBLIC_KEY_LEN];
+};
+
+// Batches smaller than this are verified on the calling thread; a few signatures finish in
+// about the time it takes to wake the worker pool.
+static constexpr size_t kParallelVerifyBatch = 8;
+// Signatures are handed to the worker pool in runs of this many.
+static constexpr size_t kVerifyBatchItemsPerTask = 4;
+
+static jlong NativeCrypto_PREPARED_VERIFIER_new(JNIEnv* env, jclass, jobject pkeyRef) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    EVP_PKEY* pkey = fromContextObject<EVP_PKEY>(env, pkeyRef);
+    JNI_TRACE("PREPARED_VERIFIER_new(%p)", pkey);
+    if (pkey == nullptr) {
+        return 0;
+    }
+
+    std::unique_ptr<PreparedVerifier> verifier(new PreparedVerifier());
+    verifier->type = EVP_PKEY_id(pkey);
+    if (verifier->type == EVP_PKEY_EC) {
+        verifier->ecKey.reset(EVP_PKEY_get1_EC_KEY(pkey));
+        if (verifier->ecKey.get() == nullptr) {
+            conscrypt::jniutil::throwExceptionFromBoringSSLError(env, "EVP_PKEY_get1_EC_KEY");
+            return 0;
+        }
+    } else if (verifier->type == EVP_PKEY_ED25519) {
+        size_t keyLength = sizeof(verifier->ed25519Key);
+        if (!EVP_PKEY_get_raw_public_key(pkey, verifier->ed25519Key, &keyLength) ||
+            keyLength != sizeof(verifier->ed25519Key)) {
+            conscrypt::jniutil::throwExceptionFromBoringSSLError(env,
+                                                                 "EVP_PKEY_get_raw_public_key");
+            return 0;
+        }
+    } else {
+        conscrypt::jniutil::throwException(env, "java/lang/IllegalArgumentException",
+                                           "Unsupported key type");
+        return 0;
+    }
+
+    JNI_TRACE("PREPARED_VERIFIER_new(%p) => %p", pkey, verifier.get());
+    return reinterpret_cast<jlong>(verifier.release());
+}
+
+static void NativeCrypto_PREPARED_VERIFIER_free(JNIEnv* env, jclass, jlong verifierRef) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    PreparedVerifier* verifier = reinterpret_cast<PreparedVerifier*>(verifierRef);
+    JNI_TRACE("PREPARED_VERIFIER_free(%p)", verifier);
+    if (verifier == nullptr) {
+        conscrypt::jniutil::throwNullPointerException(env, "verifier == null");
+        return;
+    }
+    delete verifier;
+}
+
+/*
+ * public static native long[] PREPARED_VERIFIER_verify_batch(
+ *         NativeRef.PREPARED_VERIFIER verifier, byte[] data, int[] ranges, int count)
+ *
+ * Verifies count signatures. For item i, ranges[4i] and ranges[4i + 1] are the offset and
+ * length in data of the signed input, which is the digest for ECDSA and the whole message for
+ * Ed25519, and ranges[4i + 2] and ranges[4i + 3] those of the signature. Returns a bitmap with
+ * bit i % 64 of word i / 64 set when signature i is valid. Large batches are spread over the
+ * worker pool.
+ */
+static jlongArray NativeCrypto_PREPARED_VERIFIER_verify_batch(JNIEnv* env, jclass,
+                                                              jobject verifierRef,
+                                                              jbyteArray dataArray,
+                                                              jintArray rangesArray, jint count) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    const PreparedVerifier* verifier = fromContextObject<PreparedVerifier>(env, verifierRef);
+    JNI_TRACE("PREPARED_VERIFIER_verify_batch(%p, %p, %p, %d)", verifier, dataArray,
+              rangesArray, count);
+    if (verifier == nullptr) {
+        return nullptr;
+    }
+    if (dataArray == nullptr) {
+        conscrypt::jniutil::throwNullPointerException(env, "data == null");
+        return nullptr;
+    }
+    if (rangesArray == nullptr) {
+        conscrypt::jniutil::throwNullPointerException(env, "ranges == null");
+        return nullptr;
+    }
+    ScopedIntArrayRO ranges(env, rangesArray);
+    if (ranges.get() == nullptr) {
+        return nullptr;
+    }
+    if (count < 0 || static_cast<uint64_t>(count) * 4 > ranges.size()) {
+        conscrypt::jniutil::throwException(env, "java/lang/ArrayIndexOutOfBoundsException",
+                                           "count");
+        return nullptr;
+    }
+    // Not pinned with GetPrimitiveArrayCritical, as the worker threads read it while this
+    // thread waits.
+    ScopedByteArrayRO data(env, dataArray);
+    if (data.get() == nullptr) {
+        return nullptr;
+    }
+    const int64_t dataLength = static_cast<int64_t>(data.size());
+    for (size_t i = 0; i < static_cast<size_t>(count) * 2; i++) {
+        jint offset = ranges[2 * i];
+        jint length = ranges[2 * i + 1];
+        if (offset < 0 || length < 0 || static_cast<int64_t>(offset) + length > dataLength) {
+            conscrypt::jniutil::throwException(env, "java/lang/ArrayIndexOutOfBoundsException",
+                                               "range out of data bounds");
+            return nullptr;
+        }
+    }
+
+    const uint8_t* in = reinterpret_cast<const uint8_t*>(data.get());
+    const jint* rangesPtr = ranges.get();
+    const size_t items = static_cast<size_t>(count);
+    std::vector<uint8_t> valid(items);
+    std::function<void(size_t)> verifyRun = [&](size_t task) {
+        size_t end = std::min(items, (task + 1) * kVerifyBatchItemsPerTask);
+        for (size_t i = task * kVerifyBatchItemsPerTask; i < end; i++) {
+            const jint* r = rangesPtr + 4 * i;
+            const uint8_t* message = in + r[0];
+            const uint8_t* signature = in + r[2];
+            int ok;
+            if (verifier->type == EVP_PKEY_EC) {
+                ok = ECDSA_verify(0, message, static_cast<size_t>(r[1]), signature,
+                                  static_cast<size_t>(r[3]), verifier->ecKey.get());
+            } else {
+                ok = r[3] == ED25519_SIGNATURE_LEN &&
+                     ED25519_verify(message, static_cast<size_t>(r[1]), signature,
+                                    verifier->ed25519Key);
+            }
+            if (ok != 1) {
+                // A bad signature is reported as such, not as an error.
+                ERR_clear_error();
+            }
+            valid[i] = ok == 1;
+        }
+    };
+    size_t tasks = (items + kVerifyBatchItemsPerTask - 1) / kVerifyBatchItemsPerTask;
+    if (items >= kParallelVerifyBatch) {
+        conscrypt::WorkerPool::get()->run(tasks, verifyRun);
+    } else {
+        for (size_t task = 0; task < tasks; task++) {
+            verifyRun(task);
+        }
+    }
+
+    std::vector<jlong> words((items + 63) / 64);
+    for (size_t i = 0; i < items; i++) {
+        if (valid[i]) {
+            words[i / 64] |= static_cast<jlong>(UINT64_C(1) << (i % 64));
+        }
+    }
+    ScopedLocalRef<jlongArray> result(env, env->NewLongArray(static_cast<jsize>(words.size())));
+    if (result.get() == nullptr) {
+        conscrypt::jniutil::throwOutOfMemory(env, "Unable to allocate result bitmap");
+        return nullptr;
+    }
+    env->SetLongArrayRegion(result.get(), 0, static_cast<jsize>(words.size()), words.data());
+    JNI_TRACE("PREPARED_VERIFIER_verify_batch(%p, %d) => %p", verifier, count, result.get());
+    return result.release();
+}
+
 static jboolean NativeCrypto_X25519(JNIEnv* env, jclass, jbyteArray outArray,
                                           jbyteArray privkeyArray, jbyteArray pubkeyArray) {
     CHECK_ERROR_QUEUE_ON_RETURN;
@@ -2742,6 +3082,106 @@ static jint NativeCrypto_EVP_MD_size(JNIEnv* env, jclass, jlong evpMdRef) {
     return result;
 }
 
+// Batches describing fewer bytes than this are hashed on the calling thread, as they finish in
+// about the time it takes to wake the worker pool.
+static constexpr int64_t kParallelDigestBatchBytes = 256 * 1024;
+// Messages are handed to the worker pool in runs of this many, to keep the per-task overhead
+// small next to the hashing of 1-4KB chunks.
+static constexpr size_t kDigestBatchMessagesPerTask = 32;
+
+/*
+ * public static native void EVP_Digest_batch(long evpMdRef, long inPtr, int inLength,
+ *         int[] offsets, int[] lengths, int count, long outPtr, int outLength)
+ *
+ * Hashes count independent messages, message i being lengths[i] bytes at inPtr + offsets[i], and
+ * writes the digests back to back from outPtr. Large batches are spread over the worker pool.
+ */
+static void NativeCrypto_EVP_Digest_batch(JNIEnv* env, jclass, jlong evpMdRef, jlong inPtr,
+                                          jint inLength, jintArray offsetsArray,
+                                          jintArray lengthsArray, jint count, jlong outPtr,
+                                          jint outLength) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    const EVP_MD* md = reinterpret_cast<const EVP_MD*>(evpMdRef);
+    const uint8_t* in = reinterpret_cast<const uint8_t*>(inPtr);
+    uint8_t* out = reinterpret_cast<uint8_t*>(outPtr);
+    JNI_TRACE("NativeCrypto_EVP_Digest_batch(%p, %p, %d, %p, %p, %d, %p, %d)", md, in, inLength,
+              offsetsArray, lengthsArray, count, out, outLength);
+
+    if (md == nullptr) {
+        conscrypt::jniutil::throwNullPointerException(env, "md == null");
+        return;
+    }
+    if (offsetsArray == nullptr) {
+        conscrypt::jniutil::throwNullPointerException(env, "offsets == null");
+        return;
+    }
+    if (lengthsArray == nullptr) {
+        conscrypt::jniutil::throwNullPointerException(env, "lengths == null");
+        return;
+    }
+    if ((in == nullptr && inLength != 0) || (out == nullptr && count != 0)) {
+        conscrypt::jniutil::throwNullPointerException(env, "buffer == null");
+        return;
+    }
+    ScopedIntArrayRO offsets(env, offsetsArray);
+    ScopedIntArrayRO lengths(env, lengthsArray);
+    if (offsets.get() == nullptr || lengths.get() == nullptr) {
+        return;
+    }
+    if (count < 0 || static_cast<size_t>(count) > offsets.size() ||
+        static_cast<size_t>(count) > lengths.size()) {
+        conscrypt::jniutil::throwException(env, "java/lang/ArrayIndexOutOfBoundsException",
+                                           "count");
+        return;
+    }
+    const size_t mdSize = EVP_MD_size(md);
+    if (outLength < 0 || static_cast<uint64_t>(count) * mdSize > static_cast<uint64_t>(outLength)) {
+        conscrypt::jniutil::throwException(env, "java/lang/IllegalArgumentException",
+                                           "output too small");
+        return;
+    }
+    int64_t totalBytes = 0;
+    for (jint i = 0; i < count; i++) {
+        if (offsets[i] < 0 || lengths[i] < 0 ||
+            static_cast<int64_t>(offsets[i]) + lengths[i] > inLength) {
+            conscrypt::jniutil::throwException(env, "java/lang/ArrayIndexOutOfBoundsException",
+                                               "message out of input bounds");
+            return;
+        }
+        totalBytes += lengths[i];
+    }
+
+    const jint* offsetsPtr = offsets.get();
+    const jint* lengthsPtr = lengths.get();
+    const size_t messages = static_cast<size_t>(count);
+    std::atomic<bool> failed(false);
+    std::function<void(size_t)> digestRun = [&](size_t task) {
+        size_t end = std::min(messages, (task + 1) * kDigestBatchMessagesPerTask);
+        for (size_t i = task * kDigestBatchMessagesPerTask; i < end; i++) {
+            if (!EVP_Digest(in + offsetsPtr[i], static_cast<size_t>(lengthsPtr[i]),
+                            out + i * mdSize, nullptr, md, nullptr)) {
+                // The error may be on a worker's queue, so report it generically below.
+                ERR_clear_error();
+                failed.store(true);
+            }
+        }
+    };
+    size_t tasks = (messages + kDigestBatchMessagesPerTask - 1) / kDigestBatchMessagesPerTask;
+    if (totalBytes >= kParallelDigestBatchBytes) {
+        conscrypt::WorkerPool::get()->run(tasks, digestRun);
+    } else {
+        for (size_t task = 0; task < tasks; task++) {
+            digestRun(task);
+        }
+    }
+
+    if (failed.load()) {
+        conscrypt::jniutil::throwRuntimeException(env, "EVP_Digest failed");
+        return;
+    }
+    JNI_TRACE("NativeCrypto_EVP_Digest_batch(%p, %d) => ok", md, count);
+}
+
 static jlong evpDigestSignVerifyInit(JNIEnv* env,
                                      int (*init_func)(EVP_MD_CTX*, EVP_PKEY_CTX**, const EVP_MD*,
                                                       ENGINE*, EVP_PKEY*),
@@ -2815,6 +3255,35 @@ static void evpUpdate(JNIEnv* env, jobject evpMdCtxRef, jlong inPtr, jint inLeng
     JNI_TRACE_MD("%s(%p, %p, %d) => success", jniName, mdCtx, p, inLength);
 }
 
+/**
+ * Feeds inArray[inOffset, inOffset + inLength) to update straight from the Java heap, pinning
+ * the array with GetPrimitiveArrayCritical for at most kCriticalArrayWindow bytes at a time.
+ * update must not call back into the VM. The caller checks the bounds. Returns false if update
+ * failed, or if the array couldn't be pinned in which case an exception is pending.
+ */
+template <typename UpdateFunc>
+static bool criticalArrayUpdate(JNIEnv* env, jbyteArray inArray, jint inOffset, jint inLength,
+                                UpdateFunc update) {
+    while (inLength > 0) {
+        jint window =
+                std::min(inLength, static_cast<jint>(conscrypt::jniutil::kCriticalArrayWindow));
+        void* elements = env->GetPrimitiveArrayCritical(inArray, nullptr);
+        if (elements == nullptr) {
+            conscrypt::jniutil::throwOutOfMemory(env, "Unable to pin inBytes");
+            return false;
+        }
+        int result = update(static_cast<const uint8_t*>(elements) + inOffset,
+                            static_cast<size_t>(window));
+        env->ReleasePrimitiveArrayCritical(inArray, elements, JNI_ABORT);
+        if (!result) {
+            return false;
+        }
+        inOffset += window;
+        inLength -= window;
+    }
+    return true;
+}
+
 static void evpUpdate(JNIEnv* env, jobject evpMdCtxRef, jbyteArray inJavaBytes, jint inOffset,
                       jint inLength, const char* jniName,
                       int (*update_func)(EVP_MD_CTX*, const void*, size_t)) {
@@ -2843,7 +3312,17 @@ static void evpUpdate(JNIEnv* env, jobject evpMdCtxRef, jbyteArray inJavaBytes,
     jint in_size = inLength;
 
     int update_func_result = -1;
-    if (conscrypt::jniutil::isGetByteArrayElementsLikelyToReturnACopy(array_size)) {
+    if (conscrypt::jniutil::useCriticalArrayAccess(static_cast<size_t>(in_size))) {
+        update_func_result = criticalArrayUpdate(
+                env, inJavaBytes, in_offset, in_size,
+                [mdCtx, update_func](const uint8_t* p, size_t len) {
+                    return update_func(mdCtx, p, len);
+                });
+        if (env->ExceptionCheck()) {
+            JNI_TRACE("ctx=%p %s => unable to pin array", mdCtx, jniName);
+            return;
+        }
+    } else if (conscrypt::jniutil::isGetByteArrayElementsLikelyToReturnACopy(array_size)) {
         // GetByteArrayElements is expected to return a copy. Use GetByteArrayRegion instead, to
         // avoid copying the whole array.
         if (in_size <= 1024) {
@@ -3370,6 +3849,60 @@ static void NativeCrypto_EVP_CipherInit_ex(JNIEnv* env, jclass, jobject ctxRef,
  *  public static native int EVP_CipherUpdate(long ctx, byte[] out, int outOffset, byte[] in,
  *          int inOffset, int inLength);
  */
+/**
+ * EVP_CipherUpdate over byte[]s pinned with GetPrimitiveArrayCritical, one window of at most
+ * kCriticalArrayWindow input bytes at a time, so large updates aren't copied in and out.
+ */
+static jint evpCipherUpdateCritical(JNIEnv* env, EVP_CIPHER_CTX* ctx, jbyteArray outArray,
+                                    jint outOffset, jbyteArray inArray, jint inOffset,
+                                    jint inLength) {
+    size_t in_size = static_cast<size_t>(env->GetArrayLength(inArray));
+    if (ARRAY_CHUNK_INVALID(in_size, inOffset, inLength)) {
+        conscrypt::jniutil::throwException(env, "java/lang/ArrayIndexOutOfBoundsException",
+                                           "inBytes");
+        return 0;
+    }
+    size_t out_size = static_cast<size_t>(env->GetArrayLength(outArray));
+    if (ARRAY_CHUNK_INVALID(out_size, outOffset, inLength)) {
+        conscrypt::jniutil::throwException(env, "java/lang/ArrayIndexOutOfBoundsException",
+                                           "outBytes");
+        return 0;
+    }
+
+    jint total = 0;
+    while (inLength > 0) {
+        jint window =
+                std::min(inLength, static_cast<jint>(conscrypt::jniutil::kCriticalArrayWindow));
+        void* inElements = env->GetPrimitiveArrayCritical(inArray, nullptr);
+        if (inElements == nullptr) {
+            conscrypt::jniutil::throwOutOfMemory(env, "Unable to pin inBytes");
+            return 0;
+        }
+        void* outElements = env->GetPrimitiveArrayCritical(outArray, nullptr);
+        if (outElements == nullptr) {
+            env->ReleasePrimitiveArrayCritical(inArray, inElements, JNI_ABORT);
+            conscrypt::jniutil::throwOutOfMemory(env, "Unable to pin outBytes");
+            return 0;
+        }
+        int outl;
+        int ok = EVP_CipherUpdate(ctx, static_cast<uint8_t*>(outElements) + outOffset + total,
+                                  &outl, static_cast<const uint8_t*>(inElements) + inOffset,
+                                  window);
+        env->ReleasePrimitiveArrayCritical(outArray, outElements, 0);
+        env->ReleasePrimitiveArrayCritical(inArray, inElements, JNI_ABORT);
+        if (!ok) {
+            conscrypt::jniutil::throwExceptionFromBoringSSLError(env, "EVP_CipherUpdate");
+            JNI_TRACE("ctx=%p EVP_CipherUpdate => threw error", ctx);
+            return 0;
+        }
+        total += outl;
+        inOffset += window;
+        inLength -= window;
+    }
+    JNI_TRACE("ctx=%p EVP_CipherUpdate pinned => %d", ctx, total);
+    return total;
+}
+
 static jint NativeCrypto_EVP_CipherUpdate(JNIEnv* env, jclass, jobject ctxRef, jbyteArray outArray,
                                           jint outOffset, jbyteArray inArray, jint inOffset,
                                           jint inLength) {
@@ -3382,6 +3915,12 @@ static jint NativeCrypto_EVP_CipherUpdate(JNIEnv* env, jclass, jobject ctxRef, j
         return 0;
     }
 
+    if (inArray != nullptr && outArray != nullptr && inLength > 0 &&
+        conscrypt::jniutil::useCriticalArrayAccess(static_cast<size_t>(inLength))) {
+        return evpCipherUpdateCritical(env, ctx, outArray, outOffset, inArray, inOffset,
+                                       inLength);
+    }
+
     ScopedByteArrayRO inBytes(env, inArray);
     if (inBytes.get() == nullptr) {
         return 0;
@@ -3423,6 +3962,70 @@ static jint NativeCrypto_EVP_CipherUpdate(JNIEnv* env, jclass, jobject ctxRef, j
     return outl;
 }
 
+/*
+ *  public static native int EVP_CipherUpdateDirect(long ctx, long outPtr, int outLength,
+ *          long inPtr, int inLength);
+ */
+static jint NativeCrypto_EVP_CipherUpdateDirect(JNIEnv* env, jclass, jobject ctxRef, jlong outPtr,
+                                                jint outLength, jlong inPtr, jint inLength) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    EVP_CIPHER_CTX* ctx = fromContextObject<EVP_CIPHER_CTX>(env, ctxRef);
+    uint8_t* out = reinterpret_cast<uint8_t*>(outPtr);
+    const uint8_t* in = reinterpret_cast<const uint8_t*>(inPtr);
+    JNI_TRACE("EVP_CipherUpdateDirect(%p, %p, %d, %p, %d)", ctx, out, outLength, in, inLength);
+
+    if (ctx == nullptr) {
+        JNI_TRACE("ctx=%p EVP_CipherUpdateDirect => ctx == null", ctx);
+        return 0;
+    }
+    if (in == nullptr || out == nullptr) {
+        conscrypt::jniutil::throwNullPointerException(env, nullptr);
+        return 0;
+    }
+    if (inLength < 0 || outLength < 0) {
+        conscrypt::jniutil::throwException(env, "java/lang/ArrayIndexOutOfBoundsException",
+                                           "length < 0");
+        return 0;
+    }
+
+    // Nothing checks the output against a Java array here, so refuse to run unless the most
+    // EVP_CipherUpdate could write, buffered bytes and a withheld final block included, fits.
+    size_t blockSize = EVP_CIPHER_CTX_block_size(ctx);
+    size_t maximumLen = static_cast<size_t>(inLength);
+    if (blockSize > 1) {
+        maximumLen += static_cast<size_t>(ctx->buf_len) + (ctx->final_used ? blockSize : 0);
+        maximumLen -= maximumLen % blockSize;
+    }
+    if (static_cast<size_t>(outLength) < maximumLen) {
+        conscrypt::jniutil::throwException(env, "java/lang/ArrayIndexOutOfBoundsException",
+                                           "outLength");
+        return 0;
+    }
+
+    // EVP_CipherUpdate works in place only when its output doesn't run ahead of its input,
+    // i.e. in == out with no buffered partial block or withheld final block. Anything else
+    // that overlaps is transformed from a copy of the input.
+    size_t inLen = static_cast<size_t>(inLength);
+    std::unique_ptr<uint8_t[]> inCopy;
+    bool inPlace = in == out && ctx->buf_len == 0 && !ctx->final_used;
+    if (!inPlace && buffersOverlap(in, inLen, out, static_cast<size_t>(outLength))) {
+        inCopy.reset(new uint8_t[inLen]);
+        memcpy(inCopy.get(), in, inLen);
+        in = inCopy.get();
+    }
+
+    int outl;
+    if (!EVP_CipherUpdate(ctx, out, &outl, in, inLength)) {
+        conscrypt::jniutil::throwExceptionFromBoringSSLError(env, "EVP_CipherUpdateDirect");
+        JNI_TRACE("ctx=%p EVP_CipherUpdateDirect => threw error", ctx);
+        return 0;
+    }
+
+    JNI_TRACE("EVP_CipherUpdateDirect(%p, %p, %d, %p, %d) => %d", ctx, out, outLength, in,
+              inLength, outl);
+    return outl;
+}
+
 static jint NativeCrypto_EVP_CipherFinal_ex(JNIEnv* env, jclass, jobject ctxRef,
                                             jbyteArray outArray, jint outOffset) {
     CHECK_ERROR_QUEUE_ON_RETURN;
@@ -3453,22 +4056,60 @@ static jint NativeCrypto_EVP_CipherFinal_ex(JNIEnv* env, jclass, jobject ctxRef,
     return outl;
 }
 
-static jint NativeCrypto_EVP_CIPHER_iv_length(JNIEnv* env, jclass, jlong evpCipherRef) {
+/*
+ *  public static native int EVP_CipherFinal_exDirect(long ctx, long outPtr, int outLength);
+ */
+static jint NativeCrypto_EVP_CipherFinal_exDirect(JNIEnv* env, jclass, jobject ctxRef,
+                                                  jlong outPtr, jint outLength) {
     CHECK_ERROR_QUEUE_ON_RETURN;
-    const EVP_CIPHER* evpCipher = reinterpret_cast<const EVP_CIPHER*>(evpCipherRef);
-    JNI_TRACE("EVP_CIPHER_iv_length(%p)", evpCipher);
+    EVP_CIPHER_CTX* ctx = fromContextObject<EVP_CIPHER_CTX>(env, ctxRef);
+    uint8_t* out = reinterpret_cast<uint8_t*>(outPtr);
+    JNI_TRACE("EVP_CipherFinal_exDirect(%p, %p, %d)", ctx, out, outLength);
 
-    if (evpCipher == nullptr) {
-        conscrypt::jniutil::throwNullPointerException(env, "evpCipher == null");
-        JNI_TRACE("EVP_CIPHER_iv_length => evpCipher == null");
+    if (ctx == nullptr) {
+        JNI_TRACE("ctx=%p EVP_CipherFinal_exDirect => ctx == null", ctx);
+        return 0;
+    }
+    if (out == nullptr) {
+        conscrypt::jniutil::throwNullPointerException(env, nullptr);
+        return 0;
+    }
+    // EVP_CipherFinal_ex writes at most one block.
+    if (outLength < 0 ||
+        static_cast<size_t>(outLength) < static_cast<size_t>(EVP_CIPHER_CTX_block_size(ctx))) {
+        conscrypt::jniutil::throwException(env, "java/lang/ArrayIndexOutOfBoundsException",
+                                           "outLength");
         return 0;
     }
 
-    jint ivLength = static_cast<jint>(EVP_CIPHER_iv_length(evpCipher));
-    JNI_TRACE("EVP_CIPHER_iv_length(%p) => %d", evpCipher, ivLength);
-    return ivLength;
-}
-
+    int outl;
+    if (!EVP_CipherFinal_ex(ctx, out, &outl)) {
+        conscrypt::jniutil::throwExceptionFromBoringSSLError(env, "EVP_CipherFinal_exDirect",
+                conscrypt::jniutil::throwBadPaddingException);
+        JNI_TRACE("ctx=%p EVP_CipherFinal_exDirect => threw error", ctx);
+        return 0;
+    }
+
+    JNI_TRACE("EVP_CipherFinal_exDirect(%p, %p, %d) => %d", ctx, out, outLength, outl);
+    return outl;
+}
+
+static jint NativeCrypto_EVP_CIPHER_iv_length(JNIEnv* env, jclass, jlong evpCipherRef) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    const EVP_CIPHER* evpCipher = reinterpret_cast<const EVP_CIPHER*>(evpCipherRef);
+    JNI_TRACE("EVP_CIPHER_iv_length(%p)", evpCipher);
+
+    if (evpCipher == nullptr) {
+        conscrypt::jniutil::throwNullPointerException(env, "evpCipher == null");
+        JNI_TRACE("EVP_CIPHER_iv_length => evpCipher == null");
+        return 0;
+    }
+
+    jint ivLength = static_cast<jint>(EVP_CIPHER_iv_length(evpCipher));
+    JNI_TRACE("EVP_CIPHER_iv_length(%p) => %d", evpCipher, ivLength);
+    return ivLength;
+}
+
 static jlong NativeCrypto_EVP_CIPHER_CTX_new(JNIEnv* env, jclass) {
     CHECK_ERROR_QUEUE_ON_RETURN;
     JNI_TRACE("EVP_CIPHER_CTX_new()");
@@ -3639,17 +4280,18 @@ typedef int (*evp_aead_ctx_op_func)(const EVP_AEAD_CTX* ctx, uint8_t* out, size_
                                     const uint8_t* in, size_t in_len, const uint8_t* ad,
                                     size_t ad_len);
 
-static jint evp_aead_ctx_op_common(JNIEnv* env, jlong evpAeadRef, jbyteArray keyArray, jint tagLen,
+/**
+ * Runs |realFunc| over the given input and output. If |preparedCtx| is not null it is used
+ * directly, otherwise a temporary context is initialized from |evpAeadRef|, |keyArray| and
+ * |tagLen| for the duration of the call.
+ */
+static jint evp_aead_ctx_op_common(JNIEnv* env, const EVP_AEAD_CTX* preparedCtx, jlong evpAeadRef,
+                               jbyteArray keyArray, jint tagLen,
                                uint8_t* outBuf, jbyteArray nonceArray,
                                const uint8_t* inBuf, jbyteArray aadArray,
                                evp_aead_ctx_op_func realFunc, jobject inBuffer, jobject outBuffer, jint outRange, jint inRange)  {
     const EVP_AEAD* evpAead = reinterpret_cast<const EVP_AEAD*>(evpAeadRef);
 
-    ScopedByteArrayRO keyBytes(env, keyArray);
-    if (keyBytes.get() == nullptr) {
-        return 0;
-    }
-
     std::unique_ptr<ScopedByteArrayRO> aad;
     const uint8_t* aad_chars = nullptr;
     size_t aad_chars_size = 0;
@@ -3668,22 +4310,31 @@ static jint evp_aead_ctx_op_common(JNIEnv* env, jlong evpAeadRef, jbyteArray key
     }
 
     bssl::ScopedEVP_AEAD_CTX aeadCtx;
-    const uint8_t* keyTmp = reinterpret_cast<const uint8_t*>(keyBytes.get());
-    if (!EVP_AEAD_CTX_init(aeadCtx.get(), evpAead, keyTmp, keyBytes.size(),
-                           static_cast<size_t>(tagLen), nullptr)) {
-        conscrypt::jniutil::throwExceptionFromBoringSSLError(env,
-                                                             "failure initializing AEAD context");
-        JNI_TRACE(
-                "evp_aead_ctx_op(%p, %p, %d, %p, %p, %p, %p) => fail EVP_AEAD_CTX_init",
-                evpAead, keyArray, tagLen, outBuffer, nonceArray, inBuffer,
-                aadArray);
-        return 0;
+    const EVP_AEAD_CTX* ctx = preparedCtx;
+    if (ctx == nullptr) {
+        ScopedByteArrayRO keyBytes(env, keyArray);
+        if (keyBytes.get() == nullptr) {
+            return 0;
+        }
+
+        const uint8_t* keyTmp = reinterpret_cast<const uint8_t*>(keyBytes.get());
+        if (!EVP_AEAD_CTX_init(aeadCtx.get(), evpAead, keyTmp, keyBytes.size(),
+                               static_cast<size_t>(tagLen), nullptr)) {
+            conscrypt::jniutil::throwExceptionFromBoringSSLError(env,
+                                                                 "failure initializing AEAD context");
+            JNI_TRACE(
+                    "evp_aead_ctx_op(%p, %p, %d, %p, %p, %p, %p) => fail EVP_AEAD_CTX_init",
+                    evpAead, keyArray, tagLen, outBuffer, nonceArray, inBuffer,
+                    aadArray);
+            return 0;
+        }
+        ctx = aeadCtx.get();
     }
 
     const uint8_t* nonceTmp = reinterpret_cast<const uint8_t*>(nonceBytes.get());
     size_t actualOutLength;
 
-    if (!realFunc(aeadCtx.get(), outBuf, &actualOutLength, outRange,
+    if (!realFunc(ctx, outBuf, &actualOutLength, outRange,
                   nonceTmp, nonceBytes.size(), inBuf, static_cast<size_t>(inRange),
                   aad_chars, aad_chars_size)) {
         conscrypt::jniutil::throwExceptionFromBoringSSLError(env, "evp_aead_ctx_op");
@@ -3696,8 +4347,8 @@ static jint evp_aead_ctx_op_common(JNIEnv* env, jlong evpAeadRef, jbyteArray key
     return static_cast<jint>(actualOutLength);
 }
 
-static jint evp_aead_ctx_op(JNIEnv* env, jlong evpAeadRef, jbyteArray keyArray, jint tagLen,
-                            jbyteArray outArray, jint outOffset, jbyteArray nonceArray,
+static jint evp_aead_ctx_op(JNIEnv* env, const EVP_AEAD_CTX* preparedCtx, jlong evpAeadRef,
+                            jbyteArray keyArray, jint tagLen, jbyteArray outArray, jint outOffset, jbyteArray nonceArray,
                             jbyteArray inArray, jint inOffset, jint inLength, jbyteArray aadArray,
                             evp_aead_ctx_op_func realFunc) {
     const EVP_AEAD* evpAead = reinterpret_cast<const EVP_AEAD*>(evpAeadRef);
@@ -3736,12 +4387,12 @@ static jint evp_aead_ctx_op(JNIEnv* env, jlong evpAeadRef, jbyteArray keyArray,
     uint8_t* outTmp = reinterpret_cast<uint8_t*>(outBytes.get());
     const uint8_t* inTmp = reinterpret_cast<const uint8_t*>(inBytes.get());
 
-    return evp_aead_ctx_op_common(env, evpAeadRef, keyArray, tagLen, outTmp + outOffset, nonceArray, inTmp + inOffset,
+    return evp_aead_ctx_op_common(env, preparedCtx, evpAeadRef, keyArray, tagLen, outTmp + outOffset, nonceArray, inTmp + inOffset,
                             aadArray, realFunc, inArray, outArray, outBytes.size() - outOffset, inLength);
 }
 
-static jint evp_aead_ctx_op_buf(JNIEnv* env, jlong evpAeadRef, jbyteArray keyArray, jint tagLen,
-                            jobject outBuffer, jbyteArray nonceArray,
+static jint evp_aead_ctx_op_buf(JNIEnv* env, const EVP_AEAD_CTX* preparedCtx, jlong evpAeadRef,
+                            jbyteArray keyArray, jint tagLen, jobject outBuffer, jbyteArray nonceArray,
                             jobject inBuffer, jbyteArray aadArray,
                             evp_aead_ctx_op_func realFunc) {
 
@@ -3761,31 +4412,17 @@ static jint evp_aead_ctx_op_buf(JNIEnv* env, jlong evpAeadRef, jbyteArray keyArr
         return 0;
     }
 
-    uint8_t* inBuf;
-    jint in_limit;
-    jint in_position;
-
-    inBuf = (uint8_t*)(env->GetDirectBufferAddress(inBuffer));
-     // limit is the index of the first element that should not be read or written
-    in_limit = env->CallIntMethod(inBuffer,conscrypt::jniutil::buffer_limitMethod);
-    // position is the index of the next element to be read or written
-    in_position = env->CallIntMethod(inBuffer,conscrypt::jniutil::buffer_positionMethod);
-
-    uint8_t* outBuf;
-    jint out_limit;
-    jint out_position;
-    outBuf = (uint8_t*)(env->GetDirectBufferAddress(outBuffer));
-    // limit is the index of the first element that should not be read or written
-    out_limit = env->CallIntMethod(outBuffer,conscrypt::jniutil::buffer_limitMethod);
-    // position is the index of the next element to be read or written
-    out_position = env->CallIntMethod(outBuffer,conscrypt::jniutil::buffer_positionMethod);
-
-    // Shifting over of ByteBuffer address to start at true position
-    inBuf += in_position;
-    outBuf += out_position;
+    size_t inSize;
+    uint8_t* inBuf = conscrypt::jniutil::getDirectBufferRemaining(env, inBuffer, &inSize);
+    size_t outSize;
+    uint8_t* outBuf = conscrypt::jniutil::getDirectBufferRemaining(env, outBuffer, &outSize);
+    if (inBuf == nullptr || outBuf == nullptr) {
+        conscrypt::jniutil::throwException(env, "java/lang/IllegalArgumentException",
+                                           "buffer contents are not accessible");
+        return 0;
+    }
 
-    size_t inSize = in_limit - in_position;
-    uint8_t* outBufEnd = outBuf + out_limit - out_position;
+    uint8_t* outBufEnd = outBuf + outSize;
     uint8_t* inBufEnd = inBuf + inSize;
     std::unique_ptr<uint8_t[]> inCopy;
     if (outBufEnd >= inBuf && inBufEnd >= outBuf) { // We have an overlap
@@ -3798,8 +4435,8 @@ static jint evp_aead_ctx_op_buf(JNIEnv* env, jlong evpAeadRef, jbyteArray keyArr
         inBuf = inCopy.get();
     }
 
-    return evp_aead_ctx_op_common(env, evpAeadRef, keyArray, tagLen, outBuf, nonceArray, inBuf, aadArray, realFunc,
-                               inBuffer, outBuffer, out_limit-out_position, in_limit-in_position);
+    return evp_aead_ctx_op_common(env, preparedCtx, evpAeadRef, keyArray, tagLen, outBuf, nonceArray, inBuf, aadArray, realFunc,
+                               inBuffer, outBuffer, static_cast<jint>(outSize), static_cast<jint>(inSize));
 }
 
 static jint NativeCrypto_EVP_AEAD_CTX_seal(JNIEnv* env, jclass, jlong evpAeadRef,
@@ -3808,7 +4445,7 @@ static jint NativeCrypto_EVP_AEAD_CTX_seal(JNIEnv* env, jclass, jlong evpAeadRef
                                            jbyteArray inArray, jint inOffset, jint inLength,
                                            jbyteArray aadArray) {
     CHECK_ERROR_QUEUE_ON_RETURN;
-    return evp_aead_ctx_op(env, evpAeadRef, keyArray, tagLen, outArray, outOffset, nonceArray,
+    return evp_aead_ctx_op(env, nullptr, evpAeadRef, keyArray, tagLen, outArray, outOffset, nonceArray,
                            inArray, inOffset, inLength, aadArray, EVP_AEAD_CTX_seal);
 }
 
@@ -3818,7 +4455,7 @@ static jint NativeCrypto_EVP_AEAD_CTX_open(JNIEnv* env, jclass, jlong evpAeadRef
                                            jbyteArray inArray, jint inOffset, jint inLength,
                                            jbyteArray aadArray) {
     CHECK_ERROR_QUEUE_ON_RETURN;
-    return evp_aead_ctx_op(env, evpAeadRef, keyArray, tagLen, outArray, outOffset, nonceArray,
+    return evp_aead_ctx_op(env, nullptr, evpAeadRef, keyArray, tagLen, outArray, outOffset, nonceArray,
                            inArray, inOffset, inLength, aadArray, EVP_AEAD_CTX_open);
 }
 
@@ -3826,7 +4463,7 @@ static jint NativeCrypto_EVP_AEAD_CTX_seal_buf(JNIEnv* env, jclass, jlong evpAea
                                            jbyteArray keyArray, jint tagLen, jobject outBuffer,
                                            jbyteArray nonceArray, jobject inBuffer, jbyteArray aadArray) {
     CHECK_ERROR_QUEUE_ON_RETURN;
-    return evp_aead_ctx_op_buf(env, evpAeadRef, keyArray, tagLen, outBuffer, nonceArray,
+    return evp_aead_ctx_op_buf(env, nullptr, evpAeadRef, keyArray, tagLen, outBuffer, nonceArray,
                            inBuffer, aadArray, EVP_AEAD_CTX_seal);
 }
 
@@ -3834,10 +4471,234 @@ static jint NativeCrypto_EVP_AEAD_CTX_open_buf(JNIEnv* env, jclass, jlong evpAea
                                            jbyteArray keyArray, jint tagLen, jobject outBuffer,
                                            jbyteArray nonceArray, jobject inBuffer, jbyteArray aadArray) {
     CHECK_ERROR_QUEUE_ON_RETURN;
-    return evp_aead_ctx_op_buf(env, evpAeadRef, keyArray, tagLen, outBuffer, nonceArray,
+    return evp_aead_ctx_op_buf(env, nullptr, evpAeadRef, keyArray, tagLen, outBuffer, nonceArray,
                            inBuffer, aadArray, EVP_AEAD_CTX_open);
 }
 
+static jlong NativeCrypto_EVP_AEAD_CTX_new(JNIEnv* env, jclass, jlong evpAeadRef,
+                                           jbyteArray keyArray, jint tagLen) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    const EVP_AEAD* evpAead = reinterpret_cast<const EVP_AEAD*>(evpAeadRef);
+    JNI_TRACE("EVP_AEAD_CTX_new(%p, %p, %d)", evpAead, keyArray, tagLen);
+
+    if (evpAead == nullptr) {
+        conscrypt::jniutil::throwNullPointerException(env, "evpAead == null");
+        return 0;
+    }
+
+    ScopedByteArrayRO keyBytes(env, keyArray);
+    if (keyBytes.get() == nullptr) {
+        return 0;
+    }
+
+    EVP_AEAD_CTX* ctx = EVP_AEAD_CTX_new(evpAead, reinterpret_cast<const uint8_t*>(keyBytes.get()),
+                                         keyBytes.size(), static_cast<size_t>(tagLen));
+    if (ctx == nullptr) {
+        conscrypt::jniutil::throwExceptionFromBoringSSLError(env,
+                                                             "failure initializing AEAD context");
+        JNI_TRACE("EVP_AEAD_CTX_new(%p, %p, %d) => fail", evpAead, keyArray, tagLen);
+        return 0;
+    }
+
+    JNI_TRACE("EVP_AEAD_CTX_new(%p, %p, %d) => %p", evpAead, keyArray, tagLen, ctx);
+    return reinterpret_cast<uintptr_t>(ctx);
+}
+
+static void NativeCrypto_EVP_AEAD_CTX_free(JNIEnv* env, jclass, jlong ctxRef) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    EVP_AEAD_CTX* ctx = reinterpret_cast<EVP_AEAD_CTX*>(ctxRef);
+    JNI_TRACE("EVP_AEAD_CTX_free(%p)", ctx);
+
+    EVP_AEAD_CTX_free(ctx);
+}
+
+static jint NativeCrypto_EVP_AEAD_CTX_seal_ctx(JNIEnv* env, jclass, jobject aeadCtxRef,
+                                               jbyteArray outArray, jint outOffset,
+                                               jbyteArray nonceArray, jbyteArray inArray,
+                                               jint inOffset, jint inLength, jbyteArray aadArray) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    EVP_AEAD_CTX* ctx = fromContextObject<EVP_AEAD_CTX>(env, aeadCtxRef);
+    if (ctx == nullptr) {
+        // NullPointerException thrown while calling fromContextObject
+        return 0;
+    }
+    return evp_aead_ctx_op(env, ctx, 0, nullptr, 0, outArray, outOffset, nonceArray, inArray,
+                           inOffset, inLength, aadArray, EVP_AEAD_CTX_seal);
+}
+
+static jint NativeCrypto_EVP_AEAD_CTX_open_ctx(JNIEnv* env, jclass, jobject aeadCtxRef,
+                                               jbyteArray outArray, jint outOffset,
+                                               jbyteArray nonceArray, jbyteArray inArray,
+                                               jint inOffset, jint inLength, jbyteArray aadArray) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    EVP_AEAD_CTX* ctx = fromContextObject<EVP_AEAD_CTX>(env, aeadCtxRef);
+    if (ctx == nullptr) {
+        // NullPointerException thrown while calling fromContextObject
+        return 0;
+    }
+    return evp_aead_ctx_op(env, ctx, 0, nullptr, 0, outArray, outOffset, nonceArray, inArray,
+                           inOffset, inLength, aadArray, EVP_AEAD_CTX_open);
+}
+
+static jint NativeCrypto_EVP_AEAD_CTX_seal_ctx_buf(JNIEnv* env, jclass, jobject aeadCtxRef,
+                                                   jobject outBuffer, jbyteArray nonceArray,
+                                                   jobject inBuffer, jbyteArray aadArray) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    EVP_AEAD_CTX* ctx = fromContextObject<EVP_AEAD_CTX>(env, aeadCtxRef);
+    if (ctx == nullptr) {
+        // NullPointerException thrown while calling fromContextObject
+        return 0;
+    }
+    return evp_aead_ctx_op_buf(env, ctx, 0, nullptr, 0, outBuffer, nonceArray, inBuffer,
+                               aadArray, EVP_AEAD_CTX_seal);
+}
+
+static jint NativeCrypto_EVP_AEAD_CTX_open_ctx_buf(JNIEnv* env, jclass, jobject aeadCtxRef,
+                                                   jobject outBuffer, jbyteArray nonceArray,
+                                                   jobject inBuffer, jbyteArray aadArray) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    EVP_AEAD_CTX* ctx = fromContextObject<EVP_AEAD_CTX>(env, aeadCtxRef);
+    if (ctx == nullptr) {
+        // NullPointerException thrown while calling fromContextObject
+        return 0;
+    }
+    return evp_aead_ctx_op_buf(env, ctx, 0, nullptr, 0, outBuffer, nonceArray, inBuffer,
+                               aadArray, EVP_AEAD_CTX_open);
+}
+
+// Layout of each record in the descriptor array passed to the batch AEAD functions. All offsets
+// are absolute positions in the direct buffer, which holds inputs, outputs, nonces and AADs.
+enum {
+    kAeadBatchInOffset = 0,
+    kAeadBatchInLength,
+    kAeadBatchOutOffset,
+    kAeadBatchOutLength,
+    kAeadBatchNonceOffset,
+    kAeadBatchNonceLength,
+    kAeadBatchAadOffset,
+    kAeadBatchAadLength,
+    kAeadBatchRecordSize,
+};
+
+static bool aead_batch_ranges_overlap(jint offset1, jint length1, jint offset2, jint length2) {
+    return offset1 < offset2 + length2 && offset2 < offset1 + length1;
+}
+
+/**
+ * Runs |realFunc| over every record described by |recordsArray| without leaving native code.
+ * The output length of each record is stored in |outLengthsArray|, or -1 if that record failed,
+ * and the number of records that succeeded is returned. Malformed descriptors are rejected with
+ * an exception before any record is processed.
+ */
+static jint evp_aead_ctx_op_batch(JNIEnv* env, jobject aeadCtxRef, jobject buffer,
+                                  jintArray recordsArray, jintArray outLengthsArray,
+                                  evp_aead_ctx_op_func realFunc) {
+    EVP_AEAD_CTX* ctx = fromContextObject<EVP_AEAD_CTX>(env, aeadCtxRef);
+    JNI_TRACE("evp_aead_ctx_op_batch(%p, %p, %p, %p)", ctx, buffer, recordsArray,
+              outLengthsArray);
+    if (ctx == nullptr) {
+        // NullPointerException thrown while calling fromContextObject
+        return 0;
+    }
+
+    if (!conscrypt::jniutil::isDirectByteBufferInstance(env, buffer)) {
+        conscrypt::jniutil::throwException(env, "java/lang/IllegalArgumentException",
+                                           "buffer is not a direct ByteBuffer");
+        return 0;
+    }
+
+    ScopedIntArrayRO records(env, recordsArray);
+    if (records.get() == nullptr) {
+        return 0;
+    }
+    ScopedIntArrayRW outLengths(env, outLengthsArray);
+    if (outLengths.get() == nullptr) {
+        return 0;
+    }
+
+    if (records.size() % kAeadBatchRecordSize != 0) {
+        conscrypt::jniutil::throwException(env, "java/lang/IllegalArgumentException",
+                                           "records.length is not a multiple of the record size");
+        return 0;
+    }
+    size_t numRecords = records.size() / kAeadBatchRecordSize;
+    if (outLengths.size() < numRecords) {
+        conscrypt::jniutil::throwException(env, "java/lang/ArrayIndexOutOfBoundsException",
+                                           "outLengths");
+        return 0;
+    }
+
+    uint8_t* base = reinterpret_cast<uint8_t*>(env->GetDirectBufferAddress(buffer));
+    jlong capacity = env->GetDirectBufferCapacity(buffer);
+    if (base == nullptr || capacity < 0) {
+        conscrypt::jniutil::throwException(env, "java/lang/IllegalArgumentException",
+                                           "buffer is not accessible");
+        return 0;
+    }
+
+    for (size_t i = 0; i < numRecords; i++) {
+        const jint* record = records.get() + i * kAeadBatchRecordSize;
+        for (size_t field = 0; field < kAeadBatchRecordSize; field += 2) {
+            if (ARRAY_CHUNK_INVALID(capacity, record[field], record[field + 1])) {
+                JNI_TRACE("evp_aead_ctx_op_batch(%p) => record %zu out of bounds", ctx, i);
+                conscrypt::jniutil::throwException(
+                        env, "java/lang/ArrayIndexOutOfBoundsException", "records");
+                return 0;
+            }
+        }
+        // BoringSSL allows the output to alias the input exactly, but not partially.
+        if (record[kAeadBatchInOffset] != record[kAeadBatchOutOffset] &&
+            aead_batch_ranges_overlap(record[kAeadBatchInOffset], record[kAeadBatchInLength],
+                                      record[kAeadBatchOutOffset],
+                                      record[kAeadBatchOutLength])) {
+            conscrypt::jniutil::throwException(env, "java/lang/IllegalArgumentException",
+                                               "in and out must not partially overlap");
+            return 0;
+        }
+    }
+
+    jint succeeded = 0;
+    for (size_t i = 0; i < numRecords; i++) {
+        const jint* record = records.get() + i * kAeadBatchRecordSize;
+        size_t actualOutLength;
+        if (realFunc(ctx, base + record[kAeadBatchOutOffset], &actualOutLength,
+                     static_cast<size_t>(record[kAeadBatchOutLength]),
+                     base + record[kAeadBatchNonceOffset],
+                     static_cast<size_t>(record[kAeadBatchNonceLength]),
+                     base + record[kAeadBatchInOffset],
+                     static_cast<size_t>(record[kAeadBatchInLength]),
+                     base + record[kAeadBatchAadOffset],
+                     static_cast<size_t>(record[kAeadBatchAadLength]))) {
+            outLengths[i] = static_cast<jint>(actualOutLength);
+            succeeded++;
+        } else {
+            // A failed record, e.g. one with a bad tag, must not affect the others.
+            outLengths[i] = -1;
+            ERR_clear_error();
+        }
+    }
+
+    JNI_TRACE("evp_aead_ctx_op_batch(%p) => %d of %zu records succeeded", ctx, succeeded,
+              numRecords);
+    return succeeded;
+}
+
+static jint NativeCrypto_EVP_AEAD_CTX_seal_batch(JNIEnv* env, jclass, jobject aeadCtxRef,
+                                                 jobject buffer, jintArray recordsArray,
+                                                 jintArray outLengthsArray) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    return evp_aead_ctx_op_batch(env, aeadCtxRef, buffer, recordsArray, outLengthsArray,
+                                 EVP_AEAD_CTX_seal);
+}
+
+static jint NativeCrypto_EVP_AEAD_CTX_open_batch(JNIEnv* env, jclass, jobject aeadCtxRef,
+                                                 jobject buffer, jintArray recordsArray,
+                                                 jintArray outLengthsArray) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    return evp_aead_ctx_op_batch(env, aeadCtxRef, buffer, recordsArray, outLengthsArray,
+                                 EVP_AEAD_CTX_open);
+}
+
 static jbyteArray NativeCrypto_EVP_HPKE_CTX_export(JNIEnv* env, jclass, jobject hpkeCtxRef,
                                                    jbyteArray exporterCtxArray, jint exportedLen) {
     CHECK_ERROR_QUEUE_ON_RETURN;
@@ -4115,9 +4976,9 @@ static jobject NativeCrypto_EVP_HPKE_CTX_setup_base_mode_recipient(JNIEnv* env,
     }
 
     ScopedLocalRef<jobject> ctxObject(
-                    env, env->NewObject(conscrypt::jniutil::nativeRefHpkeCtxClass,
-                                        conscrypt::jniutil::nativeRefHpkeCtxClass_constructor,
-                                        reinterpret_cast<jlong>(ctx.release())));
+            env, env->NewObject(conscrypt::jniutil::nativeRefHpkeCtxClass.get(env),
+                                conscrypt::jniutil::nativeRefHpkeCtxClass_constructor.get(env),
+                                reinterpret_cast<jlong>(ctx.release())));
     return ctxObject.release();
 }
 
@@ -4195,9 +5056,9 @@ static jobjectArray NativeCrypto_EVP_HPKE_CTX_setup_base_mode_sender(JNIEnv* env
             env, env->NewObjectArray(2, conscrypt::jniutil::objectClass, nullptr));
 
     ScopedLocalRef<jobject> ctxObject(
-                env, env->NewObject(conscrypt::jniutil::nativeRefHpkeCtxClass,
-                                    conscrypt::jniutil::nativeRefHpkeCtxClass_constructor,
-                                    reinterpret_cast<jlong>(ctx.release())));
+            env, env->NewObject(conscrypt::jniutil::nativeRefHpkeCtxClass.get(env),
+                                conscrypt::jniutil::nativeRefHpkeCtxClass_constructor.get(env),
+                                reinterpret_cast<jlong>(ctx.release())));
 
     env->SetObjectArrayElement(result.get(), 0, ctxObject.release());
     env->SetObjectArrayElement(result.get(), 1, encArray.release());
@@ -4283,9 +5144,9 @@ static jobjectArray NativeCrypto_EVP_HPKE_CTX_setup_base_mode_sender_with_seed_f
             env, env->NewObjectArray(2, conscrypt::jniutil::objectClass, nullptr));
 
     ScopedLocalRef<jobject> ctxObject(
-                    env, env->NewObject(conscrypt::jniutil::nativeRefHpkeCtxClass,
-                                        conscrypt::jniutil::nativeRefHpkeCtxClass_constructor,
-                                        reinterpret_cast<jlong>(ctx.release())));
+            env, env->NewObject(conscrypt::jniutil::nativeRefHpkeCtxClass.get(env),
+                                conscrypt::jniutil::nativeRefHpkeCtxClass_constructor.get(env),
+                                reinterpret_cast<jlong>(ctx.release())));
 
     env->SetObjectArrayElement(result.get(), 0, ctxObject.release());
     env->SetObjectArrayElement(result.get(), 1, encArray.release());
@@ -4387,6 +5248,24 @@ static void NativeCrypto_CMAC_Update(JNIEnv* env, jclass, jobject cmacCtxRef, jb
         return;
     }
 
+    if (inArray != nullptr && inLength > 0 &&
+        conscrypt::jniutil::useCriticalArrayAccess(static_cast<size_t>(inLength))) {
+        size_t array_size = static_cast<size_t>(env->GetArrayLength(inArray));
+        if (ARRAY_CHUNK_INVALID(array_size, inOffset, inLength)) {
+            conscrypt::jniutil::throwException(env, "java/lang/ArrayIndexOutOfBoundsException",
+                                               "inBytes");
+            return;
+        }
+        if (!criticalArrayUpdate(env, inArray, inOffset, inLength,
+                                 [cmacCtx](const uint8_t* p, size_t len) {
+                                     return CMAC_Update(cmacCtx, p, len);
+                                 }) &&
+            !env->ExceptionCheck()) {
+            conscrypt::jniutil::throwExceptionFromBoringSSLError(env, "CMAC_Update");
+        }
+        return;
+    }
+
     ScopedByteArrayRO inBytes(env, inArray);
     if (inBytes.get() == nullptr) {
         return;
@@ -4531,6 +5410,24 @@ static void NativeCrypto_HMAC_Update(JNIEnv* env, jclass, jobject hmacCtxRef, jb
         return;
     }
 
+    if (inArray != nullptr && inLength > 0 &&
+        conscrypt::jniutil::useCriticalArrayAccess(static_cast<size_t>(inLength))) {
+        size_t array_size = static_cast<size_t>(env->GetArrayLength(inArray));
+        if (ARRAY_CHUNK_INVALID(array_size, inOffset, inLength)) {
+            conscrypt::jniutil::throwException(env, "java/lang/ArrayIndexOutOfBoundsException",
+                                               "inBytes");
+            return;
+        }
+        if (!criticalArrayUpdate(env, inArray, inOffset, inLength,
+                                 [hmacCtx](const uint8_t* p, size_t len) {
+                                     return HMAC_Update(hmacCtx, p, len);
+                                 }) &&
+            !env->ExceptionCheck()) {
+            conscrypt::jniutil::throwExceptionFromBoringSSLError(env, "HMAC_Update");
+        }
+        return;
+    }
+
     ScopedByteArrayRO inBytes(env, inArray);
     if (inBytes.get() == nullptr) {
         return;
@@ -4598,82 +5495,413 @@ static void NativeCrypto_HMAC_Reset(JNIEnv* env, jclass, jobject hmacCtxRef) {
     }
 }
 
-static void NativeCrypto_RAND_bytes(JNIEnv* env, jclass, jbyteArray output) {
-    CHECK_ERROR_QUEUE_ON_RETURN;
-    JNI_TRACE("NativeCrypto_RAND_bytes(%p)", output);
+// Prepared MAC keys are contexts that were initialized with a key and are never updated
+// afterwards. Each one-shot MAC works on a private copy of the keyed state, so a prepared key
+// can be shared by any number of threads and the key schedule is only derived once.
 
-    ScopedByteArrayRW outputBytes(env, output);
-    if (outputBytes.get() == nullptr) {
-        return;
+/**
+ * Feeds inArray[inOffset, inOffset + inLength) to update, straight from the Java heap when
+ * useCriticalArrayAccess allows it and from a copy otherwise. Returns false with an exception
+ * pending on failure, naming jniName if update itself failed.
+ */
+template <typename UpdateFunc>
+static bool macArrayUpdate(JNIEnv* env, jbyteArray inArray, jint inOffset, jint inLength,
+                           const char* jniName, UpdateFunc update) {
+    if (inArray == nullptr) {
+        conscrypt::jniutil::throwNullPointerException(env, "in == null");
+        return false;
     }
-
-    unsigned char* tmp = reinterpret_cast<unsigned char*>(outputBytes.get());
-    if (RAND_bytes(tmp, outputBytes.size()) <= 0) {
-        conscrypt::jniutil::throwExceptionFromBoringSSLError(env, "NativeCrypto_RAND_bytes");
-        JNI_TRACE("tmp=%p NativeCrypto_RAND_bytes => threw error", tmp);
-        return;
+    size_t array_size = static_cast<size_t>(env->GetArrayLength(inArray));
+    if (ARRAY_CHUNK_INVALID(array_size, inOffset, inLength)) {
+        conscrypt::jniutil::throwException(env, "java/lang/ArrayIndexOutOfBoundsException",
+                                           "inBytes");
+        return false;
     }
 
-    JNI_TRACE("NativeCrypto_RAND_bytes(%p) => success", output);
+    bool ok;
+    if (inLength > 0 &&
+        conscrypt::jniutil::useCriticalArrayAccess(static_cast<size_t>(inLength))) {
+        ok = criticalArrayUpdate(env, inArray, inOffset, inLength, update);
+        if (env->ExceptionCheck()) {
+            return false;
+        }
+    } else {
+        ScopedByteArrayRO inBytes(env, inArray);
+        if (inBytes.get() == nullptr) {
+            return false;
+        }
+        ok = update(reinterpret_cast<const uint8_t*>(inBytes.get()) + inOffset,
+                    static_cast<size_t>(inLength));
+    }
+    if (!ok) {
+        conscrypt::jniutil::throwExceptionFromBoringSSLError(env, jniName);
+        return false;
+    }
+    return true;
 }
 
-static jstring ASN1_OBJECT_to_OID_string(JNIEnv* env, const ASN1_OBJECT* obj) {
-    /*
-     * The OBJ_obj2txt API doesn't "measure" if you pass in nullptr as the buffer.
-     * Just make a buffer that's large enough here. The documentation recommends
-     * 80 characters.
-     */
-    char output[128];
-    int ret = OBJ_obj2txt(output, sizeof(output), obj, 1);
-    if (ret < 0) {
-        conscrypt::jniutil::throwExceptionFromBoringSSLError(env, "ASN1_OBJECT_to_OID_string");
-        return nullptr;
-    } else if (size_t(ret) >= sizeof(output)) {
-        conscrypt::jniutil::throwRuntimeException(env,
-                                                  "ASN1_OBJECT_to_OID_string buffer too small");
+static jbyteArray macResultToArray(JNIEnv* env, const uint8_t* result, size_t len) {
+    ScopedLocalRef<jbyteArray> resultArray(env, env->NewByteArray(static_cast<jsize>(len)));
+    if (resultArray.get() == nullptr) {
         return nullptr;
     }
-
-    JNI_TRACE("ASN1_OBJECT_to_OID_string(%p) => %s", obj, output);
-    return env->NewStringUTF(output);
+    env->SetByteArrayRegion(resultArray.get(), 0, static_cast<jsize>(len),
+                            reinterpret_cast<const jbyte*>(result));
+    return resultArray.release();
 }
 
-static jlong NativeCrypto_create_BIO_InputStream(JNIEnv* env, jclass, jobject streamObj,
-                                                 jboolean isFinite) {
+static jlong NativeCrypto_HMAC_PREPARED_KEY_new(JNIEnv* env, jclass, jbyteArray keyArray,
+                                                jlong evpMdRef) {
     CHECK_ERROR_QUEUE_ON_RETURN;
-    JNI_TRACE("create_BIO_InputStream(%p)", streamObj);
-
-    if (streamObj == nullptr) {
-        conscrypt::jniutil::throwNullPointerException(env, "stream == null");
+    const EVP_MD* md = reinterpret_cast<const EVP_MD*>(evpMdRef);
+    JNI_TRACE("HMAC_PREPARED_KEY_new(%p, %p)", keyArray, md);
+    if (keyArray == nullptr) {
+        conscrypt::jniutil::throwNullPointerException(env, "key == null");
         return 0;
     }
-
-    const BIO_METHOD *method = stream_bio_method();
-    if (!method) {
+    if (md == nullptr) {
+        conscrypt::jniutil::throwNullPointerException(env, "md == null");
         return 0;
     }
-    bssl::UniquePtr<BIO> bio(BIO_new(method));
-    if (bio.get() == nullptr) {
+    ScopedByteArrayRO keyBytes(env, keyArray);
+    if (keyBytes.get() == nullptr) {
         return 0;
     }
 
-    bio_stream_assign(bio.get(), new BioInputStream(streamObj, isFinite == JNI_TRUE));
-
-    JNI_TRACE("create_BIO_InputStream(%p) => %p", streamObj, bio.get());
-    return static_cast<jlong>(reinterpret_cast<uintptr_t>(bio.release()));
+    bssl::UniquePtr<HMAC_CTX> hmacCtx(HMAC_CTX_new());
+    if (hmacCtx.get() == nullptr) {
+        conscrypt::jniutil::throwOutOfMemory(env, "Unable to allocate HMAC_CTX");
+        return 0;
+    }
+    const uint8_t* keyPtr = reinterpret_cast<const uint8_t*>(keyBytes.get());
+    if (!HMAC_Init_ex(hmacCtx.get(), keyPtr, keyBytes.size(), md, nullptr)) {
+        conscrypt::jniutil::throwExceptionFromBoringSSLError(env, "HMAC_Init_ex");
+        JNI_TRACE("HMAC_PREPARED_KEY_new(%p, %p) => fail HMAC_Init_ex", keyArray, md);
+        return 0;
+    }
+    JNI_TRACE("HMAC_PREPARED_KEY_new(%p, %p) => %p", keyArray, md, hmacCtx.get());
+    return reinterpret_cast<jlong>(hmacCtx.release());
 }
 
-static jlong NativeCrypto_create_BIO_OutputStream(JNIEnv* env, jclass, jobject streamObj) {
+static void NativeCrypto_HMAC_PREPARED_KEY_free(JNIEnv* env, jclass, jlong preparedKeyRef) {
     CHECK_ERROR_QUEUE_ON_RETURN;
-    JNI_TRACE("create_BIO_OutputStream(%p)", streamObj);
-
-    if (streamObj == nullptr) {
-        conscrypt::jniutil::throwNullPointerException(env, "stream == null");
-        return 0;
+    HMAC_CTX* prepared = reinterpret_cast<HMAC_CTX*>(preparedKeyRef);
+    JNI_TRACE("HMAC_PREPARED_KEY_free(%p)", prepared);
+    if (prepared == nullptr) {
+        conscrypt::jniutil::throwNullPointerException(env, "preparedKey == null");
+        return;
     }
+    HMAC_CTX_free(prepared);
+}
 
-    const BIO_METHOD *method = stream_bio_method();
-    if (!method) {
+/**
+ * Runs a single HMAC with the state of a prepared key: copies it into a stack context, lets
+ * update feed the message and returns the tag, or nullptr with an exception pending.
+ */
+template <typename UpdateFunc>
+static jbyteArray hmacOneshot(JNIEnv* env, jobject preparedKeyRef, const char* jniName,
+                              UpdateFunc update) {
+    const HMAC_CTX* prepared = fromContextObject<HMAC_CTX>(env, preparedKeyRef);
+    if (prepared == nullptr) {
+        return nullptr;
+    }
+    bssl::ScopedHMAC_CTX hmacCtx;
+    if (!HMAC_CTX_copy_ex(hmacCtx.get(), prepared)) {
+        conscrypt::jniutil::throwExceptionFromBoringSSLError(env, "HMAC_CTX_copy_ex");
+        return nullptr;
+    }
+    if (!update(hmacCtx.get())) {
+        JNI_TRACE("%s(%p) => threw exception", jniName, prepared);
+        return nullptr;
+    }
+    uint8_t result[EVP_MAX_MD_SIZE];
+    unsigned len;
+    if (!HMAC_Final(hmacCtx.get(), result, &len)) {
+        conscrypt::jniutil::throwExceptionFromBoringSSLError(env, "HMAC_Final");
+        return nullptr;
+    }
+    return macResultToArray(env, result, len);
+}
+
+static jbyteArray NativeCrypto_HMAC_oneshot(JNIEnv* env, jclass, jobject preparedKeyRef,
+                                            jbyteArray inArray, jint inOffset, jint inLength) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    JNI_TRACE("HMAC_oneshot(%p, %p, %d, %d)", preparedKeyRef, inArray, inOffset, inLength);
+    return hmacOneshot(env, preparedKeyRef, "HMAC_oneshot", [&](HMAC_CTX* hmacCtx) {
+        return macArrayUpdate(env, inArray, inOffset, inLength, "HMAC_Update",
+                              [hmacCtx](const uint8_t* p, size_t len) {
+                                  return HMAC_Update(hmacCtx, p, len);
+                              });
+    });
+}
+
+static jbyteArray NativeCrypto_HMAC_oneshotDirect(JNIEnv* env, jclass, jobject preparedKeyRef,
+                                                  jlong inPtr, jint inLength) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(inPtr);
+    JNI_TRACE("HMAC_oneshotDirect(%p, %p, %d)", preparedKeyRef, p, inLength);
+    if (p == nullptr && inLength != 0) {
+        conscrypt::jniutil::throwNullPointerException(env, nullptr);
+        return nullptr;
+    }
+    return hmacOneshot(env, preparedKeyRef, "HMAC_oneshotDirect", [&](HMAC_CTX* hmacCtx) {
+        if (!HMAC_Update(hmacCtx, p, static_cast<size_t>(inLength))) {
+            conscrypt::jniutil::throwExceptionFromBoringSSLError(env, "HMAC_Update");
+            return false;
+        }
+        return true;
+    });
+}
+
+static jlong NativeCrypto_CMAC_PREPARED_KEY_new(JNIEnv* env, jclass, jbyteArray keyArray) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    JNI_TRACE("CMAC_PREPARED_KEY_new(%p)", keyArray);
+    if (keyArray == nullptr) {
+        conscrypt::jniutil::throwNullPointerException(env, "key == null");
+        return 0;
+    }
+    bssl::UniquePtr<CMAC_CTX> cmacCtx(CMAC_CTX_new());
+    if (cmacCtx.get() == nullptr) {
+        conscrypt::jniutil::throwOutOfMemory(env, "Unable to allocate CMAC_CTX");
+        return 0;
+    }
+    ScopedByteArrayRO keyBytes(env, keyArray);
+    if (keyBytes.get() == nullptr) {
+        return 0;
+    }
+
+    const EVP_CIPHER* cipher;
+    switch (keyBytes.size()) {
+        case 16:
+            cipher = EVP_aes_128_cbc();
+            break;
+        case 24:
+            cipher = EVP_aes_192_cbc();
+            break;
+        case 32:
+            cipher = EVP_aes_256_cbc();
+            break;
+        default:
+            conscrypt::jniutil::throwException(env, "java/lang/IllegalArgumentException",
+                                               "CMAC_PREPARED_KEY_new: Unsupported key length");
+            return 0;
+    }
+
+    const uint8_t* keyPtr = reinterpret_cast<const uint8_t*>(keyBytes.get());
+    if (!CMAC_Init(cmacCtx.get(), keyPtr, keyBytes.size(), cipher, nullptr)) {
+        conscrypt::jniutil::throwExceptionFromBoringSSLError(env, "CMAC_Init");
+        JNI_TRACE("CMAC_PREPARED_KEY_new(%p) => fail CMAC_Init", keyArray);
+        return 0;
+    }
+    JNI_TRACE("CMAC_PREPARED_KEY_new(%p) => %p", keyArray, cmacCtx.get());
+    return reinterpret_cast<jlong>(cmacCtx.release());
+}
+
+static void NativeCrypto_CMAC_PREPARED_KEY_free(JNIEnv* env, jclass, jlong preparedKeyRef) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    CMAC_CTX* prepared = reinterpret_cast<CMAC_CTX*>(preparedKeyRef);
+    JNI_TRACE("CMAC_PREPARED_KEY_free(%p)", prepared);
+    if (prepared == nullptr) {
+        conscrypt::jniutil::throwNullPointerException(env, "preparedKey == null");
+        return;
+    }
+    CMAC_CTX_free(prepared);
+}
+
+/**
+ * CMAC counterpart of hmacOneshot. The copy holds the expanded AES key and both subkeys, so
+ * only the message blocks are encrypted per call.
+ */
+template <typename UpdateFunc>
+static jbyteArray cmacOneshot(JNIEnv* env, jobject preparedKeyRef, const char* jniName,
+                              UpdateFunc update) {
+    const CMAC_CTX* prepared = fromContextObject<CMAC_CTX>(env, preparedKeyRef);
+    if (prepared == nullptr) {
+        return nullptr;
+    }
+    bssl::UniquePtr<CMAC_CTX> cmacCtx(CMAC_CTX_new());
+    if (cmacCtx.get() == nullptr) {
+        conscrypt::jniutil::throwOutOfMemory(env, "Unable to allocate CMAC_CTX");
+        return nullptr;
+    }
+    if (!CMAC_CTX_copy(cmacCtx.get(), prepared)) {
+        conscrypt::jniutil::throwExceptionFromBoringSSLError(env, "CMAC_CTX_copy");
+        return nullptr;
+    }
+    if (!update(cmacCtx.get())) {
+        JNI_TRACE("%s(%p) => threw exception", jniName, prepared);
+        return nullptr;
+    }
+    uint8_t result[EVP_MAX_MD_SIZE];
+    size_t len;
+    if (!CMAC_Final(cmacCtx.get(), result, &len)) {
+        conscrypt::jniutil::throwExceptionFromBoringSSLError(env, "CMAC_Final");
+        return nullptr;
+    }
+    return macResultToArray(env, result, len);
+}
+
+static jbyteArray NativeCrypto_CMAC_oneshot(JNIEnv* env, jclass, jobject preparedKeyRef,
+                                            jbyteArray inArray, jint inOffset, jint inLength) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    JNI_TRACE("CMAC_oneshot(%p, %p, %d, %d)", preparedKeyRef, inArray, inOffset, inLength);
+    return cmacOneshot(env, preparedKeyRef, "CMAC_oneshot", [&](CMAC_CTX* cmacCtx) {
+        return macArrayUpdate(env, inArray, inOffset, inLength, "CMAC_Update",
+                              [cmacCtx](const uint8_t* p, size_t len) {
+                                  return CMAC_Update(cmacCtx, p, len);
+                              });
+    });
+}
+
+static jbyteArray NativeCrypto_CMAC_oneshotDirect(JNIEnv* env, jclass, jobject preparedKeyRef,
+                                                  jlong inPtr, jint inLength) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(inPtr);
+    JNI_TRACE("CMAC_oneshotDirect(%p, %p, %d)", preparedKeyRef, p, inLength);
+    if (p == nullptr && inLength != 0) {
+        conscrypt::jniutil::throwNullPointerException(env, nullptr);
+        return nullptr;
+    }
+    return cmacOneshot(env, preparedKeyRef, "CMAC_oneshotDirect", [&](CMAC_CTX* cmacCtx) {
+        if (!CMAC_Update(cmacCtx, p, static_cast<size_t>(inLength))) {
+            conscrypt::jniutil::throwExceptionFromBoringSSLError(env, "CMAC_Update");
+            return false;
+        }
+        return true;
+    });
+}
+
+static void NativeCrypto_RAND_bytes(JNIEnv* env, jclass, jbyteArray output) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    JNI_TRACE("NativeCrypto_RAND_bytes(%p)", output);
+
+    if (output == nullptr) {
+        conscrypt::jniutil::throwNullPointerException(env, "output == null");
+        JNI_TRACE("NativeCrypto_RAND_bytes(%p) => output == null", output);
+        return;
+    }
+
+    // Small requests, such as nonces, may be served from the thread's buffered block, and are
+    // copied in rather than pinning the array for a few bytes.
+    jsize outputLength = env->GetArrayLength(output);
+    if (static_cast<size_t>(outputLength) <= conscrypt::bufferedrand::kMaxBufferedRequest) {
+        uint8_t tmp[conscrypt::bufferedrand::kMaxBufferedRequest];
+        if (!conscrypt::bufferedrand::bytes(tmp, static_cast<size_t>(outputLength))) {
+            conscrypt::jniutil::throwExceptionFromBoringSSLError(env, "NativeCrypto_RAND_bytes");
+            JNI_TRACE("NativeCrypto_RAND_bytes(%p) => threw error", output);
+            return;
+        }
+        env->SetByteArrayRegion(output, 0, outputLength, reinterpret_cast<const jbyte*>(tmp));
+        OPENSSL_cleanse(tmp, sizeof(tmp));
+        JNI_TRACE("NativeCrypto_RAND_bytes(%p) => success", output);
+        return;
+    }
+
+    ScopedByteArrayRW outputBytes(env, output);
+    if (outputBytes.get() == nullptr) {
+        return;
+    }
+
+    unsigned char* tmp = reinterpret_cast<unsigned char*>(outputBytes.get());
+    if (RAND_bytes(tmp, outputBytes.size()) <= 0) {
+        conscrypt::jniutil::throwExceptionFromBoringSSLError(env, "NativeCrypto_RAND_bytes");
+        JNI_TRACE("tmp=%p NativeCrypto_RAND_bytes => threw error", tmp);
+        return;
+    }
+
+    JNI_TRACE("NativeCrypto_RAND_bytes(%p) => success", output);
+}
+
+static void NativeCrypto_RAND_bytes_direct(JNIEnv* env, jclass, jlong outPtr, jint outLength) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    uint8_t* out = reinterpret_cast<uint8_t*>(outPtr);
+    JNI_TRACE("NativeCrypto_RAND_bytes_direct(%p, %d)", out, outLength);
+
+    if (out == nullptr) {
+        conscrypt::jniutil::throwNullPointerException(env, "out == null");
+        return;
+    }
+    if (outLength < 0) {
+        conscrypt::jniutil::throwException(env, "java/lang/IllegalArgumentException",
+                                           "outLength < 0");
+        return;
+    }
+
+    if (!conscrypt::bufferedrand::bytes(out, static_cast<size_t>(outLength))) {
+        conscrypt::jniutil::throwExceptionFromBoringSSLError(env,
+                                                             "NativeCrypto_RAND_bytes_direct");
+        JNI_TRACE("NativeCrypto_RAND_bytes_direct(%p, %d) => threw error", out, outLength);
+        return;
+    }
+
+    JNI_TRACE("NativeCrypto_RAND_bytes_direct(%p, %d) => success", out, outLength);
+}
+
+/*
+ * public static native void setRandomBufferingEnabled(boolean enabled);
+ */
+static void NativeCrypto_setRandomBufferingEnabled(JNIEnv*, jclass, jboolean enabled) {
+    JNI_TRACE("setRandomBufferingEnabled(%d)", enabled);
+    conscrypt::bufferedrand::setEnabled(enabled);
+}
+
+static jstring ASN1_OBJECT_to_OID_string(JNIEnv* env, const ASN1_OBJECT* obj) {
+    /*
+     * The OBJ_obj2txt API doesn't "measure" if you pass in nullptr as the buffer.
+     * Just make a buffer that's large enough here. The documentation recommends
+     * 80 characters.
+     */
+    char output[128];
+    int ret = OBJ_obj2txt(output, sizeof(output), obj, 1);
+    if (ret < 0) {
+        conscrypt::jniutil::throwExceptionFromBoringSSLError(env, "ASN1_OBJECT_to_OID_string");
+        return nullptr;
+    } else if (size_t(ret) >= sizeof(output)) {
+        conscrypt::jniutil::throwRuntimeException(env,
+                                                  "ASN1_OBJECT_to_OID_string buffer too small");
+        return nullptr;
+    }
+
+    JNI_TRACE("ASN1_OBJECT_to_OID_string(%p) => %s", obj, output);
+    return env->NewStringUTF(output);
+}
+
+static jlong NativeCrypto_create_BIO_InputStream(JNIEnv* env, jclass, jobject streamObj,
+                                                 jboolean isFinite) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    JNI_TRACE("create_BIO_InputStream(%p)", streamObj);
+
+    if (streamObj == nullptr) {
+        conscrypt::jniutil::throwNullPointerException(env, "stream == null");
+        return 0;
+    }
+
+    const BIO_METHOD *method = stream_bio_method();
+    if (!method) {
+        return 0;
+    }
+    bssl::UniquePtr<BIO> bio(BIO_new(method));
+    if (bio.get() == nullptr) {
+        return 0;
+    }
+
+    bio_stream_assign(bio.get(), new BioInputStream(streamObj, isFinite == JNI_TRUE));
+
+    JNI_TRACE("create_BIO_InputStream(%p) => %p", streamObj, bio.get());
+    return static_cast<jlong>(reinterpret_cast<uintptr_t>(bio.release()));
+}
+
+static jlong NativeCrypto_create_BIO_OutputStream(JNIEnv* env, jclass, jobject streamObj) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    JNI_TRACE("create_BIO_OutputStream(%p)", streamObj);
+
+    if (streamObj == nullptr) {
+        conscrypt::jniutil::throwNullPointerException(env, "stream == null");
+        return 0;
+    }
+
+    const BIO_METHOD *method = stream_bio_method();
+    if (!method) {
         return 0;
     }
     bssl::UniquePtr<BIO> bio(BIO_new(method));
@@ -4870,8 +6098,9 @@ static jobjectArray NativeCrypto_get_X509_GENERAL_NAME_stack(JNIEnv* env, jclass
 
         ScopedLocalRef<jobject> parsedType(
                 env,
-                env->CallStaticObjectMethod(conscrypt::jniutil::integerClass,
-                                            conscrypt::jniutil::integer_valueOfMethod, gen->type));
+                env->CallStaticObjectMethod(conscrypt::jniutil::integerClass.get(env),
+                                            conscrypt::jniutil::integer_valueOfMethod.get(env),
+                                            gen->type));
         env->SetObjectArrayElement(item.get(), 0, parsedType.get());
         env->SetObjectArrayElement(item.get(), 1, val.get());
 
@@ -5716,48 +6945,79 @@ static inline bool decimal_to_integer(const char* data, size_t len, int* out) {
     return true;
 }
 
-static void NativeCrypto_ASN1_TIME_to_Calendar(JNIEnv* env, jclass, jlong asn1TimeRef,
-                                               jobject calendar) {
-    CHECK_ERROR_QUEUE_ON_RETURN;
-    ASN1_TIME* asn1Time = reinterpret_cast<ASN1_TIME*>(static_cast<uintptr_t>(asn1TimeRef));
-    JNI_TRACE("ASN1_TIME_to_Calendar(%p, %p)", asn1Time, calendar);
-
-    if (asn1Time == nullptr) {
-        conscrypt::jniutil::throwNullPointerException(env, "asn1Time == null");
-        return;
-    }
+struct Asn1TimeFields {
+    int year, mon, mday, hour, min, sec;
+};
 
+/**
+ * Splits |asn1Time| into its UTC calendar fields, with |mon| counted from one. Throws and returns
+ * false if the time is malformed.
+ */
+static bool asn1_time_to_fields(JNIEnv* env, const ASN1_TIME* asn1Time, Asn1TimeFields* out) {
     if (!ASN1_TIME_check(asn1Time)) {
         conscrypt::jniutil::throwParsingException(env, "Invalid date format");
-        return;
+        return false;
     }
 
     bssl::UniquePtr<ASN1_GENERALIZEDTIME> gen(ASN1_TIME_to_generalizedtime(asn1Time, nullptr));
     if (gen.get() == nullptr) {
         conscrypt::jniutil::throwParsingException(env,
                                                   "ASN1_TIME_to_generalizedtime returned null");
-        return;
+        return false;
     }
 
     if (ASN1_STRING_length(gen.get()) < 14 || ASN1_STRING_get0_data(gen.get()) == nullptr) {
         conscrypt::jniutil::throwNullPointerException(env, "gen->length < 14 || gen->data == null");
-        return;
+        return false;
     }
 
-    int year, mon, mday, hour, min, sec;
     const char* data = reinterpret_cast<const char*>(ASN1_STRING_get0_data(gen.get()));
-    if (!decimal_to_integer(data, 4, &year) ||
-        !decimal_to_integer(data + 4, 2, &mon) ||
-        !decimal_to_integer(data + 6, 2, &mday) ||
-        !decimal_to_integer(data + 8, 2, &hour) ||
-        !decimal_to_integer(data + 10, 2, &min) ||
-        !decimal_to_integer(data + 12, 2, &sec)) {
+    if (!decimal_to_integer(data, 4, &out->year) ||
+        !decimal_to_integer(data + 4, 2, &out->mon) ||
+        !decimal_to_integer(data + 6, 2, &out->mday) ||
+        !decimal_to_integer(data + 8, 2, &out->hour) ||
+        !decimal_to_integer(data + 10, 2, &out->min) ||
+        !decimal_to_integer(data + 12, 2, &out->sec)) {
         conscrypt::jniutil::throwParsingException(env, "Invalid date format");
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Converts |fields| to milliseconds since the epoch. Dates are counted in the proleptic Gregorian
+ * calendar that X.509 uses, which matches GregorianCalendar for anything after October 1582.
+ */
+static int64_t asn1_time_fields_to_millis(const Asn1TimeFields& fields) {
+    // Days from civil, with the year starting in March so leap days fall at the end.
+    int64_t year = fields.year - (fields.mon <= 2 ? 1 : 0);
+    int64_t era = (year >= 0 ? year : year - 399) / 400;
+    int64_t yearOfEra = year - era * 400;
+    int64_t dayOfYear = (153 * (fields.mon + (fields.mon > 2 ? -3 : 9)) + 2) / 5 + fields.mday - 1;
+    int64_t dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    int64_t days = era * 146097 + dayOfEra - 719468;
+    int64_t seconds = days * 86400 + fields.hour * 3600 + fields.min * 60 + fields.sec;
+    return seconds * 1000;
+}
+
+static void NativeCrypto_ASN1_TIME_to_Calendar(JNIEnv* env, jclass, jlong asn1TimeRef,
+                                               jobject calendar) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    ASN1_TIME* asn1Time = reinterpret_cast<ASN1_TIME*>(static_cast<uintptr_t>(asn1TimeRef));
+    JNI_TRACE("ASN1_TIME_to_Calendar(%p, %p)", asn1Time, calendar);
+
+    if (asn1Time == nullptr) {
+        conscrypt::jniutil::throwNullPointerException(env, "asn1Time == null");
+        return;
+    }
+
+    Asn1TimeFields fields;
+    if (!asn1_time_to_fields(env, asn1Time, &fields)) {
         return;
     }
 
-    env->CallVoidMethod(calendar, conscrypt::jniutil::calendar_setMethod, year, mon - 1, mday, hour,
-                        min, sec);
+    env->CallVoidMethod(calendar, conscrypt::jniutil::calendar_setMethod.get(env), fields.year,
+                        fields.mon - 1, fields.mday, fields.hour, fields.min, fields.sec);
 }
 
 // A CbsHandle is a structure used to manage resources allocated by asn1_read-*
@@ -6179,6 +7439,29 @@ static jbyteArray NativeCrypto_i2d_X509_PUBKEY(JNIEnv* env, jclass, jlong x509Re
     return ASN1ToByteArray<X509_PUBKEY>(env, X509_get_X509_PUBKEY(x509), i2d_X509_PUBKEY);
 }
 
+/**
+ * Returns the public key cache's copy of pkey, which was parsed without going through the
+ * cache, re-encoding it to find its SubjectPublicKeyInfo. Returns pkey itself if the cache is
+ * disabled or the key can't be encoded.
+ */
+static bssl::UniquePtr<EVP_PKEY> internPublicKey(bssl::UniquePtr<EVP_PKEY> pkey) {
+    if (!conscrypt::publickeycache::isEnabled()) {
+        return pkey;
+    }
+    bssl::ScopedCBB cbb;
+    uint8_t* spki;
+    size_t spkiLength;
+    if (!CBB_init(cbb.get(), 128) || !EVP_marshal_public_key(cbb.get(), pkey.get()) ||
+        !CBB_finish(cbb.get(), &spki, &spkiLength)) {
+        ERR_clear_error();
+        return pkey;
+    }
+    bssl::UniquePtr<uint8_t> spkiStorage(spki);
+    conscrypt::publickeycache::Key cacheKey;
+    conscrypt::publickeycache::computeKey(spki, spkiLength, &cacheKey);
+    return conscrypt::publickeycache::intern(cacheKey, std::move(pkey));
+}
+
 template <typename T, T* (*PEM_read_func)(BIO*, T**, pem_password_cb*, void*)>
 static jlong PEM_to_jlong(JNIEnv* env, jlong bioRef) {
     BIO* bio = to_BIO(env, bioRef);
@@ -6218,7 +7501,12 @@ static jlong NativeCrypto_PEM_read_bio_PUBKEY(JNIEnv* env, jclass, jlong bioRef)
     CHECK_ERROR_QUEUE_ON_RETURN;
     // NOLINTNEXTLINE(runtime/int)
     JNI_TRACE("PEM_read_bio_PUBKEY(0x%llx)", (long long)bioRef);
-    return PEM_to_jlong<EVP_PKEY, PEM_read_bio_PUBKEY>(env, bioRef);
+    jlong result = PEM_to_jlong<EVP_PKEY, PEM_read_bio_PUBKEY>(env, bioRef);
+    if (result == 0) {
+        return 0;
+    }
+    bssl::UniquePtr<EVP_PKEY> pkey(reinterpret_cast<EVP_PKEY*>(static_cast<uintptr_t>(result)));
+    return reinterpret_cast<uintptr_t>(internPublicKey(std::move(pkey)).release());
 }
 
 static jlong NativeCrypto_PEM_read_bio_PrivateKey(JNIEnv* env, jclass, jlong bioRef) {
@@ -6375,17 +7663,374 @@ static jlongArray NativeCrypto_d2i_PKCS7_bio(JNIEnv* env, jclass, jlong bioRef,
     }
 }
 
-static jlongArray NativeCrypto_ASN1_seq_unpack_X509_bio(JNIEnv* env, jclass, jlong bioRef) {
-    CHECK_ERROR_QUEUE_ON_RETURN;
-    BIO* bio = to_BIO(env, bioRef);
-    JNI_TRACE("ASN1_seq_unpack_X509_bio(%p)", bio);
+namespace {
 
-    if (bio == nullptr) {
-        JNI_TRACE("ASN1_seq_unpack_X509_bio(%p) => bio == null", bio);
-        return nullptr;
-    }
+// State behind a MAPPED_FILE_* handle: the mapping, plus the certificates of a PKCS#7 bundle
+// that have been split out but not yet handed to Java.
+struct MappedCertificateFile {
+    std::unique_ptr<conscrypt::MappedFile> file;
+    bssl::UniquePtr<STACK_OF(CRYPTO_BUFFER)> pending;
+    size_t pendingIndex = 0;
+};
 
-    uint8_t* data;
+}  // namespace
+
+static MappedCertificateFile* to_MappedCertificateFile(JNIEnv* env, jlong ref) {
+    MappedCertificateFile* reader =
+            reinterpret_cast<MappedCertificateFile*>(static_cast<uintptr_t>(ref));
+    if (reader == nullptr) {
+        conscrypt::jniutil::throwNullPointerException(env, "mappedFile == null");
+    }
+    return reader;
+}
+
+/**
+ * Finds the next entry in |file| and points |out| at its DER encoding, advancing past it. DER
+ * entries are used in place. PEM blocks named in |pemNames| are decoded into |*pemData|, and
+ * other blocks (keys, parameters, or text between them) are skipped. |out| is left empty at the
+ * end of the file. Throws ParsingException and returns false on malformed input.
+ */
+static bool next_mapped_der(JNIEnv* env, conscrypt::MappedFile* file,
+                            std::initializer_list<const char*> pemNames,
+                            bssl::UniquePtr<uint8_t>* pemData, CBS* out) {
+    CBS_init(out, nullptr, 0);
+    while (true) {
+        while (file->remaining() > 0 && isspace(*file->current())) {
+            file->advance(1);
+        }
+        if (file->remaining() == 0) {
+            return true;
+        }
+
+        // Certificates and PKCS#7 bundles in DER both start with a SEQUENCE tag byte.
+        CBS cbs;
+        CBS_init(&cbs, file->current(), file->remaining());
+        if (CBS_peek_asn1_tag(&cbs, CBS_ASN1_SEQUENCE)) {
+            if (!CBS_get_asn1_element(&cbs, out, CBS_ASN1_SEQUENCE)) {
+                conscrypt::jniutil::throwParsingException(env, "Truncated or malformed DER entry");
+                return false;
+            }
+            file->advance(CBS_len(out));
+            return true;
+        }
+
+        // A read-only memory BIO reads the mapping in place.
+        bssl::UniquePtr<BIO> bio(BIO_new_mem_buf(file->current(),
+                                                 static_cast<ossl_ssize_t>(file->remaining())));
+        if (!bio) {
+            conscrypt::jniutil::throwOutOfMemory(env, "Unable to allocate BIO");
+            return false;
+        }
+        char* name = nullptr;
+        char* header = nullptr;
+        uint8_t* data = nullptr;
+        long len = 0;  // NOLINT(runtime/int)
+        if (!PEM_read_bio(bio.get(), &name, &header, &data, &len)) {
+            uint32_t err = ERR_peek_last_error();
+            if (ERR_GET_LIB(err) == ERR_LIB_PEM && ERR_GET_REASON(err) == PEM_R_NO_START_LINE) {
+                // Only trailing text is left.
+                ERR_clear_error();
+                file->advance(file->remaining());
+                return true;
+            }
+            conscrypt::jniutil::throwExceptionFromBoringSSLError(
+                    env, "PEM_read_bio", conscrypt::jniutil::throwParsingException);
+            return false;
+        }
+        file->advance(file->remaining() - BIO_pending(bio.get()));
+        bssl::UniquePtr<char> nameOwner(name);
+        bssl::UniquePtr<char> headerOwner(header);
+        bssl::UniquePtr<uint8_t> dataOwner(data);
+        for (const char* pemName : pemNames) {
+            if (strcmp(name, pemName) == 0) {
+                *pemData = std::move(dataOwner);
+                CBS_init(out, pemData->get(), static_cast<size_t>(len));
+                return true;
+            }
+        }
+    }
+}
+
+/**
+ * Returns true if |der| is a PKCS#7 ContentInfo rather than a certificate: the former starts
+ * with an OID, the latter with the TBSCertificate SEQUENCE.
+ */
+static bool der_is_pkcs7(const CBS* der) {
+    CBS copy = *der;
+    CBS body;
+    return CBS_get_asn1(&copy, &body, CBS_ASN1_SEQUENCE) &&
+           CBS_peek_asn1_tag(&body, CBS_ASN1_OBJECT);
+}
+
+/**
+ * public static native long MAPPED_FILE_open(String path) throws IOException;
+ */
+static jlong NativeCrypto_MAPPED_FILE_open(JNIEnv* env, jclass, jstring pathString) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    JNI_TRACE("MAPPED_FILE_open(%p)", pathString);
+    if (pathString == nullptr) {
+        conscrypt::jniutil::throwNullPointerException(env, "path == null");
+        return 0;
+    }
+    ScopedUtfChars path(env, pathString);
+    if (path.c_str() == nullptr) {
+        return 0;
+    }
+    std::unique_ptr<conscrypt::MappedFile> file(conscrypt::MappedFile::open(path.c_str()));
+    if (!file) {
+        conscrypt::jniutil::throwIOException(env, strerror(errno));
+        return 0;
+    }
+    MappedCertificateFile* reader = new MappedCertificateFile();
+    reader->file = std::move(file);
+    JNI_TRACE("MAPPED_FILE_open(%s) => %p", path.c_str(), reader);
+    return reinterpret_cast<uintptr_t>(reader);
+}
+
+/**
+ * public static native long MAPPED_FILE_open_fd(int fd) throws IOException;
+ */
+static jlong NativeCrypto_MAPPED_FILE_open_fd(JNIEnv* env, jclass, jint fd) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    JNI_TRACE("MAPPED_FILE_open_fd(%d)", fd);
+    std::unique_ptr<conscrypt::MappedFile> file(conscrypt::MappedFile::openFd(fd));
+    if (!file) {
+        conscrypt::jniutil::throwIOException(env, strerror(errno));
+        return 0;
+    }
+    MappedCertificateFile* reader = new MappedCertificateFile();
+    reader->file = std::move(file);
+    JNI_TRACE("MAPPED_FILE_open_fd(%d) => %p", fd, reader);
+    return reinterpret_cast<uintptr_t>(reader);
+}
+
+/**
+ * public static native void MAPPED_FILE_free(long mappedFile);
+ */
+static void NativeCrypto_MAPPED_FILE_free(JNIEnv* env, jclass, jlong ref) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    MappedCertificateFile* reader = to_MappedCertificateFile(env, ref);
+    JNI_TRACE("MAPPED_FILE_free(%p)", reader);
+    delete reader;
+}
+
+/**
+ * public static native long MAPPED_FILE_next_X509(long mappedFile) throws ParsingException;
+ */
+static jlong NativeCrypto_MAPPED_FILE_next_X509(JNIEnv* env, jclass, jlong ref) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    MappedCertificateFile* reader = to_MappedCertificateFile(env, ref);
+    JNI_TRACE("MAPPED_FILE_next_X509(%p)", reader);
+    if (reader == nullptr) {
+        return 0;
+    }
+
+    CRYPTO_BUFFER_POOL* pool = GetSharedCryptoBufferPool();
+    while (true) {
+        if (reader->pending && reader->pendingIndex < sk_CRYPTO_BUFFER_num(reader->pending.get())) {
+            CRYPTO_BUFFER* buf =
+                    sk_CRYPTO_BUFFER_value(reader->pending.get(), reader->pendingIndex++);
+            X509* x509 = X509_parse_from_buffer(buf);
+            if (x509 == nullptr) {
+                conscrypt::jniutil::throwExceptionFromBoringSSLError(
+                        env, "X509_parse_from_buffer", conscrypt::jniutil::throwParsingException);
+                return 0;
+            }
+            JNI_TRACE("MAPPED_FILE_next_X509(%p) => %p from PKCS#7", reader, x509);
+            return reinterpret_cast<uintptr_t>(x509);
+        }
+        reader->pending.reset();
+
+        bssl::UniquePtr<uint8_t> pemData;
+        CBS der;
+        if (!next_mapped_der(env, reader->file.get(), {"CERTIFICATE", "X509 CERTIFICATE", "PKCS7"},
+                             &pemData, &der)) {
+            return 0;
+        }
+        if (CBS_len(&der) == 0) {
+            JNI_TRACE("MAPPED_FILE_next_X509(%p) => end of file", reader);
+            return 0;
+        }
+
+        if (der_is_pkcs7(&der)) {
+            reader->pending.reset(sk_CRYPTO_BUFFER_new_null());
+            reader->pendingIndex = 0;
+            if (!reader->pending) {
+                conscrypt::jniutil::throwOutOfMemory(env, "Unable to allocate certificate stack");
+                return 0;
+            }
+            if (!PKCS7_get_raw_certificates(reader->pending.get(), &der, pool)) {
+                conscrypt::jniutil::throwExceptionFromBoringSSLError(
+                        env, "PKCS7_get_raw_certificates",
+                        conscrypt::jniutil::throwParsingException);
+                return 0;
+            }
+            continue;
+        }
+
+        bssl::UniquePtr<CRYPTO_BUFFER> buf(CRYPTO_BUFFER_new(CBS_data(&der), CBS_len(&der), pool));
+        if (!buf) {
+            conscrypt::jniutil::throwOutOfMemory(env, "Unable to allocate CRYPTO_BUFFER");
+            return 0;
+        }
+        X509* x509 = X509_parse_from_buffer(buf.get());
+        if (x509 == nullptr) {
+            conscrypt::jniutil::throwExceptionFromBoringSSLError(
+                    env, "X509_parse_from_buffer", conscrypt::jniutil::throwParsingException);
+            return 0;
+        }
+        JNI_TRACE("MAPPED_FILE_next_X509(%p) => %p", reader, x509);
+        return reinterpret_cast<uintptr_t>(x509);
+    }
+}
+
+/**
+ * public static native long MAPPED_FILE_next_X509_CRL(long mappedFile) throws ParsingException;
+ */
+static jlong NativeCrypto_MAPPED_FILE_next_X509_CRL(JNIEnv* env, jclass, jlong ref) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    MappedCertificateFile* reader = to_MappedCertificateFile(env, ref);
+    JNI_TRACE("MAPPED_FILE_next_X509_CRL(%p)", reader);
+    if (reader == nullptr) {
+        return 0;
+    }
+
+    bssl::UniquePtr<uint8_t> pemData;
+    CBS der;
+    if (!next_mapped_der(env, reader->file.get(), {"X509 CRL"}, &pemData, &der)) {
+        return 0;
+    }
+    if (CBS_len(&der) == 0) {
+        JNI_TRACE("MAPPED_FILE_next_X509_CRL(%p) => end of file", reader);
+        return 0;
+    }
+
+    const uint8_t* p = CBS_data(&der);
+    X509_CRL* crl = d2i_X509_CRL(nullptr, &p, static_cast<long>(CBS_len(&der)));  // NOLINT
+    if (crl == nullptr) {
+        conscrypt::jniutil::throwExceptionFromBoringSSLError(
+                env, "d2i_X509_CRL", conscrypt::jniutil::throwParsingException);
+        return 0;
+    }
+    JNI_TRACE("MAPPED_FILE_next_X509_CRL(%p) => %p", reader, crl);
+    return reinterpret_cast<uintptr_t>(crl);
+}
+
+/**
+ * public static native int MAPPED_FILE_visit_X509_CRL_entries(long mappedFile,
+ *         RevokedCertificateVisitor visitor) throws ParsingException;
+ *
+ * Walks the revokedCertificates of the next CRL straight out of the mapping, calling
+ * visitor.visit(serialNumber, revocationDateMillis) for each entry without building an X509_CRL.
+ * Returns the number of entries visited, or -1 at the end of the file.
+ */
+static jint NativeCrypto_MAPPED_FILE_visit_X509_CRL_entries(JNIEnv* env, jclass, jlong ref,
+                                                            jobject visitor) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    MappedCertificateFile* reader = to_MappedCertificateFile(env, ref);
+    JNI_TRACE("MAPPED_FILE_visit_X509_CRL_entries(%p, %p)", reader, visitor);
+    if (reader == nullptr) {
+        return -1;
+    }
+    if (visitor == nullptr) {
+        conscrypt::jniutil::throwNullPointerException(env, "visitor == null");
+        return -1;
+    }
+
+    ScopedLocalRef<jclass> visitorClass(env, env->GetObjectClass(visitor));
+    jmethodID visitMethod = env->GetMethodID(visitorClass.get(), "visit", "([BJ)Z");
+    if (visitMethod == nullptr) {
+        return -1;
+    }
+
+    bssl::UniquePtr<uint8_t> pemData;
+    CBS der;
+    if (!next_mapped_der(env, reader->file.get(), {"X509 CRL"}, &pemData, &der)) {
+        return -1;
+    }
+    if (CBS_len(&der) == 0) {
+        JNI_TRACE("MAPPED_FILE_visit_X509_CRL_entries(%p) => end of file", reader);
+        return -1;
+    }
+
+    // CertificateList ::= SEQUENCE { tbsCertList, signatureAlgorithm, signatureValue }
+    // TBSCertList ::= SEQUENCE { version OPTIONAL, signature, issuer, thisUpdate,
+    //         nextUpdate OPTIONAL, revokedCertificates OPTIONAL, crlExtensions [0] OPTIONAL }
+    CBS crl, tbs, skipped, revoked;
+    int hasRevoked;
+    if (!CBS_get_asn1(&der, &crl, CBS_ASN1_SEQUENCE) ||
+        !CBS_get_asn1(&crl, &tbs, CBS_ASN1_SEQUENCE) ||
+        !CBS_get_optional_asn1(&tbs, &skipped, nullptr, CBS_ASN1_INTEGER) ||
+        !CBS_get_asn1(&tbs, &skipped, CBS_ASN1_SEQUENCE) ||
+        !CBS_get_asn1(&tbs, &skipped, CBS_ASN1_SEQUENCE) ||
+        !CBS_get_any_asn1(&tbs, &skipped, nullptr) ||
+        !CBS_get_optional_asn1(&tbs, &skipped, nullptr, CBS_ASN1_UTCTIME) ||
+        !CBS_get_optional_asn1(&tbs, &skipped, nullptr, CBS_ASN1_GENERALIZEDTIME) ||
+        !CBS_get_optional_asn1(&tbs, &revoked, &hasRevoked, CBS_ASN1_SEQUENCE)) {
+        conscrypt::jniutil::throwParsingException(env, "Malformed CRL");
+        return -1;
+    }
+
+    jint count = 0;
+    while (hasRevoked && CBS_len(&revoked) > 0) {
+        // RevokedCertificate ::= SEQUENCE { userCertificate, revocationDate,
+        //         crlEntryExtensions OPTIONAL }
+        CBS entry, serial, date;
+        CBS_ASN1_TAG dateTag;
+        if (!CBS_get_asn1(&revoked, &entry, CBS_ASN1_SEQUENCE) ||
+            !CBS_get_asn1(&entry, &serial, CBS_ASN1_INTEGER) ||
+            !CBS_get_any_asn1(&entry, &date, &dateTag)) {
+            conscrypt::jniutil::throwParsingException(env, "Malformed CRL entry");
+            return -1;
+        }
+        struct tm tm;
+        bool dateOk = false;
+        if (dateTag == CBS_ASN1_UTCTIME) {
+            dateOk = CBS_parse_utc_time(&date, &tm, /*allow_timezone_offset=*/0);
+        } else if (dateTag == CBS_ASN1_GENERALIZEDTIME) {
+            dateOk = CBS_parse_generalized_time(&date, &tm, /*allow_timezone_offset=*/0);
+        }
+        if (!dateOk) {
+            conscrypt::jniutil::throwParsingException(env, "Invalid date format");
+            return -1;
+        }
+        Asn1TimeFields fields = {tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday,
+                                 tm.tm_hour,        tm.tm_min,     tm.tm_sec};
+
+        ScopedLocalRef<jbyteArray> serialArray(
+                env, env->NewByteArray(static_cast<jsize>(CBS_len(&serial))));
+        if (serialArray.get() == nullptr) {
+            return -1;
+        }
+        env->SetByteArrayRegion(serialArray.get(), 0, static_cast<jsize>(CBS_len(&serial)),
+                                reinterpret_cast<const jbyte*>(CBS_data(&serial)));
+        jboolean more = env->CallBooleanMethod(visitor, visitMethod, serialArray.get(),
+                                               asn1_time_fields_to_millis(fields));
+        if (env->ExceptionCheck()) {
+            JNI_TRACE("MAPPED_FILE_visit_X509_CRL_entries(%p) => visitor threw", reader);
+            return -1;
+        }
+        count++;
+        if (!more) {
+            break;
+        }
+    }
+
+    JNI_TRACE("MAPPED_FILE_visit_X509_CRL_entries(%p) => %d", reader, count);
+    return count;
+}
+
+static jlongArray NativeCrypto_ASN1_seq_unpack_X509_bio(JNIEnv* env, jclass, jlong bioRef) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    BIO* bio = to_BIO(env, bioRef);
+    JNI_TRACE("ASN1_seq_unpack_X509_bio(%p)", bio);
+
+    if (bio == nullptr) {
+        JNI_TRACE("ASN1_seq_unpack_X509_bio(%p) => bio == null", bio);
+        return nullptr;
+    }
+
+    uint8_t* data;
     size_t len;
     if (!BIO_read_asn1(bio, &data, &len, 256 * 1024 * 1024 /* max length, 256MB for sanity */)) {
         conscrypt::jniutil::throwExceptionFromBoringSSLError(env, "Error reading X.509 data",
@@ -6580,6 +8225,9 @@ static jlong NativeCrypto_X509_get_pubkey(JNIEnv* env, jclass, jlong x509Ref,
         return 0;
     }
 
+    // The certificate holds its own reference to pkey; interning it lets certificates with the
+    // same key hand out one shared EVP_PKEY.
+    pkey = internPublicKey(std::move(pkey));
     JNI_TRACE("X509_get_pubkey(%p) => %p", x509, pkey.get());
     return reinterpret_cast<uintptr_t>(pkey.release());
 }
@@ -6931,6 +8579,128 @@ static jobjectArray NativeCrypto_get_X509_ext_oids(JNIEnv* env, jclass, jlong x5
                                                                                critical);
 }
 
+// Layout of the array returned by get_X509_fields; must match the X509_FIELD_* and X509_LONG_*
+// constants in NativeCrypto.java.
+enum X509FieldSlot {
+    kX509FieldLongs = 0,
+    kX509FieldSerialNumber,
+    kX509FieldIssuer,
+    kX509FieldSubject,
+    kX509FieldSigAlgOid,
+    kX509FieldKeyUsage,
+    kX509FieldExtKeyUsage,
+    kX509FieldCriticalExtOids,
+    kX509FieldNonCriticalExtOids,
+    kX509FieldCount,
+};
+
+enum X509LongSlot {
+    kX509LongNotBefore = 0,
+    kX509LongNotAfter,
+    kX509LongVersion,
+    kX509LongExFlags,
+    kX509LongPathLen,
+    kX509LongCount,
+};
+
+/**
+ * Decodes every field OpenSSLX509Certificate asks for on the common path in one call, so building
+ * a certificate and walking it in a trust manager costs one JNI transition instead of one per
+ * getter. Throws ParsingException if the validity times are malformed.
+ */
+static jobjectArray NativeCrypto_get_X509_fields(JNIEnv* env, jclass clazz, jlong x509Ref,
+                                                 jobject holder) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    X509* x509 = reinterpret_cast<X509*>(static_cast<uintptr_t>(x509Ref));
+    JNI_TRACE("get_X509_fields(%p)", x509);
+
+    if (x509 == nullptr) {
+        conscrypt::jniutil::throwNullPointerException(env, "x509 == null");
+        JNI_TRACE("get_X509_fields(%p) => x509 == null", x509);
+        return nullptr;
+    }
+
+    Asn1TimeFields notBefore;
+    Asn1TimeFields notAfter;
+    if (!asn1_time_to_fields(env, X509_get0_notBefore(x509), &notBefore) ||
+        !asn1_time_to_fields(env, X509_get0_notAfter(x509), &notAfter)) {
+        JNI_TRACE("get_X509_fields(%p) => invalid validity", x509);
+        return nullptr;
+    }
+
+    jlong longs[kX509LongCount];
+    longs[kX509LongNotBefore] = asn1_time_fields_to_millis(notBefore);
+    longs[kX509LongNotAfter] = asn1_time_fields_to_millis(notAfter);
+    longs[kX509LongVersion] = X509_get_version(x509);
+    longs[kX509LongExFlags] = NativeCrypto_get_X509_ex_flags(env, clazz, x509Ref, holder);
+    longs[kX509LongPathLen] = NativeCrypto_get_X509_ex_pathlen(env, clazz, x509Ref, holder);
+
+    ScopedLocalRef<jobjectArray> fields(
+            env, env->NewObjectArray(kX509FieldCount, conscrypt::jniutil::objectClass, nullptr));
+    if (fields.get() == nullptr) {
+        JNI_TRACE("get_X509_fields(%p) => threw allocating fields", x509);
+        return nullptr;
+    }
+
+    ScopedLocalRef<jlongArray> longsArray(env, env->NewLongArray(kX509LongCount));
+    if (longsArray.get() == nullptr) {
+        JNI_TRACE("get_X509_fields(%p) => threw allocating longs", x509);
+        return nullptr;
+    }
+    env->SetLongArrayRegion(longsArray.get(), 0, kX509LongCount, longs);
+    env->SetObjectArrayElement(fields.get(), kX509FieldLongs, longsArray.get());
+
+    // Each getter below may legitimately return null (no such extension), so only a pending
+    // exception means failure.
+    jobject values[kX509FieldCount] = {};
+    values[kX509FieldSerialNumber] =
+            NativeCrypto_X509_get_serialNumber(env, clazz, x509Ref, holder);
+    if (!env->ExceptionCheck()) {
+        values[kX509FieldIssuer] = NativeCrypto_X509_get_issuer_name(env, clazz, x509Ref, holder);
+    }
+    if (!env->ExceptionCheck()) {
+        values[kX509FieldSubject] = NativeCrypto_X509_get_subject_name(env, clazz, x509Ref, holder);
+    }
+    if (!env->ExceptionCheck()) {
+        values[kX509FieldSigAlgOid] = NativeCrypto_get_X509_sig_alg_oid(env, clazz, x509Ref, holder);
+    }
+    if (!env->ExceptionCheck()) {
+        values[kX509FieldKeyUsage] = NativeCrypto_get_X509_ex_kusage(env, clazz, x509Ref, holder);
+    }
+    if (!env->ExceptionCheck()) {
+        values[kX509FieldExtKeyUsage] =
+                NativeCrypto_get_X509_ex_xkusage(env, clazz, x509Ref, holder);
+    }
+    if (!env->ExceptionCheck()) {
+        values[kX509FieldCriticalExtOids] =
+                get_X509Type_ext_oids<X509, X509_get_ext_by_critical, X509_get_ext>(env, x509Ref,
+                                                                                    1);
+    }
+    if (!env->ExceptionCheck()) {
+        values[kX509FieldNonCriticalExtOids] =
+                get_X509Type_ext_oids<X509, X509_get_ext_by_critical, X509_get_ext>(env, x509Ref,
+                                                                                    0);
+    }
+
+    bool failed = env->ExceptionCheck();
+    for (int i = kX509FieldLongs + 1; i < kX509FieldCount; i++) {
+        if (values[i] == nullptr) {
+            continue;
+        }
+        if (!failed) {
+            env->SetObjectArrayElement(fields.get(), i, values[i]);
+        }
+        env->DeleteLocalRef(values[i]);
+    }
+    if (failed) {
+        JNI_TRACE("get_X509_fields(%p) => threw decoding fields", x509);
+        return nullptr;
+    }
+
+    JNI_TRACE("get_X509_fields(%p) => %p", x509, fields.get());
+    return fields.release();
+}
+
 static jobjectArray NativeCrypto_get_X509_CRL_ext_oids(JNIEnv* env, jclass, jlong x509CrlRef,
                                                        CONSCRYPT_UNUSED jobject holder,
                                                        jint critical) {
@@ -7101,6 +8871,17 @@ static int sslSelect(JNIEnv* env, int type, jobject fdObject, AppData* appData,
     // cannot be restarted without recreating the pollfd structure.
     int result;
     struct pollfd fds[2];
+    // Created by addWaitingThread() together with the increment, so wakeups sent since then
+    // are waiting in it.
+    int wakeupFd = appData->wakeupReadFd.load();
+    // A wakeup sent by SSL_interrupt before the descriptor existed was dropped, so check for
+    // it now. The flag is cleared before the descriptor is read there, so one side always
+    // sees the other.
+    if (wakeupFd == -1 || !appData->aliveAndKicking) {
+        std::lock_guard<std::mutex> appDataLock(appData->mutex);
+        appData->waitingThreads--;
+        return wakeupFd == -1 ? -1 : 1;
+    }
     do {
         NetFd fd(env, fdObject);
         if (fd.isClosed()) {
@@ -7119,7 +8900,7 @@ static int sslSelect(JNIEnv* env, int type, jobject fdObject, AppData* appData,
             fds[0].events = POLLOUT | POLLPRI;
         }
 
-        fds[1].fd = appData->fdsEmergency[0];
+        fds[1].fd = wakeupFd;
         fds[1].events = POLLIN | POLLPRI;
 
         // Converting from Java semantics to Posix semantics.
@@ -7155,10 +8936,7 @@ static int sslSelect(JNIEnv* env, int type, jobject fdObject, AppData* appData,
         // the pipe in a blocking way (so we make the pipe
         // non-blocking at creation).
         if (fds[1].revents & POLLIN) {
-            char token;
-            do {
-                (void)read(appData->fdsEmergency[0], &token, 1);
-            } while (errno == EINTR);
+            appData->consumeWakeup();
         }
     }
 
@@ -7181,15 +8959,11 @@ static void sslNotify(AppData* appData) {
 #ifdef _WIN32
     SetEvent(appData->interruptEvent);
 #else
-    // Write a byte to the emergency pipe, so a concurrent select() can return.
+    // Write a token to the emergency pipe, so a concurrent select() can return.
     // Note we have to restore the errno of the original system call, since the
     // caller relies on it for generating error messages.
     int errnoBackup = errno;
-    char token = '*';
-    do {
-        errno = 0;
-        (void)write(appData->fdsEmergency[1], &token, 1);
-    } while (errno == EINTR);
+    appData->signalWakeup();
     errno = errnoBackup;
 #endif
 }
@@ -7198,6 +8972,153 @@ static AppData* toAppData(const SSL* ssl) {
     return reinterpret_cast<AppData*>(SSL_get_app_data(ssl));
 }
 
+// Frees the counters attached to an SSL_CTX by SSL_CTX_new.
+static void SslCountersFree(void* /* parent */, void* ptr, CRYPTO_EX_DATA* /* ad */,
+                            int /* index */, long /* argl */ /* NOLINT(runtime/int) */,
+                            void* /* argp */) {
+    delete static_cast<conscrypt::SharedSslCounters*>(ptr);
+}
+
+static int sslCtxCountersIndex() {
+    static const int index = SSL_CTX_get_ex_new_index(0 /* argl */, nullptr /* argp */,
+                                                      nullptr /* new_func */,
+                                                      nullptr /* dup_func */, SslCountersFree);
+    return index;
+}
+
+static conscrypt::SharedSslCounters* toSslCtxCounters(const SSL_CTX* ssl_ctx) {
+    return static_cast<conscrypt::SharedSslCounters*>(
+            SSL_CTX_get_ex_data(ssl_ctx, sslCtxCountersIndex()));
+}
+
+// Frees the session ticket keys attached to an SSL_CTX by SSL_CTX_new.
+static void TicketKeysFree(void* /* parent */, void* ptr, CRYPTO_EX_DATA* /* ad */,
+                           int /* index */, long /* argl */ /* NOLINT(runtime/int) */,
+                           void* /* argp */) {
+    delete static_cast<conscrypt::TicketKeys*>(ptr);
+}
+
+static int sslCtxTicketKeysIndex() {
+    static const int index = SSL_CTX_get_ex_new_index(0 /* argl */, nullptr /* argp */,
+                                                      nullptr /* new_func */,
+                                                      nullptr /* dup_func */, TicketKeysFree);
+    return index;
+}
+
+static conscrypt::TicketKeys* toSslCtxTicketKeys(const SSL_CTX* ssl_ctx) {
+    return static_cast<conscrypt::TicketKeys*>(
+            SSL_CTX_get_ex_data(ssl_ctx, sslCtxTicketKeysIndex()));
+}
+
+// Frees the server session cache attached to an SSL_CTX by SSL_CTX_new.
+static void ServerSessionCacheFree(void* /* parent */, void* ptr, CRYPTO_EX_DATA* /* ad */,
+                                   int /* index */, long /* argl */ /* NOLINT(runtime/int) */,
+                                   void* /* argp */) {
+    delete static_cast<conscrypt::ServerSessionCache*>(ptr);
+}
+
+static int sslCtxServerSessionCacheIndex() {
+    static const int index = SSL_CTX_get_ex_new_index(0 /* argl */, nullptr /* argp */,
+                                                      nullptr /* new_func */,
+                                                      nullptr /* dup_func */,
+                                                      ServerSessionCacheFree);
+    return index;
+}
+
+// Frees the certificate map attached to an SSL_CTX by SSL_CTX_new.
+static void CertificateMapFree(void* /* parent */, void* ptr, CRYPTO_EX_DATA* /* ad */,
+                               int /* index */, long /* argl */ /* NOLINT(runtime/int) */,
+                               void* /* argp */) {
+    delete static_cast<conscrypt::CertificateMap*>(ptr);
+}
+
+static int sslCtxCertificateMapIndex() {
+    static const int index = SSL_CTX_get_ex_new_index(0 /* argl */, nullptr /* argp */,
+                                                      nullptr /* new_func */,
+                                                      nullptr /* dup_func */, CertificateMapFree);
+    return index;
+}
+
+static conscrypt::CertificateMap* toSslCtxCertificateMap(const SSL_CTX* ssl_ctx) {
+    return static_cast<conscrypt::CertificateMap*>(
+            SSL_CTX_get_ex_data(ssl_ctx, sslCtxCertificateMapIndex()));
+}
+
+/**
+ * Returns the native server session cache of ssl_ctx if it has been enabled, otherwise null.
+ */
+static conscrypt::ServerSessionCache* toEnabledServerSessionCache(const SSL_CTX* ssl_ctx) {
+    conscrypt::ServerSessionCache* cache = static_cast<conscrypt::ServerSessionCache*>(
+            SSL_CTX_get_ex_data(ssl_ctx, sslCtxServerSessionCacheIndex()));
+    return cache != nullptr && cache->enabled() ? cache : nullptr;
+}
+
+/**
+ * Adds delta to counter for both the connection and the SSL_CTX it currently belongs to.
+ */
+static void countSslEvent(const SSL* ssl, conscrypt::SslCounters::Counter counter,
+                          uint64_t delta) {
+    AppData* appData = toAppData(ssl);
+    if (appData != nullptr) {
+        appData->counters.add(counter, delta);
+    }
+    conscrypt::SharedSslCounters* ctxCounters = toSslCtxCounters(SSL_get_SSL_CTX(ssl));
+    if (ctxCounters != nullptr) {
+        ctxCounters->add(counter, delta);
+    }
+}
+
+/**
+ * Counts one upcall into Java, and the time spent in it, when it goes out of scope.
+ */
+class ScopedUpcallCounter {
+ public:
+    ScopedUpcallCounter(const SSL* ssl, conscrypt::SslCounters::Counter calls,
+                        conscrypt::SslCounters::Counter nanos)
+        : ssl_(ssl), calls_(calls), nanos_(nanos), start_(conscrypt::SslCounters::nowNanos()) {
+        CONSCRYPT_TRACE_EVENT(conscrypt::eventtrace::kCategoryCallbacks,
+                              conscrypt::eventtrace::kEventUpcallStart, ssl_, calls_);
+    }
+
+    ~ScopedUpcallCounter() {
+        uint64_t elapsed = conscrypt::SslCounters::nowNanos() - start_;
+        countSslEvent(ssl_, calls_, 1);
+        countSslEvent(ssl_, nanos_, elapsed);
+        CONSCRYPT_TRACE_EVENT(conscrypt::eventtrace::kCategoryCallbacks,
+                              conscrypt::eventtrace::kEventUpcallDone, ssl_, calls_, elapsed);
+    }
+
+ private:
+    const SSL* ssl_;
+    conscrypt::SslCounters::Counter calls_;
+    conscrypt::SslCounters::Counter nanos_;
+    uint64_t start_;
+
+    // Disallow copy and assignment.
+    ScopedUpcallCounter(const ScopedUpcallCounter&);
+    void operator=(const ScopedUpcallCounter&);
+};
+
+/**
+ * Message callback used only for its per-record notifications, which BoringSSL delivers with
+ * the record header for every record it seals or opens.
+ */
+static void record_counter_callback(int is_write, int /* version */, int content_type,
+                                    const void* buf, size_t len, SSL* ssl, void* /* arg */) {
+    if (content_type != SSL3_RT_HEADER || len < SSL3_RT_HEADER_LENGTH) {
+        return;
+    }
+    const uint8_t* header = static_cast<const uint8_t*>(buf);
+    uint64_t recordLength = (static_cast<uint64_t>(header[3]) << 8) | header[4];
+    if (is_write) {
+        countSslEvent(ssl, conscrypt::SslCounters::kRecordsSealed, 1);
+        countSslEvent(ssl, conscrypt::SslCounters::kBytesSealed, recordLength);
+    } else {
+        countSslEvent(ssl, conscrypt::SslCounters::kRecordsOpened, 1);
+        countSslEvent(ssl, conscrypt::SslCounters::kBytesOpened, recordLength);
+    }
+}
+
 static ssl_verify_result_t cert_verify_callback(SSL* ssl, CONSCRYPT_UNUSED uint8_t* out_alert) {
     JNI_TRACE("ssl=%p cert_verify_callback", ssl);
 
@@ -7209,25 +9130,46 @@ static ssl_verify_result_t cert_verify_callback(SSL* ssl, CONSCRYPT_UNUSED uint8
         return ssl_verify_invalid;
     }
 
+    const STACK_OF(CRYPTO_BUFFER)* peerCertificates = SSL_get0_peer_certificates(ssl);
+    const SSL_CIPHER* cipher = SSL_get_pending_cipher(ssl);
+    const char* authMethod = SSL_CIPHER_get_kx_name(cipher);
+
+    // A chain that this trust manager already accepted doesn't need to be verified again. The
+    // peer certificates are picked up by the Java side once the handshake completes, the same
+    // way as for a resumed session.
+    conscrypt::verifiedchaincache::Key cacheKey;
+    bool useCache = !appData->verifiedChainCacheIdentity.empty() &&
+                    conscrypt::verifiedchaincache::isEnabled() &&
+                    conscrypt::verifiedchaincache::computeKey(
+                            peerCertificates, appData->verifiedChainCacheIdentity.data(),
+                            appData->verifiedChainCacheIdentity.size(), authMethod, &cacheKey);
+    if (useCache && conscrypt::verifiedchaincache::lookup(cacheKey)) {
+        JNI_TRACE("ssl=%p cert_verify_callback => verified chain cache hit", ssl);
+        return ssl_verify_ok;
+    }
+
     // Create the byte[][] array that holds all the certs
-    ScopedLocalRef<jobjectArray> array(
-            env, CryptoBuffersToObjectArray(env, SSL_get0_peer_certificates(ssl)));
+    ScopedLocalRef<jobjectArray> array(env, CryptoBuffersToObjectArray(env, peerCertificates));
     if (array.get() == nullptr) {
         return ssl_verify_invalid;
     }
 
     jobject sslHandshakeCallbacks = appData->sslHandshakeCallbacks;
-    jmethodID methodID = conscrypt::jniutil::sslHandshakeCallbacks_verifyCertificateChain;
-
-    const SSL_CIPHER* cipher = SSL_get_pending_cipher(ssl);
-    const char* authMethod = SSL_CIPHER_get_kx_name(cipher);
+    jmethodID methodID = conscrypt::jniutil::sslHandshakeCallbacks_verifyCertificateChain.get(env);
 
     JNI_TRACE("ssl=%p cert_verify_callback calling verifyCertificateChain authMethod=%s", ssl,
               authMethod);
     ScopedLocalRef<jstring> authMethodString(env, env->NewStringUTF(authMethod));
-    env->CallVoidMethod(sslHandshakeCallbacks, methodID, array.get(), authMethodString.get());
+    {
+        ScopedUpcallCounter upcall(ssl, conscrypt::SslCounters::kCertVerifyCalls,
+                                   conscrypt::SslCounters::kCertVerifyNanos);
+        env->CallVoidMethod(sslHandshakeCallbacks, methodID, array.get(), authMethodString.get());
+    }
 
     ssl_verify_result_t result = env->ExceptionCheck() ? ssl_verify_invalid : ssl_verify_ok;
+    if (useCache && result == ssl_verify_ok) {
+        conscrypt::verifiedchaincache::insert(cacheKey);
+    }
     JNI_TRACE("ssl=%p cert_verify_callback => %d", ssl, result);
     return result;
 }
@@ -7242,6 +9184,12 @@ static void info_callback(const SSL* ssl, int type, int value) {
     if (conscrypt::trace::kWithJniTrace) {
         info_callback_LOG(ssl, type, value);
     }
+    if (type & SSL_CB_HANDSHAKE_DONE) {
+        countSslEvent(ssl,
+                      SSL_session_reused(ssl) ? conscrypt::SslCounters::kResumedHandshakes
+                                              : conscrypt::SslCounters::kFullHandshakes,
+                      1);
+    }
     if (!(type & SSL_CB_HANDSHAKE_DONE) && !(type & SSL_CB_HANDSHAKE_START)) {
         JNI_TRACE("ssl=%p info_callback ignored", ssl);
         return;
@@ -7263,7 +9211,8 @@ static void info_callback(const SSL* ssl, int type, int value) {
 
     JNI_TRACE("ssl=%p info_callback calling onSSLStateChange", ssl);
     env->CallVoidMethod(sslHandshakeCallbacks,
-                        conscrypt::jniutil::sslHandshakeCallbacks_onSSLStateChange, type, value);
+                        conscrypt::jniutil::sslHandshakeCallbacks_onSSLStateChange.get(env), type,
+                        value);
 
     if (env->ExceptionCheck()) {
         JNI_TRACE("ssl=%p info_callback exception", ssl);
@@ -7301,7 +9250,8 @@ static int cert_cb(SSL* ssl, CONSCRYPT_UNUSED void* arg) {
     }
     jobject sslHandshakeCallbacks = appData->sslHandshakeCallbacks;
 
-    jmethodID methodID = conscrypt::jniutil::sslHandshakeCallbacks_clientCertificateRequested;
+    jmethodID methodID =
+            conscrypt::jniutil::sslHandshakeCallbacks_clientCertificateRequested.get(env);
 
     // Call Java callback which can reconfigure the client certificate.
     const uint8_t* ctype = nullptr;
@@ -7347,7 +9297,12 @@ static int cert_cb(SSL* ssl, CONSCRYPT_UNUSED void* arg) {
             "ssl=%p clientCertificateRequested calling clientCertificateRequested "
             "keyTypes=%p signatureAlgs=%p issuers=%p",
             ssl, keyTypes, signatureAlgs, issuers.get());
-    env->CallVoidMethod(sslHandshakeCallbacks, methodID, keyTypes, signatureAlgs, issuers.get());
+    {
+        ScopedUpcallCounter upcall(ssl, conscrypt::SslCounters::kCertCbCalls,
+                                   conscrypt::SslCounters::kCertCbNanos);
+        env->CallVoidMethod(sslHandshakeCallbacks, methodID, keyTypes, signatureAlgs,
+                            issuers.get());
+    }
 
     if (env->ExceptionCheck()) {
         JNI_TRACE("ssl=%p cert_cb exception => 0", ssl);
@@ -7363,9 +9318,29 @@ static enum ssl_select_cert_result_t select_certificate_cb(const SSL_CLIENT_HELL
     JNI_TRACE("ssl=%p select_certificate_cb_callback", ssl);
 
     AppData* appData = toAppData(ssl);
-    JNIEnv* env = appData->env;
-    if (env == nullptr) {
-        CONSCRYPT_LOG_ERROR("AppData->env missing in select_certificate_cb");
+
+    // A host name in the certificate map is served without asking the key manager, unless
+    // SNI matchers have to vet the name first in configureServerCertificate().
+    const conscrypt::CertificateMap* certificateMap =
+            toSslCtxCertificateMap(SSL_get_SSL_CTX(ssl));
+    if (certificateMap != nullptr && !certificateMap->empty() && !appData->hasSniMatchers) {
+        std::shared_ptr<const conscrypt::ServerCredential> credential =
+                certificateMap->lookup(SSL_get_servername(ssl, TLSEXT_NAMETYPE_host_name));
+        if (credential != nullptr) {
+            if (!credential->install(ssl)) {
+                JNI_TRACE("ssl=%p select_certificate_cb mapped credential failed", ssl);
+                return ssl_select_cert_error;
+            }
+            appData->mappedCredential = std::move(credential);
+            countSslEvent(ssl, conscrypt::SslCounters::kCertificateMapHits, 1);
+            JNI_TRACE("ssl=%p select_certificate_cb => mapped credential", ssl);
+            return ssl_select_cert_success;
+        }
+    }
+
+    JNIEnv* env = appData->env;
+    if (env == nullptr) {
+        CONSCRYPT_LOG_ERROR("AppData->env missing in select_certificate_cb");
         JNI_TRACE("ssl=%p select_certificate_cb env error", ssl);
         return ssl_select_cert_error;
     }
@@ -7375,7 +9350,8 @@ static enum ssl_select_cert_result_t select_certificate_cb(const SSL_CLIENT_HELL
     }
 
     jobject sslHandshakeCallbacks = appData->sslHandshakeCallbacks;
-    jmethodID methodID = conscrypt::jniutil::sslHandshakeCallbacks_serverCertificateRequested;
+    jmethodID methodID =
+            conscrypt::jniutil::sslHandshakeCallbacks_serverCertificateRequested.get(env);
 
     JNI_TRACE("ssl=%p select_certificate_cb calling serverCertificateRequested", ssl);
     env->CallVoidMethod(sslHandshakeCallbacks, methodID);
@@ -7409,7 +9385,7 @@ static unsigned int psk_client_callback(SSL* ssl, const char* hint, char* identi
     }
 
     jobject sslHandshakeCallbacks = appData->sslHandshakeCallbacks;
-    jmethodID methodID = conscrypt::jniutil::sslHandshakeCallbacks_clientPSKKeyRequested;
+    jmethodID methodID = conscrypt::jniutil::sslHandshakeCallbacks_clientPSKKeyRequested.get(env);
     JNI_TRACE("ssl=%p psk_client_callback calling clientPSKKeyRequested", ssl);
     ScopedLocalRef<jstring> identityHintJava(env,
                                              (hint != nullptr) ? env->NewStringUTF(hint) : nullptr);
@@ -7475,7 +9451,7 @@ static unsigned int psk_server_callback(SSL* ssl, const char* identity, unsigned
     }
 
     jobject sslHandshakeCallbacks = appData->sslHandshakeCallbacks;
-    jmethodID methodID = conscrypt::jniutil::sslHandshakeCallbacks_serverPSKKeyRequested;
+    jmethodID methodID = conscrypt::jniutil::sslHandshakeCallbacks_serverPSKKeyRequested.get(env);
     JNI_TRACE("ssl=%p psk_server_callback calling serverPSKKeyRequested", ssl);
     const char* identityHint = SSL_get_psk_identity_hint(ssl);
     ScopedLocalRef<jstring> identityHintJava(
@@ -7514,6 +9490,16 @@ static unsigned int psk_server_callback(SSL* ssl, const char* identity, unsigned
 static int new_session_callback(SSL* ssl, SSL_SESSION* session) {
     JNI_TRACE("ssl=%p new_session_callback session=%p", ssl, session);
 
+    if (SSL_is_server(ssl)) {
+        conscrypt::ServerSessionCache* cache = toEnabledServerSessionCache(SSL_get_SSL_CTX(ssl));
+        if (cache != nullptr) {
+            // The cache takes its own reference; Java never sees server sessions in this mode.
+            cache->insert(session);
+            JNI_TRACE("ssl=%p new_session_callback cached natively", ssl);
+            return 0;
+        }
+    }
+
     AppData* appData = toAppData(ssl);
     JNIEnv* env = appData->env;
     if (env == nullptr) {
@@ -7527,9 +9513,13 @@ static int new_session_callback(SSL* ssl, SSL_SESSION* session) {
     }
 
     jobject sslHandshakeCallbacks = appData->sslHandshakeCallbacks;
-    jmethodID methodID = conscrypt::jniutil::sslHandshakeCallbacks_onNewSessionEstablished;
+    jmethodID methodID = conscrypt::jniutil::sslHandshakeCallbacks_onNewSessionEstablished.get(env);
     JNI_TRACE("ssl=%p new_session_callback calling onNewSessionEstablished", ssl);
-    env->CallVoidMethod(sslHandshakeCallbacks, methodID, reinterpret_cast<jlong>(session));
+    {
+        ScopedUpcallCounter upcall(ssl, conscrypt::SslCounters::kNewSessionCalls,
+                                   conscrypt::SslCounters::kNewSessionNanos);
+        env->CallVoidMethod(sslHandshakeCallbacks, methodID, reinterpret_cast<jlong>(session));
+    }
     if (env->ExceptionCheck()) {
         JNI_TRACE("ssl=%p new_session_callback exception cleared", ssl);
         env->ExceptionClear();
@@ -7549,6 +9539,14 @@ static SSL_SESSION* server_session_requested_callback(SSL* ssl, const uint8_t* i
     // the reference count (and any required synchronization).
     *out_copy = 0;
 
+    conscrypt::ServerSessionCache* cache = toEnabledServerSessionCache(SSL_get_SSL_CTX(ssl));
+    if (cache != nullptr) {
+        // lookup() already returns a new reference, which BoringSSL takes over.
+        SSL_SESSION* cached = cache->lookup(id, static_cast<size_t>(id_len)).release();
+        JNI_TRACE("ssl=%p server_session_requested_callback native => %p", ssl, cached);
+        return cached;
+    }
+
     AppData* appData = toAppData(ssl);
     JNIEnv* env = appData->env;
     if (env == nullptr) {
@@ -7571,7 +9569,7 @@ static SSL_SESSION* server_session_requested_callback(SSL* ssl, const uint8_t* i
                             reinterpret_cast<const jbyte*>(id));
 
     jobject sslHandshakeCallbacks = appData->sslHandshakeCallbacks;
-    jmethodID methodID = conscrypt::jniutil::sslHandshakeCallbacks_serverSessionRequested;
+    jmethodID methodID = conscrypt::jniutil::sslHandshakeCallbacks_serverSessionRequested.get(env);
     JNI_TRACE("ssl=%p server_session_requested_callback calling serverSessionRequested", ssl);
     jlong ssl_session_address = env->CallLongMethod(sslHandshakeCallbacks, methodID, id_array);
     if (env->ExceptionCheck()) {
@@ -7654,6 +9652,41 @@ static jlong NativeCrypto_SSL_CTX_new(JNIEnv* env, jclass) {
     SSL_CTX_set_min_proto_version(sslCtx.get(), TLS1_VERSION);
     SSL_CTX_set_max_proto_version(sslCtx.get(), TLS1_2_VERSION);
 
+    // Share certificate storage for peer chains with every other SSL_CTX in the process.
+    SSL_CTX_set0_buffer_pool(sslCtx.get(), GetSharedCryptoBufferPool());
+
+    std::unique_ptr<conscrypt::SharedSslCounters> counters(new conscrypt::SharedSslCounters());
+    if (!SSL_CTX_set_ex_data(sslCtx.get(), sslCtxCountersIndex(), counters.get())) {
+        conscrypt::jniutil::throwExceptionFromBoringSSLError(env, "SSL_CTX_set_ex_data");
+        return 0;
+    }
+    counters.release();
+
+    // Attached up front, like the counters, so that installing keys later never has to modify
+    // the ex_data of an SSL_CTX that handshakes are already reading.
+    std::unique_ptr<conscrypt::TicketKeys> ticketKeys(new conscrypt::TicketKeys());
+    if (!SSL_CTX_set_ex_data(sslCtx.get(), sslCtxTicketKeysIndex(), ticketKeys.get())) {
+        conscrypt::jniutil::throwExceptionFromBoringSSLError(env, "SSL_CTX_set_ex_data");
+        return 0;
+    }
+    ticketKeys.release();
+
+    std::unique_ptr<conscrypt::ServerSessionCache> sessionCache(
+            new conscrypt::ServerSessionCache());
+    if (!SSL_CTX_set_ex_data(sslCtx.get(), sslCtxServerSessionCacheIndex(),
+                             sessionCache.get())) {
+        conscrypt::jniutil::throwExceptionFromBoringSSLError(env, "SSL_CTX_set_ex_data");
+        return 0;
+    }
+    sessionCache.release();
+
+    std::unique_ptr<conscrypt::CertificateMap> certificateMap(new conscrypt::CertificateMap());
+    if (!SSL_CTX_set_ex_data(sslCtx.get(), sslCtxCertificateMapIndex(), certificateMap.get())) {
+        conscrypt::jniutil::throwExceptionFromBoringSSLError(env, "SSL_CTX_set_ex_data");
+        return 0;
+    }
+    certificateMap.release();
+
     uint32_t mode = SSL_CTX_get_mode(sslCtx.get());
     /*
      * Turn on "partial write" mode. This means that SSL_write() will
@@ -7681,6 +9714,7 @@ static jlong NativeCrypto_SSL_CTX_new(JNIEnv* env, jclass) {
     SSL_CTX_set_mode(sslCtx.get(), mode);
 
     SSL_CTX_set_info_callback(sslCtx.get(), info_callback);
+    SSL_CTX_set_msg_callback(sslCtx.get(), record_counter_callback);
     SSL_CTX_set_cert_cb(sslCtx.get(), cert_cb, nullptr);
     SSL_CTX_set_select_certificate_cb(sslCtx.get(), select_certificate_cb);
     if (conscrypt::trace::kWithJniTraceKeys) {
@@ -7699,6 +9733,296 @@ static jlong NativeCrypto_SSL_CTX_new(JNIEnv* env, jclass) {
     return (jlong)sslCtx.release();
 }
 
+/*
+ * public static native long[] CRYPTO_BUFFER_POOL_get_stats();
+ */
+static jlongArray NativeCrypto_CRYPTO_BUFFER_POOL_get_stats(JNIEnv* env, jclass) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    jlong stats[] = {
+            static_cast<jlong>(g_crypto_buffer_pool_requests.load(std::memory_order_relaxed)),
+    };
+    jlongArray result = env->NewLongArray(1);
+    if (result == nullptr) {
+        JNI_TRACE("NativeCrypto_CRYPTO_BUFFER_POOL_get_stats => failed to allocate array");
+        return nullptr;
+    }
+    env->SetLongArrayRegion(result, 0, 1, stats);
+    JNI_TRACE("NativeCrypto_CRYPTO_BUFFER_POOL_get_stats => requests=%lld",
+              (long long)stats[0]);  // NOLINT(runtime/int)
+    return result;
+}
+
+// Copies a snapshot of an SslCounters or SharedSslCounters into a new long[].
+template <typename Counters>
+static jlongArray countersToJavaArray(JNIEnv* env, const Counters& counters) {
+    uint64_t values[conscrypt::SslCounters::kCount];
+    counters.snapshot(values);
+    jlong result[conscrypt::SslCounters::kCount];
+    for (int i = 0; i < conscrypt::SslCounters::kCount; i++) {
+        result[i] = static_cast<jlong>(values[i]);
+    }
+    jlongArray array = env->NewLongArray(conscrypt::SslCounters::kCount);
+    if (array == nullptr) {
+        return nullptr;
+    }
+    env->SetLongArrayRegion(array, 0, conscrypt::SslCounters::kCount, result);
+    return array;
+}
+
+/*
+ * public static native long[] SSL_CTX_get_counters(long ssl_ctx, AbstractSessionContext holder);
+ */
+static jlongArray NativeCrypto_SSL_CTX_get_counters(JNIEnv* env, jclass, jlong ssl_ctx_address,
+                                                    CONSCRYPT_UNUSED jobject holder) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    SSL_CTX* ssl_ctx = to_SSL_CTX(env, ssl_ctx_address, true);
+    JNI_TRACE("ssl_ctx=%p NativeCrypto_SSL_CTX_get_counters", ssl_ctx);
+    if (ssl_ctx == nullptr) {
+        return nullptr;
+    }
+    conscrypt::SharedSslCounters* counters = toSslCtxCounters(ssl_ctx);
+    if (counters == nullptr) {
+        conscrypt::jniutil::throwRuntimeException(env, "SSL_CTX has no counters");
+        return nullptr;
+    }
+    return countersToJavaArray(env, *counters);
+}
+
+static int ticket_key_callback(SSL* ssl, uint8_t* key_name, uint8_t* iv, EVP_CIPHER_CTX* ctx,
+                               HMAC_CTX* hmac_ctx, int encrypt) {
+    const conscrypt::TicketKeys* keys = toSslCtxTicketKeys(SSL_get_SSL_CTX(ssl));
+    if (keys == nullptr) {
+        return -1;
+    }
+    int ret = keys->process(key_name, iv, ctx, hmac_ctx, encrypt);
+    JNI_TRACE("ssl=%p ticket_key_callback encrypt=%d => %d", ssl, encrypt, ret);
+    return ret;
+}
+
+/*
+ * public static native void SSL_CTX_set_ticket_keys(long ssl_ctx, AbstractSessionContext holder,
+ *                                                   byte[] keys);
+ */
+static void NativeCrypto_SSL_CTX_set_ticket_keys(JNIEnv* env, jclass, jlong ssl_ctx_address,
+                                                 CONSCRYPT_UNUSED jobject holder,
+                                                 jbyteArray keysJava) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    SSL_CTX* ssl_ctx = to_SSL_CTX(env, ssl_ctx_address, true);
+    JNI_TRACE("ssl_ctx=%p NativeCrypto_SSL_CTX_set_ticket_keys keys=%p", ssl_ctx, keysJava);
+    if (ssl_ctx == nullptr) {
+        return;
+    }
+    ScopedByteArrayRO keys(env, keysJava);
+    if (keys.get() == nullptr) {
+        JNI_TRACE("ssl_ctx=%p NativeCrypto_SSL_CTX_set_ticket_keys => keys == null", ssl_ctx);
+        return;
+    }
+    if (keys.size() == 0 || keys.size() % conscrypt::TicketKeys::kKeyLength != 0) {
+        conscrypt::jniutil::throwException(env, "java/lang/IllegalArgumentException",
+                                           "keys must be a non-empty multiple of 48 bytes");
+        JNI_TRACE("ssl_ctx=%p NativeCrypto_SSL_CTX_set_ticket_keys => bad length %zu", ssl_ctx,
+                  keys.size());
+        return;
+    }
+    conscrypt::TicketKeys* ticketKeys = toSslCtxTicketKeys(ssl_ctx);
+    if (ticketKeys == nullptr) {
+        conscrypt::jniutil::throwRuntimeException(env, "SSL_CTX has no ticket keys");
+        return;
+    }
+
+    bool firstKeys = !ticketKeys->hasKeys();
+    ticketKeys->setKeys(reinterpret_cast<const uint8_t*>(keys.get()),
+                        keys.size() / conscrypt::TicketKeys::kKeyLength);
+    if (firstKeys) {
+        // Later calls only swap the key set, which is safe while handshakes are running.
+        SSL_CTX_set_tlsext_ticket_key_cb(ssl_ctx, ticket_key_callback);
+    }
+    JNI_TRACE("ssl_ctx=%p NativeCrypto_SSL_CTX_set_ticket_keys => %zu keys", ssl_ctx,
+              keys.size() / conscrypt::TicketKeys::kKeyLength);
+}
+
+/**
+ * public static native void SSL_CTX_set_server_session_cache(long ssl_ctx,
+ *         AbstractSessionContext holder, int maxEntries, int timeoutSeconds)
+ */
+static void NativeCrypto_SSL_CTX_set_server_session_cache(JNIEnv* env, jclass,
+                                                          jlong ssl_ctx_address,
+                                                          CONSCRYPT_UNUSED jobject holder,
+                                                          jint maxEntries, jint timeoutSeconds) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    SSL_CTX* ssl_ctx = to_SSL_CTX(env, ssl_ctx_address, true);
+    JNI_TRACE("ssl_ctx=%p NativeCrypto_SSL_CTX_set_server_session_cache maxEntries=%d "
+              "timeoutSeconds=%d",
+              ssl_ctx, maxEntries, timeoutSeconds);
+    if (ssl_ctx == nullptr) {
+        return;
+    }
+    if (maxEntries < 0 || timeoutSeconds < 0) {
+        conscrypt::jniutil::throwException(env, "java/lang/IllegalArgumentException",
+                                           "maxEntries and timeoutSeconds must be >= 0");
+        return;
+    }
+    conscrypt::ServerSessionCache* cache = static_cast<conscrypt::ServerSessionCache*>(
+            SSL_CTX_get_ex_data(ssl_ctx, sslCtxServerSessionCacheIndex()));
+    if (cache == nullptr) {
+        conscrypt::jniutil::throwRuntimeException(env, "SSL_CTX has no server session cache");
+        return;
+    }
+
+    cache->configure(static_cast<size_t>(maxEntries), static_cast<uint32_t>(timeoutSeconds));
+    // BoringSSL's own cache sits behind a single lock and would hold a second copy of every
+    // session, so it is bypassed while the native cache is in use.
+    int mode = SSL_SESS_CACHE_BOTH;
+    if (maxEntries > 0) {
+        mode |= SSL_SESS_CACHE_NO_INTERNAL;
+    }
+    SSL_CTX_set_session_cache_mode(ssl_ctx, mode);
+    JNI_TRACE("ssl_ctx=%p NativeCrypto_SSL_CTX_set_server_session_cache => mode=%d", ssl_ctx,
+              mode);
+}
+
+/**
+ * public static native long SERVER_CREDENTIAL_new(byte[][] chain, NativeRef.EVP_PKEY key,
+ *                                                 byte[] ocspResponse, byte[] sctList)
+ */
+static jlong NativeCrypto_SERVER_CREDENTIAL_new(JNIEnv* env, jclass, jobjectArray chainJava,
+                                                jobject pkeyRef, jbyteArray ocspResponseJava,
+                                                jbyteArray sctListJava) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    JNI_TRACE("SERVER_CREDENTIAL_new(%p, %p, %p, %p)", chainJava, pkeyRef, ocspResponseJava,
+              sctListJava);
+    if (chainJava == nullptr) {
+        conscrypt::jniutil::throwNullPointerException(env, "chain == null");
+        return 0;
+    }
+    size_t numCerts = static_cast<size_t>(env->GetArrayLength(chainJava));
+    if (numCerts == 0) {
+        conscrypt::jniutil::throwException(env, "java/lang/IllegalArgumentException",
+                                           "chain.length == 0");
+        return 0;
+    }
+    if (pkeyRef == nullptr) {
+        conscrypt::jniutil::throwNullPointerException(env, "privateKey == null");
+        return 0;
+    }
+    EVP_PKEY* pkey = fromContextObject<EVP_PKEY>(env, pkeyRef);
+    if (pkey == nullptr) {
+        conscrypt::jniutil::throwNullPointerException(env, "pkey == null");
+        return 0;
+    }
+
+    std::shared_ptr<conscrypt::ServerCredential> credential =
+            std::make_shared<conscrypt::ServerCredential>();
+    credential->chain.resize(numCerts);
+    for (size_t i = 0; i < numCerts; ++i) {
+        ScopedLocalRef<jbyteArray> certArray(
+                env, reinterpret_cast<jbyteArray>(env->GetObjectArrayElement(chainJava, i)));
+        credential->chain[i] =
+                ByteArrayToCryptoBuffer(env, certArray.get(), GetSharedCryptoBufferPool());
+        if (!credential->chain[i]) {
+            return 0;
+        }
+    }
+    EVP_PKEY_up_ref(pkey);
+    credential->privateKey.reset(pkey);
+    if (ocspResponseJava != nullptr) {
+        ScopedByteArrayRO ocspResponse(env, ocspResponseJava);
+        if (ocspResponse.get() == nullptr) {
+            return 0;
+        }
+        const uint8_t* data = reinterpret_cast<const uint8_t*>(ocspResponse.get());
+        credential->ocspResponse.assign(data, data + ocspResponse.size());
+    }
+    if (sctListJava != nullptr) {
+        ScopedByteArrayRO sctList(env, sctListJava);
+        if (sctList.get() == nullptr) {
+            return 0;
+        }
+        const uint8_t* data = reinterpret_cast<const uint8_t*>(sctList.get());
+        credential->signedCertTimestampList.assign(data, data + sctList.size());
+    }
+
+    // Java holds one reference; each map and connection using the credential holds another.
+    auto* ref = new std::shared_ptr<const conscrypt::ServerCredential>(std::move(credential));
+    JNI_TRACE("SERVER_CREDENTIAL_new => %p", ref);
+    return reinterpret_cast<uintptr_t>(ref);
+}
+
+static void NativeCrypto_SERVER_CREDENTIAL_free(JNIEnv* env, jclass, jlong credentialRef) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    auto* ref = reinterpret_cast<std::shared_ptr<const conscrypt::ServerCredential>*>(
+            static_cast<uintptr_t>(credentialRef));
+    JNI_TRACE("SERVER_CREDENTIAL_free(%p)", ref);
+    if (ref == nullptr) {
+        conscrypt::jniutil::throwNullPointerException(env, "credential == null");
+        return;
+    }
+    delete ref;
+}
+
+/**
+ * public static native void SSL_CTX_set_certificate_map(long ssl_ctx,
+ *         AbstractSessionContext holder, String[] hostNames, long[] credentials)
+ */
+static void NativeCrypto_SSL_CTX_set_certificate_map(JNIEnv* env, jclass, jlong ssl_ctx_address,
+                                                     CONSCRYPT_UNUSED jobject holder,
+                                                     jobjectArray hostNamesJava,
+                                                     jlongArray credentialsJava) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    SSL_CTX* ssl_ctx = to_SSL_CTX(env, ssl_ctx_address, true);
+    JNI_TRACE("ssl_ctx=%p NativeCrypto_SSL_CTX_set_certificate_map hostNames=%p credentials=%p",
+              ssl_ctx, hostNamesJava, credentialsJava);
+    if (ssl_ctx == nullptr) {
+        return;
+    }
+    if (hostNamesJava == nullptr || credentialsJava == nullptr) {
+        conscrypt::jniutil::throwNullPointerException(env, "hostNames or credentials == null");
+        return;
+    }
+    ScopedLongArrayRO credentials(env, credentialsJava);
+    if (credentials.get() == nullptr) {
+        return;
+    }
+    size_t count = static_cast<size_t>(env->GetArrayLength(hostNamesJava));
+    if (credentials.size() != count) {
+        conscrypt::jniutil::throwException(env, "java/lang/IllegalArgumentException",
+                                           "hostNames.length != credentials.length");
+        return;
+    }
+    conscrypt::CertificateMap* certificateMap = toSslCtxCertificateMap(ssl_ctx);
+    if (certificateMap == nullptr) {
+        conscrypt::jniutil::throwRuntimeException(env, "SSL_CTX has no certificate map");
+        return;
+    }
+
+    conscrypt::CertificateMap::Entries entries;
+    entries.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        ScopedLocalRef<jstring> hostNameJava(
+                env, reinterpret_cast<jstring>(env->GetObjectArrayElement(hostNamesJava, i)));
+        auto* credential =
+                reinterpret_cast<const std::shared_ptr<const conscrypt::ServerCredential>*>(
+                        static_cast<uintptr_t>(credentials[i]));
+        if (hostNameJava.get() == nullptr || credential == nullptr) {
+            conscrypt::jniutil::throwNullPointerException(env, "null host name or credential");
+            return;
+        }
+        ScopedUtfChars hostName(env, hostNameJava.get());
+        if (hostName.c_str() == nullptr) {
+            return;
+        }
+        entries.emplace_back(std::string(hostName.c_str(), hostName.size()), *credential);
+    }
+
+    if (!certificateMap->replace(entries)) {
+        conscrypt::jniutil::throwException(env, "java/lang/IllegalArgumentException",
+                                           "Invalid host name");
+        return;
+    }
+    JNI_TRACE("ssl_ctx=%p NativeCrypto_SSL_CTX_set_certificate_map => %zu names", ssl_ctx,
+              certificateMap->size());
+}
+
 /**
  * public static native void SSL_CTX_free(long ssl_ctx)
  */
@@ -7794,6 +10118,8 @@ static jlong NativeCrypto_SSL_new(JNIEnv* env, jclass, jlong ssl_ctx_address,
     SSL_set_custom_verify(ssl.get(), SSL_VERIFY_PEER, cert_verify_callback);
 
     JNI_TRACE("ssl_ctx=%p NativeCrypto_SSL_new => ssl=%p appData=%p", ssl_ctx, ssl.get(), appData);
+    CONSCRYPT_TRACE_EVENT(conscrypt::eventtrace::kCategorySsl, conscrypt::eventtrace::kEventSslNew,
+                          ssl.get(), reinterpret_cast<uintptr_t>(ssl_ctx));
     return (jlong)ssl.release();
 }
 
@@ -7930,7 +10256,7 @@ static void NativeCrypto_setLocalCertsAndPrivateKey(JNIEnv* env, jclass, jlong s
         ScopedLocalRef<jbyteArray> certArray(
                 env, reinterpret_cast<jbyteArray>(
                              env->GetObjectArrayElement(encodedCertificatesJava, i)));
-        certBufferRefs[i] = ByteArrayToCryptoBuffer(env, certArray.get(), nullptr);
+        certBufferRefs[i] = ByteArrayToCryptoBuffer(env, certArray.get(), GetSharedCryptoBufferPool());
         if (!certBufferRefs[i]) {
             return;
         }
@@ -7946,6 +10272,232 @@ static void NativeCrypto_setLocalCertsAndPrivateKey(JNIEnv* env, jclass, jlong s
     JNI_TRACE("ssl=%p NativeCrypto_SSL_set_chain_and_key => ok", ssl);
 }
 
+// Private-key method installed by SSL_set_delegated_private_key. sign and decrypt only record
+// their input and ask the handshake to retry; SSL_do_delegated_key_operation then performs the
+// operation on whichever thread the caller chooses, and complete hands its result back to
+// the next SSL_do_handshake().
+static enum ssl_private_key_result_t delegatedKeyStart(SSL* ssl, bool isSign,
+                                                       uint16_t signatureAlgorithm,
+                                                       const uint8_t* in, size_t in_len) {
+    AppData* appData = toAppData(ssl);
+    if (appData == nullptr || !appData->delegatedKey) {
+        OPENSSL_PUT_ERROR(SSL, ERR_R_INTERNAL_ERROR);
+        return ssl_private_key_failure;
+    }
+    conscrypt::DelegatedKeyOperation& op = appData->delegatedKeyOperation;
+    std::lock_guard<std::mutex> lock(op.mutex);
+    op.state = conscrypt::DelegatedKeyOperation::kPending;
+    op.isSign = isSign;
+    op.signatureAlgorithm = signatureAlgorithm;
+    op.input.assign(in, in + in_len);
+    op.output.clear();
+    JNI_TRACE("ssl=%p delegatedKeyStart isSign=%d sigalg=0x%04x in_len=%zu => retry", ssl, isSign,
+              signatureAlgorithm, in_len);
+    return ssl_private_key_retry;
+}
+
+static enum ssl_private_key_result_t delegated_key_sign(SSL* ssl, CONSCRYPT_UNUSED uint8_t* out,
+                                                        CONSCRYPT_UNUSED size_t* out_len,
+                                                        CONSCRYPT_UNUSED size_t max_out,
+                                                        uint16_t signature_algorithm,
+                                                        const uint8_t* in, size_t in_len) {
+    return delegatedKeyStart(ssl, true, signature_algorithm, in, in_len);
+}
+
+static enum ssl_private_key_result_t delegated_key_decrypt(SSL* ssl,
+                                                           CONSCRYPT_UNUSED uint8_t* out,
+                                                           CONSCRYPT_UNUSED size_t* out_len,
+                                                           CONSCRYPT_UNUSED size_t max_out,
+                                                           const uint8_t* in, size_t in_len) {
+    return delegatedKeyStart(ssl, false, 0, in, in_len);
+}
+
+static enum ssl_private_key_result_t delegated_key_complete(SSL* ssl, uint8_t* out,
+                                                            size_t* out_len, size_t max_out) {
+    AppData* appData = toAppData(ssl);
+    if (appData == nullptr) {
+        OPENSSL_PUT_ERROR(SSL, ERR_R_INTERNAL_ERROR);
+        return ssl_private_key_failure;
+    }
+    conscrypt::DelegatedKeyOperation& op = appData->delegatedKeyOperation;
+    std::lock_guard<std::mutex> lock(op.mutex);
+    switch (op.state) {
+        case conscrypt::DelegatedKeyOperation::kDone:
+            op.state = conscrypt::DelegatedKeyOperation::kIdle;
+            if (op.output.size() > max_out) {
+                OPENSSL_PUT_ERROR(SSL, SSL_R_PRIVATE_KEY_OPERATION_FAILED);
+                return ssl_private_key_failure;
+            }
+            memcpy(out, op.output.data(), op.output.size());
+            *out_len = op.output.size();
+            op.output.clear();
+            return ssl_private_key_success;
+        case conscrypt::DelegatedKeyOperation::kFailed:
+            op.state = conscrypt::DelegatedKeyOperation::kIdle;
+            OPENSSL_PUT_ERROR(SSL, SSL_R_PRIVATE_KEY_OPERATION_FAILED);
+            return ssl_private_key_failure;
+        default:
+            return ssl_private_key_retry;
+    }
+}
+
+static const SSL_PRIVATE_KEY_METHOD kDelegatedKeyMethod = {
+        delegated_key_sign,
+        delegated_key_decrypt,
+        delegated_key_complete,
+};
+
+// Performs a recorded key operation the same way BoringSSL would have in-line.
+static bool runDelegatedKeyOperation(EVP_PKEY* pkey, bool isSign, uint16_t signatureAlgorithm,
+                                     const std::vector<uint8_t>& in,
+                                     std::vector<uint8_t>* out) {
+    if (!isSign) {
+        // Only RSA key exchange decrypts, and it expects a raw private-key operation.
+        RSA* rsa = EVP_PKEY_get0_RSA(pkey);
+        if (rsa == nullptr) {
+            OPENSSL_PUT_ERROR(SSL, SSL_R_WRONG_CERTIFICATE_TYPE);
+            return false;
+        }
+        out->resize(RSA_size(rsa));
+        size_t len;
+        if (!RSA_decrypt(rsa, &len, out->data(), out->size(), in.data(), in.size(),
+                         RSA_NO_PADDING)) {
+            return false;
+        }
+        out->resize(len);
+        return true;
+    }
+
+    // The digest is null for algorithms such as Ed25519 that hash internally.
+    const EVP_MD* md = SSL_get_signature_algorithm_digest(signatureAlgorithm);
+    bssl::ScopedEVP_MD_CTX ctx;
+    EVP_PKEY_CTX* pctx;
+    if (!EVP_DigestSignInit(ctx.get(), &pctx, md, nullptr, pkey)) {
+        return false;
+    }
+    if (SSL_is_signature_algorithm_rsa_pss(signatureAlgorithm) &&
+        (!EVP_PKEY_CTX_set_rsa_padding(pctx, RSA_PKCS1_PSS_PADDING) ||
+         !EVP_PKEY_CTX_set_rsa_pss_saltlen(pctx, -1 /* salt len = hash len */))) {
+        return false;
+    }
+    size_t len;
+    if (!EVP_DigestSign(ctx.get(), nullptr, &len, in.data(), in.size())) {
+        return false;
+    }
+    out->resize(len);
+    if (!EVP_DigestSign(ctx.get(), out->data(), &len, in.data(), in.size())) {
+        return false;
+    }
+    out->resize(len);
+    return true;
+}
+
+static void NativeCrypto_SSL_set_delegated_private_key(JNIEnv* env, jclass, jlong ssl_address,
+                                                       CONSCRYPT_UNUSED jobject ssl_holder,
+                                                       jobject pkeyRef) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    SSL* ssl = to_SSL(env, ssl_address, true);
+    JNI_TRACE("ssl=%p NativeCrypto_SSL_set_delegated_private_key privateKey=%p", ssl, pkeyRef);
+    if (ssl == nullptr) {
+        return;
+    }
+    EVP_PKEY* pkey = fromContextObject<EVP_PKEY>(env, pkeyRef);
+    if (pkey == nullptr) {
+        JNI_TRACE("ssl=%p NativeCrypto_SSL_set_delegated_private_key => pkey == null", ssl);
+        return;
+    }
+    AppData* appData = toAppData(ssl);
+    if (appData == nullptr) {
+        conscrypt::jniutil::throwSSLExceptionStr(env, "Unable to retrieve application data");
+        JNI_TRACE("ssl=%p NativeCrypto_SSL_set_delegated_private_key => appData == null", ssl);
+        return;
+    }
+
+    EVP_PKEY_up_ref(pkey);
+    appData->delegatedKey.reset(pkey);
+    SSL_set_private_key_method(ssl, &kDelegatedKeyMethod);
+    JNI_TRACE("ssl=%p NativeCrypto_SSL_set_delegated_private_key => ok", ssl);
+}
+
+static jboolean NativeCrypto_SSL_delegated_key_operation_pending(
+        JNIEnv* env, jclass, jlong ssl_address, CONSCRYPT_UNUSED jobject ssl_holder) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    SSL* ssl = to_SSL(env, ssl_address, true);
+    if (ssl == nullptr) {
+        return JNI_FALSE;
+    }
+    AppData* appData = toAppData(ssl);
+    if (appData == nullptr) {
+        return JNI_FALSE;
+    }
+    conscrypt::DelegatedKeyOperation& op = appData->delegatedKeyOperation;
+    std::lock_guard<std::mutex> lock(op.mutex);
+    bool pending = op.state == conscrypt::DelegatedKeyOperation::kPending ||
+                   op.state == conscrypt::DelegatedKeyOperation::kRunning;
+    JNI_TRACE("ssl=%p NativeCrypto_SSL_delegated_key_operation_pending => %d", ssl, pending);
+    return static_cast<jboolean>(pending);
+}
+
+static void NativeCrypto_SSL_do_delegated_key_operation(JNIEnv* env, jclass, jlong ssl_address,
+                                                        CONSCRYPT_UNUSED jobject ssl_holder) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    SSL* ssl = to_SSL(env, ssl_address, true);
+    JNI_TRACE("ssl=%p NativeCrypto_SSL_do_delegated_key_operation", ssl);
+    if (ssl == nullptr) {
+        return;
+    }
+    AppData* appData = toAppData(ssl);
+    if (appData == nullptr || !appData->delegatedKey) {
+        conscrypt::jniutil::throwException(env, "java/lang/IllegalStateException",
+                                           "No delegated private key");
+        JNI_TRACE("ssl=%p NativeCrypto_SSL_do_delegated_key_operation => no key", ssl);
+        return;
+    }
+
+    conscrypt::DelegatedKeyOperation& op = appData->delegatedKeyOperation;
+    bool isSign;
+    uint16_t signatureAlgorithm;
+    std::vector<uint8_t> input;
+    {
+        std::lock_guard<std::mutex> lock(op.mutex);
+        if (op.state != conscrypt::DelegatedKeyOperation::kPending) {
+            JNI_TRACE("ssl=%p NativeCrypto_SSL_do_delegated_key_operation => nothing pending",
+                      ssl);
+            return;
+        }
+        op.state = conscrypt::DelegatedKeyOperation::kRunning;
+        isSign = op.isSign;
+        signatureAlgorithm = op.signatureAlgorithm;
+        input.swap(op.input);
+    }
+
+    // The lock is not held here: with a key backed by a remote signer this is the slow part,
+    // and the handshake only needs the lock to poll for the outcome.
+    std::vector<uint8_t> output;
+    bool ok = runDelegatedKeyOperation(appData->delegatedKey.get(), isSign, signatureAlgorithm,
+                                       input, &output);
+    {
+        std::lock_guard<std::mutex> lock(op.mutex);
+        op.state = ok ? conscrypt::DelegatedKeyOperation::kDone
+                      : conscrypt::DelegatedKeyOperation::kFailed;
+        op.output.swap(output);
+    }
+
+    if (!ok) {
+        if (env->ExceptionCheck()) {
+            // The Java key threw; let that exception describe the failure.
+            ERR_clear_error();
+        } else {
+            conscrypt::jniutil::throwExceptionFromBoringSSLError(
+                    env, "SSL_do_delegated_key_operation",
+                    conscrypt::jniutil::throwSSLExceptionStr);
+        }
+        JNI_TRACE("ssl=%p NativeCrypto_SSL_do_delegated_key_operation => failed", ssl);
+        return;
+    }
+    JNI_TRACE("ssl=%p NativeCrypto_SSL_do_delegated_key_operation => ok", ssl);
+}
+
 static void NativeCrypto_SSL_set_client_CA_list(JNIEnv* env, jclass, jlong ssl_address,
                                                 CONSCRYPT_UNUSED jobject ssl_holder,
                                                 jobjectArray principals) {
@@ -7979,7 +10531,8 @@ static void NativeCrypto_SSL_set_client_CA_list(JNIEnv* env, jclass, jlong ssl_a
     for (int i = 0; i < length; i++) {
         ScopedLocalRef<jbyteArray> principal(
                 env, reinterpret_cast<jbyteArray>(env->GetObjectArrayElement(principals, i)));
-        bssl::UniquePtr<CRYPTO_BUFFER> buf = ByteArrayToCryptoBuffer(env, principal.get(), nullptr);
+        bssl::UniquePtr<CRYPTO_BUFFER> buf =
+                ByteArrayToCryptoBuffer(env, principal.get(), GetSharedCryptoBufferPool());
         if (!buf) {
             return;
         }
@@ -8596,21 +11149,92 @@ static jboolean NativeCrypto_SSL_session_reused(JNIEnv* env, jclass, jlong ssl_a
     return static_cast<jboolean>(reused);
 }
 
-static void NativeCrypto_SSL_accept_renegotiations(JNIEnv* env, jclass, jlong ssl_address,
-                                                   CONSCRYPT_UNUSED jobject ssl_holder) {
+static void NativeCrypto_SSL_set_early_data_enabled(JNIEnv* env, jclass, jlong ssl_address,
+                                                    CONSCRYPT_UNUSED jobject ssl_holder,
+                                                    jboolean enabled) {
     CHECK_ERROR_QUEUE_ON_RETURN;
     SSL* ssl = to_SSL(env, ssl_address, true);
-    JNI_TRACE("ssl=%p NativeCrypto_SSL_accept_renegotiations", ssl);
+    JNI_TRACE("ssl=%p NativeCrypto_SSL_set_early_data_enabled enabled=%d", ssl, enabled);
     if (ssl == nullptr) {
         return;
     }
 
-    SSL_set_renegotiate_mode(ssl, ssl_renegotiate_freely);
+    SSL_set_early_data_enabled(ssl, enabled ? 1 : 0);
 }
 
-static void NativeCrypto_SSL_set_tlsext_host_name(JNIEnv* env, jclass, jlong ssl_address,
-                                                  CONSCRYPT_UNUSED jobject ssl_holder,
-                                                  jstring hostname) {
+static jboolean NativeCrypto_SSL_in_early_data(JNIEnv* env, jclass, jlong ssl_address,
+                                               CONSCRYPT_UNUSED jobject ssl_holder) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    SSL* ssl = to_SSL(env, ssl_address, true);
+    JNI_TRACE("ssl=%p NativeCrypto_SSL_in_early_data", ssl);
+    if (ssl == nullptr) {
+        return JNI_FALSE;
+    }
+
+    int inEarlyData = SSL_in_early_data(ssl);
+    JNI_TRACE("ssl=%p NativeCrypto_SSL_in_early_data => %d", ssl, inEarlyData);
+    return static_cast<jboolean>(inEarlyData);
+}
+
+static jboolean NativeCrypto_SSL_early_data_accepted(JNIEnv* env, jclass, jlong ssl_address,
+                                                     CONSCRYPT_UNUSED jobject ssl_holder) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    SSL* ssl = to_SSL(env, ssl_address, true);
+    JNI_TRACE("ssl=%p NativeCrypto_SSL_early_data_accepted", ssl);
+    if (ssl == nullptr) {
+        return JNI_FALSE;
+    }
+
+    int accepted = SSL_early_data_accepted(ssl);
+    JNI_TRACE("ssl=%p NativeCrypto_SSL_early_data_accepted => %d", ssl, accepted);
+    return static_cast<jboolean>(accepted);
+}
+
+static jstring NativeCrypto_SSL_get_early_data_reason(JNIEnv* env, jclass, jlong ssl_address,
+                                                      CONSCRYPT_UNUSED jobject ssl_holder) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    SSL* ssl = to_SSL(env, ssl_address, true);
+    JNI_TRACE("ssl=%p NativeCrypto_SSL_get_early_data_reason", ssl);
+    if (ssl == nullptr) {
+        return nullptr;
+    }
+
+    const char* reason = SSL_early_data_reason_string(SSL_get_early_data_reason(ssl));
+    JNI_TRACE("ssl=%p NativeCrypto_SSL_get_early_data_reason => %s", ssl, reason);
+    if (reason == nullptr) {
+        return nullptr;
+    }
+    return env->NewStringUTF(reason);
+}
+
+static void NativeCrypto_SSL_reset_early_data_reject(JNIEnv* env, jclass, jlong ssl_address,
+                                                     CONSCRYPT_UNUSED jobject ssl_holder) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    SSL* ssl = to_SSL(env, ssl_address, true);
+    JNI_TRACE("ssl=%p NativeCrypto_SSL_reset_early_data_reject", ssl);
+    if (ssl == nullptr) {
+        return;
+    }
+
+    SSL_reset_early_data_reject(ssl);
+    ERR_clear_error();
+}
+
+static void NativeCrypto_SSL_accept_renegotiations(JNIEnv* env, jclass, jlong ssl_address,
+                                                   CONSCRYPT_UNUSED jobject ssl_holder) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    SSL* ssl = to_SSL(env, ssl_address, true);
+    JNI_TRACE("ssl=%p NativeCrypto_SSL_accept_renegotiations", ssl);
+    if (ssl == nullptr) {
+        return;
+    }
+
+    SSL_set_renegotiate_mode(ssl, ssl_renegotiate_freely);
+}
+
+static void NativeCrypto_SSL_set_tlsext_host_name(JNIEnv* env, jclass, jlong ssl_address,
+                                                  CONSCRYPT_UNUSED jobject ssl_holder,
+                                                  jstring hostname) {
     CHECK_ERROR_QUEUE_ON_RETURN;
     SSL* ssl = to_SSL(env, ssl_address, true);
     JNI_TRACE("ssl=%p NativeCrypto_SSL_set_tlsext_host_name hostname=%p", ssl, hostname);
@@ -8693,7 +11317,8 @@ static int selectApplicationProtocol(SSL* ssl, JNIEnv* env, jobject sslHandshake
                             reinterpret_cast<const jbyte*>(in));
 
     // Invoke the selection method.
-    jmethodID methodID = conscrypt::jniutil::sslHandshakeCallbacks_selectApplicationProtocol;
+    jmethodID methodID =
+            conscrypt::jniutil::sslHandshakeCallbacks_selectApplicationProtocol.get(env);
     jint offset = env->CallIntMethod(sslHandshakeCallbacks, methodID, protocols.get());
 
     if (offset < 0) {
@@ -8840,63 +11465,217 @@ static void NativeCrypto_setHasApplicationProtocolSelector(JNIEnv* env, jclass,
     }
 }
 
-/**
- * Perform SSL handshake
- */
-static void NativeCrypto_SSL_do_handshake(JNIEnv* env, jclass, jlong ssl_address,
-                                          CONSCRYPT_UNUSED jobject ssl_holder, jobject fdObject,
-                                          jobject shc, jint timeout_millis) {
+static void NativeCrypto_setHasSniMatchers(JNIEnv* env, jclass, jlong ssl_address,
+                                          CONSCRYPT_UNUSED jobject ssl_holder,
+                                          jboolean hasMatchers) {
     CHECK_ERROR_QUEUE_ON_RETURN;
     SSL* ssl = to_SSL(env, ssl_address, true);
-    JNI_TRACE("ssl=%p NativeCrypto_SSL_do_handshake fd=%p shc=%p timeout_millis=%d", ssl, fdObject,
-              shc, timeout_millis);
+    JNI_TRACE("ssl=%p NativeCrypto_setHasSniMatchers matchers=%d", ssl, hasMatchers);
     if (ssl == nullptr) {
         return;
     }
+    AppData* appData = toAppData(ssl);
+    if (appData == nullptr) {
+        conscrypt::jniutil::throwSSLExceptionStr(env, "Unable to retrieve application data");
+        JNI_TRACE("ssl=%p NativeCrypto_setHasSniMatchers appData => 0", ssl);
+        return;
+    }
+
+    appData->hasSniMatchers = hasMatchers;
+}
+
+static void NativeCrypto_setVerifiedChainCacheIdentity(JNIEnv* env, jclass, jlong ssl_address,
+                                                       CONSCRYPT_UNUSED jobject ssl_holder,
+                                                       jbyteArray identityJava) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    SSL* ssl = to_SSL(env, ssl_address, true);
+    JNI_TRACE("ssl=%p NativeCrypto_setVerifiedChainCacheIdentity identity=%p", ssl, identityJava);
+    if (ssl == nullptr) {
+        return;
+    }
+    AppData* appData = toAppData(ssl);
+    if (appData == nullptr) {
+        conscrypt::jniutil::throwSSLExceptionStr(env, "Unable to retrieve application data");
+        JNI_TRACE("ssl=%p NativeCrypto_setVerifiedChainCacheIdentity appData => 0", ssl);
+        return;
+    }
+
+    appData->verifiedChainCacheIdentity.clear();
+    if (identityJava == nullptr) {
+        return;
+    }
+    ScopedByteArrayRO identity(env, identityJava);
+    if (identity.get() == nullptr) {
+        JNI_TRACE("ssl=%p NativeCrypto_setVerifiedChainCacheIdentity => threw exception", ssl);
+        return;
+    }
+    const uint8_t* identityBytes = reinterpret_cast<const uint8_t*>(identity.get());
+    appData->verifiedChainCacheIdentity.assign(identityBytes, identityBytes + identity.size());
+}
+
+static void NativeCrypto_setVerifiedChainCacheParameters(JNIEnv* env, jclass, jint maxEntries,
+                                                         jlong ttlMillis) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    JNI_TRACE("NativeCrypto_setVerifiedChainCacheParameters maxEntries=%d ttlMillis=%lld",
+              maxEntries, (long long)ttlMillis);  // NOLINT(runtime/int)
+    if (maxEntries < 0 || ttlMillis < 0) {
+        conscrypt::jniutil::throwException(env, "java/lang/IllegalArgumentException",
+                                           "maxEntries < 0 || ttlMillis < 0");
+        return;
+    }
+    conscrypt::verifiedchaincache::configure(static_cast<size_t>(maxEntries),
+                                             static_cast<int64_t>(ttlMillis));
+}
+
+static void NativeCrypto_clearVerifiedChainCache(JNIEnv*, jclass) {
+    JNI_TRACE("NativeCrypto_clearVerifiedChainCache");
+    conscrypt::verifiedchaincache::clear();
+}
+
+static jlongArray NativeCrypto_getVerifiedChainCacheStats(JNIEnv* env, jclass) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    uint64_t hits, misses, entries;
+    conscrypt::verifiedchaincache::getStats(&hits, &misses, &entries);
+    jlong stats[] = {static_cast<jlong>(hits), static_cast<jlong>(misses),
+                     static_cast<jlong>(entries)};
+    jlongArray result = env->NewLongArray(3);
+    if (result == nullptr) {
+        JNI_TRACE("NativeCrypto_getVerifiedChainCacheStats => failed to allocate array");
+        return nullptr;
+    }
+    env->SetLongArrayRegion(result, 0, 3, stats);
+    return result;
+}
+
+static void NativeCrypto_setPublicKeyCacheParameters(JNIEnv* env, jclass, jint maxEntries) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    JNI_TRACE("NativeCrypto_setPublicKeyCacheParameters maxEntries=%d", maxEntries);
+    if (maxEntries < 0) {
+        conscrypt::jniutil::throwException(env, "java/lang/IllegalArgumentException",
+                                           "maxEntries < 0");
+        return;
+    }
+    conscrypt::publickeycache::configure(static_cast<size_t>(maxEntries));
+}
+
+static void NativeCrypto_clearPublicKeyCache(JNIEnv*, jclass) {
+    JNI_TRACE("NativeCrypto_clearPublicKeyCache");
+    conscrypt::publickeycache::clear();
+}
+
+static jlongArray NativeCrypto_getPublicKeyCacheStats(JNIEnv* env, jclass) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    uint64_t hits, misses, entries;
+    conscrypt::publickeycache::getStats(&hits, &misses, &entries);
+    jlong stats[] = {static_cast<jlong>(hits), static_cast<jlong>(misses),
+                     static_cast<jlong>(entries)};
+    jlongArray result = env->NewLongArray(3);
+    if (result == nullptr) {
+        JNI_TRACE("NativeCrypto_getPublicKeyCacheStats => failed to allocate array");
+        return nullptr;
+    }
+    env->SetLongArrayRegion(result, 0, 3, stats);
+    return result;
+}
+
+static void NativeCrypto_setTraceCategories(JNIEnv*, jclass, jint categories) {
+    JNI_TRACE("NativeCrypto_setTraceCategories categories=0x%x", categories);
+    conscrypt::eventtrace::setEnabledCategories(static_cast<uint32_t>(categories));
+}
+
+static jint NativeCrypto_getTraceCategories(JNIEnv*, jclass) {
+    return static_cast<jint>(
+            conscrypt::eventtrace::g_enabledCategories.load(std::memory_order_relaxed));
+}
+
+static void NativeCrypto_clearTrace(JNIEnv*, jclass) {
+    JNI_TRACE("NativeCrypto_clearTrace");
+    conscrypt::eventtrace::clear();
+}
+
+static jbyteArray traceToByteArray(JNIEnv* env, void (*dumpFunc)(std::vector<uint8_t>*)) {
+    std::vector<uint8_t> out;
+    dumpFunc(&out);
+    if (out.size() > static_cast<size_t>(std::numeric_limits<jsize>::max())) {
+        conscrypt::jniutil::throwOutOfMemory(env, "Trace too large");
+        return nullptr;
+    }
+    ScopedLocalRef<jbyteArray> result(env, env->NewByteArray(static_cast<jsize>(out.size())));
+    if (result.get() == nullptr) {
+        return nullptr;
+    }
+    env->SetByteArrayRegion(result.get(), 0, static_cast<jsize>(out.size()),
+                            reinterpret_cast<const jbyte*>(out.data()));
+    return result.release();
+}
+
+static jbyteArray NativeCrypto_dumpTrace(JNIEnv* env, jclass) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    JNI_TRACE("NativeCrypto_dumpTrace");
+    return traceToByteArray(env, conscrypt::eventtrace::dump);
+}
+
+static jbyteArray NativeCrypto_dumpTracePcap(JNIEnv* env, jclass) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    JNI_TRACE("NativeCrypto_dumpTracePcap");
+    return traceToByteArray(env, conscrypt::eventtrace::dumpPcap);
+}
+
+/**
+ * Drives SSL_do_handshake on fdObject, waiting in sslSelect() whenever the socket isn't ready.
+ * With NON_BLOCKING_TIMEOUT it returns WOULD_BLOCK_READ or WOULD_BLOCK_WRITE instead of waiting.
+ * Returns 0 once the handshake is done or an exception has been thrown.
+ */
+static int sslDoHandshake(JNIEnv* env, SSL* ssl, jobject fdObject, jobject shc,
+                          jint timeout_millis) {
     if (fdObject == nullptr) {
         conscrypt::jniutil::throwNullPointerException(env, "fd == null");
         JNI_TRACE("ssl=%p NativeCrypto_SSL_do_handshake fd == null => exception", ssl);
-        return;
+        return 0;
     }
     if (shc == nullptr) {
         conscrypt::jniutil::throwNullPointerException(env, "sslHandshakeCallbacks == null");
         JNI_TRACE("ssl=%p NativeCrypto_SSL_do_handshake sslHandshakeCallbacks == null => exception",
                   ssl);
-        return;
+        return 0;
     }
 
     NetFd fd(env, fdObject);
     if (fd.isClosed()) {
         // SocketException thrown by NetFd.isClosed
         JNI_TRACE("ssl=%p NativeCrypto_SSL_do_handshake fd.isClosed() => exception", ssl);
-        return;
+        return 0;
     }
 
-    int ret = SSL_set_fd(ssl, fd.get());
-    JNI_TRACE("ssl=%p NativeCrypto_SSL_do_handshake s=%d", ssl, fd.get());
+    // A non-blocking handshake comes back here after every wait, with the BIO already set.
+    int ret;
+    if (SSL_get_fd(ssl) != fd.get()) {
+        ret = SSL_set_fd(ssl, fd.get());
+        JNI_TRACE("ssl=%p NativeCrypto_SSL_do_handshake s=%d", ssl, fd.get());
 
-    if (ret != 1) {
-        conscrypt::jniutil::throwSSLExceptionWithSslErrors(env, ssl, SSL_ERROR_NONE,
-                                                           "Error setting the file descriptor");
-        JNI_TRACE("ssl=%p NativeCrypto_SSL_do_handshake SSL_set_fd => exception", ssl);
-        return;
-    }
+        if (ret != 1) {
+            conscrypt::jniutil::throwSSLExceptionWithSslErrors(
+                    env, ssl, SSL_ERROR_NONE, "Error setting the file descriptor");
+            JNI_TRACE("ssl=%p NativeCrypto_SSL_do_handshake SSL_set_fd => exception", ssl);
+            return 0;
+        }
 
-    /*
-     * Make socket non-blocking, so SSL_connect SSL_read() and SSL_write() don't hang
-     * forever and we can use select() to find out if the socket is ready.
-     */
-    if (!conscrypt::netutil::setBlocking(fd.get(), false)) {
-        conscrypt::jniutil::throwSSLExceptionStr(env, "Unable to make socket non blocking");
-        JNI_TRACE("ssl=%p NativeCrypto_SSL_do_handshake setBlocking => exception", ssl);
-        return;
+        /*
+         * Make socket non-blocking, so SSL_connect SSL_read() and SSL_write() don't hang
+         * forever and we can use select() to find out if the socket is ready.
+         */
+        if (!conscrypt::netutil::setBlocking(fd.get(), false)) {
+            conscrypt::jniutil::throwSSLExceptionStr(env, "Unable to make socket non blocking");
+            JNI_TRACE("ssl=%p NativeCrypto_SSL_do_handshake setBlocking => exception", ssl);
+            return 0;
+        }
     }
 
     AppData* appData = toAppData(ssl);
     if (appData == nullptr) {
         conscrypt::jniutil::throwSSLExceptionStr(env, "Unable to retrieve application data");
         JNI_TRACE("ssl=%p NativeCrypto_SSL_do_handshake appData => exception", ssl);
-        return;
+        return 0;
     }
 
     ret = 0;
@@ -8907,15 +11686,23 @@ static void NativeCrypto_SSL_do_handshake(JNIEnv* env, jclass, jlong ssl_address
         if (!appData->setCallbackState(env, shc, fdObject)) {
             // SocketException thrown by NetFd.isClosed
             JNI_TRACE("ssl=%p NativeCrypto_SSL_do_handshake setCallbackState => exception", ssl);
-            return;
+            return 0;
         }
+        uint64_t handshakeStart = conscrypt::SslCounters::nowNanos();
+        CONSCRYPT_TRACE_EVENT(conscrypt::eventtrace::kCategorySsl,
+                              conscrypt::eventtrace::kEventHandshakeStart, ssl);
         ret = SSL_do_handshake(ssl);
+        countSslEvent(ssl, conscrypt::SslCounters::kHandshakeNanos,
+                      conscrypt::SslCounters::nowNanos() - handshakeStart);
+        CONSCRYPT_TRACE_EVENT(conscrypt::eventtrace::kCategorySsl,
+                              conscrypt::eventtrace::kEventHandshakeDone, ssl, ret,
+                              SSL_get_error(ssl, ret));
         appData->clearCallbackState();
         // cert_verify_callback threw exception
         if (env->ExceptionCheck()) {
             ERR_clear_error();
             JNI_TRACE("ssl=%p NativeCrypto_SSL_do_handshake exception => exception", ssl);
-            return;
+            return 0;
         }
         // success case
         if (ret == 1) {
@@ -8941,13 +11728,21 @@ static void NativeCrypto_SSL_do_handshake(JNIEnv* env, jclass, jlong ssl_address
          * again.
          */
         if (sslError.get() == SSL_ERROR_WANT_READ || sslError.get() == SSL_ERROR_WANT_WRITE) {
-            appData->waitingThreads++;
+            if (timeout_millis == NON_BLOCKING_TIMEOUT) {
+                return sslError.get() == SSL_ERROR_WANT_READ ? WOULD_BLOCK_READ
+                                                             : WOULD_BLOCK_WRITE;
+            }
+            {
+                std::lock_guard<std::mutex> appDataLock(appData->mutex);
+                appData->addWaitingThread();
+            }
             int selectResult = sslSelect(env, sslError.get(), fdObject, appData, timeout_millis);
+            countSslEvent(ssl, conscrypt::SslCounters::kSelectWakeups, 1);
 
             if (selectResult == THROWN_EXCEPTION) {
                 // SocketException thrown by NetFd.isClosed
                 JNI_TRACE("ssl=%p NativeCrypto_SSL_do_handshake sslSelect => exception", ssl);
-                return;
+                return 0;
             }
             if (selectResult == -1) {
                 conscrypt::jniutil::throwSSLExceptionWithSslErrors(
@@ -8955,14 +11750,14 @@ static void NativeCrypto_SSL_do_handshake(JNIEnv* env, jclass, jlong ssl_address
                         conscrypt::jniutil::throwSSLHandshakeExceptionStr);
                 JNI_TRACE("ssl=%p NativeCrypto_SSL_do_handshake selectResult == -1 => exception",
                           ssl);
-                return;
+                return 0;
             }
             if (selectResult == 0) {
                 conscrypt::jniutil::throwSocketTimeoutException(env, "SSL handshake timed out");
                 ERR_clear_error();
                 JNI_TRACE("ssl=%p NativeCrypto_SSL_do_handshake selectResult == 0 => exception",
                           ssl);
-                return;
+                return 0;
             }
         } else {
             // CONSCRYPT_LOG_ERROR("Unknown error %d during handshake", error);
@@ -8987,7 +11782,7 @@ static void NativeCrypto_SSL_do_handshake(JNIEnv* env, jclass, jlong ssl_address
                     conscrypt::jniutil::throwSSLHandshakeExceptionStr);
         }
         JNI_TRACE("ssl=%p NativeCrypto_SSL_do_handshake clean error => exception", ssl);
-        return;
+        return 0;
     }
 
     // unclean error. See SSL_do_handshake(3SSL) man page.
@@ -9000,9 +11795,51 @@ static void NativeCrypto_SSL_do_handshake(JNIEnv* env, jclass, jlong ssl_address
                 env, ssl, sslError.release(), "SSL handshake aborted",
                 conscrypt::jniutil::throwSSLHandshakeExceptionStr);
         JNI_TRACE("ssl=%p NativeCrypto_SSL_do_handshake unclean error => exception", ssl);
-        return;
+        return 0;
     }
     JNI_TRACE("ssl=%p NativeCrypto_SSL_do_handshake => success", ssl);
+    return 0;
+}
+
+/**
+ * Perform SSL handshake
+ */
+static void NativeCrypto_SSL_do_handshake(JNIEnv* env, jclass, jlong ssl_address,
+                                          CONSCRYPT_UNUSED jobject ssl_holder, jobject fdObject,
+                                          jobject shc, jint timeout_millis) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    SSL* ssl = to_SSL(env, ssl_address, true);
+    JNI_TRACE("ssl=%p NativeCrypto_SSL_do_handshake fd=%p shc=%p timeout_millis=%d", ssl, fdObject,
+              shc, timeout_millis);
+    if (ssl == nullptr) {
+        return;
+    }
+    // Java timeouts are never negative, so this can't ask for a non-blocking handshake.
+    sslDoHandshake(env, ssl, fdObject, shc, timeout_millis < 0 ? 0 : timeout_millis);
+}
+
+/**
+ * public static native int SSL_do_handshake_nonblocking(long ssl, NativeSsl ssl_holder,
+ *         FileDescriptor fd, SSLHandshakeCallbacks shc);
+ */
+static jint NativeCrypto_SSL_do_handshake_nonblocking(JNIEnv* env, jclass, jlong ssl_address,
+                                                      CONSCRYPT_UNUSED jobject ssl_holder,
+                                                      jobject fdObject, jobject shc) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    SSL* ssl = to_SSL(env, ssl_address, true);
+    JNI_TRACE("ssl=%p NativeCrypto_SSL_do_handshake_nonblocking fd=%p shc=%p", ssl, fdObject,
+              shc);
+    if (ssl == nullptr) {
+        return 0;
+    }
+    switch (sslDoHandshake(env, ssl, fdObject, shc, NON_BLOCKING_TIMEOUT)) {
+        case WOULD_BLOCK_READ:
+            return -SSL_ERROR_WANT_READ;
+        case WOULD_BLOCK_WRITE:
+            return -SSL_ERROR_WANT_WRITE;
+        default:
+            return 0;
+    }
 }
 
 static jstring NativeCrypto_SSL_get_current_cipher(JNIEnv* env, jclass, jlong ssl_address,
@@ -9059,6 +11896,177 @@ static jobjectArray NativeCrypto_SSL_get0_peer_certificates(JNIEnv* env, jclass,
     return array.release();
 }
 
+/**
+ * public static native byte[][] SSL_get_mapped_certificates(long ssl, NativeSsl holder)
+ */
+static jobjectArray NativeCrypto_SSL_get_mapped_certificates(JNIEnv* env, jclass,
+                                                             jlong ssl_address,
+                                                             CONSCRYPT_UNUSED jobject ssl_holder) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    SSL* ssl = to_SSL(env, ssl_address, true);
+    JNI_TRACE("ssl=%p NativeCrypto_SSL_get_mapped_certificates", ssl);
+    if (ssl == nullptr) {
+        return nullptr;
+    }
+    AppData* appData = toAppData(ssl);
+    if (appData == nullptr || appData->mappedCredential == nullptr) {
+        return nullptr;
+    }
+
+    const std::vector<bssl::UniquePtr<CRYPTO_BUFFER>>& chain = appData->mappedCredential->chain;
+    ScopedLocalRef<jobjectArray> array(
+            env, env->NewObjectArray(static_cast<jsize>(chain.size()),
+                                     conscrypt::jniutil::byteArrayClass, nullptr));
+    if (array.get() == nullptr) {
+        return nullptr;
+    }
+    for (size_t i = 0; i < chain.size(); i++) {
+        ScopedLocalRef<jbyteArray> cert(env, CryptoBufferToByteArray(env, chain[i].get()));
+        if (cert.get() == nullptr) {
+            return nullptr;
+        }
+        env->SetObjectArrayElement(array.get(), static_cast<jsize>(i), cert.get());
+    }
+    JNI_TRACE("ssl=%p NativeCrypto_SSL_get_mapped_certificates => %p", ssl, array.get());
+    return array.release();
+}
+
+/**
+ * Throws the exception for reads and writes that found the peer rejected our early data.
+ */
+static void throwEarlyDataRejectedException(JNIEnv* env) {
+    conscrypt::jniutil::throwException(
+            env, TO_STRING(JNI_JARJAR_PREFIX) "org/conscrypt/EarlyDataRejectedException",
+            "Early data rejected by peer; data written before the handshake completed was "
+            "discarded");
+}
+
+/**
+ * Returns whether the socket read and write paths may move application data on ssl: after the
+ * handshake, during False Start or renegotiation, or while TLS 1.3 early data is in progress.
+ */
+static bool sslCanTransferData(const SSL* ssl) {
+    return SSL_is_init_finished(ssl) || SSL_in_false_start(ssl) ||
+           SSL_renegotiate_pending(ssl) || SSL_in_early_data(ssl);
+}
+
+/**
+ * Throws an SSLException for the failed kernel TLS call described by message, after which the
+ * connection is unusable.
+ */
+static int throwKernelTlsError(JNIEnv* env, const char* message, int error) {
+    char buf[256];
+    snprintf(buf, sizeof(buf), "%s: %s", message,
+             error == EPROTO ? "unexpected TLS message after kernel offload" : strerror(error));
+    conscrypt::jniutil::throwSSLExceptionStr(env, buf);
+    return THROWN_EXCEPTION;
+}
+
+/**
+ * The sslRead() path once the kernel decrypts incoming records, with the same results.
+ */
+static int sslReadKernel(JNIEnv* env, SSL* ssl, jobject fdObject, AppData* appData, char* buf,
+                         jint len, int read_timeout_millis) {
+    while (appData->aliveAndKicking) {
+        NetFd fd(env, fdObject);
+        if (fd.isClosed()) {
+            return THROWN_EXCEPTION;
+        }
+
+        std::unique_lock<std::mutex> appDataLock(appData->mutex);
+        int result = conscrypt::ktls::read(fd.get(), &appData->kernelTls, buf,
+                                           static_cast<size_t>(len));
+        int error = errno;
+        bool wouldBlock = result == -1 && (error == EAGAIN || error == EWOULDBLOCK);
+        if (wouldBlock && read_timeout_millis != NON_BLOCKING_TIMEOUT) {
+            appData->addWaitingThread();
+        }
+        appDataLock.unlock();
+
+        JNI_TRACE("ssl=%p sslReadKernel result=%d errno=%d", ssl, result, error);
+        if (result > 0) {
+            return result;
+        }
+        if (result == 0) {
+            // close_notify or end of stream.
+            return -1;
+        }
+        if (wouldBlock) {
+            if (read_timeout_millis == NON_BLOCKING_TIMEOUT) {
+                return WOULD_BLOCK_READ;
+            }
+            int selectResult =
+                    sslSelect(env, SSL_ERROR_WANT_READ, fdObject, appData, read_timeout_millis);
+            countSslEvent(ssl, conscrypt::SslCounters::kSelectWakeups, 1);
+            if (selectResult == THROWN_EXCEPTION) {
+                return THROWN_EXCEPTION;
+            }
+            if (selectResult == -1) {
+                return throwKernelTlsError(env, "Read error", errno);
+            }
+            if (selectResult == 0) {
+                return THROW_SOCKETTIMEOUTEXCEPTION;
+            }
+        } else if (error != EINTR) {
+            return throwKernelTlsError(env, "Read error", error);
+        }
+    }
+
+    return -1;
+}
+
+/**
+ * The sslWrite() path once the kernel encrypts outgoing records, with the same results.
+ */
+static int sslWriteKernel(JNIEnv* env, SSL* ssl, jobject fdObject, AppData* appData,
+                          const char* buf, jint len, int write_timeout_millis) {
+    int count = len;
+    while (appData->aliveAndKicking && len > 0) {
+        NetFd fd(env, fdObject);
+        if (fd.isClosed()) {
+            return THROWN_EXCEPTION;
+        }
+
+        int result = conscrypt::ktls::write(fd.get(), buf, static_cast<size_t>(len));
+        int error = errno;
+        JNI_TRACE("ssl=%p sslWriteKernel len=%d result=%d errno=%d", ssl, len, result, error);
+        if (result > 0) {
+            buf += result;
+            len -= result;
+            continue;
+        }
+        if (result == -1 && (error == EAGAIN || error == EWOULDBLOCK)) {
+            if (write_timeout_millis == NON_BLOCKING_TIMEOUT) {
+                // Report partial progress first; the caller retries the rest.
+                if (count - len > 0) {
+                    return count - len;
+                }
+                return WOULD_BLOCK_WRITE;
+            }
+            {
+                std::lock_guard<std::mutex> appDataLock(appData->mutex);
+                appData->addWaitingThread();
+            }
+            int selectResult =
+                    sslSelect(env, SSL_ERROR_WANT_WRITE, fdObject, appData, write_timeout_millis);
+            countSslEvent(ssl, conscrypt::SslCounters::kSelectWakeups, 1);
+            if (selectResult == THROWN_EXCEPTION) {
+                return THROWN_EXCEPTION;
+            }
+            if (selectResult == -1) {
+                return throwKernelTlsError(env, "Write error", errno);
+            }
+            if (selectResult == 0) {
+                return THROW_SOCKETTIMEOUTEXCEPTION;
+            }
+        } else if (result != -1 || error != EINTR) {
+            return throwKernelTlsError(env, "Write error", result == 0 ? EPIPE : error);
+        }
+    }
+
+    return count;
+}
+
 static int sslRead(JNIEnv* env, SSL* ssl, jobject fdObject, jobject shc, char* buf, jint len,
                    SslError* sslError, int read_timeout_millis) {
     JNI_TRACE("ssl=%p sslRead buf=%p len=%d", ssl, buf, len);
@@ -9076,14 +12084,17 @@ static int sslRead(JNIEnv* env, SSL* ssl, jobject fdObject, jobject shc, char* b
     if (appData == nullptr) {
         return THROW_SSLEXCEPTION;
     }
+    if (appData->kernelTls.directions & conscrypt::ktls::kRx) {
+        return sslReadKernel(env, ssl, fdObject, appData, buf, len, read_timeout_millis);
+    }
 
     while (appData->aliveAndKicking) {
         errno = 0;
 
         std::unique_lock<std::mutex> appDataLock(appData->mutex);
 
-        if (!SSL_is_init_finished(ssl) && !SSL_in_false_start(ssl) &&
-            !SSL_renegotiate_pending(ssl)) {
+        // After early data is rejected the handshake is resumed by SSL_read itself.
+        if (!appData->earlyDataRejected && !sslCanTransferData(ssl)) {
             JNI_TRACE("ssl=%p sslRead => init is not finished (state: %s)", ssl,
                       SSL_state_string_long(ssl));
             return THROW_SSLEXCEPTION;
@@ -9125,8 +12136,9 @@ static int sslRead(JNIEnv* env, SSL* ssl, jobject fdObject, jobject shc, char* b
 
         // If we are blocked by the underlying socket, tell the world that
         // there will be one more waiting thread now.
-        if (sslError->get() == SSL_ERROR_WANT_READ || sslError->get() == SSL_ERROR_WANT_WRITE) {
-            appData->waitingThreads++;
+        if ((sslError->get() == SSL_ERROR_WANT_READ || sslError->get() == SSL_ERROR_WANT_WRITE) &&
+            read_timeout_millis != NON_BLOCKING_TIMEOUT) {
+            appData->addWaitingThread();
         }
 
         appDataLock.unlock();
@@ -9145,8 +12157,13 @@ static int sslRead(JNIEnv* env, SSL* ssl, jobject fdObject, jobject shc, char* b
             // Need to wait for availability of underlying layer, then retry.
             case SSL_ERROR_WANT_READ:
             case SSL_ERROR_WANT_WRITE: {
+                if (read_timeout_millis == NON_BLOCKING_TIMEOUT) {
+                    return sslError->get() == SSL_ERROR_WANT_READ ? WOULD_BLOCK_READ
+                                                                   : WOULD_BLOCK_WRITE;
+                }
                 int selectResult =
                         sslSelect(env, sslError->get(), fdObject, appData, read_timeout_millis);
+                countSslEvent(ssl, conscrypt::SslCounters::kSelectWakeups, 1);
                 if (selectResult == THROWN_EXCEPTION) {
                     return THROWN_EXCEPTION;
                 }
@@ -9160,6 +12177,16 @@ static int sslRead(JNIEnv* env, SSL* ssl, jobject fdObject, jobject shc, char* b
                 break;
             }
 
+            // The peer declined our early data. Anything already sent as early data is lost,
+            // so tell the caller, who has to write it again; the next call completes the
+            // handshake.
+            case SSL_ERROR_EARLY_DATA_REJECTED: {
+                SSL_reset_early_data_reject(ssl);
+                ERR_clear_error();
+                appData->earlyDataRejected = true;
+                return THROW_EARLYDATAREJECTEDEXCEPTION;
+            }
+
             // A problem occurred during a system call, but this is not
             // necessarily an error.
             case SSL_ERROR_SYSCALL: {
@@ -9314,6 +12341,10 @@ static jint NativeCrypto_SSL_read(JNIEnv* env, jclass, jlong ssl_address,
             conscrypt::jniutil::throwSocketTimeoutException(env, "Read timed out");
             result = -1;
             break;
+        case THROW_EARLYDATAREJECTEDEXCEPTION:
+            throwEarlyDataRejectedException(env);
+            result = -1;
+            break;
         case THROWN_EXCEPTION:
             // SocketException thrown by NetFd.isClosed
             // or RuntimeException thrown by callback
@@ -9325,6 +12356,8 @@ static jint NativeCrypto_SSL_read(JNIEnv* env, jclass, jlong ssl_address,
     }
 
     JNI_TRACE("ssl=%p NativeCrypto_SSL_read => %d", ssl, result);
+    CONSCRYPT_TRACE_EVENT(conscrypt::eventtrace::kCategoryIo, conscrypt::eventtrace::kEventRead,
+                          ssl, len, result);
     return result;
 }
 
@@ -9346,6 +12379,9 @@ static int sslWrite(JNIEnv* env, SSL* ssl, jobject fdObject, jobject shc, const
     if (appData == nullptr) {
         return THROW_SSLEXCEPTION;
     }
+    if (appData->kernelTls.directions & conscrypt::ktls::kTx) {
+        return sslWriteKernel(env, ssl, fdObject, appData, buf, len, write_timeout_millis);
+    }
 
     int count = len;
 
@@ -9354,8 +12390,8 @@ static int sslWrite(JNIEnv* env, SSL* ssl, jobject fdObject, jobject shc, const
 
         std::unique_lock<std::mutex> appDataLock(appData->mutex);
 
-        if (!SSL_is_init_finished(ssl) && !SSL_in_false_start(ssl) &&
-            !SSL_renegotiate_pending(ssl)) {
+        // After early data is rejected the handshake is resumed by SSL_write itself.
+        if (!appData->earlyDataRejected && !sslCanTransferData(ssl)) {
             JNI_TRACE("ssl=%p sslWrite => init is not finished (state: %s)", ssl,
                       SSL_state_string_long(ssl));
             return THROW_SSLEXCEPTION;
@@ -9398,8 +12434,9 @@ static int sslWrite(JNIEnv* env, SSL* ssl, jobject fdObject, jobject shc, const
 
         // If we are blocked by the underlying socket, tell the world that
         // there will be one more waiting thread now.
-        if (sslError->get() == SSL_ERROR_WANT_READ || sslError->get() == SSL_ERROR_WANT_WRITE) {
-            appData->waitingThreads++;
+        if ((sslError->get() == SSL_ERROR_WANT_READ || sslError->get() == SSL_ERROR_WANT_WRITE) &&
+            write_timeout_millis != NON_BLOCKING_TIMEOUT) {
+            appData->addWaitingThread();
         }
 
         appDataLock.unlock();
@@ -9422,8 +12459,17 @@ static int sslWrite(JNIEnv* env, SSL* ssl, jobject fdObject, jobject shc, const
             // it's also not standard Java behavior, so we wait forever here.
             case SSL_ERROR_WANT_READ:
             case SSL_ERROR_WANT_WRITE: {
+                if (write_timeout_millis == NON_BLOCKING_TIMEOUT) {
+                    // Report partial progress first; the caller retries the rest.
+                    if (count - len > 0) {
+                        return count - len;
+                    }
+                    return sslError->get() == SSL_ERROR_WANT_READ ? WOULD_BLOCK_READ
+                                                                   : WOULD_BLOCK_WRITE;
+                }
                 int selectResult =
                         sslSelect(env, sslError->get(), fdObject, appData, write_timeout_millis);
+                countSslEvent(ssl, conscrypt::SslCounters::kSelectWakeups, 1);
                 if (selectResult == THROWN_EXCEPTION) {
                     return THROWN_EXCEPTION;
                 }
@@ -9437,6 +12483,16 @@ static int sslWrite(JNIEnv* env, SSL* ssl, jobject fdObject, jobject shc, const
                 break;
             }
 
+            // The peer declined our early data. Anything already sent as early data is lost,
+            // so tell the caller, who has to write it again; the next call completes the
+            // handshake.
+            case SSL_ERROR_EARLY_DATA_REJECTED: {
+                SSL_reset_early_data_reject(ssl);
+                ERR_clear_error();
+                appData->earlyDataRejected = true;
+                return THROW_EARLYDATAREJECTEDEXCEPTION;
+            }
+
             // A problem occurred during a system call, but this is not
             // necessarily an error.
             case SSL_ERROR_SYSCALL: {
@@ -9527,7 +12583,7 @@ static void NativeCrypto_SSL_write(JNIEnv* env, jclass, jlong ssl_address,
                 ret = sslWrite(env, ssl, fdObject, shc, reinterpret_cast<const char*>(buf.get()),
                                chunk_size, &sslError, write_timeout_millis);
                 if (ret == THROW_SSLEXCEPTION || ret == THROW_SOCKETTIMEOUTEXCEPTION ||
-                    ret == THROWN_EXCEPTION) {
+                    ret == THROWN_EXCEPTION || ret == THROW_EARLYDATAREJECTEDEXCEPTION) {
                     // Encountered an error. Terminate early and handle below.
                     break;
                 }
@@ -9544,22 +12600,280 @@ static void NativeCrypto_SSL_write(JNIEnv* env, jclass, jlong ssl_address,
         ret = sslWrite(env, ssl, fdObject, shc, reinterpret_cast<const char*>(bytes.get() + offset),
                        len, &sslError, write_timeout_millis);
     }
+    CONSCRYPT_TRACE_EVENT(conscrypt::eventtrace::kCategoryIo, conscrypt::eventtrace::kEventWrite,
+                          ssl, len, ret);
+
+    switch (ret) {
+        case THROW_SSLEXCEPTION:
+            // See sslWrite() regarding improper failure to handle normal cases.
+            conscrypt::jniutil::throwSSLExceptionWithSslErrors(env, ssl, sslError.release(),
+                                                               "Write error");
+            break;
+        case THROW_SOCKETTIMEOUTEXCEPTION:
+            conscrypt::jniutil::throwSocketTimeoutException(env, "Write timed out");
+            break;
+        case THROW_EARLYDATAREJECTEDEXCEPTION:
+            throwEarlyDataRejectedException(env);
+            break;
+        case THROWN_EXCEPTION:
+            // SocketException thrown by NetFd.isClosed
+            break;
+        default:
+            break;
+    }
+}
+
+// Chunk size for the non-blocking calls, which never move more than one TLS record's worth.
+static const jint kNonBlockingChunkSize = 16384;
+
+static jint nonBlockingResult(JNIEnv* env, SSL* ssl, int ret, SslError* sslError,
+                              const char* message) {
+    switch (ret) {
+        case THROW_SSLEXCEPTION:
+            conscrypt::jniutil::throwSSLExceptionWithSslErrors(env, ssl, sslError->release(),
+                                                               message);
+            return -1;
+        case THROWN_EXCEPTION:
+            return -1;
+        case THROW_EARLYDATAREJECTEDEXCEPTION:
+            throwEarlyDataRejectedException(env);
+            return -1;
+        case WOULD_BLOCK_READ:
+            return -SSL_ERROR_WANT_READ;
+        case WOULD_BLOCK_WRITE:
+            return -SSL_ERROR_WANT_WRITE;
+        default:
+            return ret;
+    }
+}
+
+/**
+ * public static native int SSL_read_nonblocking(long ssl, NativeSsl ssl_holder, FileDescriptor fd,
+ *         SSLHandshakeCallbacks shc, byte[] b, int offset, int len);
+ */
+static jint NativeCrypto_SSL_read_nonblocking(JNIEnv* env, jclass, jlong ssl_address,
+                                              CONSCRYPT_UNUSED jobject ssl_holder,
+                                              jobject fdObject, jobject shc, jbyteArray b,
+                                              jint offset, jint len) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    SSL* ssl = to_SSL(env, ssl_address, true);
+    JNI_TRACE("ssl=%p NativeCrypto_SSL_read_nonblocking fd=%p shc=%p b=%p offset=%d len=%d", ssl,
+              fdObject, shc, b, offset, len);
+    if (ssl == nullptr) {
+        return 0;
+    }
+    if (fdObject == nullptr) {
+        conscrypt::jniutil::throwNullPointerException(env, "fd == null");
+        return 0;
+    }
+    if (shc == nullptr) {
+        conscrypt::jniutil::throwNullPointerException(env, "sslHandshakeCallbacks == null");
+        return 0;
+    }
+    if (b == nullptr) {
+        conscrypt::jniutil::throwNullPointerException(env, "b == null");
+        return 0;
+    }
+    size_t array_size = static_cast<size_t>(env->GetArrayLength(b));
+    if (ARRAY_CHUNK_INVALID(array_size, offset, len)) {
+        conscrypt::jniutil::throwException(env, "java/lang/ArrayIndexOutOfBoundsException", "b");
+        return 0;
+    }
+
+    jint chunk = len < kNonBlockingChunkSize ? len : kNonBlockingChunkSize;
+    std::unique_ptr<jbyte[]> buf(new jbyte[static_cast<size_t>(chunk > 0 ? chunk : 1)]);
+    SslError sslError;
+    int ret = sslRead(env, ssl, fdObject, shc, reinterpret_cast<char*>(buf.get()), chunk,
+                      &sslError, NON_BLOCKING_TIMEOUT);
+    if (ret > 0) {
+        env->SetByteArrayRegion(b, offset, ret, buf.get());
+    }
+    jint result = nonBlockingResult(env, ssl, ret, &sslError, "Read error");
+    JNI_TRACE("ssl=%p NativeCrypto_SSL_read_nonblocking => %d", ssl, result);
+    return result;
+}
+
+/**
+ * public static native int SSL_write_nonblocking(long ssl, NativeSsl ssl_holder,
+ *         FileDescriptor fd, SSLHandshakeCallbacks shc, byte[] b, int offset, int len);
+ */
+static jint NativeCrypto_SSL_write_nonblocking(JNIEnv* env, jclass, jlong ssl_address,
+                                               CONSCRYPT_UNUSED jobject ssl_holder,
+                                               jobject fdObject, jobject shc, jbyteArray b,
+                                               jint offset, jint len) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    SSL* ssl = to_SSL(env, ssl_address, true);
+    JNI_TRACE("ssl=%p NativeCrypto_SSL_write_nonblocking fd=%p shc=%p b=%p offset=%d len=%d", ssl,
+              fdObject, shc, b, offset, len);
+    if (ssl == nullptr) {
+        return 0;
+    }
+    if (fdObject == nullptr) {
+        conscrypt::jniutil::throwNullPointerException(env, "fd == null");
+        return 0;
+    }
+    if (shc == nullptr) {
+        conscrypt::jniutil::throwNullPointerException(env, "sslHandshakeCallbacks == null");
+        return 0;
+    }
+    if (b == nullptr) {
+        conscrypt::jniutil::throwNullPointerException(env, "b == null");
+        return 0;
+    }
+    size_t array_size = static_cast<size_t>(env->GetArrayLength(b));
+    if (ARRAY_CHUNK_INVALID(array_size, offset, len)) {
+        conscrypt::jniutil::throwException(env, "java/lang/ArrayIndexOutOfBoundsException", "b");
+        return 0;
+    }
+
+    jint chunk = len < kNonBlockingChunkSize ? len : kNonBlockingChunkSize;
+    std::unique_ptr<jbyte[]> buf(new jbyte[static_cast<size_t>(chunk > 0 ? chunk : 1)]);
+    env->GetByteArrayRegion(b, offset, chunk, buf.get());
+    SslError sslError;
+    int ret = sslWrite(env, ssl, fdObject, shc, reinterpret_cast<const char*>(buf.get()), chunk,
+                       &sslError, NON_BLOCKING_TIMEOUT);
+    jint result = nonBlockingResult(env, ssl, ret, &sslError, "Write error");
+    JNI_TRACE("ssl=%p NativeCrypto_SSL_write_nonblocking => %d", ssl, result);
+    return result;
+}
+
+static conscrypt::SslPoller* to_SslPoller(JNIEnv* env, jlong poller_address) {
+    conscrypt::SslPoller* poller = reinterpret_cast<conscrypt::SslPoller*>(poller_address);
+    if (poller == nullptr) {
+        conscrypt::jniutil::throwNullPointerException(env, "poller == null");
+    }
+    return poller;
+}
+
+/**
+ * public static native long SSL_poller_new() throws IOException;
+ */
+static jlong NativeCrypto_SSL_poller_new(JNIEnv* env, jclass) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    if (!conscrypt::SslPoller::isSupported()) {
+        conscrypt::jniutil::throwException(env, "java/lang/UnsupportedOperationException",
+                                           "SSL poller requires epoll");
+        return 0;
+    }
+    conscrypt::SslPoller* poller = conscrypt::SslPoller::create();
+    if (poller == nullptr) {
+        conscrypt::jniutil::throwIOException(env, strerror(errno));
+        return 0;
+    }
+    JNI_TRACE("NativeCrypto_SSL_poller_new => %p", poller);
+    return reinterpret_cast<uintptr_t>(poller);
+}
+
+/**
+ * public static native void SSL_poller_free(long poller);
+ */
+static void NativeCrypto_SSL_poller_free(JNIEnv* env, jclass, jlong poller_address) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    conscrypt::SslPoller* poller = to_SslPoller(env, poller_address);
+    JNI_TRACE("NativeCrypto_SSL_poller_free poller=%p", poller);
+    delete poller;
+}
+
+/**
+ * public static native void SSL_poller_arm(long poller, FileDescriptor fd, long token,
+ *         int interest) throws IOException;
+ */
+static void NativeCrypto_SSL_poller_arm(JNIEnv* env, jclass, jlong poller_address,
+                                        jobject fdObject, jlong token, jint interest) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    conscrypt::SslPoller* poller = to_SslPoller(env, poller_address);
+    JNI_TRACE("NativeCrypto_SSL_poller_arm poller=%p fd=%p token=%lld interest=%d", poller,
+              fdObject, (long long)token, interest);  // NOLINT(runtime/int)
+    if (poller == nullptr) {
+        return;
+    }
+    NetFd fd(env, fdObject);
+    if (fd.isClosed()) {
+        return;
+    }
+    if (!poller->arm(fd.get(), static_cast<uint64_t>(token), interest)) {
+        conscrypt::jniutil::throwIOException(env, strerror(errno));
+    }
+}
+
+/**
+ * public static native void SSL_poller_remove(long poller, FileDescriptor fd) throws IOException;
+ */
+static void NativeCrypto_SSL_poller_remove(JNIEnv* env, jclass, jlong poller_address,
+                                           jobject fdObject) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    conscrypt::SslPoller* poller = to_SslPoller(env, poller_address);
+    JNI_TRACE("NativeCrypto_SSL_poller_remove poller=%p fd=%p", poller, fdObject);
+    if (poller == nullptr) {
+        return;
+    }
+    NetFd fd(env, fdObject);
+    if (fd.isClosed()) {
+        return;
+    }
+    if (!poller->remove(fd.get())) {
+        conscrypt::jniutil::throwIOException(env, strerror(errno));
+    }
+}
 
-    switch (ret) {
-        case THROW_SSLEXCEPTION:
-            // See sslWrite() regarding improper failure to handle normal cases.
-            conscrypt::jniutil::throwSSLExceptionWithSslErrors(env, ssl, sslError.release(),
-                                                               "Write error");
-            break;
-        case THROW_SOCKETTIMEOUTEXCEPTION:
-            conscrypt::jniutil::throwSocketTimeoutException(env, "Write timed out");
-            break;
-        case THROWN_EXCEPTION:
-            // SocketException thrown by NetFd.isClosed
-            break;
-        default:
-            break;
+/**
+ * public static native int SSL_poller_wait(long poller, long[] tokens, int[] events,
+ *         int timeoutMillis) throws IOException;
+ */
+static jint NativeCrypto_SSL_poller_wait(JNIEnv* env, jclass, jlong poller_address,
+                                         jlongArray tokensArray, jintArray eventsArray,
+                                         jint timeout_millis) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    conscrypt::SslPoller* poller = to_SslPoller(env, poller_address);
+    JNI_TRACE("NativeCrypto_SSL_poller_wait poller=%p timeout_millis=%d", poller, timeout_millis);
+    if (poller == nullptr) {
+        return 0;
+    }
+    if (tokensArray == nullptr) {
+        conscrypt::jniutil::throwNullPointerException(env, "tokens == null");
+        return 0;
+    }
+    if (eventsArray == nullptr) {
+        conscrypt::jniutil::throwNullPointerException(env, "events == null");
+        return 0;
+    }
+    jsize maxEvents = env->GetArrayLength(tokensArray);
+    if (env->GetArrayLength(eventsArray) < maxEvents) {
+        conscrypt::jniutil::throwException(env, "java/lang/ArrayIndexOutOfBoundsException",
+                                           "events.length < tokens.length");
+        return 0;
+    }
+    if (maxEvents == 0) {
+        return 0;
+    }
+
+    std::vector<uint64_t> tokens(static_cast<size_t>(maxEvents));
+    std::vector<jint> events(static_cast<size_t>(maxEvents));
+    int count = poller->wait(tokens.data(), events.data(), maxEvents, timeout_millis);
+    if (count < 0) {
+        conscrypt::jniutil::throwIOException(env, strerror(errno));
+        return 0;
+    }
+    for (int i = 0; i < count; i++) {
+        jlong token = static_cast<jlong>(tokens[static_cast<size_t>(i)]);
+        env->SetLongArrayRegion(tokensArray, i, 1, &token);
+    }
+    env->SetIntArrayRegion(eventsArray, 0, count, events.data());
+    JNI_TRACE("NativeCrypto_SSL_poller_wait poller=%p => %d", poller, count);
+    return count;
+}
+
+/**
+ * public static native void SSL_poller_wakeup(long poller);
+ */
+static void NativeCrypto_SSL_poller_wakeup(JNIEnv* env, jclass, jlong poller_address) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    conscrypt::SslPoller* poller = to_SslPoller(env, poller_address);
+    JNI_TRACE("NativeCrypto_SSL_poller_wakeup poller=%p", poller);
+    if (poller == nullptr) {
+        return;
     }
+    poller->wakeup();
 }
 
 /**
@@ -9588,6 +12902,44 @@ static void NativeCrypto_SSL_interrupt(JNIEnv* env, jclass, jlong ssl_address,
     }
 }
 
+/**
+ * Hands the established connection on fdObject to kernel TLS. Returns the mask of
+ * offloaded directions, 1 for sending and 2 for receiving, or 0 if the platform, kernel or
+ * negotiated connection does not allow it.
+ */
+static jint NativeCrypto_SSL_enable_ktls(JNIEnv* env, jclass, jlong ssl_address,
+                                         CONSCRYPT_UNUSED jobject ssl_holder, jobject fdObject) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    SSL* ssl = to_SSL(env, ssl_address, true);
+    JNI_TRACE("ssl=%p NativeCrypto_SSL_enable_ktls fd=%p", ssl, fdObject);
+    if (ssl == nullptr) {
+        return 0;
+    }
+    if (fdObject == nullptr) {
+        conscrypt::jniutil::throwNullPointerException(env, "fd == null");
+        JNI_TRACE("ssl=%p NativeCrypto_SSL_enable_ktls => fd == null", ssl);
+        return 0;
+    }
+    AppData* appData = toAppData(ssl);
+    if (appData == nullptr || !conscrypt::ktls::isSupported()) {
+        return 0;
+    }
+    NetFd fd(env, fdObject);
+    if (fd.isClosed()) {
+        JNI_TRACE("ssl=%p NativeCrypto_SSL_enable_ktls => socket closed", ssl);
+        return 0;
+    }
+
+    std::lock_guard<std::mutex> appDataLock(appData->mutex);
+    if (appData->kernelTls.directions != 0) {
+        return appData->kernelTls.directions;
+    }
+    int directions = conscrypt::ktls::enable(ssl, fd.get(), &appData->kernelTls);
+    ERR_clear_error();
+    JNI_TRACE("ssl=%p NativeCrypto_SSL_enable_ktls => %d", ssl, directions);
+    return directions;
+}
+
 /**
  * OpenSSL close SSL socket function.
  */
@@ -9628,6 +12980,17 @@ static void NativeCrypto_SSL_shutdown(JNIEnv* env, jclass, jlong ssl_address,
         }
 #endif
 
+        if (appData->kernelTls.directions & conscrypt::ktls::kTx) {
+            // The SSL no longer knows the write sequence, so the kernel sends the alert.
+            bool sent = fd != -1 && conscrypt::ktls::sendCloseNotify(fd);
+            appData->clearCallbackState();
+            if (!sent) {
+                throwKernelTlsError(env, "SSL shutdown failed", errno);
+            }
+            ERR_clear_error();
+            return;
+        }
+
         int ret = SSL_shutdown(ssl);
         appData->clearCallbackState();
         // callbacks can happen if server requests renegotiation
@@ -9693,6 +13056,8 @@ static void NativeCrypto_SSL_free(JNIEnv* env, jclass, jlong ssl_address,
     if (ssl == nullptr) {
         return;
     }
+    CONSCRYPT_TRACE_EVENT(conscrypt::eventtrace::kCategorySsl, conscrypt::eventtrace::kEventSslFree,
+                          ssl);
 
     AppData* appData = toAppData(ssl);
     SSL_set_app_data(ssl, nullptr);
@@ -10328,6 +13693,25 @@ static jint NativeCrypto_SSL_pending_written_bytes_in_BIO(JNIEnv* env, jclass, j
     return static_cast<jint>(BIO_ctrl_pending(bio));
 }
 
+/*
+ * public static native long[] SSL_get_counters(long ssl, NativeSsl ssl_holder);
+ */
+static jlongArray NativeCrypto_SSL_get_counters(JNIEnv* env, jclass, jlong ssl_address,
+                                                CONSCRYPT_UNUSED jobject ssl_holder) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    SSL* ssl = to_SSL(env, ssl_address, true);
+    JNI_TRACE("ssl=%p NativeCrypto_SSL_get_counters", ssl);
+    if (ssl == nullptr) {
+        return nullptr;
+    }
+    AppData* appData = toAppData(ssl);
+    if (appData == nullptr) {
+        conscrypt::jniutil::throwSSLExceptionStr(env, "Unable to retrieve application data");
+        return nullptr;
+    }
+    return countersToJavaArray(env, appData->counters);
+}
+
 static jint NativeCrypto_SSL_max_seal_overhead(JNIEnv* env, jclass, jlong ssl_address,
                                                CONSCRYPT_UNUSED jobject ssl_holder) {
     CHECK_ERROR_QUEUE_ON_RETURN;
@@ -10352,10 +13736,10 @@ static jlong NativeCrypto_SSL_BIO_new(JNIEnv* env, jclass, jlong ssl_address,
 
     BIO* internal_bio;
     BIO* network_bio;
-    if (BIO_new_bio_pair(&internal_bio, 0, &network_bio, 0) != 1) {
+    if (!conscrypt::transportbio::newPair(&internal_bio, &network_bio)) {
         conscrypt::jniutil::throwSSLExceptionWithSslErrors(env, ssl, SSL_ERROR_NONE,
-                                                           "BIO_new_bio_pair failed");
-        JNI_TRACE("ssl=%p NativeCrypto_SSL_BIO_new => BIO_new_bio_pair exception", ssl);
+                                                           "transportbio::newPair failed");
+        JNI_TRACE("ssl=%p NativeCrypto_SSL_BIO_new => transportbio::newPair exception", ssl);
         return 0;
     }
 
@@ -10397,7 +13781,15 @@ static jint NativeCrypto_ENGINE_SSL_do_handshake(JNIEnv* env, jclass, jlong ssl_
         return 0;
     }
 
+    uint64_t handshakeStart = conscrypt::SslCounters::nowNanos();
+    CONSCRYPT_TRACE_EVENT(conscrypt::eventtrace::kCategorySsl,
+                          conscrypt::eventtrace::kEventHandshakeStart, ssl);
     int ret = SSL_do_handshake(ssl);
+    countSslEvent(ssl, conscrypt::SslCounters::kHandshakeNanos,
+                  conscrypt::SslCounters::nowNanos() - handshakeStart);
+    CONSCRYPT_TRACE_EVENT(conscrypt::eventtrace::kCategorySsl,
+                          conscrypt::eventtrace::kEventHandshakeDone, ssl, ret,
+                          SSL_get_error(ssl, ret));
     appData->clearCallbackState();
     if (env->ExceptionCheck()) {
         // cert_verify_callback threw exception
@@ -10409,7 +13801,8 @@ static jint NativeCrypto_ENGINE_SSL_do_handshake(JNIEnv* env, jclass, jlong ssl_
     SslError sslError(ssl, ret);
     int code = sslError.get();
 
-    if (ret > 0 || code == SSL_ERROR_WANT_READ || code == SSL_ERROR_WANT_WRITE) {
+    if (ret > 0 || code == SSL_ERROR_WANT_READ || code == SSL_ERROR_WANT_WRITE ||
+        code == SSL_ERROR_WANT_PRIVATE_KEY_OPERATION || code == SSL_ERROR_EARLY_DATA_REJECTED) {
         // Non-exceptional case.
         JNI_TRACE("ssl=%p NativeCrypto_ENGINE_SSL_do_handshake shc=%p => ret=%d", ssl, shc, code);
         return code;
@@ -10549,6 +13942,8 @@ static jint NativeCrypto_ENGINE_SSL_read_direct(JNIEnv* env, jclass, jlong ssl_a
 
     int result = SSL_read(ssl, destPtr, length);
     appData->clearCallbackState();
+    CONSCRYPT_TRACE_EVENT(conscrypt::eventtrace::kCategoryIo, conscrypt::eventtrace::kEventRead,
+                          ssl, length, result);
     if (env->ExceptionCheck()) {
         // An exception was thrown by one of the callbacks. Just propagate that exception.
         ERR_clear_error();
@@ -10572,6 +13967,18 @@ static jint NativeCrypto_ENGINE_SSL_read_direct(JNIEnv* env, jclass, jlong ssl_a
             result = -sslError.get();
             break;
         }
+        case SSL_ERROR_WANT_PRIVATE_KEY_OPERATION: {
+            // The handshake is waiting for a delegated key operation. Like WANT_READ, there is
+            // nothing to return yet; the engine reports NEED_TASK from its handshake status.
+            result = -SSL_ERROR_WANT_READ;
+            break;
+        }
+        case SSL_ERROR_EARLY_DATA_REJECTED: {
+            // The server declined our 0-RTT data. The engine resets the SSL and carries on
+            // with the full handshake.
+            result = -SSL_ERROR_EARLY_DATA_REJECTED;
+            break;
+        }
         case SSL_ERROR_SYSCALL: {
             // A problem occurred during a system call, but this is not
             // necessarily an error.
@@ -10660,6 +14067,9 @@ static int NativeCrypto_ENGINE_SSL_write_BIO_direct(JNIEnv* env, jclass, jlong s
             ssl, bio, sourcePtr, len, shc, result);
     JNI_TRACE_PACKET_DATA(ssl, 'O', reinterpret_cast<const char*>(sourcePtr),
                           static_cast<size_t>(result));
+    if (result > 0) {
+        CONSCRYPT_TRACE_PACKET(ssl, 'O', sourcePtr, static_cast<size_t>(result));
+    }
     return result;
 }
 
@@ -10711,6 +14121,9 @@ static int NativeCrypto_ENGINE_SSL_read_BIO_direct(JNIEnv* env, jclass, jlong ss
             "=> ret=%d",
             ssl, bio, destPtr, outputSize, shc, result);
     JNI_TRACE_PACKET_DATA(ssl, 'I', destPtr, static_cast<size_t>(result));
+    if (result > 0) {
+        CONSCRYPT_TRACE_PACKET(ssl, 'I', destPtr, static_cast<size_t>(result));
+    }
     return result;
 }
 
@@ -10755,8 +14168,12 @@ static void NativeCrypto_ENGINE_SSL_force_read(JNIEnv* env, jclass, jlong ssl_ad
         case SSL_ERROR_NONE:
         case SSL_ERROR_ZERO_RETURN:
         case SSL_ERROR_WANT_READ:
-        case SSL_ERROR_WANT_WRITE: {
-            // The call succeeded, lacked data, or the SSL is closed.  All is well.
+        case SSL_ERROR_WANT_WRITE:
+        case SSL_ERROR_WANT_PRIVATE_KEY_OPERATION:
+        case SSL_ERROR_EARLY_DATA_REJECTED: {
+            // The call succeeded, lacked data, the SSL is closed, the handshake is waiting
+            // for a delegated key operation, or early data was rejected and the next read or
+            // write will say so.  All is well.
             break;
         }
         case SSL_ERROR_SYSCALL: {
@@ -10832,11 +14249,212 @@ static int NativeCrypto_ENGINE_SSL_write_direct(JNIEnv* env, jclass, jlong ssl_a
 
     int result = SSL_write(ssl, sourcePtr, len);
     appData->clearCallbackState();
+    CONSCRYPT_TRACE_EVENT(conscrypt::eventtrace::kCategoryIo, conscrypt::eventtrace::kEventWrite,
+                          ssl, len, result);
     JNI_TRACE("ssl=%p NativeCrypto_ENGINE_SSL_write_direct address=%p length=%d shc=%p => ret=%d",
               ssl, sourcePtr, len, shc, result);
     return result;
 }
 
+// Validates the (addresses, lengths, count) triple handed to the *_vec natives and returns the
+// total number of bytes described, or -1 with a pending exception.
+static int64_t checkDirectVec(JNIEnv* env, const ScopedLongArrayRO& addresses,
+                              const ScopedIntArrayRO& lengths, jint count) {
+    if (addresses.get() == nullptr || lengths.get() == nullptr) {
+        return -1;
+    }
+    if (count < 0 || static_cast<size_t>(count) > addresses.size() ||
+        static_cast<size_t>(count) > lengths.size()) {
+        conscrypt::jniutil::throwException(env, "java/lang/ArrayIndexOutOfBoundsException",
+                                           "count");
+        return -1;
+    }
+    int64_t total = 0;
+    for (jint i = 0; i < count; i++) {
+        if (lengths[i] < 0) {
+            conscrypt::jniutil::throwException(env, "java/lang/IllegalArgumentException",
+                                               "lengths[i] < 0");
+            return -1;
+        }
+        total += lengths[i];
+    }
+    return total;
+}
+
+/**
+ * Writes plaintext gathered from up to {@code count} native segments as a single SSL_write, so
+ * that data spread over several small buffers is sealed into one record instead of one record
+ * per buffer. SSL_write only accepts a contiguous buffer, so when the first non-empty segment
+ * can't fill a record by itself the segments are gathered on the stack; otherwise that segment
+ * is handed to BoringSSL in place.
+ */
+static int NativeCrypto_ENGINE_SSL_write_direct_vec(JNIEnv* env, jclass, jlong ssl_address,
+                                                    CONSCRYPT_UNUSED jobject ssl_holder,
+                                                    jlongArray addressesArray,
+                                                    jintArray lengthsArray, jint count,
+                                                    jobject shc) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    SSL* ssl = to_SSL(env, ssl_address, true);
+    if (ssl == nullptr) {
+        return -1;
+    }
+    JNI_TRACE("ssl=%p NativeCrypto_ENGINE_SSL_write_direct_vec count=%d shc=%p", ssl, count, shc);
+    if (shc == nullptr) {
+        conscrypt::jniutil::throwNullPointerException(env, "sslHandshakeCallbacks == null");
+        JNI_TRACE("ssl=%p NativeCrypto_ENGINE_SSL_write_direct_vec => sslHandshakeCallbacks == null",
+                  ssl);
+        return -1;
+    }
+    ScopedLongArrayRO addresses(env, addressesArray);
+    ScopedIntArrayRO lengths(env, lengthsArray);
+    if (checkDirectVec(env, addresses, lengths, count) < 0) {
+        JNI_TRACE("ssl=%p NativeCrypto_ENGINE_SSL_write_direct_vec => invalid segments", ssl);
+        return -1;
+    }
+
+    jint first = 0;
+    while (first < count && lengths[first] == 0) {
+        first++;
+    }
+    if (first == count) {
+        return 0;
+    }
+
+    const char* sourcePtr = reinterpret_cast<const char*>(addresses[first]);
+    int len = lengths[first];
+    char gathered[SSL3_RT_MAX_PLAIN_LENGTH];
+    if (len < SSL3_RT_MAX_PLAIN_LENGTH) {
+        size_t used = 0;
+        for (jint i = first; i < count && used < sizeof(gathered); i++) {
+            size_t chunk = std::min(static_cast<size_t>(lengths[i]), sizeof(gathered) - used);
+            memcpy(gathered + used, reinterpret_cast<const char*>(addresses[i]), chunk);
+            used += chunk;
+        }
+        if (used > static_cast<size_t>(len)) {
+            sourcePtr = gathered;
+            len = static_cast<int>(used);
+        }
+    }
+
+    AppData* appData = toAppData(ssl);
+    if (appData == nullptr) {
+        conscrypt::jniutil::throwSSLExceptionStr(env, "Unable to retrieve application data");
+        ERR_clear_error();
+        JNI_TRACE("ssl=%p NativeCrypto_ENGINE_SSL_write_direct_vec appData => null", ssl);
+        return -1;
+    }
+    if (!appData->setCallbackState(env, shc, nullptr)) {
+        conscrypt::jniutil::throwSSLExceptionStr(env, "Unable to set appdata callback");
+        ERR_clear_error();
+        JNI_TRACE("ssl=%p NativeCrypto_ENGINE_SSL_write_direct_vec => exception", ssl);
+        return -1;
+    }
+
+    errno = 0;
+
+    int result = SSL_write(ssl, sourcePtr, len);
+    appData->clearCallbackState();
+    CONSCRYPT_TRACE_EVENT(conscrypt::eventtrace::kCategoryIo, conscrypt::eventtrace::kEventWrite,
+                          ssl, len, result);
+    JNI_TRACE("ssl=%p NativeCrypto_ENGINE_SSL_write_direct_vec length=%d shc=%p => ret=%d", ssl,
+              len, shc, result);
+    return result;
+}
+
+/**
+ * Feeds up to {@code count} native segments of encrypted data into the network BIO. As with
+ * ENGINE_SSL_write_BIO_direct nothing is written unless the BIO can take every segment, so a
+ * packet split across several network buffers is consumed in one call.
+ */
+static int NativeCrypto_ENGINE_SSL_write_BIO_direct_vec(JNIEnv* env, jclass, jlong ssl_address,
+                                                        CONSCRYPT_UNUSED jobject ssl_holder,
+                                                        jlong bioRef, jlongArray addressesArray,
+                                                        jintArray lengthsArray, jint count,
+                                                        jobject shc) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    SSL* ssl = to_SSL(env, ssl_address, true);
+    if (ssl == nullptr) {
+        return -1;
+    }
+    if (shc == nullptr) {
+        conscrypt::jniutil::throwNullPointerException(env, "sslHandshakeCallbacks == null");
+        JNI_TRACE(
+                "ssl=%p NativeCrypto_ENGINE_SSL_write_BIO_direct_vec => "
+                "sslHandshakeCallbacks == null",
+                ssl);
+        return -1;
+    }
+    BIO* bio = to_BIO(env, bioRef);
+    if (bio == nullptr) {
+        return -1;
+    }
+    ScopedLongArrayRO addresses(env, addressesArray);
+    ScopedIntArrayRO lengths(env, lengthsArray);
+    int64_t total = checkDirectVec(env, addresses, lengths, count);
+    if (total < 0) {
+        JNI_TRACE("ssl=%p NativeCrypto_ENGINE_SSL_write_BIO_direct_vec => invalid segments", ssl);
+        return -1;
+    }
+    if (total > INT_MAX || BIO_ctrl_get_write_guarantee(bio) < static_cast<size_t>(total)) {
+        // The network BIO couldn't handle the entire write. Don't write anything, so that we
+        // only process one packet at a time.
+        return 0;
+    }
+
+    AppData* appData = toAppData(ssl);
+    if (appData == nullptr) {
+        conscrypt::jniutil::throwSSLExceptionStr(env, "Unable to retrieve application data");
+        ERR_clear_error();
+        JNI_TRACE("ssl=%p NativeCrypto_ENGINE_SSL_write_BIO_direct_vec appData => null", ssl);
+        return -1;
+    }
+    if (!appData->setCallbackState(env, shc, nullptr)) {
+        conscrypt::jniutil::throwSSLExceptionStr(env, "Unable to set appdata callback");
+        ERR_clear_error();
+        JNI_TRACE("ssl=%p NativeCrypto_ENGINE_SSL_write_BIO_direct_vec => exception", ssl);
+        return -1;
+    }
+
+    errno = 0;
+
+    int written = 0;
+    int result = 0;
+    for (jint i = 0; i < count; i++) {
+        if (lengths[i] == 0) {
+            continue;
+        }
+        const char* sourcePtr = reinterpret_cast<const char*>(addresses[i]);
+        result = BIO_write(bio, sourcePtr, lengths[i]);
+        if (result <= 0) {
+            break;
+        }
+        JNI_TRACE_PACKET_DATA(ssl, 'O', sourcePtr, static_cast<size_t>(result));
+        CONSCRYPT_TRACE_PACKET(ssl, 'O', sourcePtr, static_cast<size_t>(result));
+        written += result;
+        if (result < lengths[i]) {
+            break;
+        }
+    }
+    appData->clearCallbackState();
+    JNI_TRACE("ssl=%p NativeCrypto_ENGINE_SSL_write_BIO_direct_vec bio=%p count=%d => ret=%d", ssl,
+              bio, count, written > 0 ? written : result);
+    return written > 0 ? written : result;
+}
+
+/*
+ * public static native void setCriticalArrayThreshold(int threshold);
+ */
+static void NativeCrypto_setCriticalArrayThreshold(JNIEnv* env, jclass, jint threshold) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    JNI_TRACE("setCriticalArrayThreshold(%d)", threshold);
+    if (threshold < 0) {
+        conscrypt::jniutil::throwException(env, "java/lang/IllegalArgumentException",
+                                           "threshold < 0");
+        return;
+    }
+    conscrypt::jniutil::setCriticalArrayThreshold(static_cast<size_t>(threshold));
+}
+
 /**
  * public static native bool usesBoringSsl_FIPS_mode();
  */
@@ -10888,6 +14506,81 @@ static jbyteArray NativeCrypto_Scrypt_generate_key(JNIEnv* env, jclass, jbyteArr
     return key_bytes;
 }
 
+/*
+ * Overload of Scrypt_generate_key that runs the p lanes on up to maxThreads threads, within
+ * the same memory limit, reusing per-thread scratch memory between calls.
+ */
+static jbyteArray NativeCrypto_Scrypt_generate_key_parallel(JNIEnv* env, jclass,
+                                                            jbyteArray password, jbyteArray salt,
+                                                            jint n, jint r, jint p, jint key_len,
+                                                            jint maxThreads) {
+    CHECK_ERROR_QUEUE_ON_RETURN;
+    JNI_TRACE("Scrypt_generate_key(%p, %p, %d, %d, %d, %d, %d)", password, salt, n, r, p,
+              key_len, maxThreads);
+
+    if (password == nullptr) {
+        conscrypt::jniutil::throwNullPointerException(env, "password == null");
+        JNI_TRACE("Scrypt_generate_key() => password == null");
+        return nullptr;
+    }
+    if (salt == nullptr) {
+        conscrypt::jniutil::throwNullPointerException(env, "salt == null");
+        JNI_TRACE("Scrypt_generate_key() => salt == null");
+        return nullptr;
+    }
+    if (n < 0 || r < 0 || p < 0 || key_len < 0) {
+        conscrypt::jniutil::throwException(env, "java/lang/IllegalArgumentException",
+                                           "Invalid scrypt parameters");
+        return nullptr;
+    }
+
+    ScopedLocalRef<jbyteArray> key_bytes(env, env->NewByteArray(static_cast<jsize>(key_len)));
+    if (key_bytes.get() == nullptr) {
+        return nullptr;
+    }
+    ScopedByteArrayRO password_bytes(env, password);
+    if (password_bytes.get() == nullptr) {
+        return nullptr;
+    }
+    ScopedByteArrayRO salt_bytes(env, salt);
+    if (salt_bytes.get() == nullptr) {
+        return nullptr;
+    }
+    ScopedByteArrayRW out_key(env, key_bytes.get());
+    if (out_key.get() == nullptr) {
+        return nullptr;
+    }
+
+    size_t memory_limit = 1u << 29;
+    conscrypt::scrypt::Result result = conscrypt::scrypt::deriveKey(
+            reinterpret_cast<const uint8_t*>(password_bytes.get()), password_bytes.size(),
+            reinterpret_cast<const uint8_t*>(salt_bytes.get()), salt_bytes.size(),
+            static_cast<uint64_t>(n), static_cast<uint64_t>(r), static_cast<uint64_t>(p),
+            memory_limit, maxThreads > 0 ? static_cast<size_t>(maxThreads) : 1,
+            reinterpret_cast<uint8_t*>(out_key.get()), static_cast<size_t>(key_len));
+    switch (result) {
+        case conscrypt::scrypt::Result::kOk:
+            break;
+        case conscrypt::scrypt::Result::kInvalidParameters:
+            conscrypt::jniutil::throwException(env, "java/lang/IllegalArgumentException",
+                                               "Invalid scrypt parameters");
+            return nullptr;
+        case conscrypt::scrypt::Result::kMemoryLimitExceeded:
+            conscrypt::jniutil::throwException(env, "java/lang/IllegalArgumentException",
+                                               "scrypt parameters exceed the memory limit");
+            return nullptr;
+        case conscrypt::scrypt::Result::kAllocationFailed:
+            conscrypt::jniutil::throwOutOfMemory(env, "Unable to allocate scrypt scratch memory");
+            return nullptr;
+        case conscrypt::scrypt::Result::kPbkdf2Failed:
+            conscrypt::jniutil::throwExceptionFromBoringSSLError(env, "Scrypt_generate_key");
+            return nullptr;
+    }
+    JNI_TRACE("Scrypt_generate_key(%p, %p, %d, %d, %d, %d, %d) => ok", password, salt, n, r, p,
+              key_len, maxThreads);
+    return key_bytes.release();
+}
+
 // TESTING METHODS BEGIN
 
 static int NativeCrypto_BIO_read(JNIEnv* env, jclass, jlong bioRef, jbyteArray outputJavaBytes) {
@@ -11037,12 +14730,23 @@ static jlong NativeCrypto_SSL_get1_session(JNIEnv* env, jclass, jlong ssl_addres
         (char*)#functionName, (char*)(signature),                    \
                 reinterpret_cast<void*>(NativeCrypto_##functionName) \
     }
+// Registers NativeCrypto_<implName> as an overload of the Java native functionName.
+#define CONSCRYPT_NATIVE_OVERLOAD(functionName, implName, signature)  \
+    {                                                                 \
+        /* NOLINTNEXTLINE */                                          \
+        (char*)#functionName, (char*)(signature),                     \
+                reinterpret_cast<void*>(NativeCrypto_##implName)      \
+    }
 
 #define FILE_DESCRIPTOR "Ljava/io/FileDescriptor;"
+#define REVOKED_CERTIFICATE_VISITOR                                               \
+    "L" TO_STRING(JNI_JARJAR_PREFIX)                                              \
+    "org/conscrypt/CertificateFileReader$RevokedCertificateVisitor;"
 #define SSL_CALLBACKS \
     "L" TO_STRING(JNI_JARJAR_PREFIX) "org/conscrypt/NativeCrypto$SSLHandshakeCallbacks;"
 #define REF_EC_GROUP "L" TO_STRING(JNI_JARJAR_PREFIX) "org/conscrypt/NativeRef$EC_GROUP;"
 #define REF_EC_POINT "L" TO_STRING(JNI_JARJAR_PREFIX) "org/conscrypt/NativeRef$EC_POINT;"
+#define REF_EVP_AEAD_CTX "L" TO_STRING(JNI_JARJAR_PREFIX) "org/conscrypt/NativeRef$EVP_AEAD_CTX;"
 #define REF_EVP_CIPHER_CTX \
     "L" TO_STRING(JNI_JARJAR_PREFIX) "org/conscrypt/NativeRef$EVP_CIPHER_CTX;"
 #define REF_EVP_HPKE_CTX "L" TO_STRING(JNI_JARJAR_PREFIX) "org/conscrypt/NativeRef$EVP_HPKE_CTX;"
@@ -11052,6 +14756,12 @@ static jlong NativeCrypto_SSL_get1_session(JNIEnv* env, jclass, jlong ssl_addres
 #define REF_EVP_PKEY_CTX "L" TO_STRING(JNI_JARJAR_PREFIX) "org/conscrypt/NativeRef$EVP_PKEY_CTX;"
 #define REF_HMAC_CTX "L" TO_STRING(JNI_JARJAR_PREFIX) "org/conscrypt/NativeRef$HMAC_CTX;"
 #define REF_CMAC_CTX "L" TO_STRING(JNI_JARJAR_PREFIX) "org/conscrypt/NativeRef$CMAC_CTX;"
+#define REF_HMAC_PREPARED_KEY \
+    "L" TO_STRING(JNI_JARJAR_PREFIX) "org/conscrypt/NativeRef$HMAC_PREPARED_KEY;"
+#define REF_PREPARED_VERIFIER \
+    "L" TO_STRING(JNI_JARJAR_PREFIX) "org/conscrypt/NativeRef$PREPARED_VERIFIER;"
+#define REF_CMAC_PREPARED_KEY \
+    "L" TO_STRING(JNI_JARJAR_PREFIX) "org/conscrypt/NativeRef$CMAC_PREPARED_KEY;"
 #define REF_BIO_IN_STREAM "L" TO_STRING(JNI_JARJAR_PREFIX) "org/conscrypt/OpenSSLBIOInputStream;"
 #define REF_X509 "L" TO_STRING(JNI_JARJAR_PREFIX) "org/conscrypt/OpenSSLX509Certificate;"
 #define REF_X509_CRL "L" TO_STRING(JNI_JARJAR_PREFIX) "org/conscrypt/OpenSSLX509CRL;"
@@ -11059,6 +14769,7 @@ static jlong NativeCrypto_SSL_get1_session(JNIEnv* env, jclass, jlong ssl_addres
 #define REF_SSL_CTX "L" TO_STRING(JNI_JARJAR_PREFIX) "org/conscrypt/AbstractSessionContext;"
 static JNINativeMethod sNativeCryptoMethods[] = {
         CONSCRYPT_NATIVE_METHOD(clinit, "()V"),
+        CONSCRYPT_NATIVE_METHOD(get_startup_timings, "()[J"),
         CONSCRYPT_NATIVE_METHOD(CMAC_CTX_new, "()J"),
         CONSCRYPT_NATIVE_METHOD(CMAC_CTX_free, "(J)V"),
         CONSCRYPT_NATIVE_METHOD(CMAC_Init, "(" REF_CMAC_CTX "[B)V"),
@@ -11066,6 +14777,10 @@ static JNINativeMethod sNativeCryptoMethods[] = {
         CONSCRYPT_NATIVE_METHOD(CMAC_UpdateDirect, "(" REF_CMAC_CTX "JI)V"),
         CONSCRYPT_NATIVE_METHOD(CMAC_Final, "(" REF_CMAC_CTX ")[B"),
         CONSCRYPT_NATIVE_METHOD(CMAC_Reset, "(" REF_CMAC_CTX ")V"),
+        CONSCRYPT_NATIVE_METHOD(CMAC_PREPARED_KEY_new, "([B)J"),
+        CONSCRYPT_NATIVE_METHOD(CMAC_PREPARED_KEY_free, "(J)V"),
+        CONSCRYPT_NATIVE_METHOD(CMAC_oneshot, "(" REF_CMAC_PREPARED_KEY "[BII)[B"),
+        CONSCRYPT_NATIVE_METHOD(CMAC_oneshotDirect, "(" REF_CMAC_PREPARED_KEY "JI)[B"),
         CONSCRYPT_NATIVE_METHOD(EVP_PKEY_new_RSA, "([B[B[B[B[B[B[B[B)J"),
         CONSCRYPT_NATIVE_METHOD(EVP_PKEY_new_EC_KEY, "(" REF_EC_GROUP REF_EC_POINT "[B)J"),
         CONSCRYPT_NATIVE_METHOD(EVP_PKEY_type, "(" REF_EVP_PKEY ")I"),
@@ -11092,6 +14807,7 @@ static JNINativeMethod sNativeCryptoMethods[] = {
         CONSCRYPT_NATIVE_METHOD(get_RSA_private_params, "(" REF_EVP_PKEY ")[[B"),
         CONSCRYPT_NATIVE_METHOD(get_RSA_public_params, "(" REF_EVP_PKEY ")[[B"),
         CONSCRYPT_NATIVE_METHOD(chacha20_encrypt_decrypt, "([BI[BII[B[BI)V"),
+        CONSCRYPT_NATIVE_METHOD(chacha20_encrypt_decryptDirect, "(JJI[B[BI)V"),
         CONSCRYPT_NATIVE_METHOD(EC_GROUP_new_by_curve_name, "(Ljava/lang/String;)J"),
         CONSCRYPT_NATIVE_METHOD(EC_GROUP_new_arbitrary, "([B[B[B[B[B[BI)J"),
         CONSCRYPT_NATIVE_METHOD(EC_GROUP_get_curve_name, "(" REF_EC_GROUP ")Ljava/lang/String;"),
@@ -11117,6 +14833,10 @@ static JNINativeMethod sNativeCryptoMethods[] = {
         CONSCRYPT_NATIVE_METHOD(ECDSA_size, "(" REF_EVP_PKEY ")I"),
         CONSCRYPT_NATIVE_METHOD(ECDSA_sign, "([B[B" REF_EVP_PKEY ")I"),
         CONSCRYPT_NATIVE_METHOD(ECDSA_verify, "([B[B" REF_EVP_PKEY ")I"),
+        CONSCRYPT_NATIVE_METHOD(PREPARED_VERIFIER_new, "(" REF_EVP_PKEY ")J"),
+        CONSCRYPT_NATIVE_METHOD(PREPARED_VERIFIER_free, "(J)V"),
+        CONSCRYPT_NATIVE_METHOD(PREPARED_VERIFIER_verify_batch,
+                                "(" REF_PREPARED_VERIFIER "[B[II)[J"),
         CONSCRYPT_NATIVE_METHOD(X25519, "([B[B[B)Z"),
         CONSCRYPT_NATIVE_METHOD(X25519_keypair, "([B[B)V"),
         CONSCRYPT_NATIVE_METHOD(EVP_MD_CTX_create, "()J"),
@@ -11129,6 +14849,7 @@ static JNINativeMethod sNativeCryptoMethods[] = {
         CONSCRYPT_NATIVE_METHOD(EVP_DigestFinal_ex, "(" REF_EVP_MD_CTX "[BI)I"),
         CONSCRYPT_NATIVE_METHOD(EVP_get_digestbyname, "(Ljava/lang/String;)J"),
         CONSCRYPT_NATIVE_METHOD(EVP_MD_size, "(J)I"),
+        CONSCRYPT_NATIVE_METHOD(EVP_Digest_batch, "(JJI[I[IIJI)V"),
         CONSCRYPT_NATIVE_METHOD(EVP_DigestSignInit, "(" REF_EVP_MD_CTX "J" REF_EVP_PKEY ")J"),
         CONSCRYPT_NATIVE_METHOD(EVP_DigestSignUpdate, "(" REF_EVP_MD_CTX "[BII)V"),
         CONSCRYPT_NATIVE_METHOD(EVP_DigestSignUpdateDirect, "(" REF_EVP_MD_CTX "JI)V"),
@@ -11150,7 +14871,9 @@ static JNINativeMethod sNativeCryptoMethods[] = {
         CONSCRYPT_NATIVE_METHOD(EVP_get_cipherbyname, "(Ljava/lang/String;)J"),
         CONSCRYPT_NATIVE_METHOD(EVP_CipherInit_ex, "(" REF_EVP_CIPHER_CTX "J[B[BZ)V"),
         CONSCRYPT_NATIVE_METHOD(EVP_CipherUpdate, "(" REF_EVP_CIPHER_CTX "[BI[BII)I"),
+        CONSCRYPT_NATIVE_METHOD(EVP_CipherUpdateDirect, "(" REF_EVP_CIPHER_CTX "JIJI)I"),
         CONSCRYPT_NATIVE_METHOD(EVP_CipherFinal_ex, "(" REF_EVP_CIPHER_CTX "[BI)I"),
+        CONSCRYPT_NATIVE_METHOD(EVP_CipherFinal_exDirect, "(" REF_EVP_CIPHER_CTX "JI)I"),
         CONSCRYPT_NATIVE_METHOD(EVP_CIPHER_iv_length, "(J)I"),
         CONSCRYPT_NATIVE_METHOD(EVP_CIPHER_CTX_new, "()J"),
         CONSCRYPT_NATIVE_METHOD(EVP_CIPHER_CTX_block_size, "(" REF_EVP_CIPHER_CTX ")I"),
@@ -11172,6 +14895,18 @@ static JNINativeMethod sNativeCryptoMethods[] = {
                                 "(J[BILjava/nio/ByteBuffer;[BLjava/nio/ByteBuffer;[B)I"),
         CONSCRYPT_NATIVE_METHOD(EVP_AEAD_CTX_open_buf,
                                 "(J[BILjava/nio/ByteBuffer;[BLjava/nio/ByteBuffer;[B)I"),
+        CONSCRYPT_NATIVE_METHOD(EVP_AEAD_CTX_new, "(J[BI)J"),
+        CONSCRYPT_NATIVE_METHOD(EVP_AEAD_CTX_free, "(J)V"),
+        CONSCRYPT_NATIVE_METHOD(EVP_AEAD_CTX_seal_ctx, "(" REF_EVP_AEAD_CTX "[BI[B[BII[B)I"),
+        CONSCRYPT_NATIVE_METHOD(EVP_AEAD_CTX_open_ctx, "(" REF_EVP_AEAD_CTX "[BI[B[BII[B)I"),
+        CONSCRYPT_NATIVE_METHOD(EVP_AEAD_CTX_seal_ctx_buf,
+                                "(" REF_EVP_AEAD_CTX "Ljava/nio/ByteBuffer;[BLjava/nio/ByteBuffer;[B)I"),
+        CONSCRYPT_NATIVE_METHOD(EVP_AEAD_CTX_open_ctx_buf,
+                                "(" REF_EVP_AEAD_CTX "Ljava/nio/ByteBuffer;[BLjava/nio/ByteBuffer;[B)I"),
+        CONSCRYPT_NATIVE_METHOD(EVP_AEAD_CTX_seal_batch,
+                                "(" REF_EVP_AEAD_CTX "Ljava/nio/ByteBuffer;[I[I)I"),
+        CONSCRYPT_NATIVE_METHOD(EVP_AEAD_CTX_open_batch,
+                                "(" REF_EVP_AEAD_CTX "Ljava/nio/ByteBuffer;[I[I)I"),
         CONSCRYPT_NATIVE_METHOD(EVP_HPKE_CTX_export, "(" REF_EVP_HPKE_CTX "[BI)[B"),
         CONSCRYPT_NATIVE_METHOD(EVP_HPKE_CTX_free, "(J)V"),
         CONSCRYPT_NATIVE_METHOD(EVP_HPKE_CTX_open, "(" REF_EVP_HPKE_CTX "[B[B)[B"),
@@ -11187,7 +14922,13 @@ static JNINativeMethod sNativeCryptoMethods[] = {
         CONSCRYPT_NATIVE_METHOD(HMAC_UpdateDirect, "(" REF_HMAC_CTX "JI)V"),
         CONSCRYPT_NATIVE_METHOD(HMAC_Final, "(" REF_HMAC_CTX ")[B"),
         CONSCRYPT_NATIVE_METHOD(HMAC_Reset, "(" REF_HMAC_CTX ")V"),
+        CONSCRYPT_NATIVE_METHOD(HMAC_PREPARED_KEY_new, "([BJ)J"),
+        CONSCRYPT_NATIVE_METHOD(HMAC_PREPARED_KEY_free, "(J)V"),
+        CONSCRYPT_NATIVE_METHOD(HMAC_oneshot, "(" REF_HMAC_PREPARED_KEY "[BII)[B"),
+        CONSCRYPT_NATIVE_METHOD(HMAC_oneshotDirect, "(" REF_HMAC_PREPARED_KEY "JI)[B"),
         CONSCRYPT_NATIVE_METHOD(RAND_bytes, "([B)V"),
+        CONSCRYPT_NATIVE_METHOD(RAND_bytes_direct, "(JI)V"),
+        CONSCRYPT_NATIVE_METHOD(setRandomBufferingEnabled, "(Z)V"),
         CONSCRYPT_NATIVE_METHOD(create_BIO_InputStream, ("(" REF_BIO_IN_STREAM "Z)J")),
         CONSCRYPT_NATIVE_METHOD(create_BIO_OutputStream, "(Ljava/io/OutputStream;)J"),
         CONSCRYPT_NATIVE_METHOD(BIO_free_all, "(J)V"),
@@ -11198,6 +14939,13 @@ static JNINativeMethod sNativeCryptoMethods[] = {
         CONSCRYPT_NATIVE_METHOD(PEM_read_bio_X509, "(J)J"),
         CONSCRYPT_NATIVE_METHOD(PEM_read_bio_PKCS7, "(JI)[J"),
         CONSCRYPT_NATIVE_METHOD(d2i_PKCS7_bio, "(JI)[J"),
+        CONSCRYPT_NATIVE_METHOD(MAPPED_FILE_open, "(Ljava/lang/String;)J"),
+        CONSCRYPT_NATIVE_METHOD(MAPPED_FILE_open_fd, "(I)J"),
+        CONSCRYPT_NATIVE_METHOD(MAPPED_FILE_free, "(J)V"),
+        CONSCRYPT_NATIVE_METHOD(MAPPED_FILE_next_X509, "(J)J"),
+        CONSCRYPT_NATIVE_METHOD(MAPPED_FILE_next_X509_CRL, "(J)J"),
+        CONSCRYPT_NATIVE_METHOD(MAPPED_FILE_visit_X509_CRL_entries,
+                                "(J" REVOKED_CERTIFICATE_VISITOR ")I"),
         CONSCRYPT_NATIVE_METHOD(i2d_PKCS7, "([J)[B"),
         CONSCRYPT_NATIVE_METHOD(ASN1_seq_unpack_X509_bio, "(J)[J"),
         CONSCRYPT_NATIVE_METHOD(ASN1_seq_pack_X509, "([J)[B"),
@@ -11226,6 +14974,7 @@ static JNINativeMethod sNativeCryptoMethods[] = {
         CONSCRYPT_NATIVE_METHOD(X509_REVOKED_print, "(JJ)V"),
         CONSCRYPT_NATIVE_METHOD(get_X509_REVOKED_revocationDate, "(J)J"),
         CONSCRYPT_NATIVE_METHOD(get_X509_ext_oids, "(J" REF_X509 "I)[Ljava/lang/String;"),
+        CONSCRYPT_NATIVE_METHOD(get_X509_fields, "(J" REF_X509 ")[Ljava/lang/Object;"),
         CONSCRYPT_NATIVE_METHOD(get_X509_CRL_ext_oids, "(J" REF_X509_CRL "I)[Ljava/lang/String;"),
         CONSCRYPT_NATIVE_METHOD(get_X509_REVOKED_ext_oids, "(JI)[Ljava/lang/String;"),
         CONSCRYPT_NATIVE_METHOD(get_X509_GENERAL_NAME_stack,
@@ -11283,14 +15032,25 @@ static JNINativeMethod sNativeCryptoMethods[] = {
         CONSCRYPT_NATIVE_METHOD(asn1_write_free, "(J)V"),
         CONSCRYPT_NATIVE_METHOD(EVP_has_aes_hardware, "()I"),
         CONSCRYPT_NATIVE_METHOD(SSL_CTX_new, "()J"),
+        CONSCRYPT_NATIVE_METHOD(CRYPTO_BUFFER_POOL_get_stats, "()[J"),
         CONSCRYPT_NATIVE_METHOD(SSL_CTX_free, "(J" REF_SSL_CTX ")V"),
         CONSCRYPT_NATIVE_METHOD(SSL_CTX_set_session_id_context, "(J" REF_SSL_CTX "[B)V"),
         CONSCRYPT_NATIVE_METHOD(SSL_CTX_set_timeout, "(J" REF_SSL_CTX "J)J"),
+        CONSCRYPT_NATIVE_METHOD(SSL_CTX_set_ticket_keys, "(J" REF_SSL_CTX "[B)V"),
+        CONSCRYPT_NATIVE_METHOD(SSL_CTX_set_server_session_cache, "(J" REF_SSL_CTX "II)V"),
+        CONSCRYPT_NATIVE_METHOD(SSL_CTX_set_certificate_map,
+                                "(J" REF_SSL_CTX "[Ljava/lang/String;[J)V"),
+        CONSCRYPT_NATIVE_METHOD(SERVER_CREDENTIAL_new, "([[B" REF_EVP_PKEY "[B[B)J"),
+        CONSCRYPT_NATIVE_METHOD(SERVER_CREDENTIAL_free, "(J)V"),
+        CONSCRYPT_NATIVE_METHOD(SSL_CTX_get_counters, "(J" REF_SSL_CTX ")[J"),
         CONSCRYPT_NATIVE_METHOD(SSL_new, "(J" REF_SSL_CTX ")J"),
         CONSCRYPT_NATIVE_METHOD(SSL_enable_tls_channel_id, "(J" REF_SSL ")V"),
         CONSCRYPT_NATIVE_METHOD(SSL_get_tls_channel_id, "(J" REF_SSL ")[B"),
         CONSCRYPT_NATIVE_METHOD(SSL_set1_tls_channel_id, "(J" REF_SSL REF_EVP_PKEY ")V"),
         CONSCRYPT_NATIVE_METHOD(setLocalCertsAndPrivateKey, "(J" REF_SSL "[[B" REF_EVP_PKEY ")V"),
+        CONSCRYPT_NATIVE_METHOD(SSL_set_delegated_private_key, "(J" REF_SSL REF_EVP_PKEY ")V"),
+        CONSCRYPT_NATIVE_METHOD(SSL_do_delegated_key_operation, "(J" REF_SSL ")V"),
+        CONSCRYPT_NATIVE_METHOD(SSL_delegated_key_operation_pending, "(J" REF_SSL ")Z"),
         CONSCRYPT_NATIVE_METHOD(SSL_set_client_CA_list, "(J" REF_SSL "[[B)V"),
         CONSCRYPT_NATIVE_METHOD(SSL_set_mode, "(J" REF_SSL "J)J"),
         CONSCRYPT_NATIVE_METHOD(SSL_set_options, "(J" REF_SSL "J)J"),
@@ -11315,6 +15075,11 @@ static JNINativeMethod sNativeCryptoMethods[] = {
         CONSCRYPT_NATIVE_METHOD(SSL_set_session, "(J" REF_SSL "J)V"),
         CONSCRYPT_NATIVE_METHOD(SSL_set_session_creation_enabled, "(J" REF_SSL "Z)V"),
         CONSCRYPT_NATIVE_METHOD(SSL_session_reused, "(J" REF_SSL ")Z"),
+        CONSCRYPT_NATIVE_METHOD(SSL_set_early_data_enabled, "(J" REF_SSL "Z)V"),
+        CONSCRYPT_NATIVE_METHOD(SSL_in_early_data, "(J" REF_SSL ")Z"),
+        CONSCRYPT_NATIVE_METHOD(SSL_early_data_accepted, "(J" REF_SSL ")Z"),
+        CONSCRYPT_NATIVE_METHOD(SSL_get_early_data_reason, "(J" REF_SSL ")Ljava/lang/String;"),
+        CONSCRYPT_NATIVE_METHOD(SSL_reset_early_data_reject, "(J" REF_SSL ")V"),
         CONSCRYPT_NATIVE_METHOD(SSL_accept_renegotiations, "(J" REF_SSL ")V"),
         CONSCRYPT_NATIVE_METHOD(SSL_set_tlsext_host_name, "(J" REF_SSL "Ljava/lang/String;)V"),
         CONSCRYPT_NATIVE_METHOD(SSL_get_servername, "(J" REF_SSL ")Ljava/lang/String;"),
@@ -11322,10 +15087,24 @@ static JNINativeMethod sNativeCryptoMethods[] = {
         CONSCRYPT_NATIVE_METHOD(SSL_get_current_cipher, "(J" REF_SSL ")Ljava/lang/String;"),
         CONSCRYPT_NATIVE_METHOD(SSL_get_version, "(J" REF_SSL ")Ljava/lang/String;"),
         CONSCRYPT_NATIVE_METHOD(SSL_get0_peer_certificates, "(J" REF_SSL ")[[B"),
+        CONSCRYPT_NATIVE_METHOD(SSL_get_mapped_certificates, "(J" REF_SSL ")[[B"),
         CONSCRYPT_NATIVE_METHOD(SSL_read, "(J" REF_SSL FILE_DESCRIPTOR SSL_CALLBACKS "[BIII)I"),
         CONSCRYPT_NATIVE_METHOD(SSL_write, "(J" REF_SSL FILE_DESCRIPTOR SSL_CALLBACKS "[BIII)V"),
+        CONSCRYPT_NATIVE_METHOD(SSL_do_handshake_nonblocking,
+                                "(J" REF_SSL FILE_DESCRIPTOR SSL_CALLBACKS ")I"),
+        CONSCRYPT_NATIVE_METHOD(SSL_read_nonblocking,
+                                "(J" REF_SSL FILE_DESCRIPTOR SSL_CALLBACKS "[BII)I"),
+        CONSCRYPT_NATIVE_METHOD(SSL_write_nonblocking,
+                                "(J" REF_SSL FILE_DESCRIPTOR SSL_CALLBACKS "[BII)I"),
+        CONSCRYPT_NATIVE_METHOD(SSL_poller_new, "()J"),
+        CONSCRYPT_NATIVE_METHOD(SSL_poller_free, "(J)V"),
+        CONSCRYPT_NATIVE_METHOD(SSL_poller_arm, "(J" FILE_DESCRIPTOR "JI)V"),
+        CONSCRYPT_NATIVE_METHOD(SSL_poller_remove, "(J" FILE_DESCRIPTOR ")V"),
+        CONSCRYPT_NATIVE_METHOD(SSL_poller_wait, "(J[J[II)I"),
+        CONSCRYPT_NATIVE_METHOD(SSL_poller_wakeup, "(J)V"),
         CONSCRYPT_NATIVE_METHOD(SSL_interrupt, "(J" REF_SSL ")V"),
         CONSCRYPT_NATIVE_METHOD(SSL_shutdown, "(J" REF_SSL FILE_DESCRIPTOR SSL_CALLBACKS ")V"),
+        CONSCRYPT_NATIVE_METHOD(SSL_enable_ktls, "(J" REF_SSL FILE_DESCRIPTOR ")I"),
         CONSCRYPT_NATIVE_METHOD(SSL_get_shutdown, "(J" REF_SSL ")I"),
         CONSCRYPT_NATIVE_METHOD(SSL_free, "(J" REF_SSL ")V"),
         CONSCRYPT_NATIVE_METHOD(SSL_SESSION_session_id, "(J)[B"),
@@ -11346,12 +15125,26 @@ static JNINativeMethod sNativeCryptoMethods[] = {
         CONSCRYPT_NATIVE_METHOD(getApplicationProtocol, "(J" REF_SSL ")[B"),
         CONSCRYPT_NATIVE_METHOD(setApplicationProtocols, "(J" REF_SSL "Z[B)V"),
         CONSCRYPT_NATIVE_METHOD(setHasApplicationProtocolSelector, "(J" REF_SSL "Z)V"),
+        CONSCRYPT_NATIVE_METHOD(setHasSniMatchers, "(J" REF_SSL "Z)V"),
+        CONSCRYPT_NATIVE_METHOD(setVerifiedChainCacheIdentity, "(J" REF_SSL "[B)V"),
+        CONSCRYPT_NATIVE_METHOD(setVerifiedChainCacheParameters, "(IJ)V"),
+        CONSCRYPT_NATIVE_METHOD(clearVerifiedChainCache, "()V"),
+        CONSCRYPT_NATIVE_METHOD(getVerifiedChainCacheStats, "()[J"),
+        CONSCRYPT_NATIVE_METHOD(setPublicKeyCacheParameters, "(I)V"),
+        CONSCRYPT_NATIVE_METHOD(clearPublicKeyCache, "()V"),
+        CONSCRYPT_NATIVE_METHOD(getPublicKeyCacheStats, "()[J"),
+        CONSCRYPT_NATIVE_METHOD(setTraceCategories, "(I)V"),
+        CONSCRYPT_NATIVE_METHOD(getTraceCategories, "()I"),
+        CONSCRYPT_NATIVE_METHOD(clearTrace, "()V"),
+        CONSCRYPT_NATIVE_METHOD(dumpTrace, "()[B"),
+        CONSCRYPT_NATIVE_METHOD(dumpTracePcap, "()[B"),
         CONSCRYPT_NATIVE_METHOD(SSL_CIPHER_get_kx_name, "(J)Ljava/lang/String;"),
         CONSCRYPT_NATIVE_METHOD(get_cipher_names, "(Ljava/lang/String;)[Ljava/lang/String;"),
         CONSCRYPT_NATIVE_METHOD(get_ocsp_single_extension,
                                 "([BLjava/lang/String;J" REF_X509 "J" REF_X509 ")[B"),
         CONSCRYPT_NATIVE_METHOD(getDirectBufferAddress, "(Ljava/nio/Buffer;)J"),
         CONSCRYPT_NATIVE_METHOD(SSL_BIO_new, "(J" REF_SSL ")J"),
+        CONSCRYPT_NATIVE_METHOD(SSL_get_counters, "(J" REF_SSL ")[J"),
         CONSCRYPT_NATIVE_METHOD(SSL_max_seal_overhead, "(J" REF_SSL ")I"),
         CONSCRYPT_NATIVE_METHOD(SSL_clear_error, "()V"),
         CONSCRYPT_NATIVE_METHOD(SSL_pending_readable_bytes, "(J" REF_SSL ")I"),
@@ -11361,11 +15154,17 @@ static JNINativeMethod sNativeCryptoMethods[] = {
         CONSCRYPT_NATIVE_METHOD(ENGINE_SSL_read_direct, "(J" REF_SSL "JI" SSL_CALLBACKS ")I"),
         CONSCRYPT_NATIVE_METHOD(ENGINE_SSL_write_direct, "(J" REF_SSL "JI" SSL_CALLBACKS ")I"),
         CONSCRYPT_NATIVE_METHOD(ENGINE_SSL_write_BIO_direct, "(J" REF_SSL "JJI" SSL_CALLBACKS ")I"),
+        CONSCRYPT_NATIVE_METHOD(ENGINE_SSL_write_direct_vec, "(J" REF_SSL "[J[II" SSL_CALLBACKS ")I"),
+        CONSCRYPT_NATIVE_METHOD(ENGINE_SSL_write_BIO_direct_vec,
+                                "(J" REF_SSL "J[J[II" SSL_CALLBACKS ")I"),
         CONSCRYPT_NATIVE_METHOD(ENGINE_SSL_read_BIO_direct, "(J" REF_SSL "JJI" SSL_CALLBACKS ")I"),
         CONSCRYPT_NATIVE_METHOD(ENGINE_SSL_force_read, "(J" REF_SSL SSL_CALLBACKS ")V"),
         CONSCRYPT_NATIVE_METHOD(ENGINE_SSL_shutdown, "(J" REF_SSL SSL_CALLBACKS ")V"),
         CONSCRYPT_NATIVE_METHOD(usesBoringSsl_FIPS_mode, "()Z"),
+        CONSCRYPT_NATIVE_METHOD(setCriticalArrayThreshold, "(I)V"),
         CONSCRYPT_NATIVE_METHOD(Scrypt_generate_key, "([B[BIIII)[B"),
+        CONSCRYPT_NATIVE_OVERLOAD(Scrypt_generate_key, Scrypt_generate_key_parallel,
+                                  "([B[BIIIII)[B"),
 
         // Used for testing only.
         CONSCRYPT_NATIVE_METHOD(BIO_read, "(J[B)I"),
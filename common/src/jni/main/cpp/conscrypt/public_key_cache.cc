@@ -0,0 +1,148 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <conscrypt/public_key_cache.h>
+
+#include <atomic>
+#include <iterator>
+#include <list>
+#include <mutex>  // NOLINT(build/c++11)
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+namespace conscrypt {
+namespace publickeycache {
+
+namespace {
+
+struct Entry {
+    Key key;
+    bssl::UniquePtr<EVP_PKEY> pkey;
+};
+
+// Entries are kept in least-recently-used order, most recent first, with an index from the
+// SubjectPublicKeyInfo digest to the list position. Each entry holds one reference to its key.
+std::mutex g_mutex;
+std::list<Entry>* g_entries;
+std::unordered_map<std::string, std::list<Entry>::iterator>* g_index;
+size_t g_max_entries;
+std::atomic<bool> g_enabled;
+std::atomic<uint64_t> g_hits;
+std::atomic<uint64_t> g_misses;
+
+std::string indexKey(const Key& key) {
+    return std::string(reinterpret_cast<const char*>(key.digest), sizeof(key.digest));
+}
+
+void ensureStorageLocked() {
+    if (g_entries == nullptr) {
+        g_entries = new std::list<Entry>();
+        g_index = new std::unordered_map<std::string, std::list<Entry>::iterator>();
+    }
+}
+
+void eraseLocked(std::list<Entry>::iterator it) {
+    g_index->erase(indexKey(it->key));
+    g_entries->erase(it);
+}
+
+bssl::UniquePtr<EVP_PKEY> newReference(EVP_PKEY* pkey) {
+    EVP_PKEY_up_ref(pkey);
+    return bssl::UniquePtr<EVP_PKEY>(pkey);
+}
+
+}  // namespace
+
+void configure(size_t maxEntries) {
+    // Keys are freed once the lock is released.
+    std::list<Entry> dropped;
+    std::lock_guard<std::mutex> lock(g_mutex);
+    ensureStorageLocked();
+    if (maxEntries == 0) {
+        g_enabled = false;
+        g_max_entries = 0;
+        dropped.swap(*g_entries);
+        g_index->clear();
+        return;
+    }
+    g_max_entries = maxEntries;
+    while (g_entries->size() > g_max_entries) {
+        eraseLocked(std::prev(g_entries->end()));
+    }
+    g_enabled = true;
+}
+
+bool isEnabled() {
+    return g_enabled.load(std::memory_order_relaxed);
+}
+
+void computeKey(const uint8_t* spki, size_t spkiLength, Key* key) {
+    SHA256(spki, spkiLength, key->digest);
+}
+
+bssl::UniquePtr<EVP_PKEY> lookup(const Key& key) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    if (!g_enabled || g_index == nullptr) {
+        return nullptr;
+    }
+    auto found = g_index->find(indexKey(key));
+    if (found == g_index->end()) {
+        g_misses.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    g_entries->splice(g_entries->begin(), *g_entries, found->second);
+    g_hits.fetch_add(1, std::memory_order_relaxed);
+    return newReference(found->second->pkey.get());
+}
+
+bssl::UniquePtr<EVP_PKEY> intern(const Key& key, bssl::UniquePtr<EVP_PKEY> pkey) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    if (!g_enabled || g_index == nullptr || pkey == nullptr) {
+        return pkey;
+    }
+    auto found = g_index->find(indexKey(key));
+    if (found != g_index->end()) {
+        g_entries->splice(g_entries->begin(), *g_entries, found->second);
+        return newReference(found->second->pkey.get());
+    }
+    if (g_entries->size() >= g_max_entries) {
+        eraseLocked(std::prev(g_entries->end()));
+    }
+    g_entries->push_front(Entry{key, newReference(pkey.get())});
+    (*g_index)[indexKey(key)] = g_entries->begin();
+    return pkey;
+}
+
+void clear() {
+    std::list<Entry> dropped;
+    std::lock_guard<std::mutex> lock(g_mutex);
+    if (g_entries == nullptr) {
+        return;
+    }
+    dropped.swap(*g_entries);
+    g_index->clear();
+}
+
+void getStats(uint64_t* hits, uint64_t* misses, uint64_t* entries) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    *hits = g_hits.load(std::memory_order_relaxed);
+    *misses = g_misses.load(std::memory_order_relaxed);
+    *entries = g_entries != nullptr ? g_entries->size() : 0;
+}
+
+}  // namespace publickeycache
+}  // namespace conscrypt
@@ -0,0 +1,281 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <conscrypt/scrypt.h>
+#include <conscrypt/worker_pool.h>
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <new>
+
+namespace conscrypt {
+namespace scrypt {
+
+namespace {
+
+// Same bound on r * p as EVP_PBE_scrypt.
+constexpr uint64_t kMaxPR = (UINT64_C(1) << 30) - 1;
+
+inline uint32_t rotl(uint32_t v, int c) {
+    return (v << c) | (v >> (32 - c));
+}
+
+inline uint32_t load32le(const uint8_t* p) {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+           (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+inline void store32le(uint8_t* p, uint32_t v) {
+    p[0] = static_cast<uint8_t>(v);
+    p[1] = static_cast<uint8_t>(v >> 8);
+    p[2] = static_cast<uint8_t>(v >> 16);
+    p[3] = static_cast<uint8_t>(v >> 24);
+}
+
+// Salsa20/8 core, in place on one 64-byte block.
+void salsa208(uint32_t b[16]) {
+    uint32_t x[16];
+    memcpy(x, b, sizeof(x));
+    for (int i = 0; i < 8; i += 2) {
+        x[4] ^= rotl(x[0] + x[12], 7);
+        x[8] ^= rotl(x[4] + x[0], 9);
+        x[12] ^= rotl(x[8] + x[4], 13);
+        x[0] ^= rotl(x[12] + x[8], 18);
+        x[9] ^= rotl(x[5] + x[1], 7);
+        x[13] ^= rotl(x[9] + x[5], 9);
+        x[1] ^= rotl(x[13] + x[9], 13);
+        x[5] ^= rotl(x[1] + x[13], 18);
+        x[14] ^= rotl(x[10] + x[6], 7);
+        x[2] ^= rotl(x[14] + x[10], 9);
+        x[6] ^= rotl(x[2] + x[14], 13);
+        x[10] ^= rotl(x[6] + x[2], 18);
+        x[3] ^= rotl(x[15] + x[11], 7);
+        x[7] ^= rotl(x[3] + x[15], 9);
+        x[11] ^= rotl(x[7] + x[3], 13);
+        x[15] ^= rotl(x[11] + x[7], 18);
+
+        x[1] ^= rotl(x[0] + x[3], 7);
+        x[2] ^= rotl(x[1] + x[0], 9);
+        x[3] ^= rotl(x[2] + x[1], 13);
+        x[0] ^= rotl(x[3] + x[2], 18);
+        x[6] ^= rotl(x[5] + x[4], 7);
+        x[7] ^= rotl(x[6] + x[5], 9);
+        x[4] ^= rotl(x[7] + x[6], 13);
+        x[5] ^= rotl(x[4] + x[7], 18);
+        x[11] ^= rotl(x[10] + x[9], 7);
+        x[8] ^= rotl(x[11] + x[10], 9);
+        x[9] ^= rotl(x[8] + x[11], 13);
+        x[10] ^= rotl(x[9] + x[8], 18);
+        x[12] ^= rotl(x[15] + x[14], 7);
+        x[13] ^= rotl(x[12] + x[15], 9);
+        x[14] ^= rotl(x[13] + x[12], 13);
+        x[15] ^= rotl(x[14] + x[13], 18);
+    }
+    for (int i = 0; i < 16; i++) {
+        b[i] += x[i];
+    }
+}
+
+// scryptBlockMix from RFC 7914 on 2 * r blocks of 16 words, writing the shuffled result to out.
+void blockMix(const uint32_t* in, uint32_t* out, size_t r) {
+    uint32_t x[16];
+    memcpy(x, &in[(2 * r - 1) * 16], sizeof(x));
+    for (size_t i = 0; i < 2 * r; i++) {
+        for (size_t k = 0; k < 16; k++) {
+            x[k] ^= in[i * 16 + k];
+        }
+        salsa208(x);
+        memcpy(&out[((i / 2) + (i & 1) * r) * 16], x, sizeof(x));
+    }
+}
+
+// scryptROMix from RFC 7914 on the 128 * r bytes of lane. v holds N * 32 * r words and xy
+// 64 * r words.
+void roMix(uint8_t* lane, uint64_t N, size_t r, uint32_t* v, uint32_t* xy) {
+    const size_t words = 32 * r;
+    uint32_t* x = xy;
+    uint32_t* y = xy + words;
+    for (size_t k = 0; k < words; k++) {
+        x[k] = load32le(lane + 4 * k);
+    }
+    for (uint64_t i = 0; i < N; i++) {
+        memcpy(&v[i * words], x, words * sizeof(uint32_t));
+        blockMix(x, y, r);
+        std::swap(x, y);
+    }
+    for (uint64_t i = 0; i < N; i++) {
+        // Integerify: the first word of the last block, which is enough as N <= 2^32.
+        uint64_t j = x[(2 * r - 1) * 16] & (N - 1);
+        const uint32_t* vj = &v[j * words];
+        for (size_t k = 0; k < words; k++) {
+            x[k] ^= vj[k];
+        }
+        blockMix(x, y, r);
+        std::swap(x, y);
+    }
+    for (size_t k = 0; k < words; k++) {
+        store32le(lane + 4 * k, x[k]);
+    }
+}
+
+// Bytes held by all Arena instances, bounded by kMaxRetainedBytes.
+std::atomic<size_t> retainedBytes(0);
+
+// Takes bytes from the retained budget, returning false if that would go over it.
+bool reserveRetained(size_t bytes) {
+    size_t current = retainedBytes.load();
+    do {
+        if (bytes > kMaxRetainedBytes - current) {
+            return false;
+        }
+    } while (!retainedBytes.compare_exchange_weak(current, current + bytes));
+    return true;
+}
+
+/**
+ * Scratch area owned by one thread and reused by the scrypt calls it runs, so that repeated
+ * derivations don't go back to the allocator for tens of megabytes each time. Callers cleanse
+ * the words they used before returning, and the area is cleansed again before it is freed.
+ */
+class Arena {
+ public:
+    Arena() : data_(nullptr), words_(0) {}
+    ~Arena() {
+        freeData();
+        retainedBytes -= words_ * sizeof(uint32_t);
+    }
+
+    /**
+     * Returns space for at least words words, which stays valid until the next call, or
+     * nullptr if it can't be allocated. Requests over kMaxArenaBytes, or that would take the
+     * arenas over kMaxRetainedBytes, are served from owned instead and not kept.
+     */
+    uint32_t* get(size_t words, std::unique_ptr<uint32_t[]>* owned) {
+        if (words <= words_) {
+            return data_;
+        }
+        if (words > kMaxArenaBytes / sizeof(uint32_t) ||
+            !reserveRetained((words - words_) * sizeof(uint32_t))) {
+            owned->reset(new (std::nothrow) uint32_t[words]);
+            return owned->get();
+        }
+        // The budget now covers words, whether or not the allocation succeeds.
+        freeData();
+        data_ = static_cast<uint32_t*>(malloc(words * sizeof(uint32_t)));
+        if (data_ == nullptr) {
+            retainedBytes -= words * sizeof(uint32_t);
+            words_ = 0;
+            return nullptr;
+        }
+        words_ = words;
+        return data_;
+    }
+
+ private:
+    void freeData() {
+        if (data_ != nullptr) {
+            OPENSSL_cleanse(data_, words_ * sizeof(uint32_t));
+            free(data_);
+            data_ = nullptr;
+        }
+    }
+
+    uint32_t* data_;
+    size_t words_;
+
+    // Disallow copy and assignment.
+    Arena(const Arena&);
+    void operator=(const Arena&);
+};
+
+thread_local Arena threadArena;
+
+}  // namespace
+
+Result deriveKey(const uint8_t* password, size_t passwordLen, const uint8_t* salt,
+                 size_t saltLen, uint64_t N, uint64_t r, uint64_t p, size_t maxMem,
+                 size_t maxThreads, uint8_t* out, size_t outLen) {
+    // The same checks as EVP_PBE_scrypt, including N <= 2^32 for Integerify and, per RFC 7914,
+    // N < 2^(128 * r / 8).
+    if (r == 0 || p == 0 || p > kMaxPR / r || N < 2 || (N & (N - 1)) != 0 ||
+        N > UINT64_C(1) << 32 || (16 * r <= 63 && N >= UINT64_C(1) << (16 * r))) {
+        return Result::kInvalidParameters;
+    }
+
+    // Memory is counted in 128 * r byte units: p for B and N + 1 for each lane running at once,
+    // so that a single lane needs exactly what EVP_PBE_scrypt asks for.
+    const uint64_t unit = 128 * r;
+    const uint64_t maxUnits = maxMem / unit;
+    if (maxUnits < p || (maxUnits - p) / (N + 1) == 0) {
+        return Result::kMemoryLimitExceeded;
+    }
+    WorkerPool* pool = WorkerPool::get();
+    uint64_t lanesAtOnce = std::min<uint64_t>((maxUnits - p) / (N + 1), p);
+    lanesAtOnce = std::min<uint64_t>(lanesAtOnce, std::max<size_t>(maxThreads, 1));
+    lanesAtOnce = std::min<uint64_t>(lanesAtOnce, pool->parallelism());
+
+    const size_t bLen = static_cast<size_t>(unit * p);
+    std::unique_ptr<uint8_t[]> b(new (std::nothrow) uint8_t[bLen]);
+    if (b.get() == nullptr) {
+        return Result::kAllocationFailed;
+    }
+    const EVP_MD* sha256 = EVP_sha256();
+    if (!PKCS5_PBKDF2_HMAC(reinterpret_cast<const char*>(password), passwordLen, salt, saltLen,
+                           1, sha256, bLen, b.get())) {
+        return Result::kPbkdf2Failed;
+    }
+
+    const size_t tasks = static_cast<size_t>(lanesAtOnce);
+    const size_t vWords = static_cast<size_t>(N) * 32 * static_cast<size_t>(r);
+    const size_t xyWords = 64 * static_cast<size_t>(r);
+    std::atomic<bool> allocationFailed(false);
+    std::function<void(size_t)> runLanes = [&](size_t task) {
+        std::unique_ptr<uint32_t[]> owned;
+        uint32_t* scratch = threadArena.get(vWords + xyWords, &owned);
+        if (scratch == nullptr) {
+            allocationFailed.store(true);
+            return;
+        }
+        for (uint64_t lane = task; lane < p; lane += tasks) {
+            roMix(b.get() + lane * unit, N, static_cast<size_t>(r), scratch, scratch + vWords);
+        }
+        OPENSSL_cleanse(scratch, (vWords + xyWords) * sizeof(uint32_t));
+    };
+    if (tasks > 1) {
+        pool->run(tasks, runLanes);
+    } else {
+        runLanes(0);
+    }
+
+    Result result = Result::kOk;
+    if (allocationFailed.load()) {
+        result = Result::kAllocationFailed;
+    } else if (!PKCS5_PBKDF2_HMAC(reinterpret_cast<const char*>(password), passwordLen, b.get(),
+                                  bLen, 1, sha256, outLen, out)) {
+        result = Result::kPbkdf2Failed;
+    }
+    OPENSSL_cleanse(b.get(), bLen);
+    return result;
+}
+
+}  // namespace scrypt
+}  // namespace conscrypt
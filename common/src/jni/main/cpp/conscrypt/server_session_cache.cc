@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <conscrypt/server_session_cache.h>
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <functional>
+#include <utility>
+
+namespace conscrypt {
+
+void ServerSessionCache::configure(size_t capacity, uint32_t timeoutSeconds) {
+    timeoutSeconds_.store(timeoutSeconds, std::memory_order_relaxed);
+    capacity_.store(capacity, std::memory_order_relaxed);
+
+    size_t limit = shardCapacity();
+    for (Shard& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        while (shard.lru.size() > limit) {
+            shard.index.erase(shard.lru.back().id);
+            shard.lru.pop_back();
+        }
+    }
+}
+
+void ServerSessionCache::insert(SSL_SESSION* session) {
+    unsigned int idLength;
+    const uint8_t* id = SSL_SESSION_get_id(session, &idLength);
+    if (idLength == 0 || !enabled()) {
+        return;
+    }
+
+    uint32_t timeout = timeoutSeconds_.load(std::memory_order_relaxed);
+    if (timeout == 0) {
+        timeout = SSL_SESSION_get_timeout(session);
+    }
+    SSL_SESSION_up_ref(session);
+    Entry entry{std::string(reinterpret_cast<const char*>(id), idLength),
+                bssl::UniquePtr<SSL_SESSION>(session), nowSeconds() + timeout};
+
+    Shard& shard = shardFor(entry.id);
+    size_t limit = shardCapacity();
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto existing = shard.index.find(entry.id);
+    if (existing != shard.index.end()) {
+        shard.lru.erase(existing->second);
+        shard.index.erase(existing);
+    }
+    shard.lru.push_front(std::move(entry));
+    shard.index[shard.lru.front().id] = shard.lru.begin();
+    while (shard.lru.size() > limit) {
+        shard.index.erase(shard.lru.back().id);
+        shard.lru.pop_back();
+    }
+}
+
+bssl::UniquePtr<SSL_SESSION> ServerSessionCache::lookup(const uint8_t* id, size_t idLength) {
+    std::string key(reinterpret_cast<const char*>(id), idLength);
+    Shard& shard = shardFor(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.index.find(key);
+    if (it == shard.index.end()) {
+        return nullptr;
+    }
+    if (it->second->expiresAtSeconds <= nowSeconds()) {
+        shard.lru.erase(it->second);
+        shard.index.erase(it);
+        return nullptr;
+    }
+    // Move to the front of the LRU list; splice keeps the index's iterator valid.
+    shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+    SSL_SESSION* session = shard.lru.front().session.get();
+    SSL_SESSION_up_ref(session);
+    return bssl::UniquePtr<SSL_SESSION>(session);
+}
+
+size_t ServerSessionCache::size() const {
+    size_t total = 0;
+    for (const Shard& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        total += shard.lru.size();
+    }
+    return total;
+}
+
+ServerSessionCache::Shard& ServerSessionCache::shardFor(const std::string& id) {
+    return shards_[std::hash<std::string>()(id) % kShards];
+}
+
+size_t ServerSessionCache::shardCapacity() const {
+    // Round up so that a small capacity still leaves room in every shard.
+    return (capacity_.load(std::memory_order_relaxed) + kShards - 1) / kShards;
+}
+
+uint64_t ServerSessionCache::nowSeconds() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::seconds>(
+                                         std::chrono::steady_clock::now().time_since_epoch())
+                                         .count());
+}
+
+}  // namespace conscrypt
@@ -0,0 +1,180 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <conscrypt/ssl_poller.h>
+
+#include <errno.h>
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif  // __linux__
+
+namespace conscrypt {
+
+#ifdef __linux__
+
+namespace {
+
+// Token reserved for the wakeup eventfd.
+constexpr uint64_t kWakeupToken = ~static_cast<uint64_t>(0);
+
+// Upper bound on the events fetched by a single epoll_wait().
+constexpr int kMaxEventsPerWait = 64;
+
+}  // namespace
+
+bool SslPoller::isSupported() {
+    return true;
+}
+
+SslPoller* SslPoller::create() {
+    int pollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (pollFd == -1) {
+        return nullptr;
+    }
+    int wakeupFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (wakeupFd == -1) {
+        int savedErrno = errno;
+        close(pollFd);
+        errno = savedErrno;
+        return nullptr;
+    }
+    // The wakeup descriptor is level-triggered, so a wakeup() that happens before wait() is
+    // not lost.
+    struct epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.u64 = kWakeupToken;
+    if (epoll_ctl(pollFd, EPOLL_CTL_ADD, wakeupFd, &event) == -1) {
+        int savedErrno = errno;
+        close(wakeupFd);
+        close(pollFd);
+        errno = savedErrno;
+        return nullptr;
+    }
+    return new SslPoller(pollFd, wakeupFd);
+}
+
+SslPoller::~SslPoller() {
+    close(wakeupFd_);
+    close(pollFd_);
+}
+
+bool SslPoller::arm(int fd, uint64_t token, int interest) {
+    struct epoll_event event = {};
+    event.events = EPOLLONESHOT | EPOLLRDHUP;
+    if (interest & kRead) {
+        event.events |= EPOLLIN | EPOLLPRI;
+    }
+    if (interest & kWrite) {
+        event.events |= EPOLLOUT;
+    }
+    event.data.u64 = token;
+    if (epoll_ctl(pollFd_, EPOLL_CTL_MOD, fd, &event) == 0) {
+        return true;
+    }
+    if (errno != ENOENT) {
+        return false;
+    }
+    return epoll_ctl(pollFd_, EPOLL_CTL_ADD, fd, &event) == 0;
+}
+
+bool SslPoller::remove(int fd) {
+    struct epoll_event event = {};
+    return epoll_ctl(pollFd_, EPOLL_CTL_DEL, fd, &event) == 0;
+}
+
+int SslPoller::wait(uint64_t* tokens, int* events, int maxEvents, int timeoutMillis) {
+    struct epoll_event ready[kMaxEventsPerWait];
+    if (maxEvents > kMaxEventsPerWait) {
+        maxEvents = kMaxEventsPerWait;
+    }
+    int count;
+    do {
+        count = epoll_wait(pollFd_, ready, maxEvents, timeoutMillis < 0 ? -1 : timeoutMillis);
+    } while (count == -1 && errno == EINTR);
+    if (count == -1) {
+        return -1;
+    }
+
+    int stored = 0;
+    for (int i = 0; i < count; i++) {
+        if (ready[i].data.u64 == kWakeupToken) {
+            uint64_t value;
+            (void)read(wakeupFd_, &value, sizeof(value));
+            continue;
+        }
+        int readyBits = 0;
+        // Errors and hang-ups are reported as both directions being ready, so that the next
+        // SSL_read or SSL_write call surfaces them.
+        if (ready[i].events & (EPOLLIN | EPOLLPRI | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
+            readyBits |= kRead;
+        }
+        if (ready[i].events & (EPOLLOUT | EPOLLHUP | EPOLLERR)) {
+            readyBits |= kWrite;
+        }
+        tokens[stored] = ready[i].data.u64;
+        events[stored] = readyBits;
+        stored++;
+    }
+    return stored;
+}
+
+void SslPoller::wakeup() {
+    uint64_t one = 1;
+    ssize_t rc;
+    do {
+        rc = write(wakeupFd_, &one, sizeof(one));
+    } while (rc == -1 && errno == EINTR);
+}
+
+#else  // !__linux__
+
+bool SslPoller::isSupported() {
+    return false;
+}
+
+SslPoller* SslPoller::create() {
+    errno = ENOSYS;
+    return nullptr;
+}
+
+SslPoller::~SslPoller() {
+    (void)pollFd_;
+    (void)wakeupFd_;
+}
+
+bool SslPoller::arm(int, uint64_t, int) {
+    errno = ENOSYS;
+    return false;
+}
+
+bool SslPoller::remove(int) {
+    errno = ENOSYS;
+    return false;
+}
+
+int SslPoller::wait(uint64_t*, int*, int, int) {
+    errno = ENOSYS;
+    return -1;
+}
+
+void SslPoller::wakeup() {}
+
+#endif  // __linux__
+
+}  // namespace conscrypt
@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <conscrypt/ticket_keys.h>
+
+#include <openssl/crypto.h>
+#include <openssl/digest.h>
+#include <openssl/rand.h>
+#include <string.h>
+
+namespace conscrypt {
+
+static_assert(TicketKeys::kKeyLength == 48, "ticket key layout changed");
+
+bool TicketKeys::setKeys(const uint8_t* keys, size_t count) {
+    if (count == 0) {
+        return false;
+    }
+    std::shared_ptr<std::vector<Key>> newKeys = std::make_shared<std::vector<Key>>(count);
+    for (size_t i = 0; i < count; i++) {
+        const uint8_t* key = keys + i * kKeyLength;
+        Key& out = (*newKeys)[i];
+        memcpy(out.name, key, sizeof(out.name));
+        memcpy(out.hmacKey, key + sizeof(out.name), sizeof(out.hmacKey));
+        memcpy(out.aesKey, key + sizeof(out.name) + sizeof(out.hmacKey), sizeof(out.aesKey));
+    }
+
+    std::shared_ptr<const std::vector<Key>> oldKeys;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        oldKeys = std::move(keys_);
+        keys_ = std::move(newKeys);
+    }
+    // Handshakes may still hold the old set; wipe it only if this was the last reference.
+    if (oldKeys.use_count() == 1) {
+        OPENSSL_cleanse(const_cast<Key*>(oldKeys->data()), oldKeys->size() * sizeof(Key));
+    }
+    return true;
+}
+
+bool TicketKeys::hasKeys() const {
+    return snapshot() != nullptr;
+}
+
+std::shared_ptr<const std::vector<TicketKeys::Key>> TicketKeys::snapshot() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return keys_;
+}
+
+int TicketKeys::process(uint8_t* keyName, uint8_t* iv, EVP_CIPHER_CTX* cipherCtx,
+                        HMAC_CTX* hmacCtx, int encrypt) const {
+    std::shared_ptr<const std::vector<Key>> keys = snapshot();
+    if (keys == nullptr) {
+        return encrypt ? -1 : 0;
+    }
+
+    const EVP_CIPHER* cipher = EVP_aes_128_cbc();
+    if (encrypt) {
+        const Key& current = keys->front();
+        if (!RAND_bytes(iv, EVP_CIPHER_iv_length(cipher))) {
+            return -1;
+        }
+        memcpy(keyName, current.name, sizeof(current.name));
+        if (!HMAC_Init_ex(hmacCtx, current.hmacKey, sizeof(current.hmacKey), EVP_sha256(),
+                          nullptr) ||
+            !EVP_EncryptInit_ex(cipherCtx, cipher, nullptr, current.aesKey, iv)) {
+            return -1;
+        }
+        return 1;
+    }
+
+    for (size_t i = 0; i < keys->size(); i++) {
+        const Key& key = (*keys)[i];
+        if (CRYPTO_memcmp(keyName, key.name, sizeof(key.name)) != 0) {
+            continue;
+        }
+        if (!HMAC_Init_ex(hmacCtx, key.hmacKey, sizeof(key.hmacKey), EVP_sha256(), nullptr) ||
+            !EVP_DecryptInit_ex(cipherCtx, cipher, nullptr, key.aesKey, iv)) {
+            return -1;
+        }
+        return i == 0 ? 1 : 2;
+    }
+    // Unknown key, e.g. one that has been rotated out: fall back to a full handshake.
+    return 0;
+}
+
+}  // namespace conscrypt
@@ -0,0 +1,253 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <conscrypt/transport_bio.h>
+
+#include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <new>
+
+namespace conscrypt {
+namespace transportbio {
+
+namespace {
+
+// Storage grows in whole pages so that a handshake flight written in several pieces doesn't
+// reallocate for each of them.
+constexpr size_t kAllocationGranule = 4096;
+
+class Ring {
+ public:
+    size_t size() const {
+        return size_;
+    }
+
+    size_t writeGuarantee() const {
+        return kCapacity - size_;
+    }
+
+    // Appends up to len bytes and returns how many were taken.
+    size_t write(const uint8_t* data, size_t len) {
+        len = std::min(len, writeGuarantee());
+        if (len == 0 || !reserve(size_ + len)) {
+            return 0;
+        }
+        size_t tail = (head_ + size_) % allocated_;
+        size_t first = std::min(len, allocated_ - tail);
+        memcpy(storage_.get() + tail, data, first);
+        memcpy(storage_.get(), data + first, len - first);
+        size_ += len;
+        return len;
+    }
+
+    // Removes up to len bytes into out and returns how many were copied.
+    size_t read(uint8_t* out, size_t len) {
+        len = std::min(len, size_);
+        if (len == 0) {
+            return 0;
+        }
+        size_t first = std::min(len, allocated_ - head_);
+        memcpy(out, storage_.get() + head_, first);
+        memcpy(out + first, storage_.get(), len - first);
+        size_ -= len;
+        head_ = (head_ + len) % allocated_;
+        if (size_ == 0) {
+            // Drained: keep a single granule so that the next record doesn't allocate, but give
+            // back anything grown beyond it rather than holding a full buffer per connection.
+            head_ = 0;
+            if (allocated_ > kAllocationGranule) {
+                storage_.reset();
+                allocated_ = 0;
+            }
+        }
+        return len;
+    }
+
+ private:
+    // Ensures there is room for needed bytes, linearising the contents if the storage moves.
+    bool reserve(size_t needed) {
+        if (needed <= allocated_) {
+            return true;
+        }
+        size_t target = std::max(needed, allocated_ * 2);
+        target = (target + kAllocationGranule - 1) / kAllocationGranule * kAllocationGranule;
+        target = std::min(target, kCapacity);
+        std::unique_ptr<uint8_t[]> grown(new (std::nothrow) uint8_t[target]);
+        if (!grown) {
+            return false;
+        }
+        if (size_ > 0) {
+            size_t first = std::min(size_, allocated_ - head_);
+            memcpy(grown.get(), storage_.get() + head_, first);
+            memcpy(grown.get() + first, storage_.get(), size_ - first);
+        }
+        storage_ = std::move(grown);
+        allocated_ = target;
+        head_ = 0;
+        return true;
+    }
+
+    std::unique_ptr<uint8_t[]> storage_;
+    size_t allocated_ = 0;
+    size_t head_ = 0;
+    size_t size_ = 0;
+};
+
+struct Pair;
+
+// One side of a pair. The internal end reads inbound and writes outbound data; the network end
+// does the opposite.
+struct End {
+    Pair* pair;
+    Ring* readRing;
+    Ring* writeRing;
+    // Set once the other end has been freed.
+    std::atomic<bool>* peerClosed;
+};
+
+struct Pair {
+    Ring inbound;
+    Ring outbound;
+    std::atomic<bool> internalClosed{false};
+    std::atomic<bool> networkClosed{false};
+    std::atomic<int> refs{2};
+    End internalEnd{this, &inbound, &outbound, &networkClosed};
+    End networkEnd{this, &outbound, &inbound, &internalClosed};
+};
+
+int transportWrite(BIO* b, const char* buf, int len) {
+    BIO_clear_retry_flags(b);
+    End* end = static_cast<End*>(BIO_get_data(b));
+    if (end == nullptr || buf == nullptr || len < 0 || end->peerClosed->load()) {
+        return -1;
+    }
+    size_t written = end->writeRing->write(reinterpret_cast<const uint8_t*>(buf),
+                                           static_cast<size_t>(len));
+    if (written == 0 && len > 0) {
+        BIO_set_retry_write(b);
+        return -1;
+    }
+    return static_cast<int>(written);
+}
+
+int transportRead(BIO* b, char* buf, int len) {
+    BIO_clear_retry_flags(b);
+    End* end = static_cast<End*>(BIO_get_data(b));
+    if (end == nullptr || buf == nullptr || len < 0) {
+        return 0;
+    }
+    size_t read = end->readRing->read(reinterpret_cast<uint8_t*>(buf), static_cast<size_t>(len));
+    if (read == 0 && len > 0) {
+        if (end->peerClosed->load()) {
+            return 0;
+        }
+        BIO_set_retry_read(b);
+        return -1;
+    }
+    return static_cast<int>(read);
+}
+
+// NOLINTNEXTLINE(runtime/int)
+long transportCtrl(BIO* b, int cmd, long, void*) {
+    End* end = static_cast<End*>(BIO_get_data(b));
+    if (end == nullptr) {
+        return 0;
+    }
+    switch (cmd) {
+        case BIO_CTRL_PENDING:
+            return static_cast<long>(end->readRing->size());  // NOLINT(runtime/int)
+        case BIO_CTRL_WPENDING:
+            return static_cast<long>(end->writeRing->size());  // NOLINT(runtime/int)
+        case BIO_C_GET_WRITE_GUARANTEE:
+            if (end->peerClosed->load()) {
+                return 0;
+            }
+            return static_cast<long>(end->writeRing->writeGuarantee());  // NOLINT(runtime/int)
+        case BIO_CTRL_EOF:
+            return end->readRing->size() == 0 && end->peerClosed->load() ? 1 : 0;
+        case BIO_CTRL_FLUSH:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+int transportDestroy(BIO* b) {
+    if (b == nullptr) {
+        return 0;
+    }
+    End* end = static_cast<End*>(BIO_get_data(b));
+    if (end != nullptr) {
+        Pair* pair = end->pair;
+        if (end == &pair->internalEnd) {
+            pair->internalClosed.store(true);
+        } else {
+            pair->networkClosed.store(true);
+        }
+        if (pair->refs.fetch_sub(1) == 1) {
+            delete pair;
+        }
+    }
+    BIO_set_data(b, nullptr);
+    BIO_set_init(b, 0);
+    return 1;
+}
+
+const BIO_METHOD* transportMethod() {
+    static const BIO_METHOD* method = []() -> const BIO_METHOD* {
+        BIO_METHOD* m = BIO_meth_new(0, "conscrypt transport");
+        if (!m || !BIO_meth_set_write(m, transportWrite) ||
+            !BIO_meth_set_read(m, transportRead) || !BIO_meth_set_ctrl(m, transportCtrl) ||
+            !BIO_meth_set_destroy(m, transportDestroy)) {
+            BIO_meth_free(m);
+            return nullptr;
+        }
+        return m;
+    }();
+    return method;
+}
+
+}  // namespace
+
+bool newPair(BIO** internalBio, BIO** networkBio) {
+    const BIO_METHOD* method = transportMethod();
+    if (method == nullptr) {
+        return false;
+    }
+    BIO* internal = BIO_new(method);
+    BIO* network = BIO_new(method);
+    Pair* pair = new (std::nothrow) Pair();
+    if (internal == nullptr || network == nullptr || pair == nullptr) {
+        BIO_free(internal);
+        BIO_free(network);
+        delete pair;
+        return false;
+    }
+    BIO_set_data(internal, &pair->internalEnd);
+    BIO_set_init(internal, 1);
+    BIO_set_data(network, &pair->networkEnd);
+    BIO_set_init(network, 1);
+    *internalBio = internal;
+    *networkBio = network;
+    return true;
+}
+
+}  // namespace transportbio
+}  // namespace conscrypt
@@ -0,0 +1,178 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <conscrypt/verified_chain_cache.h>
+
+#include <string.h>
+
+#include <atomic>
+#include <chrono>  // NOLINT(build/c++11)
+#include <iterator>
+#include <list>
+#include <mutex>  // NOLINT(build/c++11)
+#include <string>
+#include <unordered_map>
+
+namespace conscrypt {
+namespace verifiedchaincache {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Entry {
+    Key key;
+    Clock::time_point expiry;
+};
+
+// Entries are kept in least-recently-used order, most recent first, with an index from the
+// chain digest to the list position.
+std::mutex g_mutex;
+std::list<Entry>* g_entries;
+std::unordered_map<std::string, std::list<Entry>::iterator>* g_index;
+size_t g_max_entries;
+Clock::duration g_ttl;
+std::atomic<bool> g_enabled;
+std::atomic<uint64_t> g_hits;
+std::atomic<uint64_t> g_misses;
+
+std::string indexKey(const Key& key) {
+    return std::string(reinterpret_cast<const char*>(key.digest), sizeof(key.digest));
+}
+
+void ensureStorageLocked() {
+    if (g_entries == nullptr) {
+        g_entries = new std::list<Entry>();
+        g_index = new std::unordered_map<std::string, std::list<Entry>::iterator>();
+    }
+}
+
+void eraseLocked(std::list<Entry>::iterator it) {
+    g_index->erase(indexKey(it->key));
+    g_entries->erase(it);
+}
+
+void hashLengthPrefixed(SHA256_CTX* ctx, const uint8_t* data, size_t length) {
+    uint8_t prefix[8];
+    for (size_t i = 0; i < sizeof(prefix); i++) {
+        prefix[i] = static_cast<uint8_t>(static_cast<uint64_t>(length) >> (56 - 8 * i));
+    }
+    SHA256_Update(ctx, prefix, sizeof(prefix));
+    SHA256_Update(ctx, data, length);
+}
+
+}  // namespace
+
+void configure(size_t maxEntries, int64_t ttlMillis) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    ensureStorageLocked();
+    if (maxEntries == 0 || ttlMillis <= 0) {
+        g_enabled = false;
+        g_max_entries = 0;
+        g_entries->clear();
+        g_index->clear();
+        return;
+    }
+    g_max_entries = maxEntries;
+    g_ttl = std::chrono::duration_cast<Clock::duration>(std::chrono::milliseconds(ttlMillis));
+    while (g_entries->size() > g_max_entries) {
+        eraseLocked(std::prev(g_entries->end()));
+    }
+    g_enabled = true;
+}
+
+bool isEnabled() {
+    return g_enabled.load(std::memory_order_relaxed);
+}
+
+bool computeKey(const STACK_OF(CRYPTO_BUFFER)* chain, const uint8_t* identity,
+                size_t identityLength, const char* authMethod, Key* key) {
+    size_t numCerts = sk_CRYPTO_BUFFER_num(chain);
+    if (numCerts == 0) {
+        return false;
+    }
+
+    SHA256_CTX ctx;
+    SHA256_Init(&ctx);
+    hashLengthPrefixed(&ctx, identity, identityLength);
+    const char* method = authMethod != nullptr ? authMethod : "";
+    hashLengthPrefixed(&ctx, reinterpret_cast<const uint8_t*>(method), strlen(method));
+    for (size_t i = 0; i < numCerts; i++) {
+        const CRYPTO_BUFFER* cert = sk_CRYPTO_BUFFER_value(chain, i);
+        hashLengthPrefixed(&ctx, CRYPTO_BUFFER_data(cert), CRYPTO_BUFFER_len(cert));
+    }
+    SHA256_Final(key->digest, &ctx);
+    return true;
+}
+
+bool lookup(const Key& key) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    if (!g_enabled || g_index == nullptr) {
+        return false;
+    }
+    auto found = g_index->find(indexKey(key));
+    if (found == g_index->end()) {
+        g_misses.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    std::list<Entry>::iterator it = found->second;
+    if (Clock::now() >= it->expiry) {
+        eraseLocked(it);
+        g_misses.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    g_entries->splice(g_entries->begin(), *g_entries, it);
+    g_hits.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void insert(const Key& key) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    if (!g_enabled || g_index == nullptr) {
+        return;
+    }
+    Clock::time_point expiry = Clock::now() + g_ttl;
+    auto found = g_index->find(indexKey(key));
+    if (found != g_index->end()) {
+        found->second->expiry = expiry;
+        g_entries->splice(g_entries->begin(), *g_entries, found->second);
+        return;
+    }
+    if (g_entries->size() >= g_max_entries) {
+        eraseLocked(std::prev(g_entries->end()));
+    }
+    g_entries->push_front(Entry{key, expiry});
+    (*g_index)[indexKey(key)] = g_entries->begin();
+}
+
+void clear() {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    if (g_entries == nullptr) {
+        return;
+    }
+    g_entries->clear();
+    g_index->clear();
+}
+
+void getStats(uint64_t* hits, uint64_t* misses, uint64_t* entries) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    *hits = g_hits.load(std::memory_order_relaxed);
+    *misses = g_misses.load(std::memory_order_relaxed);
+    *entries = g_entries != nullptr ? g_entries->size() : 0;
+}
+
+}  // namespace verifiedchaincache
+}  // namespace conscrypt
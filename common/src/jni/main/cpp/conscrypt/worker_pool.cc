@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <conscrypt/worker_pool.h>
+
+#include <algorithm>
+
+#ifdef _WIN32
+#include <thread>  // NOLINT(build/c++11)
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+namespace conscrypt {
+
+namespace {
+
+// More threads than this rarely pay off for the short jobs handed to the pool, and each one
+// costs a stack for the life of the process.
+constexpr size_t kMaxWorkers = 3;
+
+size_t onlineCpus() {
+#ifdef _WIN32
+    return std::thread::hardware_concurrency();
+#else
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    return cpus > 0 ? static_cast<size_t>(cpus) : 1;
+#endif
+}
+
+}  // namespace
+
+WorkerPool* WorkerPool::get() {
+    // Never destroyed, as detached workers may still be waiting on it at exit.
+    static WorkerPool* pool = new WorkerPool();
+    return pool;
+}
+
+WorkerPool::WorkerPool() : workers_(0), job_(nullptr), generation_(0) {
+    size_t wanted = std::min(kMaxWorkers, std::max<size_t>(onlineCpus(), 1) - 1);
+    for (size_t i = 0; i < wanted; i++) {
+#ifdef _WIN32
+        std::thread([this] { workerLoop(); }).detach();
+#else
+        pthread_attr_t attr;
+        if (pthread_attr_init(&attr) != 0) {
+            break;
+        }
+        pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+        pthread_t thread;
+        int rc = pthread_create(
+                &thread, &attr,
+                [](void* pool) -> void* {
+                    static_cast<WorkerPool*>(pool)->workerLoop();
+                    return nullptr;
+                },
+                this);
+        pthread_attr_destroy(&attr);
+        if (rc != 0) {
+            break;
+        }
+#endif
+        workers_++;
+    }
+}
+
+void WorkerPool::drain(Job* job) {
+    for (size_t i = job->next.fetch_add(1); i < job->count; i = job->next.fetch_add(1)) {
+        (*job->task)(i);
+    }
+}
+
+void WorkerPool::workerLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    uint64_t seen = generation_;
+    for (;;) {
+        jobPosted_.wait(lock, [&] { return job_ != nullptr && generation_ != seen; });
+        seen = generation_;
+        Job* job = job_;
+        job->active++;
+        lock.unlock();
+        drain(job);
+        lock.lock();
+        if (--job->active == 0) {
+            jobDrained_.notify_all();
+        }
+    }
+}
+
+void WorkerPool::run(size_t count, const std::function<void(size_t)>& task) {
+    std::unique_lock<std::mutex> busy(runMutex_, std::try_to_lock);
+    if (!busy.owns_lock() || workers_ == 0 || count < 2) {
+        for (size_t i = 0; i < count; i++) {
+            task(i);
+        }
+        return;
+    }
+
+    Job job;
+    job.task = &task;
+    job.count = count;
+    job.next.store(0);
+    job.active = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        job_ = &job;
+        generation_++;
+    }
+    jobPosted_.notify_all();
+
+    drain(&job);
+
+    // Workers that wake from here on must not pick up job, which is about to go out of scope.
+    std::unique_lock<std::mutex> lock(mutex_);
+    job_ = nullptr;
+    jobDrained_.wait(lock, [&] { return job.active == 0; });
+}
+
+}  // namespace conscrypt
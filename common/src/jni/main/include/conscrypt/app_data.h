@@ -18,15 +18,19 @@
 #define CONSCRYPT_APP_DATA_H_
 
 #include <conscrypt/NetFd.h>
+#include <conscrypt/certificate_map.h>
 #include <conscrypt/compat.h>
 #include <conscrypt/jniutil.h>
+#include <conscrypt/ktls.h>
 #include <conscrypt/netutil.h>
+#include <conscrypt/ssl_counters.h>
 #include <conscrypt/trace.h>
 
 #include <jni.h>
 #include <atomic>
 #include <memory>
 #include <mutex>  // NOLINT(build/c++11)
+#include <vector>
 
 #ifdef _WIN32
 // Needed for inet_ntop
@@ -38,12 +42,33 @@
 #include <winsock2.h>
 #else  // !_WIN32
 #include <arpa/inet.h>
+#include <errno.h>
 #include <poll.h>
 #include <unistd.h>
+#ifdef __linux__
+#include <sys/eventfd.h>
+#endif  // __linux__
 #endif  // !_WIN32
 
 namespace conscrypt {
 
+/**
+ * A private-key operation that the handshake has handed off so that it can be completed on
+ * another thread. The handshake thread records the input and returns
+ * SSL_ERROR_WANT_PRIVATE_KEY_OPERATION; a worker computes the result with the delegated key
+ * and the next SSL_do_handshake() picks it up. All fields are guarded by mutex.
+ */
+struct DelegatedKeyOperation {
+    enum State { kIdle, kPending, kRunning, kDone, kFailed };
+
+    std::mutex mutex;
+    State state = kIdle;
+    bool isSign = false;
+    uint16_t signatureAlgorithm = 0;
+    std::vector<uint8_t> input;
+    std::vector<uint8_t> output;
+};
+
 /**
  * Our additional application data needed for getting synchronization right.
  * This maybe warrants a bit of lengthy prose:
@@ -74,7 +99,9 @@ namespace conscrypt {
  *
  * The pipe may seem like a bit of overhead, but it fits in nicely with the
  * other file descriptors of the select(), so there's only one condition to wait
- * for.
+ * for. On Linux a single semaphore eventfd takes the place of the pipe. Either
+ * way it is only created the first time a thread actually blocks, so
+ * connections that never wait (such as all engine-based ones) don't pay for it.
  *
  * (4) Finally, a mutex is needed to make sure that at most one thread is in
  * either SSL_read() or SSL_write() at any given time. This is an OpenSSL
@@ -110,7 +137,10 @@ class AppData {
 #ifdef _WIN32
     HANDLE interruptEvent;
 #else
-    int fdsEmergency[2];
+    // Read side of the wakeup descriptor, or -1 until ensureWakeupFd() creates it. It is
+    // published atomically so that SSL_interrupt can signal without holding the mutex.
+    std::atomic<int> wakeupReadFd;
+    int wakeupWriteFd;
 #endif
     std::mutex mutex;
     JNIEnv* env;
@@ -118,6 +148,26 @@ class AppData {
     char* applicationProtocolsData;
     size_t applicationProtocolsLength;
     bool hasApplicationProtocolSelector;
+    // Set when the server's SSLParameters carry SNI matchers, which only Java can evaluate, so
+    // select_certificate_cb must not serve a host name from the certificate map.
+    bool hasSniMatchers;
+    // Opaque description of the trust manager verifying this connection. When non-empty and
+    // the verified chain cache is enabled, cert_verify_callback may skip the Java upcall.
+    std::vector<uint8_t> verifiedChainCacheIdentity;
+    // Performance counters for this connection, see NativeCrypto.SSL_get_counters.
+    SslCounters counters;
+    // Key used for private-key operations that are delegated to another thread, or null
+    // when the key is used synchronously from within the handshake.
+    bssl::UniquePtr<EVP_PKEY> delegatedKey;
+    DelegatedKeyOperation delegatedKeyOperation;
+    // Which directions of a socket connection the kernel encrypts, see
+    // NativeCrypto.SSL_enable_ktls.
+    ktls::State kernelTls;
+    // The credential select_certificate_cb took from the SSL_CTX's certificate map, if any.
+    std::shared_ptr<const ServerCredential> mappedCredential;
+    // Set once the peer rejected our early data, after which the next read or write of a
+    // socket connection resumes the handshake. Guarded by mutex.
+    bool earlyDataRejected;
 
     /**
      * Creates the application data context for the SSL*.
@@ -131,15 +181,6 @@ class AppData {
             return nullptr;
         }
         appData.get()->interruptEvent = interruptEvent;
-#else
-        if (pipe(appData.get()->fdsEmergency) == -1) {
-            CONSCRYPT_LOG_ERROR("AppData::create pipe(2) failed: %s", strerror(errno));
-            return nullptr;
-        }
-        if (!netutil::setBlocking(appData.get()->fdsEmergency[0], false)) {
-            CONSCRYPT_LOG_ERROR("AppData::create fcntl(2) failed: %s", strerror(errno));
-            return nullptr;
-        }
 #endif
         return appData.release();
     }
@@ -151,17 +192,106 @@ class AppData {
             CloseHandle(interruptEvent);
         }
 #else
-        if (fdsEmergency[0] != -1) {
-            close(fdsEmergency[0]);
+        int readFd = wakeupReadFd.load();
+        if (readFd != -1) {
+            close(readFd);
         }
-        if (fdsEmergency[1] != -1) {
-            close(fdsEmergency[1]);
+        if (wakeupWriteFd != -1 && wakeupWriteFd != readFd) {
+            close(wakeupWriteFd);
         }
 #endif
         clearApplicationProtocols();
         clearCallbackState();
     }
 
+    /**
+     * Records that the calling thread is about to wait in sslSelect(). Creates the
+     * wakeup descriptor in the same critical section, so that an sslNotify() issued
+     * before the thread starts polling leaves a token rather than being dropped.
+     * Must be called with mutex held.
+     */
+    void addWaitingThread() {
+        waitingThreads++;
+#ifndef _WIN32
+        ensureWakeupFd();
+#endif
+    }
+
+#ifndef _WIN32
+    /**
+     * Returns the descriptor that sslSelect() polls to be woken up, creating it
+     * on first use. Must be called with mutex held. Returns -1 on failure.
+     */
+    int ensureWakeupFd() {
+        int readFd = wakeupReadFd.load();
+        if (readFd != -1) {
+            return readFd;
+        }
+#ifdef __linux__
+        // A semaphore eventfd keeps the pipe's one-token-per-wakeup semantics.
+        int fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK | EFD_SEMAPHORE);
+        if (fd == -1) {
+            CONSCRYPT_LOG_ERROR("AppData::ensureWakeupFd eventfd(2) failed: %s",
+                                strerror(errno));
+            return -1;
+        }
+        wakeupWriteFd = fd;
+        wakeupReadFd.store(fd);
+        return fd;
+#else
+        int fds[2];
+        if (pipe(fds) == -1) {
+            CONSCRYPT_LOG_ERROR("AppData::ensureWakeupFd pipe(2) failed: %s", strerror(errno));
+            return -1;
+        }
+        if (!netutil::setBlocking(fds[0], false)) {
+            CONSCRYPT_LOG_ERROR("AppData::ensureWakeupFd fcntl(2) failed: %s", strerror(errno));
+            close(fds[0]);
+            close(fds[1]);
+            return -1;
+        }
+        wakeupWriteFd = fds[1];
+        wakeupReadFd.store(fds[0]);
+        return fds[0];
+#endif  // __linux__
+    }
+
+    /**
+     * Wakes up one thread blocked in sslSelect(). Does nothing if no thread has
+     * ever blocked, since there is then nobody to wake.
+     */
+    void signalWakeup() {
+        if (wakeupReadFd.load() == -1) {
+            return;
+        }
+#ifdef __linux__
+        uint64_t token = 1;
+#else
+        char token = '*';
+#endif  // __linux__
+        do {
+            errno = 0;
+            (void)write(wakeupWriteFd, &token, sizeof(token));
+        } while (errno == EINTR);
+    }
+
+    /**
+     * Consumes one wakeup token, if any. The descriptor is non-blocking, see
+     * sslSelect().
+     */
+    void consumeWakeup() {
+#ifdef __linux__
+        uint64_t token;
+#else
+        char token;
+#endif  // __linux__
+        do {
+            errno = 0;
+            (void)read(wakeupReadFd.load(), &token, sizeof(token));
+        } while (errno == EINTR);
+    }
+#endif  // !_WIN32
+
     /**
      * Only called in server mode. Sets the protocols for ALPN negotiation.
      *
@@ -227,12 +357,14 @@ class AppData {
           sslHandshakeCallbacks(nullptr),
           applicationProtocolsData(nullptr),
           applicationProtocolsLength(static_cast<size_t>(-1)),
-          hasApplicationProtocolSelector(false) {
+          hasApplicationProtocolSelector(false),
+          hasSniMatchers(false),
+          earlyDataRejected(false) {
 #ifdef _WIN32
         interruptEvent = nullptr;
 #else
-        fdsEmergency[0] = -1;
-        fdsEmergency[1] = -1;
+        wakeupReadFd = -1;
+        wakeupWriteFd = -1;
 #endif
     }
 
@@ -21,7 +21,6 @@
 #include <openssl/ssl.h>
 
 #include <conscrypt/bio_stream.h>
-#include <nativehelper/scoped_local_ref.h>
 
 namespace conscrypt {
 
@@ -30,15 +29,46 @@ class BioInputStream : public BioStream {
     BioInputStream(jobject stream, bool isFinite) : BioStream(stream), isFinite_(isFinite) {}
 
     int read(char *buf, int len) {
-        return read_internal(buf, len, jniutil::inputStream_readMethod);
+        JNIEnv *env = jniutil::getJNIEnv();
+        if (env == nullptr) {
+            JNI_TRACE("BioInputStream::read could not get JNIEnv");
+            return -1;
+        }
+
+        // OpenSSLBIOInputStream#read fills the whole range unless it hits EOF, so keep going
+        // until a chunk comes back short.
+        int total = 0;
+        while (total < len) {
+            jsize chunk = len - total < kMaxScratchLength ? len - total : kMaxScratchLength;
+            int read = read_internal(env, buf + total, chunk, false);
+            if (read < 0) {
+                return -1;
+            }
+            total += read;
+            if (read < chunk) {
+                break;
+            }
+        }
+        return total;
     }
 
     int gets(char *buf, int len) {
-        if (len > PEM_LINE_LENGTH) {
-            len = PEM_LINE_LENGTH;
+        if (len <= 0) {
+            return 0;
+        }
+        JNIEnv *env = jniutil::getJNIEnv();
+        if (env == nullptr) {
+            JNI_TRACE("BioInputStream::gets could not get JNIEnv");
+            return -1;
         }
 
-        int read = read_internal(buf, len - 1, jniutil::openSslInputStream_readLineMethod);
+        // Lines are consumed exactly up to the newline, so nothing past the PEM block BoringSSL
+        // asked for is taken from the caller's stream.
+        int max = len - 1 < kMaxScratchLength ? len - 1 : kMaxScratchLength;
+        int read = read_internal(env, buf, max, true);
+        if (read < 0) {
+            return -1;
+        }
         buf[read] = '\0';
         JNI_TRACE("BIO::gets \"%s\"", buf);
         return read;
@@ -51,25 +81,27 @@ class BioInputStream : public BioStream {
  private:
     const bool isFinite_;
 
-    int read_internal(char *buf, int len, jmethodID method) {
-        JNIEnv *env = jniutil::getJNIEnv();
-        if (env == nullptr) {
-            JNI_TRACE("BioInputStream::read could not get JNIEnv");
-            return -1;
-        }
-
+    int read_internal(JNIEnv *env, char *buf, jsize len, bool line) {
         if (env->ExceptionCheck()) {
             JNI_TRACE("BioInputStream::read called with pending exception");
             return -1;
         }
 
-        ScopedLocalRef<jbyteArray> javaBytes(env, env->NewByteArray(len));
-        if (javaBytes.get() == nullptr) {
-            JNI_TRACE("BioInputStream::read failed call to NewByteArray");
+        jbyteArray javaBytes = getScratch(env, len);
+        if (javaBytes == nullptr) {
+            JNI_TRACE("BioInputStream::read failed to allocate scratch array");
             return -1;
         }
 
-        jint read = env->CallIntMethod(getStream(), method, javaBytes.get());
+        jint read;
+        if (line) {
+            read = env->CallIntMethod(getStream(),
+                                      jniutil::openSslInputStream_readLineMethod.get(env),
+                                      javaBytes, len);
+        } else {
+            read = env->CallIntMethod(getStream(), jniutil::inputStream_readMethod.get(env),
+                                      javaBytes, 0, len);
+        }
         if (env->ExceptionCheck()) {
             JNI_TRACE("BioInputStream::read failed call to InputStream#read");
             return -1;
@@ -80,15 +112,11 @@ class BioInputStream : public BioStream {
             setEof(true);
             read = 0;
         } else if (read > 0) {
-            env->GetByteArrayRegion(javaBytes.get(), 0, read, reinterpret_cast<jbyte *>(buf));
+            env->GetByteArrayRegion(javaBytes, 0, read, reinterpret_cast<jbyte *>(buf));
         }
 
         return read;
     }
-
- public:
-    /** Length of PEM-encoded line (64) plus CR plus NUL */
-    static const int PEM_LINE_LENGTH = 66;
 };
 
 }  // namespace conscrypt
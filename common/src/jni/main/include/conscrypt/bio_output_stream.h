@@ -39,18 +39,23 @@ class BioOutputStream : public BioStream {
             return -1;
         }
 
-        ScopedLocalRef<jbyteArray> javaBytes(env, env->NewByteArray(len));
-        if (javaBytes.get() == nullptr) {
-            JNI_TRACE("BioOutputStream::write => failed call to NewByteArray");
+        jbyteArray javaBytes = getScratch(env, len);
+        if (javaBytes == nullptr) {
+            JNI_TRACE("BioOutputStream::write => failed to allocate scratch array");
             return -1;
         }
 
-        env->SetByteArrayRegion(javaBytes.get(), 0, len, reinterpret_cast<const jbyte*>(buf));
-
-        env->CallVoidMethod(getStream(), jniutil::outputStream_writeMethod, javaBytes.get());
-        if (env->ExceptionCheck()) {
-            JNI_TRACE("BioOutputStream::write => failed call to OutputStream#write");
-            return -1;
+        for (int written = 0; written < len;) {
+            jsize chunk = len - written < kMaxScratchLength ? len - written : kMaxScratchLength;
+            env->SetByteArrayRegion(javaBytes, 0, chunk,
+                                    reinterpret_cast<const jbyte*>(buf + written));
+            env->CallVoidMethod(getStream(), jniutil::outputStream_writeMethod.get(env),
+                                javaBytes, 0, chunk);
+            if (env->ExceptionCheck()) {
+                JNI_TRACE("BioOutputStream::write => failed call to OutputStream#write");
+                return -1;
+            }
+            written += chunk;
         }
 
         return len;
@@ -29,7 +29,7 @@ namespace conscrypt {
  */
 class BioStream {
  public:
-    explicit BioStream(jobject stream) : mEof(false) {
+    explicit BioStream(jobject stream) : mEof(false), mScratch(nullptr), mScratchLength(0) {
         JNIEnv* env = jniutil::getJNIEnv();
         mStream = env->NewGlobalRef(stream);
     }
@@ -37,6 +37,9 @@ class BioStream {
     ~BioStream() {
         JNIEnv* env = jniutil::getJNIEnv();
 
+        if (mScratch != nullptr) {
+            env->DeleteGlobalRef(mScratch);
+        }
         env->DeleteGlobalRef(mStream);
     }
 
@@ -56,7 +59,7 @@ class BioStream {
             return -1;
         }
 
-        env->CallVoidMethod(mStream, jniutil::outputStream_flushMethod);
+        env->CallVoidMethod(mStream, jniutil::outputStream_flushMethod.get(env));
         if (env->ExceptionCheck()) {
             return -1;
         }
@@ -65,17 +68,62 @@ class BioStream {
     }
 
  protected:
+    /** Upper bound on the scratch array; larger transfers are made in chunks of this size. */
+    static const jsize kMaxScratchLength = 16 * 1024;
+
     jobject getStream() {
         return mStream;
     }
 
+    /**
+     * Returns a Java array of at least min(len, kMaxScratchLength) bytes that is kept for the
+     * life of the stream, so that parsing a PEM bundle line by line doesn't allocate an array per
+     * BIO call. Returns nullptr with an exception pending on failure.
+     */
+    jbyteArray getScratch(JNIEnv* env, jsize len) {
+        if (len > kMaxScratchLength) {
+            len = kMaxScratchLength;
+        }
+        if (mScratch != nullptr && mScratchLength >= len) {
+            return mScratch;
+        }
+        // Grow geometrically from a few PEM lines' worth so a run of slightly larger requests
+        // doesn't reallocate each time.
+        jsize newLength = mScratchLength == 0 ? kMinScratchLength : mScratchLength;
+        while (newLength < len) {
+            newLength *= 2;
+        }
+        if (newLength > kMaxScratchLength) {
+            newLength = kMaxScratchLength;
+        }
+        jbyteArray array = env->NewByteArray(newLength);
+        if (array == nullptr) {
+            return nullptr;
+        }
+        jbyteArray global = static_cast<jbyteArray>(env->NewGlobalRef(array));
+        env->DeleteLocalRef(array);
+        if (global == nullptr) {
+            return nullptr;
+        }
+        if (mScratch != nullptr) {
+            env->DeleteGlobalRef(mScratch);
+        }
+        mScratch = global;
+        mScratchLength = newLength;
+        return mScratch;
+    }
+
     void setEof(bool eof) {
         mEof = eof;
     }
 
  private:
+    static const jsize kMinScratchLength = 256;
+
     jobject mStream;
     bool mEof;
+    jbyteArray mScratch;
+    jsize mScratchLength;
 };
 
 }  // namespace conscrypt
@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CONSCRYPT_BUFFERED_RAND_H_
+#define CONSCRYPT_BUFFERED_RAND_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace conscrypt {
+namespace bufferedrand {
+
+/**
+ * Largest request served from the per-thread block. This covers nonces, IVs and symmetric
+ * keys; anything longer goes straight to RAND_bytes().
+ */
+constexpr size_t kMaxBufferedRequest = 64;
+
+/**
+ * Size of the block of randomness each thread draws from RAND_bytes() at a time.
+ */
+constexpr size_t kBlockBytes = 1024;
+
+/**
+ * Turns buffering on or off for the whole process. It is off by default: the block holds
+ * future key and nonce material in memory, and BoringSSL reseeds after fork() and VM snapshot
+ * restores on its own, while the block is only dropped in the child after fork(). Switching
+ * makes every thread discard its block the next time it asks for bytes.
+ */
+void setEnabled(bool enable);
+
+/**
+ * Fills out with len bytes from BoringSSL's RAND_bytes(), like that function. When buffering
+ * is enabled, see setEnabled(), requests of up to kMaxBufferedRequest bytes are served from a
+ * per-thread block that is refilled in bulk, so that small requests don't each pay for a DRBG
+ * call. Bytes are wiped from the block as they are handed out, and the block is discarded in
+ * the child after fork() so that parent and child never share output. In FIPS mode, see
+ * FIPS_mode(), RAND_bytes() is always called directly.
+ *
+ * Returns false, with the reason on the error queue, if RAND_bytes() failed.
+ */
+bool bytes(uint8_t* out, size_t len);
+
+}  // namespace bufferedrand
+}  // namespace conscrypt
+
+#endif  // CONSCRYPT_BUFFERED_RAND_H_
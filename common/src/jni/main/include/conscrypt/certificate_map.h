@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CONSCRYPT_CERTIFICATE_MAP_H_
+#define CONSCRYPT_CERTIFICATE_MAP_H_
+
+#include <openssl/pool.h>
+#include <openssl/ssl.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace conscrypt {
+
+/**
+ * A server certificate chain and its private key, with the OCSP response and SCT list to
+ * staple, kept in the form BoringSSL takes so that installing it on an SSL copies nothing.
+ * Immutable once built and shared by every map and connection using it.
+ */
+struct ServerCredential {
+    std::vector<bssl::UniquePtr<CRYPTO_BUFFER>> chain;
+    bssl::UniquePtr<EVP_PKEY> privateKey;
+    // Empty when there is nothing to staple.
+    std::vector<uint8_t> ocspResponse;
+    std::vector<uint8_t> signedCertTimestampList;
+
+    /**
+     * Makes this the certificate of the server ssl. Returns false with the error queue set.
+     */
+    bool install(SSL* ssl) const;
+};
+
+/**
+ * Maps the SNI host names of one server SSL_CTX to their credentials, so that
+ * select_certificate_cb can pick and install a certificate without calling into Java. A name
+ * is either exact, or a wildcard "*.example.com" matching any single label in front of
+ * "example.com". Exact names win over wildcards. Names are compared case-insensitively and
+ * ignore a trailing dot.
+ *
+ * replace() swaps the whole table at once, so a handshake sees either the old or the new
+ * table, never a mix. It is safe to call while handshakes are running.
+ */
+class CertificateMap {
+ public:
+    using Entries = std::vector<std::pair<std::string, std::shared_ptr<const ServerCredential>>>;
+
+    /**
+     * Replaces every entry with entries; a later entry for the same name wins. Returns false,
+     * leaving the map unchanged, if a name is empty or has a wildcard other than a whole
+     * leading "*." label.
+     */
+    bool replace(const Entries& entries);
+
+    /**
+     * Returns whether the map has no entries, which callers can check before lookup().
+     */
+    bool empty() const {
+        return size_.load(std::memory_order_relaxed) == 0;
+    }
+
+    /**
+     * Returns the number of names in the map.
+     */
+    size_t size() const {
+        return size_.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Returns the credential for the SNI host name, or null if no entry matches.
+     */
+    std::shared_ptr<const ServerCredential> lookup(const char* hostName) const;
+
+ private:
+    struct Table {
+        std::unordered_map<std::string, std::shared_ptr<const ServerCredential>> exact;
+        // Keyed by the name after the "*.".
+        std::unordered_map<std::string, std::shared_ptr<const ServerCredential>> wildcard;
+    };
+
+    std::shared_ptr<const Table> snapshot() const;
+
+    mutable std::mutex mutex_;
+    std::shared_ptr<const Table> table_;
+    std::atomic<size_t> size_{0};
+};
+
+}  // namespace conscrypt
+
+#endif  // CONSCRYPT_CERTIFICATE_MAP_H_
@@ -0,0 +1,161 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CONSCRYPT_EVENT_TRACE_H_
+#define CONSCRYPT_EVENT_TRACE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <vector>
+
+namespace conscrypt {
+namespace eventtrace {
+
+/**
+ * Runtime tracing of compact binary events into per-thread ring buffers. Unlike the JNI_TRACE
+ * family in trace.h, which formats text and is compiled out of release builds, these events
+ * are always compiled in and cost a single relaxed load while their category is off, so they
+ * can be switched on in a running process to capture an incident.
+ *
+ * Each thread writes only to its own ring, without locks; a dump reads every ring while the
+ * writers carry on, skipping any slot being overwritten at that moment. When a ring is full
+ * the oldest events are overwritten.
+ *
+ * The values of Category and Event must match the constants in NativeTrace.java.
+ */
+enum Category : uint32_t {
+    // SSL creation and destruction, and handshakes.
+    kCategorySsl = 1 << 0,
+    // Application data reads and writes.
+    kCategoryIo = 1 << 1,
+    // TLS records moving through the network BIO, with their leading bytes.
+    kCategoryPackets = 1 << 2,
+    // Calls into Java from BoringSSL callbacks.
+    kCategoryCallbacks = 1 << 3,
+};
+
+constexpr uint32_t kAllCategories =
+        kCategorySsl | kCategoryIo | kCategoryPackets | kCategoryCallbacks;
+
+enum Event : uint16_t {
+    // args: the SSL_CTX.
+    kEventSslNew = 1,
+    kEventSslFree = 2,
+    kEventHandshakeStart = 3,
+    // args: the SSL_do_handshake() result and SSL_get_error().
+    kEventHandshakeDone = 4,
+    // args: bytes requested and the result.
+    kEventRead = 5,
+    kEventWrite = 6,
+    // args: the record length and the direction, 'I' or 'O'. Data: up to kMaxPacketBytes.
+    kEventPacket = 7,
+    // args: which callback, as the SslCounters index of its call count, which is also its
+    // SSL_COUNTER_* constant in NativeCrypto.java.
+    kEventUpcallStart = 8,
+    // args: the same as kEventUpcallStart, then the time spent in nanoseconds.
+    kEventUpcallDone = 9,
+};
+
+/**
+ * Number of leading bytes of each record kept for kEventPacket, enough for the TLS record and
+ * handshake headers.
+ */
+constexpr size_t kMaxPacketBytes = 1024;
+
+/**
+ * Number of 64-byte slots in each thread's ring. An event takes one slot, plus one for each
+ * 56 bytes of packet data.
+ */
+constexpr size_t kSlotsPerThread = 4096;
+
+extern std::atomic<uint32_t> g_enabledCategories;
+
+inline bool isEnabled(uint32_t category) {
+    return (g_enabledCategories.load(std::memory_order_relaxed) & category) != 0;
+}
+
+/**
+ * Sets the categories to record, as a mask of Category values. 0 turns tracing off; events
+ * already recorded are kept until clear().
+ */
+void setEnabledCategories(uint32_t categories);
+
+/**
+ * Records event for ssl on the calling thread's ring.
+ */
+void record(Event event, const void* ssl, uint64_t arg0 = 0, uint64_t arg1 = 0,
+            uint64_t arg2 = 0, uint64_t arg3 = 0);
+
+/**
+ * Records a kEventPacket of len bytes at data for ssl, keeping the first kMaxPacketBytes.
+ */
+void recordPacket(const void* ssl, char direction, const void* data, size_t len);
+
+/**
+ * Drops every event recorded so far.
+ */
+void clear();
+
+/**
+ * Appends every event currently held to out, oldest first, in this little-endian layout:
+ *
+ *   header, 24 bytes:
+ *     char[4]  magic "CTRC"
+ *     uint32   format version, 1
+ *     int64    offset in nanoseconds to add to event timestamps to get Unix time
+ *     uint32   number of events
+ *     uint32   reserved, 0
+ *   then for each event, 56 bytes followed by its data padded to a multiple of 8:
+ *     uint64   monotonic timestamp in nanoseconds
+ *     uint64   SSL address, or 0
+ *     uint32   thread id
+ *     uint16   event id
+ *     uint16   data length
+ *     uint64[4] args
+ */
+void dump(std::vector<uint8_t>* out);
+
+/**
+ * Appends the kEventPacket events currently held to out as a pcap file of IPv4/TCP packets,
+ * one TCP stream per SSL, so that tools such as Wireshark can dissect the captured records.
+ * Records longer than kMaxPacketBytes appear truncated.
+ */
+void dumpPcap(std::vector<uint8_t>* out);
+
+}  // namespace eventtrace
+}  // namespace conscrypt
+
+/**
+ * Records a trace event if category is enabled. The arguments after ssl are up to four
+ * integers.
+ */
+#define CONSCRYPT_TRACE_EVENT(category, event, ssl, ...)                      \
+    do {                                                                      \
+        if (conscrypt::eventtrace::isEnabled(category)) {                     \
+            conscrypt::eventtrace::record(event, ssl, ##__VA_ARGS__);         \
+        }                                                                     \
+    } while (0)
+
+#define CONSCRYPT_TRACE_PACKET(ssl, direction, data, len)                                 \
+    do {                                                                                  \
+        if (conscrypt::eventtrace::isEnabled(conscrypt::eventtrace::kCategoryPackets)) { \
+            conscrypt::eventtrace::recordPacket(ssl, direction, data, len);               \
+        }                                                                                 \
+    } while (0)
+
+#endif  // CONSCRYPT_EVENT_TRACE_H_
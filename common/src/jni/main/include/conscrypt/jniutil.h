@@ -24,55 +24,152 @@
 #include <conscrypt/macros.h>
 #include <nativehelper/scoped_local_ref.h>
 
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+
 namespace conscrypt {
 namespace jniutil {
 
+/**
+ * A global reference to a class that is looked up the first time it is used instead of when
+ * the library is loaded, so that a process which never needs it never pays for loading it.
+ * Safe to use from any thread: threads racing on the first use may each look the class up, and
+ * one of the results is kept. Aborts if the class does not exist.
+ */
+class LazyClass {
+ public:
+    constexpr explicit LazyClass(const char* name) : name_(name), class_(nullptr) {}
+
+    jclass get(JNIEnv* env) {
+        jclass result = class_.load(std::memory_order_acquire);
+        return result != nullptr ? result : resolve(env);
+    }
+
+ private:
+    jclass resolve(JNIEnv* env);
+
+    const char* const name_;
+    std::atomic<jclass> class_;
+};
+
+/**
+ * A method of a LazyClass, looked up on first use like the class itself.
+ */
+class LazyMethod {
+ public:
+    constexpr LazyMethod(LazyClass* clazz, const char* name, const char* signature,
+                         bool isStatic = false)
+        : class_(clazz), name_(name), signature_(signature), isStatic_(isStatic),
+          method_(nullptr) {}
+
+    jmethodID get(JNIEnv* env) {
+        jmethodID result = method_.load(std::memory_order_acquire);
+        return result != nullptr ? result : resolve(env);
+    }
+
+    /**
+     * Returns the class declaring this method, for calling static methods.
+     */
+    jclass getClass(JNIEnv* env) {
+        return class_->get(env);
+    }
+
+ private:
+    jmethodID resolve(JNIEnv* env);
+
+    LazyClass* const class_;
+    const char* const name_;
+    const char* const signature_;
+    const bool isStatic_;
+    std::atomic<jmethodID> method_;
+};
+
 extern JavaVM* gJavaVM;
-extern jclass cryptoUpcallsClass;
-extern jclass openSslInputStreamClass;
+extern LazyClass cryptoUpcallsClass;
+extern LazyClass openSslInputStreamClass;
 extern jclass nativeRefClass;
-extern jclass nativeRefHpkeCtxClass;
+extern LazyClass nativeRefHpkeCtxClass;
 
 extern jclass byteArrayClass;
-extern jclass calendarClass;
+extern LazyClass calendarClass;
 extern jclass objectClass;
 extern jclass objectArrayClass;
-extern jclass integerClass;
-extern jclass inputStreamClass;
-extern jclass outputStreamClass;
+extern LazyClass integerClass;
+extern LazyClass inputStreamClass;
+extern LazyClass outputStreamClass;
 extern jclass stringClass;
 extern jclass byteBufferClass;
 
 extern jfieldID nativeRef_address;
-
-extern jmethodID calendar_setMethod;
-extern jmethodID inputStream_readMethod;
-extern jmethodID integer_valueOfMethod;
-extern jmethodID openSslInputStream_readLineMethod;
-extern jmethodID outputStream_writeMethod;
-extern jmethodID outputStream_flushMethod;
+extern jfieldID buffer_positionField;
+extern jfieldID buffer_limitField;
+
+extern LazyMethod calendar_setMethod;
+extern LazyMethod inputStream_readMethod;
+extern LazyMethod integer_valueOfMethod;
+extern LazyMethod openSslInputStream_readLineMethod;
+extern LazyMethod outputStream_writeMethod;
+extern LazyMethod outputStream_flushMethod;
 extern jmethodID buffer_positionMethod;
 extern jmethodID buffer_limitMethod;
-extern jmethodID buffer_isDirectMethod;
-extern jmethodID cryptoUpcallsClass_rawSignMethod;
-extern jmethodID cryptoUpcallsClass_rsaSignMethod;
-extern jmethodID cryptoUpcallsClass_rsaDecryptMethod;
-extern jmethodID nativeRefHpkeCtxClass_constructor;
-extern jmethodID sslHandshakeCallbacks_verifyCertificateChain;
-extern jmethodID sslHandshakeCallbacks_onSSLStateChange;
-extern jmethodID sslHandshakeCallbacks_clientCertificateRequested;
-extern jmethodID sslHandshakeCallbacks_serverCertificateRequested;
-extern jmethodID sslHandshakeCallbacks_clientPSKKeyRequested;
-extern jmethodID sslHandshakeCallbacks_serverPSKKeyRequested;
-extern jmethodID sslHandshakeCallbacks_onNewSessionEstablished;
-extern jmethodID sslHandshakeCallbacks_selectApplicationProtocol;
-extern jmethodID sslHandshakeCallbacks_serverSessionRequested;
-
-/**
- * Initializes the JNI constants from the environment.
+extern LazyMethod cryptoUpcallsClass_rawSignMethod;
+extern LazyMethod cryptoUpcallsClass_rsaSignMethod;
+extern LazyMethod cryptoUpcallsClass_rsaDecryptMethod;
+extern LazyMethod nativeRefHpkeCtxClass_constructor;
+extern LazyMethod sslHandshakeCallbacks_verifyCertificateChain;
+extern LazyMethod sslHandshakeCallbacks_onSSLStateChange;
+extern LazyMethod sslHandshakeCallbacks_clientCertificateRequested;
+extern LazyMethod sslHandshakeCallbacks_serverCertificateRequested;
+extern LazyMethod sslHandshakeCallbacks_clientPSKKeyRequested;
+extern LazyMethod sslHandshakeCallbacks_serverPSKKeyRequested;
+extern LazyMethod sslHandshakeCallbacks_onNewSessionEstablished;
+extern LazyMethod sslHandshakeCallbacks_selectApplicationProtocol;
+extern LazyMethod sslHandshakeCallbacks_serverSessionRequested;
+
+/**
+ * Initializes the JNI constants from the environment. Only the classes that nearly every
+ * native call needs are resolved here; the rest are LazyClass and LazyMethod.
  */
 void init(JavaVM* vm, JNIEnv* env);
 
+/**
+ * Indices of the start-up measurements filled in by getStartupTimings.
+ */
+enum StartupTiming : size_t {
+    // Nanoseconds spent in init().
+    kStartupInitNanos,
+    // Nanoseconds spent registering the native methods.
+    kStartupRegisterNanos,
+    // Nanoseconds spent in JNI_OnLoad, including the two above.
+    kStartupOnLoadNanos,
+    // Nanoseconds spent in the static initializer of NativeCrypto.
+    kStartupClinitNanos,
+    // Number of LazyClass and LazyMethod lookups so far.
+    kStartupLazyResolutions,
+    // Nanoseconds spent in those lookups.
+    kStartupLazyResolutionNanos,
+    // Nanoseconds from the start of JNI_OnLoad to the call of getStartupTimings.
+    kStartupNanosSinceLoad,
+    kStartupTimingCount,
+};
+
+/**
+ * Returns the current time of the clock start-up is measured with, in nanoseconds.
+ */
+uint64_t startupNanos();
+
+/**
+ * Adds value to the start-up measurement timing.
+ */
+void recordStartupTiming(StartupTiming timing, uint64_t value);
+
+/**
+ * Fills out with the start-up measurements, indexed by StartupTiming.
+ */
+void getStartupTimings(uint64_t out[kStartupTimingCount]);
+
 /**
  * Obtains the current thread's JNIEnv
  */
@@ -126,6 +223,20 @@ inline jfieldID getFieldRef(JNIEnv* env, jclass clazz, const char* name, const c
     return localField;
 }
 
+/**
+ * Like getFieldRef, but returns nullptr rather than aborting if the field does not exist. Used
+ * for implementation fields of platform classes that might not be present on every VM.
+ */
+inline jfieldID getOptionalFieldRef(JNIEnv* env, jclass clazz, const char* name,
+                                    const char* sig) {
+    jfieldID localField = env->GetFieldID(clazz, name, sig);
+    if (localField == nullptr) {
+        env->ExceptionClear();
+        CONSCRYPT_LOG_VERBOSE("could not find optional field %s", name);
+    }
+    return localField;
+}
+
 inline jclass findClass(JNIEnv* env, const char* name) {
     ScopedLocalRef<jclass> localClass(env, env->FindClass(name));
     jclass result = reinterpret_cast<jclass>(env->NewGlobalRef(localClass.get()));
@@ -149,16 +260,65 @@ void jniRegisterNativeMethods(JNIEnv* env, const char* className, const JNINativ
 extern int jniGetFDFromFileDescriptor(JNIEnv* env, jobject fileDescriptor);
 
 /**
- * Returns true if buffer is a non-null direct ByteBuffer instance.
+ * Returns true if buffer is a non-null direct ByteBuffer instance. This does not call into
+ * Java, so the direct-buffer natives only pay for upcalls where the VM hides the position and
+ * limit fields, see getBufferPosition().
  */
 extern bool isDirectByteBufferInstance(JNIEnv* env, jobject buffer);
 
+/**
+ * Returns the position of a java.nio.Buffer. This reads the field directly when the VM exposes
+ * it, avoiding a call back into Java.
+ */
+inline jint getBufferPosition(JNIEnv* env, jobject buffer) {
+    if (buffer_positionField != nullptr) {
+        return env->GetIntField(buffer, buffer_positionField);
+    }
+    return env->CallIntMethod(buffer, buffer_positionMethod);
+}
+
+/**
+ * Returns the limit of a java.nio.Buffer. This reads the field directly when the VM exposes
+ * it, avoiding a call back into Java.
+ */
+inline jint getBufferLimit(JNIEnv* env, jobject buffer) {
+    if (buffer_limitField != nullptr) {
+        return env->GetIntField(buffer, buffer_limitField);
+    }
+    return env->CallIntMethod(buffer, buffer_limitMethod);
+}
+
+/**
+ * Returns the address of the first remaining byte of a direct ByteBuffer and stores the number
+ * of remaining bytes in |length|. Returns nullptr if the buffer's contents are not accessible.
+ * The caller is responsible for checking that |buffer| is a direct ByteBuffer.
+ */
+extern uint8_t* getDirectBufferRemaining(JNIEnv* env, jobject buffer, size_t* length);
+
 /**
  * Returns true if the VM's JNI GetByteArrayElements method is likely to create a copy when
  * invoked on an array of the provided size.
  */
 extern bool isGetByteArrayElementsLikelyToReturnACopy(size_t size);
 
+/**
+ * Upper bound on the number of bytes processed per GetPrimitiveArrayCritical window, which
+ * bounds how long a pinned array can hold up the garbage collector.
+ */
+constexpr size_t kCriticalArrayWindow = 256 * 1024;
+
+/**
+ * Sets the minimum number of bytes for which update calls taking a byte[] work on the array in
+ * place, in GetPrimitiveArrayCritical windows, instead of copying it out first. 0 disables the
+ * pinned path, which is the default.
+ */
+extern void setCriticalArrayThreshold(size_t threshold);
+
+/**
+ * Returns true if an update of |length| bytes from a byte[] should use the pinned path.
+ */
+extern bool useCriticalArrayAccess(size_t length);
+
 /**
  * Throw an exception with the specified class and an optional message.
  *
@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CONSCRYPT_KTLS_H_
+#define CONSCRYPT_KTLS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <openssl/ssl.h>
+
+namespace conscrypt {
+namespace ktls {
+
+/**
+ * Kernel TLS offload of an established connection. Once the handshake is done, the traffic
+ * keys and record sequence numbers are handed to the kernel with setsockopt(SOL_TLS), after
+ * which application data is read and written as plain socket I/O and the kernel does the
+ * record encryption. This also lets sendfile() and splice() send encrypted data without
+ * copying it through user space.
+ *
+ * Only AES-GCM and ChaCha20-Poly1305 with TLS 1.2 or 1.3 are offloaded, and only on Linux;
+ * enable() returns 0 everywhere else. Once a direction is offloaded the SSL no longer sees
+ * the records of that direction: in TLS 1.3 NewSessionTicket messages are dropped, and a
+ * KeyUpdate, renegotiation or any alert other than close_notify ends the connection.
+ */
+enum Direction : int {
+    kTx = 1 << 0,
+    kRx = 1 << 1,
+};
+
+/**
+ * Per-connection state of an offloaded connection. All fields are guarded by the mutex of the
+ * connection's AppData.
+ */
+struct State {
+    // Mask of the offloaded Directions.
+    int directions = 0;
+    // Protocol version of the connection, TLS1_2_VERSION or TLS1_3_VERSION.
+    uint16_t version = 0;
+    // Set once close_notify has been received.
+    bool peerClosed = false;
+    // Progress through post-handshake messages, which may span reads and records.
+    uint8_t handshakeHeader[4] = {};
+    size_t handshakeHeaderBytes = 0;
+    size_t handshakeBodyRemaining = 0;
+    // Progress through an alert record.
+    uint8_t alert[2] = {};
+    size_t alertBytes = 0;
+};
+
+/**
+ * Returns true if this platform can offload TLS to the kernel at all.
+ */
+bool isSupported();
+
+/**
+ * Offloads the established connection ssl on the socket fd and records the result in state.
+ * Send is only offloaded together with receive, and receive only while the SSL holds no
+ * unread records, so that the SSL never writes records of its own past the kernel. Returns the
+ * mask of offloaded Directions, 0 if the kernel, cipher or protocol version does not allow
+ * offload, in which case ssl remains usable as before.
+ */
+int enable(SSL* ssl, int fd, State* state);
+
+/**
+ * Reads up to len bytes of application data from the offloaded socket fd without blocking.
+ * Returns the number of bytes read, 0 at the end of the stream, or -1 with errno set. EPROTO
+ * means the peer sent an alert or a post-handshake message that cannot be handled.
+ */
+int read(int fd, State* state, void* buf, size_t len);
+
+/**
+ * Writes up to len bytes of application data to the offloaded socket fd without blocking.
+ * Returns the number of bytes written or -1 with errno set.
+ */
+int write(int fd, const void* buf, size_t len);
+
+/**
+ * Sends a close_notify alert on the offloaded socket fd. Returns false with errno set.
+ */
+bool sendCloseNotify(int fd);
+
+}  // namespace ktls
+}  // namespace conscrypt
+
+#endif  // CONSCRYPT_KTLS_H_
@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CONSCRYPT_MAPPED_FILE_H_
+#define CONSCRYPT_MAPPED_FILE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace conscrypt {
+
+/**
+ * Read-only view of a whole file with a cursor, used to parse large certificate bundles and
+ * CRLs in place instead of pulling them through a Java InputStream. The file is memory-mapped
+ * where mmap is available, with a sequential access hint so pages already parsed can be
+ * reclaimed; elsewhere it is read into the heap.
+ */
+class MappedFile {
+ public:
+    /**
+     * Maps the file at path. Returns nullptr with errno set on failure.
+     */
+    static MappedFile* open(const char* path);
+
+    /**
+     * Maps the file open on fd, from its start. The caller keeps ownership of fd and may close
+     * it as soon as this returns. Returns nullptr with errno set on failure.
+     */
+    static MappedFile* openFd(int fd);
+
+    ~MappedFile();
+
+    /**
+     * Returns the unread part of the file, which is remaining() bytes long.
+     */
+    const uint8_t* current() const {
+        return data_ + offset_;
+    }
+
+    size_t remaining() const {
+        return size_ - offset_;
+    }
+
+    /**
+     * Moves the cursor forward by n bytes, clamped to the end of the file.
+     */
+    void advance(size_t n) {
+        offset_ = n < remaining() ? offset_ + n : size_;
+    }
+
+ private:
+    MappedFile(const uint8_t* data, size_t size, bool mapped)
+        : data_(data), size_(size), offset_(0), mapped_(mapped) {}
+
+    const uint8_t* data_;
+    size_t size_;
+    size_t offset_;
+    // Whether data_ is a mapping to unmap, as opposed to a heap buffer to free.
+    bool mapped_;
+
+    // Disallow copy and assignment.
+    MappedFile(const MappedFile&);
+    void operator=(const MappedFile&);
+};
+
+}  // namespace conscrypt
+
+#endif  // CONSCRYPT_MAPPED_FILE_H_
@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CONSCRYPT_PUBLIC_KEY_CACHE_H_
+#define CONSCRYPT_PUBLIC_KEY_CACHE_H_
+
+#include <openssl/evp.h>
+#include <openssl/sha.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace conscrypt {
+namespace publickeycache {
+
+/**
+ * Cache key: SHA-256 over the DER encoded SubjectPublicKeyInfo.
+ */
+struct Key {
+    uint8_t digest[SHA256_DIGEST_LENGTH];
+};
+
+/**
+ * Enables the process-wide intern table of parsed public keys, holding at most maxEntries
+ * keys. Passing 0 disables the table and drops all entries; keys already handed out stay
+ * valid, as each holder has its own reference.
+ */
+extern void configure(size_t maxEntries);
+
+/**
+ * Returns true if the table has been enabled with configure().
+ */
+extern bool isEnabled();
+
+/**
+ * Computes the cache key of the spkiLength bytes of DER SubjectPublicKeyInfo at spki.
+ */
+extern void computeKey(const uint8_t* spki, size_t spkiLength, Key* key);
+
+/**
+ * Returns a new reference to the key interned under key, or nullptr if there is none.
+ */
+extern bssl::UniquePtr<EVP_PKEY> lookup(const Key& key);
+
+/**
+ * Interns pkey, which was parsed from the SubjectPublicKeyInfo behind key, and returns it. If
+ * another thread interned the same key first, returns a reference to that one instead, so
+ * that every caller ends up sharing a single EVP_PKEY. When the table is disabled, returns
+ * pkey unchanged.
+ */
+extern bssl::UniquePtr<EVP_PKEY> intern(const Key& key, bssl::UniquePtr<EVP_PKEY> pkey);
+
+/**
+ * Drops all entries.
+ */
+extern void clear();
+
+/**
+ * Copies the hit, miss and entry counts into the given pointers.
+ */
+extern void getStats(uint64_t* hits, uint64_t* misses, uint64_t* entries);
+
+}  // namespace publickeycache
+}  // namespace conscrypt
+
+#endif  // CONSCRYPT_PUBLIC_KEY_CACHE_H_
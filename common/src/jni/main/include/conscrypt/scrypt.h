@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CONSCRYPT_SCRYPT_H_
+#define CONSCRYPT_SCRYPT_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace conscrypt {
+namespace scrypt {
+
+/**
+ * Largest scratch area, in bytes, that a thread keeps between calls. The usual interactive
+ * login parameters, N = 2^15 and r = 8, need 32MiB per lane; anything bigger is allocated for
+ * the call and freed afterwards.
+ */
+constexpr size_t kMaxArenaBytes = 32 * 1024 * 1024 + 4096;
+
+/**
+ * Most bytes that the scratch areas of all threads keep between calls together, enough for two
+ * derivations with the login parameters. Threads that would go over it allocate for the call.
+ */
+constexpr size_t kMaxRetainedBytes = 2 * kMaxArenaBytes;
+
+enum class Result {
+    kOk,
+    // N, r or p are out of range, as for EVP_PBE_scrypt.
+    kInvalidParameters,
+    // Even a single lane at a time would need more than maxMem bytes.
+    kMemoryLimitExceeded,
+    kAllocationFailed,
+    // PBKDF2 failed, with the reason on the calling thread's error queue.
+    kPbkdf2Failed,
+};
+
+/**
+ * Derives outLen bytes into out as RFC 7914 scrypt, giving the same output as EVP_PBE_scrypt.
+ * The p lanes of ROMix are run on up to maxThreads threads from the shared WorkerPool, limited
+ * further so that the lanes running at once fit within maxMem bytes. Each thread reuses its
+ * scratch area between calls, up to kMaxArenaBytes and kMaxRetainedBytes overall. Scratch
+ * space is cleansed after every call, as it holds data derived from the password.
+ */
+Result deriveKey(const uint8_t* password, size_t passwordLen, const uint8_t* salt,
+                 size_t saltLen, uint64_t N, uint64_t r, uint64_t p, size_t maxMem,
+                 size_t maxThreads, uint8_t* out, size_t outLen);
+
+}  // namespace scrypt
+}  // namespace conscrypt
+
+#endif  // CONSCRYPT_SCRYPT_H_
@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CONSCRYPT_SERVER_SESSION_CACHE_H_
+#define CONSCRYPT_SERVER_SESSION_CACHE_H_
+
+#include <openssl/ssl.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <list>
+#include <mutex>  // NOLINT(build/c++11)
+#include <string>
+#include <unordered_map>
+
+namespace conscrypt {
+
+/**
+ * Server-side session cache for one SSL_CTX, looked up and filled directly from BoringSSL's
+ * session callbacks so that session ID resumption never calls into Java. Entries are spread
+ * over kShards independently locked shards by session ID, and each shard evicts its least
+ * recently used entry once it holds its share of the capacity.
+ *
+ * The cache starts disabled; configure() with a non-zero capacity enables it. It is safe to
+ * reconfigure while handshakes are using it.
+ */
+class ServerSessionCache {
+ public:
+    static constexpr size_t kShards = 16;
+
+    /**
+     * Sets the maximum number of sessions kept and how long each stays usable. A timeout of 0
+     * uses each session's own timeout. A capacity of 0 disables the cache and drops its
+     * entries.
+     */
+    void configure(size_t capacity, uint32_t timeoutSeconds);
+
+    bool enabled() const {
+        return capacity_.load(std::memory_order_relaxed) != 0;
+    }
+
+    /**
+     * Adds a reference to session to the cache, replacing any entry with the same ID. Sessions
+     * without an ID, such as those resumed from tickets, are ignored.
+     */
+    void insert(SSL_SESSION* session);
+
+    /**
+     * Returns a new reference to the live session with the given ID, or null.
+     */
+    bssl::UniquePtr<SSL_SESSION> lookup(const uint8_t* id, size_t idLength);
+
+    /**
+     * Returns the number of sessions currently cached, expired ones included.
+     */
+    size_t size() const;
+
+ private:
+    struct Entry {
+        std::string id;
+        bssl::UniquePtr<SSL_SESSION> session;
+        uint64_t expiresAtSeconds;
+    };
+
+    struct Shard {
+        mutable std::mutex mutex;
+        // Most recently used first.
+        std::list<Entry> lru;
+        std::unordered_map<std::string, std::list<Entry>::iterator> index;
+    };
+
+    Shard& shardFor(const std::string& id);
+    size_t shardCapacity() const;
+    static uint64_t nowSeconds();
+
+    std::atomic<size_t> capacity_{0};
+    std::atomic<uint32_t> timeoutSeconds_{0};
+    Shard shards_[kShards];
+};
+
+}  // namespace conscrypt
+
+#endif  // CONSCRYPT_SERVER_SESSION_CACHE_H_
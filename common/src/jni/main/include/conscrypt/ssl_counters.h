@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CONSCRYPT_SSL_COUNTERS_H_
+#define CONSCRYPT_SSL_COUNTERS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <chrono>  // NOLINT(build/c++11)
+
+namespace conscrypt {
+
+/**
+ * Always-on performance counters kept for each SSL, and through SharedSslCounters for each
+ * SSL_CTX. Updates are relaxed atomic adds so that they are cheap enough for the data path; a
+ * snapshot is not a consistent cut across counters, only each individual value is exact.
+ *
+ * The order of Counter must match the SSL_COUNTER_* constants in NativeCrypto.java.
+ */
+class SslCounters {
+ public:
+    enum Counter {
+        kFullHandshakes,
+        kResumedHandshakes,
+        kHandshakeNanos,
+        kRecordsSealed,
+        kBytesSealed,
+        kRecordsOpened,
+        kBytesOpened,
+        kCertVerifyCalls,
+        kCertVerifyNanos,
+        kCertCbCalls,
+        kCertCbNanos,
+        kNewSessionCalls,
+        kNewSessionNanos,
+        kSelectWakeups,
+        kCertificateMapHits,
+        kCount,
+    };
+
+    void add(Counter counter, uint64_t delta) {
+        values_[counter].fetch_add(delta, std::memory_order_relaxed);
+    }
+
+    void snapshot(uint64_t* out) const {
+        for (size_t i = 0; i < static_cast<size_t>(kCount); i++) {
+            out[i] = values_[i].load(std::memory_order_relaxed);
+        }
+    }
+
+    static uint64_t nowNanos() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                             std::chrono::steady_clock::now().time_since_epoch())
+                                             .count());
+    }
+
+ private:
+    std::atomic<uint64_t> values_[kCount] = {};
+};
+
+/**
+ * The counters of an SSL_CTX, which every connection made from it updates from its own thread.
+ * They are spread over kShards cache-line aligned copies of SslCounters and each thread adds
+ * to one of them, so that cores serving different connections don't contend on the same cache
+ * lines. A snapshot sums the copies.
+ */
+class SharedSslCounters {
+ public:
+    static constexpr size_t kShards = 16;
+
+    void add(SslCounters::Counter counter, uint64_t delta) {
+        shards_[shardIndex()].counters.add(counter, delta);
+    }
+
+    void snapshot(uint64_t* out) const {
+        for (size_t i = 0; i < static_cast<size_t>(SslCounters::kCount); i++) {
+            out[i] = 0;
+        }
+        uint64_t values[SslCounters::kCount];
+        for (const Shard& shard : shards_) {
+            shard.counters.snapshot(values);
+            for (size_t i = 0; i < static_cast<size_t>(SslCounters::kCount); i++) {
+                out[i] += values[i];
+            }
+        }
+    }
+
+ private:
+    struct alignas(64) Shard {
+        SslCounters counters;
+    };
+
+    // Threads take shards round robin the first time they count anything.
+    static size_t shardIndex() {
+        static std::atomic<size_t> nextShard(0);
+        thread_local size_t shard = nextShard.fetch_add(1, std::memory_order_relaxed) % kShards;
+        return shard;
+    }
+
+    Shard shards_[kShards];
+};
+
+}  // namespace conscrypt
+
+#endif  // CONSCRYPT_SSL_COUNTERS_H_
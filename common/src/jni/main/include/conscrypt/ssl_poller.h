@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CONSCRYPT_SSL_POLLER_H_
+#define CONSCRYPT_SSL_POLLER_H_
+
+#include <stdint.h>
+
+namespace conscrypt {
+
+/**
+ * Readiness multiplexer shared by many non-blocking SSL connections, so that a small pool of
+ * threads can drive them instead of one thread parked in poll() per connection. Registrations
+ * are one-shot: after a descriptor is reported ready it must be re-armed before it is reported
+ * again, which lets several threads call wait() on the same poller without racing on the same
+ * connection.
+ *
+ * Only available where epoll is, i.e. Linux and Android; create() returns nullptr elsewhere.
+ */
+class SslPoller {
+ public:
+    static constexpr int kRead = 1;
+    static constexpr int kWrite = 2;
+
+    /**
+     * Returns true if this platform supports SslPoller.
+     */
+    static bool isSupported();
+
+    /**
+     * Returns a new poller, or nullptr with errno set on failure.
+     */
+    static SslPoller* create();
+
+    ~SslPoller();
+
+    /**
+     * Registers fd, or re-arms it if it is already registered, so that the next time it becomes
+     * ready for any of the interest bits wait() reports token. Returns false with errno set.
+     */
+    bool arm(int fd, uint64_t token, int interest);
+
+    /**
+     * Stops watching fd. Returns false with errno set.
+     */
+    bool remove(int fd);
+
+    /**
+     * Waits up to timeoutMillis (negative means forever) for registered descriptors to become
+     * ready and stores at most maxEvents of their tokens and ready bits. Returns the number of
+     * entries stored, 0 on timeout or wakeup(), or -1 with errno set.
+     */
+    int wait(uint64_t* tokens, int* events, int maxEvents, int timeoutMillis);
+
+    /**
+     * Makes one pending or future call to wait() return early.
+     */
+    void wakeup();
+
+ private:
+    SslPoller(int pollFd, int wakeupFd) : pollFd_(pollFd), wakeupFd_(wakeupFd) {}
+
+    int pollFd_;
+    int wakeupFd_;
+
+    // Disallow copy and assignment.
+    SslPoller(const SslPoller&);
+    void operator=(const SslPoller&);
+};
+
+}  // namespace conscrypt
+
+#endif  // CONSCRYPT_SSL_POLLER_H_
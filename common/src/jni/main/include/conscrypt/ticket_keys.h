@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CONSCRYPT_TICKET_KEYS_H_
+#define CONSCRYPT_TICKET_KEYS_H_
+
+#include <openssl/cipher.h>
+#include <openssl/hmac.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <vector>
+
+namespace conscrypt {
+
+/**
+ * Session ticket keys shared by every connection of one server SSL_CTX, used through
+ * SSL_CTX_set_tlsext_ticket_key_cb(). The first key encrypts new tickets and every key
+ * decrypts, so a fleet can roll keys by first distributing a new key as a decrypt-only one and
+ * then promoting it. Tickets under an older key are accepted and renewed under the current
+ * one.
+ *
+ * setKeys() swaps the whole set at once, so a handshake sees either the old or the new set,
+ * never a mix. It is safe to call while handshakes are running.
+ */
+class TicketKeys {
+ public:
+    /**
+     * Length of one key: a 16-byte name, a 16-byte HMAC-SHA256 secret and a 16-byte AES-128
+     * key. This is the layout SSL_CTX_set_tlsext_ticket_keys() takes.
+     */
+    static constexpr size_t kKeyLength = 48;
+
+    /**
+     * Replaces the keys with the count keys of kKeyLength bytes each at keys. Returns false,
+     * leaving the keys unchanged, if count is 0.
+     */
+    bool setKeys(const uint8_t* keys, size_t count);
+
+    /**
+     * Returns whether setKeys() has installed any keys.
+     */
+    bool hasKeys() const;
+
+    /**
+     * The SSL_CTX_set_tlsext_ticket_key_cb() callback for these keys. Returns 1 when the
+     * ticket was encrypted, or decrypted with the current key; 2 when it was decrypted with an
+     * older key and should be renewed; 0 when no key matches; and -1 on error.
+     */
+    int process(uint8_t* keyName, uint8_t* iv, EVP_CIPHER_CTX* cipherCtx, HMAC_CTX* hmacCtx,
+                int encrypt) const;
+
+ private:
+    struct Key {
+        uint8_t name[16];
+        uint8_t hmacKey[16];
+        uint8_t aesKey[16];
+    };
+
+    std::shared_ptr<const std::vector<Key>> snapshot() const;
+
+    mutable std::mutex mutex_;
+    std::shared_ptr<const std::vector<Key>> keys_;
+};
+
+}  // namespace conscrypt
+
+#endif  // CONSCRYPT_TICKET_KEYS_H_
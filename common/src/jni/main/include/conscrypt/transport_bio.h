@@ -0,0 +1,52 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CONSCRYPT_TRANSPORT_BIO_H_
+#define CONSCRYPT_TRANSPORT_BIO_H_
+
+#include <openssl/bio.h>
+
+#include <stddef.h>
+
+namespace conscrypt {
+namespace transportbio {
+
+/**
+ * Number of bytes each direction of a transport pair accepts before writes report a retry.
+ * Matches the default size of a BIO_new_bio_pair() buffer so that one maximum-sized TLS record
+ * always fits.
+ */
+constexpr size_t kCapacity = 17 * 1024;
+
+/**
+ * Creates a connected pair of memory BIOs for the engine transport, a drop-in replacement for
+ * BIO_new_bio_pair(). Data written to one end is read from the other. Each direction is a ring
+ * buffer that grows in 4 KiB granules as data is queued. Once the reader drains it, the ring
+ * keeps one granule for the next records and releases anything beyond that, so a connection
+ * holds at most one granule per direction between records, and nothing once the pair is freed.
+ *
+ * Both ends support BIO_ctrl_pending() and BIO_ctrl_get_write_guarantee(). Once one end is
+ * freed, the other end reads EOF after draining what is left and its writes fail. Neither end
+ * is thread-safe, same as a bio pair.
+ *
+ * Returns false if allocation fails.
+ */
+extern bool newPair(BIO** internalBio, BIO** networkBio);
+
+}  // namespace transportbio
+}  // namespace conscrypt
+
+#endif  // CONSCRYPT_TRANSPORT_BIO_H_
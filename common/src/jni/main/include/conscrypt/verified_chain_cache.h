@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CONSCRYPT_VERIFIED_CHAIN_CACHE_H_
+#define CONSCRYPT_VERIFIED_CHAIN_CACHE_H_
+
+#include <openssl/sha.h>
+#include <openssl/ssl.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace conscrypt {
+namespace verifiedchaincache {
+
+/**
+ * Cache key: SHA-256 over the trust identity, the authentication method and the peer chain.
+ */
+struct Key {
+    uint8_t digest[SHA256_DIGEST_LENGTH];
+};
+
+/**
+ * Enables the process-wide cache of peer chains that were accepted by the Java trust manager,
+ * holding at most maxEntries entries for ttlMillis each. Passing 0 for either argument
+ * disables the cache and drops all entries.
+ */
+extern void configure(size_t maxEntries, int64_t ttlMillis);
+
+/**
+ * Returns true if the cache has been enabled with configure().
+ */
+extern bool isEnabled();
+
+/**
+ * Computes the cache key of a peer chain as seen by the trust manager identified by identity.
+ * Returns false if the chain is empty.
+ */
+extern bool computeKey(const STACK_OF(CRYPTO_BUFFER)* chain, const uint8_t* identity,
+                       size_t identityLength, const char* authMethod, Key* key);
+
+/**
+ * Returns true if key is present and has not expired.
+ */
+extern bool lookup(const Key& key);
+
+/**
+ * Records that the chain behind key was accepted by the trust manager.
+ */
+extern void insert(const Key& key);
+
+/**
+ * Drops all entries. Entries for a single trust manager are invalidated by giving it a new
+ * identity instead, after which its old entries are never looked up again and age out.
+ */
+extern void clear();
+
+/**
+ * Copies the hit, miss and entry counts into the given pointers.
+ */
+extern void getStats(uint64_t* hits, uint64_t* misses, uint64_t* entries);
+
+}  // namespace verifiedchaincache
+}  // namespace conscrypt
+
+#endif  // CONSCRYPT_VERIFIED_CHAIN_CACHE_H_
@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CONSCRYPT_WORKER_POOL_H_
+#define CONSCRYPT_WORKER_POOL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <condition_variable>  // NOLINT(build/c++11)
+#include <functional>
+#include <mutex>  // NOLINT(build/c++11)
+
+namespace conscrypt {
+
+/**
+ * Small process-wide pool of native threads for splitting CPU-bound work that doesn't touch the
+ * JVM, such as hashing a large batch of messages. The threads are started on first use and live
+ * for the rest of the process. The calling thread always takes part in the work, so a job still
+ * completes if no workers could be started.
+ */
+class WorkerPool {
+ public:
+    /**
+     * Returns the shared pool, starting its threads on the first call.
+     */
+    static WorkerPool* get();
+
+    /**
+     * Calls task(i) for every i in [0, count) and returns once all calls have finished. Calls
+     * may run concurrently on any of the pool's threads and the calling thread, in no
+     * particular order. If another job is already running the calling thread does the whole job
+     * itself rather than waiting for the pool.
+     */
+    void run(size_t count, const std::function<void(size_t)>& task);
+
+    /**
+     * Returns the number of threads, including the caller, that a job may be spread over.
+     */
+    size_t parallelism() const {
+        return workers_ + 1;
+    }
+
+ private:
+    struct Job {
+        const std::function<void(size_t)>* task;
+        size_t count;
+        std::atomic<size_t> next;
+        // Workers currently inside drain(), guarded by mutex_.
+        size_t active;
+    };
+
+    WorkerPool();
+
+    void workerLoop();
+    static void drain(Job* job);
+
+    size_t workers_;
+    // Held by the caller of run() for the duration of a job.
+    std::mutex runMutex_;
+    std::mutex mutex_;
+    std::condition_variable jobPosted_;
+    std::condition_variable jobDrained_;
+    Job* job_;
+    uint64_t generation_;
+
+    // Disallow copy and assignment.
+    WorkerPool(const WorkerPool&);
+    void operator=(const WorkerPool&);
+};
+
+}  // namespace conscrypt
+
+#endif  // CONSCRYPT_WORKER_POOL_H_
@@ -624,6 +624,40 @@ abstract class AbstractConscryptSocket extends SSLSocket {
      */
     abstract void setUseSessionTickets(boolean useSessionTickets);
 
+    /**
+     * Enables TLS 1.3 early data, see {@link Conscrypt#setEarlyDataEnabled(SSLSocket, boolean)}.
+     */
+    abstract void setEarlyDataEnabled(boolean enabled);
+
+    /**
+     * Returns whether the handshake is paused for early data, see {@link
+     * Conscrypt#isInEarlyData(SSLSocket)}.
+     */
+    abstract boolean isInEarlyData();
+
+    /**
+     * Returns why early data was or wasn't used, see {@link
+     * Conscrypt#getEarlyDataStatus(SSLSocket)}.
+     */
+    abstract String getEarlyDataStatus();
+
+    /**
+     * Enables kernel TLS offload, see {@link Conscrypt#setKernelTlsEnabled(SSLSocket, boolean)}.
+     */
+    abstract void setKernelTlsEnabled(boolean enabled);
+
+    /**
+     * Returns whether the kernel encrypts and decrypts the connection, see {@link
+     * Conscrypt#isKernelTlsActive(SSLSocket)}.
+     */
+    abstract boolean isKernelTlsActive();
+
+    /**
+     * Enables the shared readiness loop, see {@link
+     * Conscrypt#setSharedPollerEnabled(SSLSocket, boolean)}.
+     */
+    abstract void setSharedPollerEnabled(boolean enabled);
+
     /**
      * Enables/disables TLS Channel ID for this server socket.
      *
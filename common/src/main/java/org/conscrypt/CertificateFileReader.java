@@ -0,0 +1,192 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package org.conscrypt;
+
+import java.io.Closeable;
+import java.io.File;
+import java.io.IOException;
+import java.security.cert.CRLException;
+import java.security.cert.CertificateParsingException;
+import java.security.cert.X509CRL;
+import java.security.cert.X509Certificate;
+import java.util.ArrayList;
+import java.util.List;
+import org.conscrypt.OpenSSLX509CertificateFactory.ParsingException;
+
+/**
+ * Reads certificates and CRLs out of a file incrementally, one entry per call. The file is
+ * memory-mapped and parsed natively in place rather than streamed through an
+ * {@link java.io.InputStream}, so large trust stores and CRLs load quickly and only the entries
+ * the caller keeps stay on the heap.
+ *
+ * <p>Certificate files may hold any mix of concatenated DER certificates, PEM
+ * {@code CERTIFICATE} blocks and DER or PEM PKCS#7 bundles; other PEM blocks and text between
+ * them are skipped. CRL files may hold one or more DER or PEM CRLs.
+ *
+ * <p>Instances are safe for use by multiple threads, though entries are handed out in file order
+ * so concurrent readers see disjoint subsets.
+ */
+@ExperimentalApi
+public final class CertificateFileReader implements Closeable {
+    /**
+     * Receives the entries of a CRL from {@link #visitNextCrl}.
+     */
+    public interface RevokedCertificateVisitor {
+        /**
+         * Called for each revoked certificate in file order.
+         *
+         * @param serialNumber the big-endian two's complement serial number, as accepted by
+         *         {@link java.math.BigInteger#BigInteger(byte[])}
+         * @param revocationDateMillis the revocation date in milliseconds since the epoch
+         * @return whether to continue with the next entry
+         */
+        boolean visit(byte[] serialNumber, long revocationDateMillis);
+    }
+
+    private long context;
+
+    private CertificateFileReader(long context) {
+        this.context = context;
+    }
+
+    /**
+     * Opens {@code path} for reading.
+     */
+    public static CertificateFileReader open(String path) throws IOException {
+        if (path == null) {
+            throw new NullPointerException("path == null");
+        }
+        return new CertificateFileReader(NativeCrypto.MAPPED_FILE_open(path));
+    }
+
+    /**
+     * Opens {@code file} for reading.
+     */
+    public static CertificateFileReader open(File file) throws IOException {
+        return open(file.getPath());
+    }
+
+    /**
+     * Opens the regular file that {@code fd} refers to, such as one obtained from
+     * {@code ParcelFileDescriptor.getFd()} on Android. The whole file is read from its start
+     * regardless of the descriptor's position. The caller keeps ownership of {@code fd} and may
+     * close it as soon as this returns.
+     */
+    public static CertificateFileReader openFd(int fd) throws IOException {
+        return new CertificateFileReader(NativeCrypto.MAPPED_FILE_open_fd(fd));
+    }
+
+    /**
+     * Returns the next certificate, or {@code null} once the file is exhausted.
+     */
+    public synchronized X509Certificate nextCertificate() throws CertificateParsingException {
+        long x509;
+        try {
+            x509 = NativeCrypto.MAPPED_FILE_next_X509(checkOpen());
+        } catch (ParsingException e) {
+            throw new CertificateParsingException(e);
+        }
+        if (x509 == 0) {
+            return null;
+        }
+        try {
+            return new OpenSSLX509Certificate(x509);
+        } catch (ParsingException e) {
+            throw new CertificateParsingException(e);
+        }
+    }
+
+    /**
+     * Returns all of the remaining certificates.
+     */
+    public synchronized List<X509Certificate> readAllCertificates()
+            throws CertificateParsingException {
+        List<X509Certificate> certs = new ArrayList<>();
+        X509Certificate cert;
+        while ((cert = nextCertificate()) != null) {
+            certs.add(cert);
+        }
+        return certs;
+    }
+
+    /**
+     * Returns the next CRL, or {@code null} once the file is exhausted.
+     */
+    public synchronized X509CRL nextCrl() throws CRLException {
+        long crl;
+        try {
+            crl = NativeCrypto.MAPPED_FILE_next_X509_CRL(checkOpen());
+        } catch (ParsingException e) {
+            throw new CRLException(e);
+        }
+        if (crl == 0) {
+            return null;
+        }
+        try {
+            return new OpenSSLX509CRL(crl);
+        } catch (ParsingException e) {
+            throw new CRLException(e);
+        }
+    }
+
+    /**
+     * Passes each revoked certificate of the next CRL to {@code visitor} without building a
+     * {@link X509CRL}, which lets callers index very large CRLs in bounded memory. The CRL's
+     * signature is not checked; callers that need it should verify the CRL separately.
+     *
+     * @return the number of entries visited, or -1 once the file is exhausted
+     */
+    public synchronized int visitNextCrl(RevokedCertificateVisitor visitor) throws CRLException {
+        if (visitor == null) {
+            throw new NullPointerException("visitor == null");
+        }
+        try {
+            return NativeCrypto.MAPPED_FILE_visit_X509_CRL_entries(checkOpen(), visitor);
+        } catch (ParsingException e) {
+            throw new CRLException(e);
+        }
+    }
+
+    /**
+     * Unmaps the file. Certificates and CRLs already returned remain usable.
+     */
+    @Override
+    public synchronized void close() {
+        long toFree = context;
+        if (toFree != 0) {
+            context = 0;
+            NativeCrypto.MAPPED_FILE_free(toFree);
+        }
+    }
+
+    private long checkOpen() {
+        if (context == 0) {
+            throw new IllegalStateException("Reader is closed");
+        }
+        return context;
+    }
+
+    @Override
+    @SuppressWarnings("Finalize")
+    protected void finalize() throws Throwable {
+        try {
+            close();
+        } finally {
+            super.finalize();
+        }
+    }
+}
@@ -17,11 +17,17 @@ package org.conscrypt;
 
 import java.io.IOException;
 import java.io.InputStream;
+import java.nio.BufferOverflowException;
 import java.nio.ByteBuffer;
+import java.nio.ReadOnlyBufferException;
 import java.security.KeyManagementException;
+import java.security.NoSuchAlgorithmException;
 import java.security.PrivateKey;
 import java.security.Provider;
 import java.security.cert.X509Certificate;
+import java.util.Collections;
+import java.util.LinkedHashMap;
+import java.util.Map;
 import java.util.Properties;
 import javax.net.ssl.HostnameVerifier;
 import javax.net.ssl.HttpsURLConnection;
@@ -240,6 +246,146 @@ public final class Conscrypt {
         return SSLParametersImpl.getDefaultX509TrustManager();
     }
 
+    /**
+     * Enables a process-wide cache of peer certificate chains that were accepted by a trust
+     * manager, so that repeat peers skip chain verification during the handshake. At most
+     * {@code maxEntries} chains are kept, each for at most {@code ttlMillis} milliseconds.
+     * Passing 0 for either value disables the cache, which is the default.
+     *
+     * <p>Only enable this for trust managers whose decision depends solely on the chain, the
+     * peer host and the endpoint identification algorithm.
+     */
+    @ExperimentalApi
+    public static void setVerifiedChainCacheParameters(int maxEntries, long ttlMillis) {
+        checkAvailability();
+        VerifiedChainCache.setParameters(maxEntries, ttlMillis);
+    }
+
+    /**
+     * Forgets every chain accepted by the given trust manager, for example after its trust
+     * store changed. Passing {@code null} empties the whole cache.
+     */
+    @ExperimentalApi
+    public static void invalidateVerifiedChainCache(X509TrustManager trustManager) {
+        checkAvailability();
+        VerifiedChainCache.invalidate(trustManager);
+    }
+
+    /**
+     * Enables a process-wide table of parsed public keys, so that keys decoded from the same
+     * SubjectPublicKeyInfo, such as the key of a peer certificate seen on every connection,
+     * share a single native key instead of each being parsed and stored again. At most
+     * {@code maxEntries} distinct keys are kept, the least recently used being dropped first.
+     * Passing 0 disables the table, which is the default.
+     */
+    @ExperimentalApi
+    public static void setPublicKeyCacheParameters(int maxEntries) {
+        checkAvailability();
+        NativeCrypto.setPublicKeyCacheParameters(maxEntries);
+    }
+
+    /**
+     * Makes digest, MAC and cipher updates of at least {@code thresholdBytes} bytes from a
+     * {@code byte[]} work on the array in place rather than on a native copy of it. The array is
+     * pinned in windows of a few hundred kilobytes, so garbage collection may be held off for
+     * the time it takes to process one window. Passing 0 disables this, which is the default.
+     *
+     * <p>Pinning mostly helps on VMs whose JNI copies arrays, such as OpenJDK.
+     */
+    @ExperimentalApi
+    public static void setCriticalArrayThreshold(int thresholdBytes) {
+        checkAvailability();
+        NativeCrypto.setCriticalArrayThreshold(thresholdBytes);
+    }
+
+    /**
+     * Makes random requests of up to 64 bytes, such as nonces and IVs, be served from a block of
+     * 1 KiB that each thread draws from BoringSSL's DRBG at a time, instead of each request
+     * calling into the DRBG. Disabled by default and ignored in FIPS mode.
+     *
+     * <p>Only enable this if the process is never cloned other than by {@code fork()}: the block
+     * is discarded in a forked child, but a VM snapshot restored more than once would hand out
+     * the same bytes from each copy, while BoringSSL on its own would reseed. The block also
+     * keeps up to 1 KiB of future key and nonce material in memory.
+     */
+    @ExperimentalApi
+    public static void setRandomBufferingEnabled(boolean enabled) {
+        checkAvailability();
+        NativeCrypto.setRandomBufferingEnabled(enabled);
+    }
+
+    /**
+     * Returns what loading the native library cost, for measuring the start-up time of
+     * short-lived processes. The entries, all times in nanoseconds, are:
+     *
+     * <ul>
+     * <li>{@code initNanos}: resolving the JNI classes and methods that almost every call needs.
+     * Others are looked up the first time they are used.
+     * <li>{@code registerNanos}: registering the native methods.
+     * <li>{@code onLoadNanos}: all of {@code JNI_OnLoad}, including the two above.
+     * <li>{@code clinitNanos}: initializing BoringSSL.
+     * <li>{@code lazyResolutions}: how many classes and methods have been looked up on first
+     * use so far, and {@code lazyResolutionNanos} the time that took.
+     * <li>{@code nanosSinceLoad}: the time from the start of {@code JNI_OnLoad} to this call.
+     * Called right after the first crypto operation, it gives the time to that operation.
+     * </ul>
+     */
+    @ExperimentalApi
+    public static Map<String, Long> getNativeStartupTimings() {
+        checkAvailability();
+        long[] timings = NativeCrypto.get_startup_timings();
+        Map<String, Long> result = new LinkedHashMap<>();
+        result.put("initNanos", timings[NativeCrypto.STARTUP_INIT_NANOS]);
+        result.put("registerNanos", timings[NativeCrypto.STARTUP_REGISTER_NANOS]);
+        result.put("onLoadNanos", timings[NativeCrypto.STARTUP_ON_LOAD_NANOS]);
+        result.put("clinitNanos", timings[NativeCrypto.STARTUP_CLINIT_NANOS]);
+        result.put("lazyResolutions", timings[NativeCrypto.STARTUP_LAZY_RESOLUTIONS]);
+        result.put("lazyResolutionNanos", timings[NativeCrypto.STARTUP_LAZY_RESOLUTION_NANOS]);
+        result.put("nanosSinceLoad", timings[NativeCrypto.STARTUP_NANOS_SINCE_LOAD]);
+        return Collections.unmodifiableMap(result);
+    }
+
+    /**
+     * Hashes many independent messages with one call into native code, which is much cheaper
+     * than a {@link java.security.MessageDigest} per message when the messages are small. Message
+     * {@code i} is the {@code lengths[i]} bytes at {@code input.position() + offsets[i]}, and must
+     * lie before {@code input.limit()}. The digests are written back to back at
+     * {@code output.position()}, which is advanced past them; the input's position is unchanged.
+     * Large batches are hashed on several threads.
+     *
+     * @param algorithm a JCA digest name such as {@code SHA-256}; SHA-1, SHA-224, SHA-256,
+     *         SHA-384 and SHA-512 are supported
+     * @param input a direct buffer holding the messages
+     * @param offsets the offset of each message, relative to the input's position
+     * @param lengths the length of each message, with as many entries as {@code offsets}
+     * @param output a direct buffer with room for {@code offsets.length} digests
+     */
+    @ExperimentalApi
+    public static void digestBatch(String algorithm, ByteBuffer input, int[] offsets,
+            int[] lengths, ByteBuffer output) throws NoSuchAlgorithmException {
+        checkAvailability();
+        if (offsets.length != lengths.length) {
+            throw new IllegalArgumentException("offsets.length != lengths.length");
+        }
+        if (!input.isDirect() || !output.isDirect()) {
+            throw new IllegalArgumentException("Buffers must be direct");
+        }
+        if (output.isReadOnly()) {
+            throw new ReadOnlyBufferException();
+        }
+        long evpMd = EvpMdRef.getEVP_MDByJcaDigestAlgorithmStandardName(algorithm);
+        long written = (long) offsets.length
+                * EvpMdRef.getDigestSizeBytesByJcaDigestAlgorithmStandardName(algorithm);
+        if (written > output.remaining()) {
+            throw new BufferOverflowException();
+        }
+        NativeCrypto.EVP_Digest_batch(evpMd,
+                NativeCrypto.getDirectBufferAddress(input) + input.position(), input.remaining(),
+                offsets, lengths, offsets.length,
+                NativeCrypto.getDirectBufferAddress(output) + output.position(), (int) written);
+        output.position(output.position() + (int) written);
+    }
+
     /**
      * Indicates whether the given {@link SSLContext} was created by this distribution of Conscrypt.
      */
@@ -279,6 +425,101 @@ public final class Conscrypt {
         ((ServerSessionContext) serverContext).setPersistentCache(cache);
     }
 
+    /**
+     * Sets the keys the server side of the context uses to encrypt and decrypt stateless TLS
+     * session tickets, and turns tickets on for its connections. Giving every server behind a
+     * load balancer the same keys lets a client resume on any of them without shared session
+     * state.
+     *
+     * <p>Each key is 48 bytes: a 16-byte key name, a 16-byte HMAC-SHA256 secret and a 16-byte
+     * AES-128 key, the layout also used by other TLS servers' ticket key files. {@code keys[0]}
+     * encrypts new tickets and every key decrypts, so keys can be rotated without breaking
+     * resumption: first add a new key after the current one everywhere, then move it to the
+     * front, and finally drop the old key. Tickets under a key other than {@code keys[0]} are
+     * renewed on resumption. Each call replaces the previous set atomically and may be made
+     * while connections are active.
+     *
+     * <p>The keys should be generated with a strong random number generator and kept secret:
+     * anyone holding them can decrypt the sessions they protect.
+     *
+     * @param context the context whose server side gets the keys
+     * @param keys one or more 48-byte keys, current key first
+     */
+    @ExperimentalApi
+    public static void setServerSessionTicketKeys(SSLContext context, byte[][] keys) {
+        SSLSessionContext serverContext = context.getServerSessionContext();
+        if (!(serverContext instanceof ServerSessionContext)) {
+            throw new IllegalArgumentException(
+                    "Not a conscrypt server context: " + serverContext.getClass().getName());
+        }
+        ((ServerSessionContext) serverContext).setTicketKeys(keys);
+    }
+
+    /**
+     * Sets credentials the server side of the context picks by the client's SNI host name in
+     * native code, before any {@link javax.net.ssl.X509KeyManager} is asked. This saves a call
+     * into Java and the re-encoding of the chain on every handshake of servers hosting many
+     * names.
+     *
+     * <p>A host name is either exact, such as {@code www.example.com}, or a wildcard such as
+     * {@code *.example.com}, which matches any single label in front of {@code example.com}.
+     * Exact names win. Names are matched case-insensitively and ignore a trailing dot. A
+     * handshake with no SNI, or with a name not in the map, falls back to the key manager as
+     * usual. Each call replaces the whole map atomically and may be made while connections are
+     * active; an empty map sends every handshake back to the key manager.
+     *
+     * <p>Handshakes served from the map do not consult the key manager or private key
+     * delegation set with {@link #setDelegatePrivateKeyOperations}, and send the OCSP response
+     * and SCTs of the credential when it has them. Sockets and engines whose {@link
+     * javax.net.ssl.SSLParameters} carry SNI matchers skip the map and always go through the
+     * key manager, so that the matchers can reject the requested name first.
+     *
+     * @param context the context whose server side gets the credentials
+     * @param credentials the credential to use for each host name
+     * @throws IllegalArgumentException if a host name is empty or has a misplaced {@code *}
+     */
+    @ExperimentalApi
+    public static void setServerCredentials(
+            SSLContext context, Map<String, ServerCredential> credentials) {
+        SSLSessionContext serverContext = context.getServerSessionContext();
+        if (!(serverContext instanceof ServerSessionContext)) {
+            throw new IllegalArgumentException(
+                    "Not a conscrypt server context: " + serverContext.getClass().getName());
+        }
+        ((ServerSessionContext) serverContext).setServerCredentials(credentials);
+    }
+
+    /**
+     * Moves the server-side session cache of the context into native code. Sessions created by
+     * full handshakes are stored, and session ID resumptions are looked up, without calling
+     * back into Java, in a cache split into independently locked shards that each evict their
+     * least recently used entries. This removes per-handshake upcalls and lock contention on
+     * busy servers.
+     *
+     * <p>While the native cache is enabled, new server sessions are not added to the context's
+     * {@link SSLSessionContext}, so {@link SSLSessionContext#getIds()} does not list them and a
+     * cache set with {@link #setServerSessionCache} is not filled. Session tickets, if enabled,
+     * are unaffected. This should be called before the context starts accepting connections;
+     * capacity and timeout may be changed later.
+     *
+     * @param context the context whose server side is configured
+     * @param maxEntries the maximum number of cached sessions, or 0 to turn the native cache
+     *     off again
+     * @param timeoutSeconds how long a cached session may be resumed, or 0 to use the session
+     *     timeout of the context
+     */
+    @ExperimentalApi
+    public static void setServerSessionCacheParameters(
+            SSLContext context, int maxEntries, int timeoutSeconds) {
+        SSLSessionContext serverContext = context.getServerSessionContext();
+        if (!(serverContext instanceof ServerSessionContext)) {
+            throw new IllegalArgumentException(
+                    "Not a conscrypt server context: " + serverContext.getClass().getName());
+        }
+        ((ServerSessionContext) serverContext)
+                .setNativeSessionCacheParameters(maxEntries, timeoutSeconds);
+    }
+
     /**
      * Indicates whether the given {@link SSLSocketFactory} was created by this distribution of
      * Conscrypt.
@@ -390,6 +631,98 @@ public final class Conscrypt {
         toConscrypt(socket).setUseSessionTickets(useSessionTickets);
     }
 
+    /**
+     * Enables TLS 1.3 early data (0-RTT) for the socket. See {@link
+     * #setEarlyDataEnabled(SSLEngine, boolean)} for how it behaves. A file-descriptor-based
+     * client socket returns from {@link SSLSocket#startHandshake()} as soon as early data can be
+     * written, much like with False Start. If the server then rejects it, the early data is lost
+     * and the read or write that learns of this throws {@link EarlyDataRejectedException}
+     * without transferring anything; the caller should write the data again, and the next read
+     * or write completes the handshake. Engine-based sockets finish the handshake before
+     * returning, so they accept early data as servers but don't send it as clients. Must be
+     * called before the handshake starts.
+     *
+     * @param socket the socket
+     * @param enabled whether to use early data
+     */
+    @ExperimentalApi
+    public static void setEarlyDataEnabled(SSLSocket socket, boolean enabled) {
+        toConscrypt(socket).setEarlyDataEnabled(enabled);
+    }
+
+    /**
+     * Returns whether the handshake of the socket is paused for early data. Data a server reads
+     * while this is {@code true} arrived as early data and may have been replayed by an
+     * attacker.
+     */
+    @ExperimentalApi
+    public static boolean isInEarlyData(SSLSocket socket) {
+        return toConscrypt(socket).isInEarlyData();
+    }
+
+    /**
+     * Returns why early data was or wasn't used on the connection, e.g. {@code "accepted"},
+     * {@code "disabled"}, {@code "no_session_offered"} or {@code "peer_declined"}, or {@code
+     * null} if this isn't known yet or the connection is closed.
+     */
+    @ExperimentalApi
+    public static String getEarlyDataStatus(SSLSocket socket) {
+        return toConscrypt(socket).getEarlyDataStatus();
+    }
+
+    /**
+     * Enables Linux kernel TLS offload for the socket. Once the handshake completes, the
+     * traffic keys are handed to the kernel, which then encrypts and decrypts the records, so
+     * application data moves through plain socket reads and writes. Data sent through the
+     * underlying socket's channel, for example with {@link
+     * java.nio.channels.FileChannel#transferTo}, is then encrypted too, without being copied
+     * into the process; such writes must not interleave with writes to the socket's output
+     * stream.
+     *
+     * <p>Only AES-GCM and ChaCha20-Poly1305 connections using TLS 1.2 or 1.3 are offloaded, and
+     * the socket silently stays in user space when the platform, the kernel or the connection
+     * doesn't allow it, or when False Start or early data let the handshake return early. With
+     * TLS 1.3, session tickets received after the handshake are discarded, and a key update
+     * from the peer ends the connection. Has no effect on engine-based sockets. Must be called
+     * before the handshake starts.
+     *
+     * @param socket the socket
+     * @param enabled whether to offload TLS to the kernel
+     */
+    @ExperimentalApi
+    public static void setKernelTlsEnabled(SSLSocket socket, boolean enabled) {
+        toConscrypt(socket).setKernelTlsEnabled(enabled);
+    }
+
+    /**
+     * Returns whether the kernel both encrypts and decrypts the records of the socket's
+     * connection, see {@link #setKernelTlsEnabled(SSLSocket, boolean)}.
+     */
+    @ExperimentalApi
+    public static boolean isKernelTlsActive(SSLSocket socket) {
+        return toConscrypt(socket).isKernelTlsActive();
+    }
+
+    /**
+     * Makes the socket wait for its underlying socket through a readiness loop shared by all
+     * sockets that enable it, instead of in a {@code poll()} call of its own. The handshake,
+     * reads and writes then run without blocking, and a thread that has to wait for the network
+     * parks until one of a few shared poller threads sees the socket become ready. This avoids
+     * a wakeup descriptor and a poll system call per waiting socket, which matters with many
+     * thousands of mostly idle connections.
+     *
+     * <p>Requires epoll, i.e. Linux or Android; elsewhere the handshake throws {@link
+     * UnsupportedOperationException}. Has no effect on engine-based sockets. Must be called
+     * before the handshake starts.
+     *
+     * @param socket the socket
+     * @param enabled whether to use the shared poller
+     */
+    @ExperimentalApi
+    public static void setSharedPollerEnabled(SSLSocket socket, boolean enabled) {
+        toConscrypt(socket).setSharedPollerEnabled(enabled);
+    }
+
     /**
      * Enables/disables TLS Channel ID for the given server-side socket.
      *
@@ -680,6 +1013,67 @@ public final class Conscrypt {
         toConscrypt(engine).setUseSessionTickets(useSessionTickets);
     }
 
+    /**
+     * Makes the engine hand each private-key operation of the handshake out as a delegated task
+     * instead of performing it inside {@code wrap} or {@code unwrap}. This lets a key that is
+     * slow to use, such as one held by a remote signing service, be driven from another thread:
+     * when the handshake needs the key the engine reports {@link
+     * javax.net.ssl.SSLEngineResult.HandshakeStatus#NEED_TASK}, {@link
+     * SSLEngine#getDelegatedTask()} returns the operation, and the handshake continues once it
+     * has run. Must be called before the handshake starts.
+     *
+     * @param engine the engine
+     * @param enabled whether to delegate private-key operations
+     */
+    @ExperimentalApi
+    public static void setDelegatePrivateKeyOperations(SSLEngine engine, boolean enabled) {
+        toConscrypt(engine).setDelegatePrivateKeyOperations(enabled);
+    }
+
+    /**
+     * Enables TLS 1.3 early data (0-RTT) for the engine, which saves a round trip when resuming
+     * a session. A client resuming a session whose server allowed early data sends whatever it
+     * wraps before the server's reply arrives as early data: {@code wrap} consumes application
+     * data while the handshake status is still {@code NEED_UNWRAP}. A server accepts early data
+     * on sessions it issued with early data enabled and hands it out from {@code unwrap} before
+     * its handshake finishes. Sessions are resumed through the engine's session context as
+     * usual.
+     *
+     * <p>Early data can be replayed by an attacker, so a server should only act on it if doing
+     * so more than once is harmless; see {@link #isInEarlyData(SSLEngine)}. A server may also
+     * reject it, in which case everything written as early data is discarded and the handshake
+     * continues normally; a {@link HandshakeListener} learns of this through {@link
+     * HandshakeListener#onEarlyDataResolved(boolean)} and should write the data again. Must be
+     * called before the handshake starts.
+     *
+     * @param engine the engine
+     * @param enabled whether to use early data
+     */
+    @ExperimentalApi
+    public static void setEarlyDataEnabled(SSLEngine engine, boolean enabled) {
+        toConscrypt(engine).setEarlyDataEnabled(enabled);
+    }
+
+    /**
+     * Returns whether the handshake of the engine is paused for early data. Data a server
+     * unwraps while this is {@code true} arrived as early data and may have been replayed by an
+     * attacker.
+     */
+    @ExperimentalApi
+    public static boolean isInEarlyData(SSLEngine engine) {
+        return toConscrypt(engine).isInEarlyData();
+    }
+
+    /**
+     * Returns why early data was or wasn't used on the connection, e.g. {@code "accepted"},
+     * {@code "disabled"}, {@code "no_session_offered"} or {@code "peer_declined"}, or {@code
+     * null} if this isn't known yet or the engine is closed.
+     */
+    @ExperimentalApi
+    public static String getEarlyDataStatus(SSLEngine engine) {
+        return toConscrypt(engine).getEarlyDataStatus();
+    }
+
     /**
      * Sets the application-layer protocols (ALPN) in prioritization order.
      *
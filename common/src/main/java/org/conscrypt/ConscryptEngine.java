@@ -35,6 +35,7 @@ package org.conscrypt;
 import static java.lang.Math.max;
 import static java.lang.Math.min;
 import static javax.net.ssl.SSLEngineResult.HandshakeStatus.FINISHED;
+import static javax.net.ssl.SSLEngineResult.HandshakeStatus.NEED_TASK;
 import static javax.net.ssl.SSLEngineResult.HandshakeStatus.NEED_UNWRAP;
 import static javax.net.ssl.SSLEngineResult.HandshakeStatus.NEED_WRAP;
 import static javax.net.ssl.SSLEngineResult.HandshakeStatus.NOT_HANDSHAKING;
@@ -47,6 +48,8 @@ import static org.conscrypt.NativeConstants.SSL3_RT_MAX_PACKET_SIZE;
 import static org.conscrypt.NativeConstants.SSL3_RT_MAX_PLAIN_LENGTH;
 import static org.conscrypt.NativeConstants.SSL_CB_HANDSHAKE_DONE;
 import static org.conscrypt.NativeConstants.SSL_CB_HANDSHAKE_START;
+import static org.conscrypt.NativeConstants.SSL_ERROR_EARLY_DATA_REJECTED;
+import static org.conscrypt.NativeConstants.SSL_ERROR_WANT_PRIVATE_KEY_OPERATION;
 import static org.conscrypt.NativeConstants.SSL_ERROR_WANT_READ;
 import static org.conscrypt.NativeConstants.SSL_ERROR_WANT_WRITE;
 import static org.conscrypt.NativeConstants.SSL_ERROR_ZERO_RETURN;
@@ -108,6 +111,7 @@ final class ConscryptEngine extends AbstractConscryptEngine implements NativeCry
     private static final SSLEngineResult NEED_WRAP_OK = new SSLEngineResult(OK, NEED_WRAP, 0, 0);
     private static final SSLEngineResult NEED_WRAP_CLOSED =
             new SSLEngineResult(CLOSED, NEED_WRAP, 0, 0);
+    private static final SSLEngineResult NEED_TASK_OK = new SSLEngineResult(OK, NEED_TASK, 0, 0);
     private static final SSLEngineResult CLOSED_NOT_HANDSHAKING =
             new SSLEngineResult(CLOSED, NOT_HANDSHAKING, 0, 0);
 
@@ -174,8 +178,27 @@ final class ConscryptEngine extends AbstractConscryptEngine implements NativeCry
 
     private HandshakeListener handshakeListener;
 
+    /**
+     * Whether the delegated private-key operation handed out by {@link #getDelegatedTask()} is
+     * still running, and the failure it ended with, if any.
+     */
+    // @GuardedBy("ssl");
+    private boolean keyOperationTaskRunning;
+    // @GuardedBy("ssl");
+    private SSLException keyOperationFailure;
+
+    /**
+     * Whether the handshake has paused to let TLS 1.3 early data through. Application data is
+     * then wrapped and unwrapped although the handshake hasn't finished.
+     */
+    // @GuardedBy("ssl");
+    private boolean inEarlyData;
+
     private final ByteBuffer[] singleSrcBuffer = new ByteBuffer[1];
     private final ByteBuffer[] singleDstBuffer = new ByteBuffer[1];
+    // Addresses and lengths of the direct buffers handed to the gathering write natives.
+    private long[] gatherAddresses = new long[4];
+    private int[] gatherLengths = new int[4];
     private final PeerInfoProvider peerInfoProvider;
 
     ConscryptEngine(SSLParametersImpl sslParameters) {
@@ -493,8 +516,46 @@ final class ConscryptEngine extends AbstractConscryptEngine implements NativeCry
 
     @Override
     public Runnable getDelegatedTask() {
-        // This implementation doesn't use any delegated tasks.
-        return null;
+        synchronized (ssl) {
+            // The only delegated tasks are private-key operations, see
+            // setDelegatePrivateKeyOperations.
+            if (keyOperationTaskRunning || !isKeyOperationPending()) {
+                return null;
+            }
+            keyOperationTaskRunning = true;
+        }
+        return new Runnable() {
+            @Override
+            public void run() {
+                SSLException failure = null;
+                try {
+                    // Deliberately not synchronized on ssl: the key may take a long time, and
+                    // the engine has nothing to do for this connection until it is done.
+                    ssl.doDelegatedKeyOperation();
+                } catch (SSLException e) {
+                    failure = e;
+                } catch (RuntimeException e) {
+                    failure = new SSLException(e);
+                } finally {
+                    synchronized (ssl) {
+                        keyOperationTaskRunning = false;
+                        keyOperationFailure = failure;
+                    }
+                }
+            }
+        };
+    }
+
+    /**
+     * Returns whether the handshake is waiting for a delegated private-key operation.
+     */
+    // @GuardedBy("ssl");
+    private boolean isKeyOperationPending() {
+        if (!sslParameters.delegatePrivateKeyOperations || handshakeFinished
+                || state != STATE_HANDSHAKE_STARTED) {
+            return false;
+        }
+        return keyOperationTaskRunning || ssl.isDelegatedKeyOperationPending();
     }
 
     @Override
@@ -538,6 +599,9 @@ final class ConscryptEngine extends AbstractConscryptEngine implements NativeCry
         }
         switch (state) {
             case STATE_HANDSHAKE_STARTED:
+                if (isKeyOperationPending()) {
+                    return NEED_TASK;
+                }
                 return pendingStatus(pendingOutboundEncryptedBytes());
             case STATE_HANDSHAKE_COMPLETED:
                 return HandshakeStatus.NEED_WRAP;
@@ -783,6 +847,9 @@ final class ConscryptEngine extends AbstractConscryptEngine implements NativeCry
                 if (handshakeStatus == NEED_WRAP) {
                     return NEED_WRAP_OK;
                 }
+                if (handshakeStatus == NEED_TASK) {
+                    return NEED_TASK_OK;
+                }
                 if (state == STATE_CLOSED) {
                     return NEED_WRAP_CLOSED;
                 }
@@ -818,7 +885,21 @@ final class ConscryptEngine extends AbstractConscryptEngine implements NativeCry
 
             // Write all of the encrypted source data to the networkBio
             int bytesConsumed = 0;
-            if (lenRemaining > 0 && srcsOffset < srcsEndOffset) {
+            int segments = lenRemaining > 0
+                    ? gatherDirectSegments(srcs, srcsOffset, srcsEndOffset, lenRemaining)
+                    : 0;
+            if (segments > 1) {
+                // The packet is spread over several direct buffers, so write all of them to the
+                // networkBio in one call rather than one BIO_write per buffer.
+                int written = writeEncryptedDataGathered(segments);
+                if (written > 0) {
+                    BufferUtils.consume(srcs, srcsOffset, srcsEndOffset, written);
+                    bytesConsumed = written;
+                    lenRemaining -= written;
+                } else {
+                    NativeCrypto.SSL_clear_error();
+                }
+            } else if (lenRemaining > 0 && srcsOffset < srcsEndOffset) {
                 do {
                     ByteBuffer src = srcs[srcsOffset];
                     int remaining = src.remaining();
@@ -883,6 +964,10 @@ final class ConscryptEngine extends AbstractConscryptEngine implements NativeCry
                                 case -SSL_ERROR_WANT_WRITE: {
                                     return newResult(bytesConsumed, bytesProduced, handshakeStatus);
                                 }
+                                case -SSL_ERROR_EARLY_DATA_REJECTED: {
+                                    onEarlyDataRejected();
+                                    return newResult(bytesConsumed, bytesProduced, handshakeStatus);
+                                }
                                 case -SSL_ERROR_ZERO_RETURN: {
                                     // We received a close_notify from the peer, so mark the
                                     // inbound direction as closed and shut down the SSL object
@@ -972,6 +1057,13 @@ final class ConscryptEngine extends AbstractConscryptEngine implements NativeCry
                     case SSL_ERROR_WANT_WRITE: {
                         return NEED_WRAP;
                     }
+                    case SSL_ERROR_WANT_PRIVATE_KEY_OPERATION: {
+                        return NEED_TASK;
+                    }
+                    case SSL_ERROR_EARLY_DATA_REJECTED: {
+                        onEarlyDataRejected();
+                        return handshake();
+                    }
                     default: {
                         // SSL_ERROR_NONE.
                     }
@@ -980,8 +1072,17 @@ final class ConscryptEngine extends AbstractConscryptEngine implements NativeCry
                 // Shut down the SSL and rethrow the exception.  Users will need to drain any alerts
                 // from the SSL before closing.
                 closeAll();
-                throw e;
+                // A failed delegated key operation explains the failure better than BoringSSL.
+                throw keyOperationFailure != null ? keyOperationFailure : e;
+            }
+
+            if (sslParameters.earlyDataEnabled && ssl.isInEarlyData()) {
+                // BoringSSL returned early so that early data can flow. The rest of the
+                // handshake is driven by later calls, and only then does it finish.
+                inEarlyData = true;
+                return pendingStatus(pendingOutboundEncryptedBytes());
             }
+            inEarlyData = false;
 
             // The handshake has completed successfully...
 
@@ -999,10 +1100,25 @@ final class ConscryptEngine extends AbstractConscryptEngine implements NativeCry
         handshakeFinished = true;
         // Notify the listener, if provided.
         if (handshakeListener != null) {
+            if (sslParameters.earlyDataEnabled && ssl.isEarlyDataAccepted()) {
+                handshakeListener.onEarlyDataResolved(true);
+            }
             handshakeListener.onHandshakeFinished();
         }
     }
 
+    /**
+     * Resets the SSL after the server rejected our early data so that the handshake continues
+     * as a full one, and lets the listener know that the data needs to be written again.
+     */
+    private void onEarlyDataRejected() throws SSLException {
+        ssl.resetEarlyDataReject();
+        inEarlyData = false;
+        if (handshakeListener != null) {
+            handshakeListener.onEarlyDataResolved(false);
+        }
+    }
+
     /**
      * Write plaintext data to the OpenSSL internal BIO
      *
@@ -1030,6 +1146,17 @@ final class ConscryptEngine extends AbstractConscryptEngine implements NativeCry
         return ssl.writeDirectByteBuffer(directByteBufferAddress(src, pos), len);
     }
 
+    /**
+     * Writes the segments collected by {@link #gatherDirectSegments} as a single TLS record.
+     */
+    private int writePlaintextDataGathered(int segments) throws SSLException {
+        try {
+            return ssl.writeDirectByteBuffers(gatherAddresses, gatherLengths, segments);
+        } catch (Exception e) {
+            throw convertException(e);
+        }
+    }
+
     private int writePlaintextDataHeap(ByteBuffer src, int pos, int len) throws IOException {
         AllocatedBuffer allocatedBuffer = null;
         try {
@@ -1160,6 +1287,18 @@ final class ConscryptEngine extends AbstractConscryptEngine implements NativeCry
         return networkBio.writeDirectByteBuffer(directByteBufferAddress(src, pos), len);
     }
 
+    /**
+     * Writes the segments collected by {@link #gatherDirectSegments} to the network BIO.
+     */
+    private int writeEncryptedDataGathered(int segments) throws SSLException {
+        try {
+            return networkBio.writeDirectByteBuffers(gatherAddresses, gatherLengths, segments);
+        } catch (IOException e) {
+            closeAll();
+            throw new SSLException(e);
+        }
+    }
+
     private int writeEncryptedDataHeap(ByteBuffer src, int pos, int len) throws IOException {
         AllocatedBuffer allocatedBuffer = null;
         try {
@@ -1207,6 +1346,35 @@ final class ConscryptEngine extends AbstractConscryptEngine implements NativeCry
         return lazyDirectBuffer;
     }
 
+    /**
+     * Records the address and length of each non-empty buffer in {@code buffers[offset, end)}
+     * until {@code maxBytes} bytes are covered. Returns the number of segments recorded, or -1 if
+     * any of the buffers needed is not direct and the data has to be copied instead.
+     */
+    private int gatherDirectSegments(ByteBuffer[] buffers, int offset, int end, int maxBytes) {
+        int count = 0;
+        for (int i = offset; i < end && maxBytes > 0; i++) {
+            ByteBuffer buffer = buffers[i];
+            int remaining = buffer.remaining();
+            if (remaining == 0) {
+                continue;
+            }
+            if (!buffer.isDirect()) {
+                return -1;
+            }
+            if (count == gatherAddresses.length) {
+                gatherAddresses = Arrays.copyOf(gatherAddresses, count * 2);
+                gatherLengths = Arrays.copyOf(gatherLengths, count * 2);
+            }
+            int length = min(remaining, maxBytes);
+            gatherAddresses[count] = directByteBufferAddress(buffer, buffer.position());
+            gatherLengths[count] = length;
+            maxBytes -= length;
+            count++;
+        }
+        return count;
+    }
+
     private long directByteBufferAddress(ByteBuffer directBuffer, int pos) {
         return NativeCrypto.getDirectBufferAddress(directBuffer) + pos;
     }
@@ -1419,9 +1587,13 @@ final class ConscryptEngine extends AbstractConscryptEngine implements NativeCry
             // Prepare OpenSSL to work in server mode and receive handshake
             if (!handshakeFinished) {
                 handshakeStatus = handshake();
-                if (handshakeStatus == NEED_UNWRAP) {
+                // Early data may be written while waiting for the server's flight.
+                if (handshakeStatus == NEED_UNWRAP && !inEarlyData) {
                     return NEED_UNWRAP_OK;
                 }
+                if (handshakeStatus == NEED_TASK) {
+                    return NEED_TASK_OK;
+                }
 
                 if (state == STATE_CLOSED) {
                     return NEED_UNWRAP_CLOSED;
@@ -1443,28 +1615,40 @@ final class ConscryptEngine extends AbstractConscryptEngine implements NativeCry
                 // data as possible from the source buffers to fill a record. Note the we can't
                 // mark the data as consumed until we see how much the TLS layer actually consumes.
                 boolean isCopy = false;
+                int result;
                 ByteBuffer outputBuffer
                         = BufferUtils.getBufferLargerThan(srcs, SSL3_RT_MAX_PLAIN_LENGTH);
-                if (outputBuffer == null) {
-                    // The buffer by getOrCreateLazyDirectBuffer() is also used by
-                    // writePlainTextDataHeap(), but by filling it here the write path will go via
-                    // writePlainTextDataDirect() and the cost will be approximately the same,
-                    // especially if compacting multiple non-direct buffers into a single
-                    // direct one.
-                    // TODO(): use bufferAllocator if set.
-                    // https://github.com/google/conscrypt/issues/974
-                    outputBuffer = BufferUtils.copyNoConsume(
-                            srcs, getOrCreateLazyDirectBuffer(), SSL3_RT_MAX_PLAIN_LENGTH);
+                int segments = outputBuffer == null
+                        ? gatherDirectSegments(srcs, 0, srcs.length, SSL3_RT_MAX_PLAIN_LENGTH)
+                        : -1;
+                if (segments > 0) {
+                    // All of the data is in direct buffers, so let the native code gather it
+                    // into a single record without an intermediate Java copy.
+                    result = writePlaintextDataGathered(segments);
                     isCopy = true;
+                } else {
+                    if (outputBuffer == null) {
+                        // The buffer by getOrCreateLazyDirectBuffer() is also used by
+                        // writePlainTextDataHeap(), but by filling it here the write path will go
+                        // via writePlainTextDataDirect() and the cost will be approximately the
+                        // same, especially if compacting multiple non-direct buffers into a single
+                        // direct one.
+                        // TODO(): use bufferAllocator if set.
+                        // https://github.com/google/conscrypt/issues/974
+                        outputBuffer = BufferUtils.copyNoConsume(
+                                srcs, getOrCreateLazyDirectBuffer(), SSL3_RT_MAX_PLAIN_LENGTH);
+                        isCopy = true;
+                    }
+                    // Write plaintext application data to the SSL engine
+                    result = writePlaintextData(outputBuffer,
+                            min(SSL3_RT_MAX_PLAIN_LENGTH, outputBuffer.remaining()));
                 }
                 final SSLEngineResult pendingNetResult;
-                // Write plaintext application data to the SSL engine
-                int result = writePlaintextData(outputBuffer,
-                        min(SSL3_RT_MAX_PLAIN_LENGTH, outputBuffer.remaining()));
                 if (result > 0) {
                     bytesConsumed = result;
                     if (isCopy) {
-                        // Data was a copy, so mark it as consumed in the original buffers.
+                        // Data was gathered or copied, so mark it as consumed in the original
+                        // buffers.
                         BufferUtils.consume(srcs, bytesConsumed);
                     }
 
@@ -1524,6 +1708,15 @@ final class ConscryptEngine extends AbstractConscryptEngine implements NativeCry
                                     dst, bytesConsumed, bytesProduced, handshakeStatus);
                             return pendingNetResult != null ? pendingNetResult
                                     : NEED_WRAP_CLOSED;
+                        case SSL_ERROR_WANT_PRIVATE_KEY_OPERATION:
+                            return new SSLEngineResult(getEngineStatus(), NEED_TASK,
+                                    bytesConsumed, bytesProduced);
+                        case SSL_ERROR_EARLY_DATA_REJECTED:
+                            // Nothing of this write was consumed; the caller writes it again
+                            // once the full handshake is done.
+                            onEarlyDataRejected();
+                            return new SSLEngineResult(getEngineStatus(),
+                                    getHandshakeStatusInternal(), bytesConsumed, bytesProduced);
                         default:
                             // Everything else is considered as error
                             closeAll();
@@ -1735,6 +1928,45 @@ final class ConscryptEngine extends AbstractConscryptEngine implements NativeCry
         sslParameters.setUseSessionTickets(useSessionTickets);
     }
 
+    @Override
+    void setDelegatePrivateKeyOperations(boolean enabled) {
+        synchronized (ssl) {
+            if (isHandshakeStarted()) {
+                throw new IllegalStateException(
+                        "Private-key delegation must be set before starting the handshake.");
+            }
+            sslParameters.setDelegatePrivateKeyOperations(enabled);
+        }
+    }
+
+    @Override
+    void setEarlyDataEnabled(boolean enabled) {
+        synchronized (ssl) {
+            if (isHandshakeStarted()) {
+                throw new IllegalStateException(
+                        "Early data must be enabled before starting the handshake.");
+            }
+            sslParameters.setEarlyDataEnabled(enabled);
+        }
+    }
+
+    @Override
+    boolean isInEarlyData() {
+        synchronized (ssl) {
+            return sslParameters.earlyDataEnabled && !handshakeFinished && ssl.isInEarlyData();
+        }
+    }
+
+    @Override
+    String getEarlyDataStatus() {
+        synchronized (ssl) {
+            if (state < STATE_HANDSHAKE_STARTED || state == STATE_CLOSED) {
+                return null;
+            }
+        }
+        return ssl.getEarlyDataStatus();
+    }
+
     @Override
     String[] getApplicationProtocols() {
         return sslParameters.getApplicationProtocols();
@@ -448,6 +448,36 @@ class ConscryptEngineSocket extends OpenSSLSocketImpl implements SSLParametersIm
         engine.setUseSessionTickets(useSessionTickets);
     }
 
+    @Override
+    final void setEarlyDataEnabled(boolean enabled) {
+        engine.setEarlyDataEnabled(enabled);
+    }
+
+    @Override
+    final boolean isInEarlyData() {
+        return engine.isInEarlyData();
+    }
+
+    @Override
+    final String getEarlyDataStatus() {
+        return engine.getEarlyDataStatus();
+    }
+
+    @Override
+    final void setKernelTlsEnabled(boolean enabled) {
+        // The engine always encrypts in user space.
+    }
+
+    @Override
+    final boolean isKernelTlsActive() {
+        return false;
+    }
+
+    @Override
+    final void setSharedPollerEnabled(boolean enabled) {
+        // The engine socket does its I/O through the underlying socket's streams.
+    }
+
     @Override
     public final void setChannelIdEnabled(boolean enabled) {
         engine.setChannelIdEnabled(enabled);
@@ -0,0 +1,36 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package org.conscrypt;
+
+import javax.net.ssl.SSLException;
+
+/**
+ * Thrown by a read or write on a socket with TLS 1.3 early data enabled when the server
+ * rejects the early data. Everything written before the handshake completed was discarded,
+ * and nothing was read or written by the call that threw. The connection stays usable: the
+ * caller should write the data again, and the next read or write finishes the handshake.
+ *
+ * @see Conscrypt#setEarlyDataEnabled(javax.net.ssl.SSLSocket, boolean)
+ */
+@ExperimentalApi
+public class EarlyDataRejectedException extends SSLException {
+    private static final long serialVersionUID = -2958712645217706436L;
+
+    public EarlyDataRejectedException(String msg) {
+        super(msg);
+    }
+}
@@ -274,6 +274,26 @@ final class Java8EngineWrapper extends AbstractConscryptEngine {
         delegate.setUseSessionTickets(useSessionTickets);
     }
 
+    @Override
+    void setDelegatePrivateKeyOperations(boolean enabled) {
+        delegate.setDelegatePrivateKeyOperations(enabled);
+    }
+
+    @Override
+    void setEarlyDataEnabled(boolean enabled) {
+        delegate.setEarlyDataEnabled(enabled);
+    }
+
+    @Override
+    boolean isInEarlyData() {
+        return delegate.isInEarlyData();
+    }
+
+    @Override
+    String getEarlyDataStatus() {
+        return delegate.getEarlyDataStatus();
+    }
+
     @Override
     void setApplicationProtocols(String[] protocols) {
         delegate.setApplicationProtocols(protocols);
@@ -73,6 +73,29 @@ public final class NativeCrypto {
 
     private native static void clinit();
 
+    /** Index of the time spent resolving the eagerly needed JNI references, in nanoseconds. */
+    static final int STARTUP_INIT_NANOS = 0;
+    /** Index of the time spent registering the native methods, in nanoseconds. */
+    static final int STARTUP_REGISTER_NANOS = 1;
+    /** Index of the time spent in JNI_OnLoad, in nanoseconds. */
+    static final int STARTUP_ON_LOAD_NANOS = 2;
+    /** Index of the time spent in {@link #clinit}, in nanoseconds. */
+    static final int STARTUP_CLINIT_NANOS = 3;
+    /** Index of the number of JNI classes and methods looked up on first use. */
+    static final int STARTUP_LAZY_RESOLUTIONS = 4;
+    /** Index of the time spent in those lookups, in nanoseconds. */
+    static final int STARTUP_LAZY_RESOLUTION_NANOS = 5;
+    /** Index of the time from the start of JNI_OnLoad to the call, in nanoseconds. */
+    static final int STARTUP_NANOS_SINCE_LOAD = 6;
+    /** Length of the array returned by get_startup_timings. */
+    static final int STARTUP_TIMING_COUNT = 7;
+
+    /**
+     * Returns the start-up measurements of the native library, indexed by the
+     * {@code STARTUP_*} constants.
+     */
+    static native long[] get_startup_timings();
+
     /**
      * Checks to see whether or not the native library was successfully loaded. If not, throws
      * the {@link UnsatisfiedLinkError} that was encountered while attempting to load the library.
@@ -151,6 +174,13 @@ public final class NativeCrypto {
     static native void chacha20_encrypt_decrypt(byte[] in, int inOffset, byte[] out, int outOffset,
             int length, byte[] key, byte[] nonce, int blockCounter);
 
+    /**
+     * Like chacha20_encrypt_decrypt over native memory. {@code in} and {@code out} may be the
+     * same address, or overlap in any other way.
+     */
+    static native void chacha20_encrypt_decryptDirect(long inPtr, long outPtr, int length,
+            byte[] key, byte[] nonce, int blockCounter);
+
     // --- EC functions --------------------------
 
     static native long EVP_PKEY_new_EC_KEY(
@@ -206,6 +236,22 @@ public final class NativeCrypto {
 
     static native int ECDSA_verify(byte[] data, byte[] sig, NativeRef.EVP_PKEY pkey);
 
+    // --- Prepared signature verifiers ----------------------------------------
+
+    static native long PREPARED_VERIFIER_new(NativeRef.EVP_PKEY pkey);
+
+    static native void PREPARED_VERIFIER_free(long verifier);
+
+    /**
+     * Verifies {@code count} signatures against a prepared key. Item {@code i} is described by
+     * {@code ranges[4 * i]} to {@code ranges[4 * i + 3]}: the offset and length in {@code data}
+     * of the signed input, which is the digest for ECDSA and the message for Ed25519, then those
+     * of the signature. Returns a bitmap in the layout of {@link java.util.BitSet#valueOf(long[])}
+     * with bit {@code i} set when signature {@code i} is valid.
+     */
+    static native long[] PREPARED_VERIFIER_verify_batch(
+            NativeRef.PREPARED_VERIFIER verifier, byte[] data, int[] ranges, int count);
+
     // --- Curve25519 --------------
 
     static native boolean X25519(byte[] out, byte[] privateKey, byte[] publicKey) throws InvalidKeyException;
@@ -219,6 +265,15 @@ public final class NativeCrypto {
 
     static native int EVP_MD_size(long evp_md_const);
 
+    /**
+     * Hashes the first {@code count} messages in the {@code inLength} bytes at native address
+     * {@code inPtr}, message {@code i} being the {@code lengths[i]} bytes at offset
+     * {@code offsets[i]}, and writes their digests back to back to {@code outPtr}. Large batches
+     * are hashed on several threads.
+     */
+    static native void EVP_Digest_batch(long evp_md_const, long inPtr, int inLength,
+            int[] offsets, int[] lengths, int count, long outPtr, int outLength);
+
     // --- Message digest context functions --------------
 
     static native long EVP_MD_CTX_create();
@@ -304,9 +359,22 @@ public final class NativeCrypto {
     static native int EVP_CipherUpdate(NativeRef.EVP_CIPHER_CTX ctx, byte[] out, int outOffset,
             byte[] in, int inOffset, int inLength) throws IndexOutOfBoundsException;
 
+    /**
+     * Like EVP_CipherUpdate over native memory. {@code outLength} must cover everything the update
+     * can output. The buffers may be the same address, or overlap in any other way.
+     */
+    static native int EVP_CipherUpdateDirect(NativeRef.EVP_CIPHER_CTX ctx, long outPtr,
+            int outLength, long inPtr, int inLength) throws IndexOutOfBoundsException;
+
     static native int EVP_CipherFinal_ex(NativeRef.EVP_CIPHER_CTX ctx, byte[] out, int outOffset)
             throws BadPaddingException, IllegalBlockSizeException;
 
+    /**
+     * Like EVP_CipherFinal_ex into native memory, which must have room for a whole block.
+     */
+    static native int EVP_CipherFinal_exDirect(NativeRef.EVP_CIPHER_CTX ctx, long outPtr,
+            int outLength) throws BadPaddingException, IllegalBlockSizeException;
+
     static native int EVP_CIPHER_iv_length(long evpCipher);
 
     static native long EVP_CIPHER_CTX_new();
@@ -355,6 +423,56 @@ public final class NativeCrypto {
                                             byte[] nonce, ByteBuffer input, byte[] ad)
             throws ShortBufferException, BadPaddingException;
 
+    /**
+     * Returns a new EVP_AEAD_CTX initialized with {@code key}, which can be used for any number
+     * of seal and open operations via the {@code _ctx} variants below without repeating the
+     * key setup.
+     */
+    static native long EVP_AEAD_CTX_new(long evpAead, byte[] key, int tagLengthInBytes);
+
+    static native void EVP_AEAD_CTX_free(long ctx);
+
+    static native int EVP_AEAD_CTX_seal_ctx(NativeRef.EVP_AEAD_CTX ctx, byte[] out, int outOffset,
+            byte[] nonce, byte[] in, int inOffset, int inLength, byte[] ad)
+            throws ShortBufferException, BadPaddingException;
+
+    static native int EVP_AEAD_CTX_seal_ctx_buf(NativeRef.EVP_AEAD_CTX ctx, ByteBuffer out,
+            byte[] nonce, ByteBuffer input, byte[] ad)
+            throws ShortBufferException, BadPaddingException;
+
+    static native int EVP_AEAD_CTX_open_ctx(NativeRef.EVP_AEAD_CTX ctx, byte[] out, int outOffset,
+            byte[] nonce, byte[] in, int inOffset, int inLength, byte[] ad)
+            throws ShortBufferException, BadPaddingException;
+
+    static native int EVP_AEAD_CTX_open_ctx_buf(NativeRef.EVP_AEAD_CTX ctx, ByteBuffer out,
+            byte[] nonce, ByteBuffer input, byte[] ad)
+            throws ShortBufferException, BadPaddingException;
+
+    /**
+     * Number of {@code int}s describing each record passed to the batch AEAD functions. Each
+     * record is laid out as {@code inOffset, inLength, outOffset, outLength, nonceOffset,
+     * nonceLength, aadOffset, aadLength}, where the offsets are absolute positions in the
+     * direct buffer holding all of the data. A record's output may alias its input exactly,
+     * but must not otherwise overlap it.
+     */
+    static final int AEAD_BATCH_RECORD_SIZE = 8;
+
+    /**
+     * Seals every record described by {@code records} in a single call. The ciphertext length
+     * of each record is written to {@code outLengths}, or -1 if that record could not be
+     * sealed. Returns the number of records that were sealed successfully.
+     */
+    static native int EVP_AEAD_CTX_seal_batch(
+            NativeRef.EVP_AEAD_CTX ctx, ByteBuffer buffer, int[] records, int[] outLengths);
+
+    /**
+     * Opens every record described by {@code records} in a single call. The plaintext length
+     * of each record is written to {@code outLengths}, or -1 if that record failed to
+     * authenticate. Returns the number of records that were opened successfully.
+     */
+    static native int EVP_AEAD_CTX_open_batch(
+            NativeRef.EVP_AEAD_CTX ctx, ByteBuffer buffer, int[] records, int[] outLengths);
+
     // --- CMAC functions ------------------------------------------------------
 
     static native long CMAC_CTX_new();
@@ -371,6 +489,20 @@ public final class NativeCrypto {
 
     static native void CMAC_Reset(NativeRef.CMAC_CTX ctx);
 
+    /**
+     * Returns a CMAC context keyed with {@code key} for use with {@link #CMAC_oneshot}. It is
+     * never modified afterwards, so it may be used by several threads at once.
+     */
+    static native long CMAC_PREPARED_KEY_new(byte[] key);
+
+    static native void CMAC_PREPARED_KEY_free(long preparedKey);
+
+    static native byte[] CMAC_oneshot(
+            NativeRef.CMAC_PREPARED_KEY preparedKey, byte[] in, int inOffset, int inLength);
+
+    static native byte[] CMAC_oneshotDirect(
+            NativeRef.CMAC_PREPARED_KEY preparedKey, long inPtr, int inLength);
+
     // --- HMAC functions ------------------------------------------------------
 
     static native long HMAC_CTX_new();
@@ -387,6 +519,21 @@ public final class NativeCrypto {
 
     static native void HMAC_Reset(NativeRef.HMAC_CTX ctx);
 
+    /**
+     * Returns an HMAC context holding the inner and outer padded key state for {@code key}, for
+     * use with {@link #HMAC_oneshot}. It is never modified afterwards, so it may be used by
+     * several threads at once.
+     */
+    static native long HMAC_PREPARED_KEY_new(byte[] key, long evp_md);
+
+    static native void HMAC_PREPARED_KEY_free(long preparedKey);
+
+    static native byte[] HMAC_oneshot(
+            NativeRef.HMAC_PREPARED_KEY preparedKey, byte[] in, int inOffset, int inLength);
+
+    static native byte[] HMAC_oneshotDirect(
+            NativeRef.HMAC_PREPARED_KEY preparedKey, long inPtr, int inLength);
+
     // --- HPKE functions ------------------------------------------------------
     static native byte[] EVP_HPKE_CTX_export(
             NativeRef.EVP_HPKE_CTX ctx, byte[] exporterCtx, int length);
@@ -432,6 +579,20 @@ public final class NativeCrypto {
 
     static native void RAND_bytes(byte[] output);
 
+    /**
+     * Fills the {@code length} bytes of native memory at {@code address}, such as the contents
+     * of a direct buffer, with random bytes. Like {@link #RAND_bytes(byte[])}, short requests
+     * are served from a per-thread block that is refilled in bulk when {@link
+     * #setRandomBufferingEnabled} turned that on.
+     */
+    static native void RAND_bytes_direct(long address, int length);
+
+    /**
+     * Sets whether short random requests are served from a per-thread block of DRBG output
+     * rather than each calling into the DRBG. Off by default; ignored in FIPS mode.
+     */
+    static native void setRandomBufferingEnabled(boolean enabled);
+
     // --- X509_NAME -----------------------------------------------------------
 
     static int X509_NAME_hash(X500Principal principal) {
@@ -515,6 +676,34 @@ public final class NativeCrypto {
 
     static native String[] get_X509_ext_oids(long x509ctx, OpenSSLX509Certificate holder, int critical);
 
+    // Slots of the array returned by get_X509_fields.
+    static final int X509_FIELD_LONGS = 0;
+    static final int X509_FIELD_SERIAL_NUMBER = 1;
+    static final int X509_FIELD_ISSUER = 2;
+    static final int X509_FIELD_SUBJECT = 3;
+    static final int X509_FIELD_SIG_ALG_OID = 4;
+    static final int X509_FIELD_KEY_USAGE = 5;
+    static final int X509_FIELD_EXT_KEY_USAGE = 6;
+    static final int X509_FIELD_CRITICAL_EXT_OIDS = 7;
+    static final int X509_FIELD_NON_CRITICAL_EXT_OIDS = 8;
+
+    // Entries of the long[] in the X509_FIELD_LONGS slot.
+    static final int X509_LONG_NOT_BEFORE = 0;
+    static final int X509_LONG_NOT_AFTER = 1;
+    static final int X509_LONG_VERSION = 2;
+    static final int X509_LONG_EX_FLAGS = 3;
+    static final int X509_LONG_PATH_LEN = 4;
+
+    /**
+     * Decodes the commonly used fields of a certificate in one call: the validity times (in
+     * milliseconds since the epoch), version, extension flags and path length in a {@code long[]},
+     * followed by the serial number, DER issuer and subject, signature algorithm OID, key usage,
+     * extended key usage and the critical and non-critical extension OIDs, laid out by the
+     * {@code X509_FIELD_*} constants. Absent extensions leave their slot null.
+     */
+    static native Object[] get_X509_fields(long x509ctx, OpenSSLX509Certificate holder)
+            throws ParsingException;
+
     static native Object[][] get_X509_GENERAL_NAME_stack(long x509ctx, OpenSSLX509Certificate holder, int type)
             throws CertificateParsingException;
 
@@ -567,6 +756,39 @@ public final class NativeCrypto {
     /** Returns an array of X509 or X509_CRL pointers. */
     static native long[] PEM_read_bio_PKCS7(long bioCtx, int which);
 
+    // --- Mapped certificate files -------------------------------------------
+
+    /**
+     * Maps {@code path} read-only for incremental parsing with the {@code MAPPED_FILE_next_*}
+     * methods. The handle must be released with {@link #MAPPED_FILE_free}.
+     */
+    static native long MAPPED_FILE_open(String path) throws IOException;
+
+    /**
+     * Like {@link #MAPPED_FILE_open} for an already open file. {@code fd} is not taken over and
+     * may be closed once this returns.
+     */
+    static native long MAPPED_FILE_open_fd(int fd) throws IOException;
+
+    static native void MAPPED_FILE_free(long mappedFile);
+
+    /**
+     * Returns the next certificate in a bundle of concatenated DER or PEM certificates or
+     * PKCS#7 blobs, or 0 at the end of the file. Unrelated PEM blocks are skipped.
+     */
+    static native long MAPPED_FILE_next_X509(long mappedFile) throws ParsingException;
+
+    /** Returns the next DER or PEM CRL in the file, or 0 at the end of the file. */
+    static native long MAPPED_FILE_next_X509_CRL(long mappedFile) throws ParsingException;
+
+    /**
+     * Reports each revoked certificate in the next CRL to {@code visitor} without decoding the
+     * CRL into an object, stopping early if the visitor returns false. Returns the number of
+     * entries visited, or -1 at the end of the file.
+     */
+    static native int MAPPED_FILE_visit_X509_CRL_entries(long mappedFile,
+            CertificateFileReader.RevokedCertificateVisitor visitor) throws ParsingException;
+
     // --- X509_CRL ------------------------------------------------------------
 
     static native long d2i_X509_CRL_bio(long bioCtx);
@@ -899,6 +1121,17 @@ public final class NativeCrypto {
 
     static native long SSL_CTX_new();
 
+    /** Index of the number of pooled certificate buffer lookups in CRYPTO_BUFFER_POOL_get_stats. */
+    static final int CRYPTO_BUFFER_POOL_STAT_REQUESTS = 0;
+
+    /**
+     * Returns counters for the process-wide certificate buffer pool shared by all SSL_CTX
+     * instances, indexed by the {@code CRYPTO_BUFFER_POOL_STAT_*} constants. Only certificates
+     * passed in from Java are counted; peer chains are pooled by BoringSSL without reporting.
+     * BoringSSL does not say whether a lookup found an existing buffer, so hits are not counted.
+     */
+    static native long[] CRYPTO_BUFFER_POOL_get_stats();
+
     // IMPLEMENTATION NOTE: The default list of cipher suites is a trade-off between what we'd like
     // to use and what servers currently support. We strive to be secure enough by default. We thus
     // avoid unacceptably weak suites (e.g., those with bulk cipher secret key shorter than 128
@@ -976,6 +1209,84 @@ public final class NativeCrypto {
 
     static native long SSL_CTX_set_timeout(long ssl_ctx, AbstractSessionContext holder, long seconds);
 
+    /** Index of the number of full handshakes in the counters returned by SSL_get_counters. */
+    static final int SSL_COUNTER_FULL_HANDSHAKES = 0;
+    /** Index of the number of resumed handshakes. */
+    static final int SSL_COUNTER_RESUMED_HANDSHAKES = 1;
+    /** Index of the total time spent in SSL_do_handshake, in nanoseconds. */
+    static final int SSL_COUNTER_HANDSHAKE_NANOS = 2;
+    /** Index of the number of TLS records sealed. */
+    static final int SSL_COUNTER_RECORDS_SEALED = 3;
+    /** Index of the number of record payload bytes sealed, as sent on the wire. */
+    static final int SSL_COUNTER_BYTES_SEALED = 4;
+    /** Index of the number of TLS records opened. */
+    static final int SSL_COUNTER_RECORDS_OPENED = 5;
+    /** Index of the number of record payload bytes opened, as received on the wire. */
+    static final int SSL_COUNTER_BYTES_OPENED = 6;
+    /** Index of the number of verifyCertificateChain upcalls. */
+    static final int SSL_COUNTER_CERT_VERIFY_CALLS = 7;
+    /** Index of the total time spent in verifyCertificateChain upcalls, in nanoseconds. */
+    static final int SSL_COUNTER_CERT_VERIFY_NANOS = 8;
+    /** Index of the number of clientCertificateRequested upcalls. */
+    static final int SSL_COUNTER_CERT_CB_CALLS = 9;
+    /** Index of the total time spent in clientCertificateRequested upcalls, in nanoseconds. */
+    static final int SSL_COUNTER_CERT_CB_NANOS = 10;
+    /** Index of the number of onNewSessionEstablished upcalls. */
+    static final int SSL_COUNTER_NEW_SESSION_CALLS = 11;
+    /** Index of the total time spent in onNewSessionEstablished upcalls, in nanoseconds. */
+    static final int SSL_COUNTER_NEW_SESSION_NANOS = 12;
+    /** Index of the number of times a socket read, write or handshake waited for the socket. */
+    static final int SSL_COUNTER_SELECT_WAKEUPS = 13;
+    /** Index of the number of server certificates chosen from the native certificate map. */
+    static final int SSL_COUNTER_CERTIFICATE_MAP_HITS = 14;
+    /** Length of the arrays returned by SSL_get_counters and SSL_CTX_get_counters. */
+    static final int SSL_COUNTER_COUNT = 15;
+
+    /**
+     * Returns a snapshot of the performance counters summed over every connection created from
+     * {@code ssl_ctx}, indexed by the {@code SSL_COUNTER_*} constants.
+     */
+    static native long[] SSL_CTX_get_counters(long ssl_ctx, AbstractSessionContext holder);
+
+    /**
+     * Installs the session ticket keys of a server {@code ssl_ctx}, replacing any previous ones
+     * atomically. {@code keys} holds one or more 48-byte keys back to back, each a 16-byte name,
+     * a 16-byte HMAC secret and a 16-byte AES key. The first key encrypts new tickets; all of
+     * them decrypt.
+     */
+    static native void SSL_CTX_set_ticket_keys(
+            long ssl_ctx, AbstractSessionContext holder, byte[] keys);
+
+    /**
+     * Configures the lock-striped native session cache of a server {@code ssl_ctx}. While
+     * {@code maxEntries} is non-zero, sessions are stored and looked up for session ID
+     * resumption entirely in native code, replacing both BoringSSL's internal cache and the
+     * {@link SSLHandshakeCallbacks} session upcalls. A {@code timeoutSeconds} of 0 keeps each
+     * session's own timeout. Setting {@code maxEntries} to 0 drops the cache again.
+     */
+    static native void SSL_CTX_set_server_session_cache(
+            long ssl_ctx, AbstractSessionContext holder, int maxEntries, int timeoutSeconds);
+
+    /**
+     * Returns a native server credential holding the DER-encoded {@code chain}, leaf first, the
+     * private key and, when not {@code null}, the OCSP response and SignedCertificateTimestampList
+     * to staple. Free it with {@link #SERVER_CREDENTIAL_free}; maps installed with
+     * {@link #SSL_CTX_set_certificate_map} keep their own reference.
+     */
+    static native long SERVER_CREDENTIAL_new(byte[][] chain, NativeRef.EVP_PKEY privateKey,
+            byte[] ocspResponse, byte[] signedCertificateTimestamps);
+
+    static native void SERVER_CREDENTIAL_free(long credential);
+
+    /**
+     * Replaces the SNI certificate map of a server {@code ssl_ctx} atomically. A client whose
+     * server name matches {@code hostNames[i]}, exactly or through a leading {@code *.} label,
+     * gets {@code credentials[i]} without the
+     * {@link SSLHandshakeCallbacks#serverCertificateRequested} upcall. Empty arrays clear the map.
+     */
+    static native void SSL_CTX_set_certificate_map(long ssl_ctx, AbstractSessionContext holder,
+            String[] hostNames, long[] credentials);
+
     static native long SSL_new(long ssl_ctx, AbstractSessionContext holder) throws SSLException;
 
     static native void SSL_enable_tls_channel_id(long ssl, NativeSsl ssl_holder) throws SSLException;
@@ -995,6 +1306,31 @@ public final class NativeCrypto {
     static native void setLocalCertsAndPrivateKey(long ssl, NativeSsl ssl_holder, byte[][] encodedCertificates,
         NativeRef.EVP_PKEY pkey) throws SSLException;
 
+    /**
+     * Makes the handshake hand signing and decryption with {@code pkey} off to the caller instead
+     * of performing them in-line. When the handshake needs the key it stops with {@code
+     * SSL_ERROR_WANT_PRIVATE_KEY_OPERATION}; the operation is then run with {@link
+     * #SSL_do_delegated_key_operation}, from any thread, and the handshake resumes on its next
+     * call. Must be called after {@link #setLocalCertsAndPrivateKey}.
+     */
+    static native void SSL_set_delegated_private_key(
+            long ssl, NativeSsl ssl_holder, NativeRef.EVP_PKEY pkey) throws SSLException;
+
+    /**
+     * Performs the key operation the handshake is waiting for, if any. This may block for as long
+     * as the key takes, and must not be called while holding locks the handshake needs.
+     *
+     * @throws SSLException if the operation failed; the handshake then fails when it resumes.
+     */
+    static native void SSL_do_delegated_key_operation(long ssl, NativeSsl ssl_holder)
+            throws SSLException;
+
+    /**
+     * Returns whether the handshake is waiting for a delegated key operation that has not
+     * finished yet.
+     */
+    static native boolean SSL_delegated_key_operation_pending(long ssl, NativeSsl ssl_holder);
+
     static native void SSL_set_client_CA_list(long ssl, NativeSsl ssl_holder, byte[][] asn1DerEncodedX500Principals)
             throws SSLException;
 
@@ -1245,6 +1581,34 @@ public final class NativeCrypto {
 
     static native boolean SSL_session_reused(long ssl, NativeSsl ssl_holder);
 
+    /**
+     * Enables TLS 1.3 early data. Clients then send data written before the handshake is
+     * complete as 0-RTT data when resuming an early-data-capable session; servers accept it
+     * when resuming a session they issued with early data enabled.
+     */
+    static native void SSL_set_early_data_enabled(long ssl, NativeSsl ssl_holder, boolean enabled);
+
+    /**
+     * Returns whether the handshake has paused to let early data be written (clients) or read
+     * (servers).
+     */
+    static native boolean SSL_in_early_data(long ssl, NativeSsl ssl_holder);
+
+    static native boolean SSL_early_data_accepted(long ssl, NativeSsl ssl_holder);
+
+    /**
+     * Returns why early data was accepted or not, as named by BoringSSL's {@code
+     * SSL_early_data_reason_string}, e.g. {@code "accepted"} or {@code "peer_declined"}.
+     */
+    static native String SSL_get_early_data_reason(long ssl, NativeSsl ssl_holder);
+
+    /**
+     * Resets a client after its early data was rejected, reported as {@link
+     * NativeConstants#SSL_ERROR_EARLY_DATA_REJECTED}, so that the handshake continues as a full
+     * one. Anything written as early data has been discarded and must be sent again.
+     */
+    static native void SSL_reset_early_data_reject(long ssl, NativeSsl ssl_holder);
+
     static native void SSL_accept_renegotiations(long ssl, NativeSsl ssl_holder) throws SSLException;
 
     static native void SSL_set_tlsext_host_name(long ssl, NativeSsl ssl_holder, String hostname)
@@ -1255,6 +1619,15 @@ public final class NativeCrypto {
             long ssl, NativeSsl ssl_holder, FileDescriptor fd, SSLHandshakeCallbacks shc, int timeoutMillis)
             throws SSLException, SocketTimeoutException, CertificateException;
 
+    /**
+     * Advances the handshake like {@link #SSL_do_handshake} but never waits for the socket.
+     * Returns 0 once the handshake is done, or {@link #SSL_NONBLOCKING_WANT_READ} or {@link
+     * #SSL_NONBLOCKING_WANT_WRITE} when it must be called again after the socket is ready.
+     */
+    static native int SSL_do_handshake_nonblocking(long ssl, NativeSsl ssl_holder,
+            FileDescriptor fd, SSLHandshakeCallbacks shc)
+            throws SSLException, CertificateException;
+
     public static native String SSL_get_current_cipher(long ssl, NativeSsl ssl_holder);
 
     public static native String SSL_get_version(long ssl, NativeSsl ssl_holder);
@@ -1264,6 +1637,12 @@ public final class NativeCrypto {
      */
     static native byte[][] SSL_get0_peer_certificates(long ssl, NativeSsl ssl_holder);
 
+    /**
+     * Returns the DER-encoded chain the certificate map installed on the server {@code ssl}, or
+     * {@code null} if its certificate did not come from the map.
+     */
+    static native byte[][] SSL_get_mapped_certificates(long ssl, NativeSsl ssl_holder);
+
     /**
      * Reads with the native SSL_read function from the encrypted data stream
      * @return -1 if error or the end of the stream is reached.
@@ -1278,10 +1657,83 @@ public final class NativeCrypto {
             SSLHandshakeCallbacks shc, byte[] b, int off, int len, int writeTimeoutMillis)
             throws IOException;
 
+    /** Returned by the non-blocking I/O calls when the socket must become readable first. */
+    static final int SSL_NONBLOCKING_WANT_READ = -2;
+
+    /** Returned by the non-blocking I/O calls when the socket must become writable first. */
+    static final int SSL_NONBLOCKING_WANT_WRITE = -3;
+
+    /**
+     * Reads like {@link #SSL_read} but never waits for the socket. Returns the number of bytes
+     * read, -1 at the end of the stream, or {@link #SSL_NONBLOCKING_WANT_READ} or
+     * {@link #SSL_NONBLOCKING_WANT_WRITE} when the socket isn't ready.
+     */
+    static native int SSL_read_nonblocking(long ssl, NativeSsl ssl_holder, FileDescriptor fd,
+            SSLHandshakeCallbacks shc, byte[] b, int off, int len) throws IOException;
+
+    /**
+     * Writes like {@link #SSL_write} but never waits for the socket. Returns the number of bytes
+     * written, which may be fewer than {@code len}, or {@link #SSL_NONBLOCKING_WANT_READ} or
+     * {@link #SSL_NONBLOCKING_WANT_WRITE} when nothing could be written.
+     */
+    static native int SSL_write_nonblocking(long ssl, NativeSsl ssl_holder, FileDescriptor fd,
+            SSLHandshakeCallbacks shc, byte[] b, int off, int len) throws IOException;
+
+    /** Interest and readiness bit for {@link #SSL_poller_arm} and {@link #SSL_poller_wait}. */
+    static final int SSL_POLLER_READ = 1;
+
+    /** Interest and readiness bit for {@link #SSL_poller_arm} and {@link #SSL_poller_wait}. */
+    static final int SSL_POLLER_WRITE = 2;
+
+    /**
+     * Creates a readiness multiplexer that many non-blocking connections can share, so a small
+     * pool of threads can drive them. Requires epoll.
+     *
+     * @throws UnsupportedOperationException if the platform has no epoll
+     */
+    static native long SSL_poller_new() throws IOException;
+
+    static native void SSL_poller_free(long poller);
+
+    /**
+     * Registers or re-arms {@code fd}. The next time it is ready for {@code interest}, one call
+     * to {@link #SSL_poller_wait} reports {@code token}, after which it must be armed again.
+     */
+    static native void SSL_poller_arm(long poller, FileDescriptor fd, long token, int interest)
+            throws IOException;
+
+    static native void SSL_poller_remove(long poller, FileDescriptor fd) throws IOException;
+
+    /**
+     * Waits up to {@code timeoutMillis} (negative means forever) for armed descriptors and
+     * stores their tokens and ready bits. Returns the number stored, or 0 on timeout or
+     * {@link #SSL_poller_wakeup}.
+     */
+    static native int SSL_poller_wait(long poller, long[] tokens, int[] events, int timeoutMillis)
+            throws IOException;
+
+    /** Makes one pending or future {@link #SSL_poller_wait} call return early. */
+    static native void SSL_poller_wakeup(long poller);
+
     static native void SSL_interrupt(long ssl, NativeSsl ssl_holder);
     static native void SSL_shutdown(
             long ssl, NativeSsl ssl_holder, FileDescriptor fd, SSLHandshakeCallbacks shc) throws IOException;
 
+    /** Bit of the {@link #SSL_enable_ktls} result set when the kernel encrypts outgoing data. */
+    static final int KTLS_TX = 1;
+    /** Bit of the {@link #SSL_enable_ktls} result set when the kernel decrypts incoming data. */
+    static final int KTLS_RX = 1 << 1;
+
+    /**
+     * Hands the established connection on {@code fd} to Linux kernel TLS, after which
+     * {@link #SSL_read}, {@link #SSL_write} and {@link #SSL_shutdown} do plain socket I/O for
+     * the offloaded directions. Only AES-GCM and ChaCha20-Poly1305 with TLS 1.2 or 1.3 can be
+     * offloaded, sending is only offloaded together with receiving, and neither is if records
+     * are already buffered. Returns the mask of {@code KTLS_*} directions offloaded, 0 if none
+     * could be.
+     */
+    static native int SSL_enable_ktls(long ssl, NativeSsl ssl_holder, FileDescriptor fd);
+
     static native int SSL_get_shutdown(long ssl, NativeSsl ssl_holder);
 
     static native void SSL_free(long ssl, NativeSsl ssl_holder);
@@ -1450,6 +1902,12 @@ public final class NativeCrypto {
      */
     static native int SSL_max_seal_overhead(long ssl, NativeSsl ssl_holder);
 
+    /**
+     * Returns a snapshot of the performance counters of a single connection, indexed by the
+     * {@code SSL_COUNTER_*} constants.
+     */
+    static native long[] SSL_get_counters(long ssl, NativeSsl ssl_holder) throws SSLException;
+
     /**
      * Enables ALPN for this TLS endpoint and sets the list of supported ALPN protocols in
      * wire-format (length-prefixed 8-bit strings).
@@ -1466,6 +1924,83 @@ public final class NativeCrypto {
     static native void setHasApplicationProtocolSelector(long ssl, NativeSsl ssl_holder, boolean hasSelector)
             throws IOException;
 
+    /**
+     * Called for a server endpoint only. Indicates that the SNI matchers of its parameters
+     * must vet the requested server name, so the context's certificate map is not consulted
+     * and the certificate always comes from {@link
+     * SSLHandshakeCallbacks#serverCertificateRequested}.
+     */
+    static native void setHasSniMatchers(long ssl, NativeSsl ssl_holder, boolean hasMatchers);
+
+    /**
+     * Attaches the trust identity used to look up the peer chain in the verified chain cache.
+     * A {@code null} identity means the peer is always verified through
+     * {@link SSLHandshakeCallbacks#verifyCertificateChain}.
+     */
+    static native void setVerifiedChainCacheIdentity(
+            long ssl, NativeSsl ssl_holder, byte[] identity);
+
+    /**
+     * Configures the process-wide verified chain cache. Passing 0 for either value disables
+     * the cache and drops its entries.
+     */
+    static native void setVerifiedChainCacheParameters(int maxEntries, long ttlMillis);
+
+    /** Drops every entry in the verified chain cache. */
+    static native void clearVerifiedChainCache();
+
+    /** Index of the hit count in {@link #getVerifiedChainCacheStats()}. */
+    static final int VERIFIED_CHAIN_CACHE_STAT_HITS = 0;
+    /** Index of the miss count in {@link #getVerifiedChainCacheStats()}. */
+    static final int VERIFIED_CHAIN_CACHE_STAT_MISSES = 1;
+    /** Index of the number of live entries in {@link #getVerifiedChainCacheStats()}. */
+    static final int VERIFIED_CHAIN_CACHE_STAT_ENTRIES = 2;
+
+    /**
+     * Returns counters for the verified chain cache, indexed by the
+     * {@code VERIFIED_CHAIN_CACHE_STAT_*} constants.
+     */
+    static native long[] getVerifiedChainCacheStats();
+
+    /**
+     * Configures the process-wide intern table that shares one native key between all parses of
+     * the same SubjectPublicKeyInfo, in {@link #EVP_parse_public_key}, {@link #X509_get_pubkey}
+     * and {@link #PEM_read_bio_PUBKEY}. Passing 0 disables the table and drops its entries.
+     */
+    static native void setPublicKeyCacheParameters(int maxEntries);
+
+    /** Drops every entry in the public key cache. */
+    static native void clearPublicKeyCache();
+
+    /** Index of the hit count in {@link #getPublicKeyCacheStats()}. */
+    static final int PUBLIC_KEY_CACHE_STAT_HITS = 0;
+    /** Index of the miss count in {@link #getPublicKeyCacheStats()}. */
+    static final int PUBLIC_KEY_CACHE_STAT_MISSES = 1;
+    /** Index of the number of live entries in {@link #getPublicKeyCacheStats()}. */
+    static final int PUBLIC_KEY_CACHE_STAT_ENTRIES = 2;
+
+    /**
+     * Returns counters for the public key cache, indexed by the
+     * {@code PUBLIC_KEY_CACHE_STAT_*} constants.
+     */
+    static native long[] getPublicKeyCacheStats();
+
+    // --- Runtime event trace -------------------------------------------------
+
+    /** Sets the native trace categories to record, a mask of {@code NativeTrace.CATEGORY_*}. */
+    static native void setTraceCategories(int categories);
+
+    static native int getTraceCategories();
+
+    /** Drops every recorded trace event. */
+    static native void clearTrace();
+
+    /** Returns the recorded trace events in the format described by {@link NativeTrace#dump}. */
+    static native byte[] dumpTrace();
+
+    /** Returns the recorded packet events as a pcap file. */
+    static native byte[] dumpTracePcap();
+
     /**
      * Returns the selected ALPN protocol. If the server did not select a
      * protocol, {@code null} will be returned.
@@ -1515,6 +2050,23 @@ public final class NativeCrypto {
     static native int ENGINE_SSL_write_BIO_direct(long ssl, NativeSsl ssl_holder, long bioRef, long pos, int length,
             SSLHandshakeCallbacks shc) throws IOException;
 
+    /**
+     * Gathering variant of {@link #ENGINE_SSL_write_direct} that writes the first {@code count}
+     * native segments described by {@code addresses} and {@code lengths} as a single TLS record.
+     * Returns the number of bytes consumed across the segments, in order, or the SSL_write
+     * result if nothing was written.
+     */
+    static native int ENGINE_SSL_write_direct_vec(long ssl, NativeSsl ssl_holder, long[] addresses,
+            int[] lengths, int count, SSLHandshakeCallbacks shc) throws IOException;
+
+    /**
+     * Gathering variant of {@link #ENGINE_SSL_write_BIO_direct}. Nothing is written unless the BIO
+     * can accept all {@code count} segments.
+     */
+    static native int ENGINE_SSL_write_BIO_direct_vec(long ssl, NativeSsl ssl_holder, long bioRef,
+            long[] addresses, int[] lengths, int count, SSLHandshakeCallbacks shc)
+            throws IOException;
+
     /**
      * Reads data from the given BIO into a direct {@link java.nio.ByteBuffer}.
      */
@@ -1539,11 +2091,27 @@ public final class NativeCrypto {
      */
     static native byte[] Scrypt_generate_key(byte[] password, byte[] salt, int n, int r, int p, int key_len);
 
+    /**
+     * Generates the same key as {@link #Scrypt_generate_key(byte[], byte[], int, int, int, int)}
+     * with the {@code p} independent lanes spread over up to {@code maxThreads} native threads,
+     * as far as the memory limit allows. Scratch memory is kept per thread between calls.
+     */
+    static native byte[] Scrypt_generate_key(
+            byte[] password, byte[] salt, int n, int r, int p, int key_len, int maxThreads);
+
     /**
      * Return {@code true} if BoringSSL has been built in FIPS mode.
      */
     static native boolean usesBoringSsl_FIPS_mode();
 
+    /**
+     * Sets the minimum length at which digest, MAC and cipher updates from a {@code byte[]}
+     * process the array in place under {@code GetPrimitiveArrayCritical}, one bounded window at a
+     * time, instead of copying it into native memory first. 0 disables this, which is the
+     * default.
+     */
+    static native void setCriticalArrayThreshold(int threshold);
+
     /**
      * Used for testing only.
      */
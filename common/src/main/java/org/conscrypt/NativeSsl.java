@@ -149,6 +149,23 @@ final class NativeSsl {
     }
 
     X509Certificate[] getLocalCertificates() {
+        if (localCertificates == null && !isClient()) {
+            // A server whose certificate came from the native certificate map never saw it in
+            // Java, so fetch the chain that was installed.
+            lock.readLock().lock();
+            try {
+                if (!isClosed()) {
+                    byte[][] encoded = NativeCrypto.SSL_get_mapped_certificates(ssl, this);
+                    if (encoded != null) {
+                        localCertificates = SSLUtils.decodeX509CertificateChain(encoded);
+                    }
+                }
+            } catch (CertificateException e) {
+                // Cannot happen: the chain was encoded from X509Certificates.
+            } finally {
+                lock.readLock().unlock();
+            }
+        }
         return localCertificates;
     }
 
@@ -291,6 +308,9 @@ final class NativeSsl {
 
         // Set the local certs and private key.
         NativeCrypto.setLocalCertsAndPrivateKey(ssl, this, encodedLocalCerts, key.getNativeRef());
+        if (parameters.delegatePrivateKeyOperations) {
+            NativeCrypto.SSL_set_delegated_private_key(ssl, this, key.getNativeRef());
+        }
     }
 
     String getVersion() {
@@ -362,6 +382,9 @@ final class NativeSsl {
         if (!isClient() && parameters.applicationProtocolSelector != null) {
             NativeCrypto.setHasApplicationProtocolSelector(ssl, this, true);
         }
+        if (!isClient() && parameters.hasSNIMatchers()) {
+            NativeCrypto.setHasSniMatchers(ssl, this, true);
+        }
 
         // setup server certificates and private keys.
         // clients will receive a call back to request certificates.
@@ -379,13 +402,21 @@ final class NativeSsl {
 
         enablePSKKeyManagerIfRequested();
 
-        if (parameters.useSessionTickets) {
+        // Servers with shared ticket keys use tickets even if they weren't enabled explicitly:
+        // installing the keys is how they opt in.
+        // Early data rides on TLS 1.3 session tickets, so enabling it enables them too.
+        if (parameters.useSessionTickets || parameters.earlyDataEnabled
+                || (!isClient() && parameters.getSessionContext().hasTicketKeys())) {
             NativeCrypto.SSL_clear_options(ssl, this, SSL_OP_NO_TICKET);
         } else {
             NativeCrypto.SSL_set_options(
                     ssl, this, NativeCrypto.SSL_get_options(ssl, this) | SSL_OP_NO_TICKET);
         }
 
+        if (parameters.earlyDataEnabled) {
+            NativeCrypto.SSL_set_early_data_enabled(ssl, this, true);
+        }
+
         if (parameters.getUseSni() && AddressUtils.isValidSniHostname(hostname)) {
             NativeCrypto.SSL_set_tlsext_host_name(ssl, this, hostname);
         }
@@ -397,6 +428,12 @@ final class NativeSsl {
         if (!parameters.isSpake()) {
           setCertificateValidation();
         }
+
+        byte[] verifiedChainCacheIdentity =
+                VerifiedChainCache.identityFor(parameters, isClient(), hostname);
+        if (verifiedChainCacheIdentity != null) {
+            NativeCrypto.setVerifiedChainCacheIdentity(ssl, this, verifiedChainCacheIdentity);
+        }
         setTlsChannelId(channelIdPrivateKey);
     }
 
@@ -452,6 +489,22 @@ final class NativeSsl {
         }
     }
 
+    /**
+     * Advances the handshake without waiting for {@code fd}; see {@link
+     * NativeCrypto#SSL_do_handshake_nonblocking}.
+     */
+    int doHandshakeNonBlocking(FileDescriptor fd) throws CertificateException, IOException {
+        lock.readLock().lock();
+        try {
+            if (isClosed() || fd == null || !fd.valid()) {
+                throw new SocketException("Socket is closed");
+            }
+            return NativeCrypto.SSL_do_handshake_nonblocking(ssl, this, fd, handshakeCallbacks);
+        } finally {
+            lock.readLock().unlock();
+        }
+    }
+
     int doHandshake() throws IOException {
         lock.readLock().lock();
         try {
@@ -461,6 +514,69 @@ final class NativeSsl {
         }
     }
 
+    /**
+     * Runs the private-key operation the handshake is waiting for. Holding the read lock keeps
+     * the SSL from being freed while a slow key is working, without blocking other callers.
+     */
+    void doDelegatedKeyOperation() throws SSLException {
+        lock.readLock().lock();
+        try {
+            if (isClosed()) {
+                throw new SSLException("Connection closed");
+            }
+            NativeCrypto.SSL_do_delegated_key_operation(ssl, this);
+        } finally {
+            lock.readLock().unlock();
+        }
+    }
+
+    boolean isInEarlyData() {
+        lock.readLock().lock();
+        try {
+            return !isClosed() && NativeCrypto.SSL_in_early_data(ssl, this);
+        } finally {
+            lock.readLock().unlock();
+        }
+    }
+
+    boolean isEarlyDataAccepted() {
+        lock.readLock().lock();
+        try {
+            return !isClosed() && NativeCrypto.SSL_early_data_accepted(ssl, this);
+        } finally {
+            lock.readLock().unlock();
+        }
+    }
+
+    String getEarlyDataStatus() {
+        lock.readLock().lock();
+        try {
+            return isClosed() ? null : NativeCrypto.SSL_get_early_data_reason(ssl, this);
+        } finally {
+            lock.readLock().unlock();
+        }
+    }
+
+    void resetEarlyDataReject() {
+        lock.readLock().lock();
+        try {
+            if (!isClosed()) {
+                NativeCrypto.SSL_reset_early_data_reject(ssl, this);
+            }
+        } finally {
+            lock.readLock().unlock();
+        }
+    }
+
+    boolean isDelegatedKeyOperationPending() {
+        lock.readLock().lock();
+        try {
+            return !isClosed() && NativeCrypto.SSL_delegated_key_operation_pending(ssl, this);
+        } finally {
+            lock.readLock().unlock();
+        }
+    }
+
     // TODO(nathanmittler): Remove once after we switch to the engine socket.
     int read(FileDescriptor fd, byte[] buf, int offset, int len, int timeoutMillis)
             throws IOException {
@@ -491,6 +607,39 @@ final class NativeSsl {
         }
     }
 
+    /**
+     * Reads without waiting for {@code fd}; see {@link NativeCrypto#SSL_read_nonblocking}. Used
+     * when readiness is driven by a shared {@link NativeCrypto#SSL_poller_new poller}.
+     */
+    int readNonBlocking(FileDescriptor fd, byte[] buf, int offset, int len) throws IOException {
+        lock.readLock().lock();
+        try {
+            if (isClosed() || fd == null || !fd.valid()) {
+                throw new SocketException("Socket is closed");
+            }
+            return NativeCrypto.SSL_read_nonblocking(
+                    ssl, this, fd, handshakeCallbacks, buf, offset, len);
+        } finally {
+            lock.readLock().unlock();
+        }
+    }
+
+    /**
+     * Writes without waiting for {@code fd}; see {@link NativeCrypto#SSL_write_nonblocking}.
+     */
+    int writeNonBlocking(FileDescriptor fd, byte[] buf, int offset, int len) throws IOException {
+        lock.readLock().lock();
+        try {
+            if (isClosed() || fd == null || !fd.valid()) {
+                throw new SocketException("Socket is closed");
+            }
+            return NativeCrypto.SSL_write_nonblocking(
+                    ssl, this, fd, handshakeCallbacks, buf, offset, len);
+        } finally {
+            lock.readLock().unlock();
+        }
+    }
+
     @SuppressWarnings("deprecation") // PSKKeyManager is deprecated, but in our own package
     private void enablePSKKeyManagerIfRequested() throws SSLException {
         // Enable Pre-Shared Key (PSK) key exchange if requested
@@ -571,6 +720,22 @@ final class NativeSsl {
         NativeCrypto.SSL_interrupt(ssl, this);
     }
 
+    /**
+     * Hands the established connection on {@code fd} to kernel TLS and returns the mask of
+     * {@code NativeCrypto.KTLS_*} directions offloaded, 0 if none could be.
+     */
+    int enableKernelTls(FileDescriptor fd) {
+        lock.readLock().lock();
+        try {
+            if (isClosed()) {
+                return 0;
+            }
+            return NativeCrypto.SSL_enable_ktls(ssl, this, fd);
+        } finally {
+            lock.readLock().unlock();
+        }
+    }
+
     // TODO(nathanmittler): Remove once after we switch to the engine socket.
     void shutdown(FileDescriptor fd) throws IOException {
         NativeCrypto.SSL_shutdown(ssl, this, fd, handshakeCallbacks);
@@ -624,6 +789,17 @@ final class NativeSsl {
         }
     }
 
+    int writeDirectByteBuffers(long[] sourceAddresses, int[] sourceLengths, int count)
+            throws IOException {
+        lock.readLock().lock();
+        try {
+            return NativeCrypto.ENGINE_SSL_write_direct_vec(
+                    ssl, this, sourceAddresses, sourceLengths, count, handshakeCallbacks);
+        } finally {
+            lock.readLock().unlock();
+        }
+    }
+
     void forceRead() throws IOException {
         lock.readLock().lock();
         try {
@@ -645,6 +821,22 @@ final class NativeSsl {
         }
     }
 
+    /**
+     * Returns this connection's performance counters, indexed by the
+     * {@code NativeCrypto.SSL_COUNTER_*} constants, or {@code null} once it has been closed.
+     */
+    long[] getCounters() throws SSLException {
+        lock.readLock().lock();
+        try {
+            if (isClosed()) {
+                return null;
+            }
+            return NativeCrypto.SSL_get_counters(ssl, this);
+        } finally {
+            lock.readLock().unlock();
+        }
+    }
+
     int getMaxSealOverhead() {
         return NativeCrypto.SSL_max_seal_overhead(ssl, this);
     }
@@ -720,6 +912,20 @@ final class NativeSsl {
             }
         }
 
+        int writeDirectByteBuffers(long[] addresses, int[] lengths, int count)
+                throws IOException {
+            lock.readLock().lock();
+            try {
+                if (isClosed()) {
+                    throw new SSLException("Connection closed");
+                }
+                return NativeCrypto.ENGINE_SSL_write_BIO_direct_vec(
+                        ssl, NativeSsl.this, bio, addresses, lengths, count, handshakeCallbacks);
+            } finally {
+                lock.readLock().unlock();
+            }
+        }
+
         int readDirectByteBuffer(long destAddress, int destLength) throws IOException {
             lock.readLock().lock();
             try {
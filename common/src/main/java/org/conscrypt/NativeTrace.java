@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package org.conscrypt;
+
+/**
+ * Low-overhead tracing of native TLS events, which can be switched on in a running process,
+ * for example to capture a latency incident in production. Each native thread records compact
+ * binary events into its own ring buffer of a few hundred kilobytes, overwriting its oldest
+ * events when full. While a category is off its events cost a single memory load.
+ *
+ * <p>{@link #dump()} returns the recorded events for offline tools to decode, and
+ * {@link #dumpPcap()} returns the {@link #CATEGORY_PACKETS} events as a pcap capture that
+ * Wireshark can read.
+ */
+@ExperimentalApi
+public final class NativeTrace {
+    /** SSL creation and destruction, and handshakes. */
+    public static final int CATEGORY_SSL = 1;
+    /** Application data reads and writes. */
+    public static final int CATEGORY_IO = 1 << 1;
+    /**
+     * TLS records passing through the network buffers of engine-based connections, with their
+     * first 1024 bytes. Only the record framing and, before TLS 1.3 encryption starts, the
+     * handshake messages are in the clear.
+     */
+    public static final int CATEGORY_PACKETS = 1 << 2;
+    /** Calls from the native handshake into Java, such as certificate verification. */
+    public static final int CATEGORY_CALLBACKS = 1 << 3;
+    /** Every category. */
+    public static final int CATEGORY_ALL =
+            CATEGORY_SSL | CATEGORY_IO | CATEGORY_PACKETS | CATEGORY_CALLBACKS;
+
+    /** An SSL was created. Args: the address of its SSL_CTX. */
+    public static final int EVENT_SSL_NEW = 1;
+    /** An SSL was freed. */
+    public static final int EVENT_SSL_FREE = 2;
+    /** A call to SSL_do_handshake is starting. */
+    public static final int EVENT_HANDSHAKE_START = 3;
+    /** A call to SSL_do_handshake returned. Args: its result, then SSL_get_error. */
+    public static final int EVENT_HANDSHAKE_DONE = 4;
+    /** Application data was read. Args: the bytes requested, then the result. */
+    public static final int EVENT_READ = 5;
+    /** Application data was written. Args: the bytes offered, then the result. */
+    public static final int EVENT_WRITE = 6;
+    /**
+     * Bytes passed through the network buffer. Args: their length, then {@code 'I'} or
+     * {@code 'O'}. Data: the first 1024 bytes.
+     */
+    public static final int EVENT_PACKET = 7;
+    /** A callback into Java is starting. Args: the callback, as its call counter index. */
+    public static final int EVENT_UPCALL_START = 8;
+    /** A callback into Java returned. Args: the callback, then its duration in nanoseconds. */
+    public static final int EVENT_UPCALL_DONE = 9;
+
+    private NativeTrace() {}
+
+    /**
+     * Starts recording the events of the given categories, a mask of {@code CATEGORY_*}
+     * values, and stops recording the others. Passing 0 stops tracing; events already recorded
+     * are kept until {@link #clear()}.
+     */
+    public static void setCategories(int categories) {
+        Conscrypt.checkAvailability();
+        NativeCrypto.setTraceCategories(categories);
+    }
+
+    /**
+     * Returns the categories being recorded.
+     */
+    public static int getCategories() {
+        Conscrypt.checkAvailability();
+        return NativeCrypto.getTraceCategories();
+    }
+
+    /**
+     * Drops every event recorded so far.
+     */
+    public static void clear() {
+        Conscrypt.checkAvailability();
+        NativeCrypto.clearTrace();
+    }
+
+    /**
+     * Returns every event currently recorded, oldest first. All values are little-endian. The
+     * 24-byte header holds the magic {@code CTRC}, a 32-bit format version of 1, the signed
+     * 64-bit offset in nanoseconds from event timestamps to Unix time, the 32-bit event count
+     * and 4 reserved bytes. Each event follows as a 64-bit monotonic timestamp in nanoseconds,
+     * the 64-bit SSL address or 0, a 32-bit thread id, a 16-bit {@code EVENT_*} id, a 16-bit
+     * data length and four 64-bit args, then the data padded to a multiple of 8 bytes.
+     */
+    public static byte[] dump() {
+        Conscrypt.checkAvailability();
+        return NativeCrypto.dumpTrace();
+    }
+
+    /**
+     * Returns the {@link #EVENT_PACKET} events currently recorded as a pcap file of IPv4/TCP
+     * packets, one TCP stream per connection, with {@code 'O'} bytes sent from port 443.
+     * Records longer than 1024 bytes appear truncated.
+     */
+    public static byte[] dumpPcap() {
+        Conscrypt.checkAvailability();
+        return NativeCrypto.dumpTracePcap();
+    }
+}
@@ -89,6 +89,18 @@ public abstract class OpenSSLAeadCipher extends OpenSSLCipher {
      */
     int tagLengthInBytes;
 
+    /**
+     * Native AEAD context initialized with {@link #aeadCtxKey}. It is kept across
+     * operations for as long as the key, AEAD and tag length stay the same, so that the key
+     * schedule only has to be computed once per key.
+     */
+    private NativeRef.EVP_AEAD_CTX aeadCtx;
+
+    /**
+     * The key {@link #aeadCtx} was initialized with.
+     */
+    private byte[] aeadCtxKey;
+
     protected OpenSSLAeadCipher(Mode mode) {
         super(mode, Padding.NOPADDING);
     }
@@ -165,12 +177,19 @@ public abstract class OpenSSLAeadCipher extends OpenSSLCipher {
 
         checkSupportedTagLength(tagLenBits);
 
-        tagLengthInBytes = tagLenBits / 8;
+        final int newTagLengthInBytes = tagLenBits / 8;
+        final long newEvpAead = getEVP_AEAD(encodedKey.length);
+        if (aeadCtx != null
+                && (newEvpAead != evpAead || newTagLengthInBytes != tagLengthInBytes
+                        || !arraysAreEqual(aeadCtxKey, encodedKey))) {
+            aeadCtx = null;
+            aeadCtxKey = null;
+        }
+        tagLengthInBytes = newTagLengthInBytes;
+        evpAead = newEvpAead;
 
         final boolean encrypting = isEncrypting();
 
-        evpAead = getEVP_AEAD(encodedKey.length);
-
         final int expectedIvLength = NativeCrypto.EVP_AEAD_nonce_length(evpAead);
         if (iv == null && expectedIvLength != 0) {
             if (!encrypting) {
@@ -329,17 +348,29 @@ public abstract class OpenSSLAeadCipher extends OpenSSLCipher {
         }
     }
 
+    /**
+     * Returns the native AEAD context for the current key, creating it on first use.
+     */
+    private NativeRef.EVP_AEAD_CTX getAeadCtx() {
+        if (aeadCtx == null) {
+            aeadCtx = new NativeRef.EVP_AEAD_CTX(
+                    NativeCrypto.EVP_AEAD_CTX_new(evpAead, encodedKey, tagLengthInBytes));
+            aeadCtxKey = encodedKey;
+        }
+        return aeadCtx;
+    }
+
     int doFinalInternal(ByteBuffer input, ByteBuffer output)
             throws ShortBufferException, IllegalBlockSizeException, BadPaddingException {
         checkInitialization();
         final int bytesWritten;
         try {
             if (isEncrypting()) {
-                bytesWritten = NativeCrypto.EVP_AEAD_CTX_seal_buf(
-                        evpAead, encodedKey, tagLengthInBytes, output, iv, input, aad);
+                bytesWritten = NativeCrypto.EVP_AEAD_CTX_seal_ctx_buf(
+                        getAeadCtx(), output, iv, input, aad);
             } else {
-                bytesWritten = NativeCrypto.EVP_AEAD_CTX_open_buf(
-                        evpAead, encodedKey, tagLengthInBytes, output, iv, input, aad);
+                bytesWritten = NativeCrypto.EVP_AEAD_CTX_open_ctx_buf(
+                        getAeadCtx(), output, iv, input, aad);
             }
         } catch (BadPaddingException e) {
             throwAEADBadTagExceptionIfAvailable(e.getMessage(), e.getCause());
@@ -358,11 +389,11 @@ public abstract class OpenSSLAeadCipher extends OpenSSLCipher {
         final int bytesWritten;
         try {
             if (isEncrypting()) {
-                bytesWritten = NativeCrypto.EVP_AEAD_CTX_seal(evpAead, encodedKey,
-                        tagLengthInBytes, output, outputOffset, iv, buf, 0, bufCount, aad);
+                bytesWritten = NativeCrypto.EVP_AEAD_CTX_seal_ctx(
+                        getAeadCtx(), output, outputOffset, iv, buf, 0, bufCount, aad);
             } else {
-                bytesWritten = NativeCrypto.EVP_AEAD_CTX_open(evpAead, encodedKey,
-                        tagLengthInBytes, output, outputOffset, iv, buf, 0, bufCount, aad);
+                bytesWritten = NativeCrypto.EVP_AEAD_CTX_open_ctx(
+                        getAeadCtx(), output, outputOffset, iv, buf, 0, bufCount, aad);
             }
         } catch (BadPaddingException e) {
             throwAEADBadTagExceptionIfAvailable(e.getMessage(), e.getCause());
@@ -16,6 +16,7 @@
 
 package org.conscrypt;
 
+import java.nio.ByteBuffer;
 import java.security.AlgorithmParameters;
 import java.security.InvalidAlgorithmParameterException;
 import java.security.InvalidKeyException;
@@ -161,6 +162,48 @@ public abstract class OpenSSLCipher extends CipherSpi {
     abstract int doFinalInternal(byte[] output, int outputOffset, int maximumLen)
             throws IllegalBlockSizeException, BadPaddingException, ShortBufferException;
 
+    /**
+     * Returns whether {@link #updateInternalDirect(ByteBuffer, ByteBuffer)} and
+     * {@link #doFinalInternalDirect(ByteBuffer)} are implemented, so direct buffers can be
+     * transformed in native memory instead of through arrays.
+     */
+    boolean supportsDirectBuffers() {
+        return false;
+    }
+
+    /**
+     * Like {@link #updateInternal(byte[], int, int, byte[], int, int)} for the remaining bytes of
+     * two direct buffers, which may share memory, e.g. for in-place operation. Advances both
+     * positions and returns the number of bytes written to {@code output}.
+     */
+    int updateInternalDirect(ByteBuffer input, ByteBuffer output) throws ShortBufferException {
+        throw new UnsupportedOperationException();
+    }
+
+    /**
+     * Like {@link #doFinalInternal(byte[], int, int)} into a direct buffer. Advances its position
+     * and returns the number of bytes written.
+     */
+    int doFinalInternalDirect(ByteBuffer output)
+            throws IllegalBlockSizeException, BadPaddingException, ShortBufferException {
+        throw new UnsupportedOperationException();
+    }
+
+    /**
+     * Returns the native address of the position of a direct buffer.
+     */
+    static long directAddress(ByteBuffer buffer) {
+        return NativeCrypto.getDirectBufferAddress(buffer) + buffer.position();
+    }
+
+    private boolean canUseDirectBuffers(ByteBuffer input, ByteBuffer output) {
+        // Direct buffers' contents can't always be accessed from JNI, in which case the
+        // superclass's copying implementation handles them.
+        return supportsDirectBuffers() && input.isDirect() && output.isDirect()
+                && !output.isReadOnly() && NativeCrypto.getDirectBufferAddress(input) != 0
+                && NativeCrypto.getDirectBufferAddress(output) != 0;
+    }
+
     /**
      * Returns the standard name for the particular algorithm.
      */
@@ -407,6 +450,36 @@ public abstract class OpenSSLCipher extends CipherSpi {
         return bytesWritten + doFinalInternal(output, outputOffset, maximumLen);
     }
 
+    @Override
+    protected int engineUpdate(ByteBuffer input, ByteBuffer output) throws ShortBufferException {
+        if (input == null || output == null || !canUseDirectBuffers(input, output)) {
+            return super.engineUpdate(input, output);
+        }
+        if (!input.hasRemaining()) {
+            return 0;
+        }
+        return updateInternalDirect(input, output);
+    }
+
+    @Override
+    protected int engineDoFinal(ByteBuffer input, ByteBuffer output) throws ShortBufferException,
+            IllegalBlockSizeException, BadPaddingException {
+        if (input == null || output == null || !canUseDirectBuffers(input, output)) {
+            return super.engineDoFinal(input, output);
+        }
+        final int maximumLen = getOutputSizeForFinal(input.remaining());
+        if (output.remaining() < maximumLen) {
+            throw new ShortBufferWithoutStackTraceException(
+                    "output buffer too small: " + output.remaining() + " < " + maximumLen);
+        }
+
+        int bytesWritten = 0;
+        if (input.hasRemaining()) {
+            bytesWritten = updateInternalDirect(input, output);
+        }
+        return bytesWritten + doFinalInternalDirect(output);
+    }
+
     @Override
     protected byte[] engineWrap(Key key) throws IllegalBlockSizeException, InvalidKeyException {
         try {
@@ -54,7 +54,7 @@ final class OpenSSLX509CRL extends X509CRL {
     private final Date thisUpdate;
     private final Date nextUpdate;
 
-    private OpenSSLX509CRL(long ctx) throws ParsingException {
+    OpenSSLX509CRL(long ctx) throws ParsingException {
         mContext = ctx;
         // The legacy X509 OpenSSL APIs don't validate ASN1_TIME structures until access, so
         // parse them here because this is the only time we're allowed to throw ParsingException
@@ -39,14 +39,12 @@ import java.security.spec.InvalidKeySpecException;
 import java.security.spec.X509EncodedKeySpec;
 import java.util.ArrayList;
 import java.util.Arrays;
-import java.util.Calendar;
 import java.util.Collection;
 import java.util.Collections;
 import java.util.Date;
 import java.util.HashSet;
 import java.util.List;
 import java.util.Set;
-import java.util.TimeZone;
 
 import javax.crypto.BadPaddingException;
 import javax.crypto.IllegalBlockSizeException;
@@ -66,19 +64,45 @@ public final class OpenSSLX509Certificate extends X509Certificate {
     private final Date notBefore;
     private final Date notAfter;
 
+    // Decoded up front with the validity dates and kept out of the serialized form; getters hand
+    // out copies of the arrays.
+    private final transient int version;
+    private final transient int exFlags;
+    private final transient int pathLen;
+    private final transient byte[] serialNumber;
+    private final transient byte[] issuer;
+    private final transient byte[] subject;
+    private final transient String sigAlgOid;
+    private final transient boolean[] keyUsage;
+    private final transient String[] extendedKeyUsage;
+    private final transient String[] criticalExtensionOids;
+    private final transient String[] nonCriticalExtensionOids;
+
+    private transient volatile X500Principal issuerPrincipal;
+    private transient volatile X500Principal subjectPrincipal;
+
     OpenSSLX509Certificate(long ctx) throws ParsingException {
         mContext = ctx;
         // The legacy X509 OpenSSL APIs don't validate ASN1_TIME structures until access, so
-        // parse them here because this is the only time we're allowed to throw ParsingException
-        notBefore = toDate(NativeCrypto.X509_get_notBefore(mContext, this));
-        notAfter = toDate(NativeCrypto.X509_get_notAfter(mContext, this));
-    }
-
-    private static Date toDate(long asn1time) throws ParsingException {
-        Calendar calendar = Calendar.getInstance(TimeZone.getTimeZone("UTC"));
-        calendar.set(Calendar.MILLISECOND, 0);
-        NativeCrypto.ASN1_TIME_to_Calendar(asn1time, calendar);
-        return calendar.getTime();
+        // parse them here because this is the only time we're allowed to throw ParsingException.
+        // The rest of the commonly used fields come back from the same call, which saves a JNI
+        // transition per getter when chains are walked during path building.
+        Object[] fields = NativeCrypto.get_X509_fields(mContext, this);
+        long[] longs = (long[]) fields[NativeCrypto.X509_FIELD_LONGS];
+        notBefore = new Date(longs[NativeCrypto.X509_LONG_NOT_BEFORE]);
+        notAfter = new Date(longs[NativeCrypto.X509_LONG_NOT_AFTER]);
+        version = (int) longs[NativeCrypto.X509_LONG_VERSION];
+        exFlags = (int) longs[NativeCrypto.X509_LONG_EX_FLAGS];
+        pathLen = (int) longs[NativeCrypto.X509_LONG_PATH_LEN];
+        serialNumber = (byte[]) fields[NativeCrypto.X509_FIELD_SERIAL_NUMBER];
+        issuer = (byte[]) fields[NativeCrypto.X509_FIELD_ISSUER];
+        subject = (byte[]) fields[NativeCrypto.X509_FIELD_SUBJECT];
+        sigAlgOid = (String) fields[NativeCrypto.X509_FIELD_SIG_ALG_OID];
+        keyUsage = (boolean[]) fields[NativeCrypto.X509_FIELD_KEY_USAGE];
+        extendedKeyUsage = (String[]) fields[NativeCrypto.X509_FIELD_EXT_KEY_USAGE];
+        criticalExtensionOids = (String[]) fields[NativeCrypto.X509_FIELD_CRITICAL_EXT_OIDS];
+        nonCriticalExtensionOids =
+                (String[]) fields[NativeCrypto.X509_FIELD_NON_CRITICAL_EXT_OIDS];
     }
 
     public static OpenSSLX509Certificate fromX509DerInputStream(InputStream is)
@@ -192,21 +216,16 @@ public final class OpenSSLX509Certificate extends X509Certificate {
 
     @Override
     public Set<String> getCriticalExtensionOIDs() {
-        String[] critOids =
-                NativeCrypto.get_X509_ext_oids(mContext, this, NativeCrypto.EXTENSION_TYPE_CRITICAL);
-
         /*
          * This API has a special case that if there are no extensions, we
          * should return null. So if we have no critical extensions, we'll check
          * non-critical extensions.
          */
-        if ((critOids.length == 0)
-                && (NativeCrypto.get_X509_ext_oids(mContext, this,
-                        NativeCrypto.EXTENSION_TYPE_NON_CRITICAL).length == 0)) {
+        if ((criticalExtensionOids.length == 0) && (nonCriticalExtensionOids.length == 0)) {
             return null;
         }
 
-        return new HashSet<>(Arrays.asList(critOids));
+        return new HashSet<>(Arrays.asList(criticalExtensionOids));
     }
 
     @Override
@@ -216,26 +235,21 @@ public final class OpenSSLX509Certificate extends X509Certificate {
 
     @Override
     public Set<String> getNonCriticalExtensionOIDs() {
-        String[] nonCritOids =
-                NativeCrypto.get_X509_ext_oids(mContext, this, NativeCrypto.EXTENSION_TYPE_NON_CRITICAL);
-
         /*
          * This API has a special case that if there are no extensions, we
          * should return null. So if we have no non-critical extensions, we'll
          * check critical extensions.
          */
-        if ((nonCritOids.length == 0)
-                && (NativeCrypto.get_X509_ext_oids(mContext, this,
-                        NativeCrypto.EXTENSION_TYPE_CRITICAL).length == 0)) {
+        if ((nonCriticalExtensionOids.length == 0) && (criticalExtensionOids.length == 0)) {
             return null;
         }
 
-        return new HashSet<>(Arrays.asList(nonCritOids));
+        return new HashSet<>(Arrays.asList(nonCriticalExtensionOids));
     }
 
     @Override
     public boolean hasUnsupportedCriticalExtension() {
-        return (NativeCrypto.get_X509_ex_flags(mContext, this) & NativeConstants.EXFLAG_CRITICAL) != 0;
+        return (exFlags & NativeConstants.EXFLAG_CRITICAL) != 0;
     }
 
     @Override
@@ -262,12 +276,12 @@ public final class OpenSSLX509Certificate extends X509Certificate {
 
     @Override
     public int getVersion() {
-        return (int) NativeCrypto.X509_get_version(mContext, this) + 1;
+        return version + 1;
     }
 
     @Override
     public BigInteger getSerialNumber() {
-        return new BigInteger(NativeCrypto.X509_get_serialNumber(mContext, this));
+        return new BigInteger(serialNumber);
     }
 
     @Override
@@ -318,7 +332,7 @@ public final class OpenSSLX509Certificate extends X509Certificate {
 
     @Override
     public String getSigAlgOID() {
-        return NativeCrypto.get_X509_sig_alg_oid(mContext, this);
+        return sigAlgOid;
     }
 
     @Override
@@ -338,27 +352,19 @@ public final class OpenSSLX509Certificate extends X509Certificate {
 
     @Override
     public boolean[] getKeyUsage() {
-        final boolean[] kusage = NativeCrypto.get_X509_ex_kusage(mContext, this);
-        if (kusage == null) {
+        if (keyUsage == null) {
             return null;
         }
 
-        if (kusage.length >= 9) {
-            return kusage;
-        }
-
-        final boolean[] resized = new boolean[9];
-        System.arraycopy(kusage, 0, resized, 0, kusage.length);
-        return resized;
+        return Arrays.copyOf(keyUsage, Math.max(keyUsage.length, 9));
     }
 
     @Override
     public int getBasicConstraints() {
-        if ((NativeCrypto.get_X509_ex_flags(mContext, this) & NativeConstants.EXFLAG_CA) == 0) {
+        if ((exFlags & NativeConstants.EXFLAG_CA) == 0) {
             return -1;
         }
 
-        final int pathLen = NativeCrypto.get_X509_ex_pathlen(mContext, this);
         if (pathLen == -1) {
             return Integer.MAX_VALUE;
         }
@@ -484,24 +490,31 @@ public final class OpenSSLX509Certificate extends X509Certificate {
 
     @Override
     public X500Principal getIssuerX500Principal() {
-        final byte[] issuer = NativeCrypto.X509_get_issuer_name(mContext, this);
-        return new X500Principal(issuer);
+        X500Principal principal = issuerPrincipal;
+        if (principal == null) {
+            principal = new X500Principal(issuer);
+            issuerPrincipal = principal;
+        }
+        return principal;
     }
 
     @Override
     public X500Principal getSubjectX500Principal() {
-        final byte[] subject = NativeCrypto.X509_get_subject_name(mContext, this);
-        return new X500Principal(subject);
+        X500Principal principal = subjectPrincipal;
+        if (principal == null) {
+            principal = new X500Principal(subject);
+            subjectPrincipal = principal;
+        }
+        return principal;
     }
 
     @Override
     public List<String> getExtendedKeyUsage() {
-        String[] extUsage = NativeCrypto.get_X509_ex_xkusage(mContext, this);
-        if (extUsage == null) {
+        if (extendedKeyUsage == null) {
             return null;
         }
 
-        return Arrays.asList(extUsage);
+        return Arrays.asList(extendedKeyUsage.clone());
     }
 
     private static Collection<List<?>> alternativeNameArrayToList(Object[][] altNameArray) {
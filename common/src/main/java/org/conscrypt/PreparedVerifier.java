@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package org.conscrypt;
+
+import java.security.InvalidKeyException;
+import java.security.PublicKey;
+import java.util.BitSet;
+
+/**
+ * An ECDSA or Ed25519 public key parsed once, for callers that check many signatures against a
+ * few long-lived keys, such as token issuers. Where a {@link java.security.Signature} decodes
+ * the key again on every {@code initVerify}, a prepared verifier keeps the decoded key and can
+ * check a whole batch of signatures in one call, spread over a small pool of native threads
+ * when the batch is large.
+ *
+ * <p>For ECDSA the signed input is the digest of the message, as for {@code NONEwithECDSA},
+ * and signatures are DER encoded. For Ed25519 the signed input is the message itself.
+ *
+ * <p>Instances are immutable and safe for use by any number of threads at once.
+ */
+@ExperimentalApi
+public final class PreparedVerifier {
+    private final String algorithm;
+    private final NativeRef.PREPARED_VERIFIER verifier;
+
+    private PreparedVerifier(String algorithm, NativeRef.PREPARED_VERIFIER verifier) {
+        this.algorithm = algorithm;
+        this.verifier = verifier;
+    }
+
+    /**
+     * Prepares {@code key}, which must be an EC or Ed25519 public key with an X.509 encoding.
+     */
+    public static PreparedVerifier create(PublicKey key) throws InvalidKeyException {
+        if (key == null) {
+            throw new InvalidKeyException("key == null");
+        }
+        byte[] encoded = key.getEncoded();
+        if (encoded == null || !"X.509".equals(key.getFormat())) {
+            throw new InvalidKeyException("Key must have an X.509 encoding");
+        }
+        return create(encoded);
+    }
+
+    /**
+     * Prepares the EC or Ed25519 public key in the X.509 SubjectPublicKeyInfo {@code encoded}.
+     */
+    public static PreparedVerifier create(byte[] encoded) throws InvalidKeyException {
+        if (encoded == null) {
+            throw new InvalidKeyException("encoded == null");
+        }
+        NativeRef.EVP_PKEY pkey;
+        try {
+            pkey = new NativeRef.EVP_PKEY(NativeCrypto.EVP_parse_public_key(encoded));
+        } catch (OpenSSLX509CertificateFactory.ParsingException e) {
+            throw new InvalidKeyException(e);
+        }
+        String algorithm;
+        int type = NativeCrypto.EVP_PKEY_type(pkey);
+        if (type == NativeConstants.EVP_PKEY_EC) {
+            algorithm = "EC";
+        } else if (type == NativeConstants.EVP_PKEY_ED25519) {
+            algorithm = "Ed25519";
+        } else {
+            throw new InvalidKeyException("Unsupported key type: " + type);
+        }
+        return new PreparedVerifier(
+                algorithm, new NativeRef.PREPARED_VERIFIER(NativeCrypto.PREPARED_VERIFIER_new(pkey)));
+    }
+
+    /**
+     * Returns {@code EC} or {@code Ed25519}.
+     */
+    public String getAlgorithm() {
+        return algorithm;
+    }
+
+    /**
+     * Returns whether {@code signature} is a valid signature of {@code input}.
+     */
+    public boolean verify(byte[] input, byte[] signature) {
+        return verify(new byte[][] {input}, new byte[][] {signature}).get(0);
+    }
+
+    /**
+     * Checks {@code signatures[i]} against {@code inputs[i]} for every {@code i}, and returns a
+     * set with bit {@code i} set when that signature is valid.
+     */
+    public BitSet verify(byte[][] inputs, byte[][] signatures) {
+        if (inputs.length != signatures.length) {
+            throw new IllegalArgumentException("inputs.length != signatures.length");
+        }
+        int count = inputs.length;
+        long total = 0;
+        for (int i = 0; i < count; i++) {
+            total += inputs[i].length + signatures[i].length;
+        }
+        if (total > Integer.MAX_VALUE) {
+            throw new IllegalArgumentException("Batch too large");
+        }
+        byte[] data = new byte[(int) total];
+        int[] ranges = new int[4 * count];
+        int offset = 0;
+        for (int i = 0; i < count; i++) {
+            offset = append(data, offset, inputs[i], ranges, 4 * i);
+            offset = append(data, offset, signatures[i], ranges, 4 * i + 2);
+        }
+        return BitSet.valueOf(
+                NativeCrypto.PREPARED_VERIFIER_verify_batch(verifier, data, ranges, count));
+    }
+
+    private static int append(byte[] data, int offset, byte[] src, int[] ranges, int index) {
+        System.arraycopy(src, 0, data, offset, src.length);
+        ranges[index] = offset;
+        ranges[index + 1] = src.length;
+        return offset + src.length;
+    }
+}
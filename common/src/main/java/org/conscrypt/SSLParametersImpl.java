@@ -107,6 +107,10 @@ final class SSLParametersImpl implements Cloneable {
     byte[] applicationProtocols = EmptyArray.BYTE;
     ApplicationProtocolSelectorAdapter applicationProtocolSelector;
     boolean useSessionTickets;
+    // engine-only. Whether private-key operations are handed out as delegated tasks.
+    boolean delegatePrivateKeyOperations;
+    // Whether TLS 1.3 early data (0-RTT) is offered by clients and accepted by servers.
+    boolean earlyDataEnabled;
     private Boolean useSni;
 
     /**
@@ -232,6 +236,8 @@ final class SSLParametersImpl implements Cloneable {
                 : sslParams.applicationProtocols.clone();
         this.applicationProtocolSelector = sslParams.applicationProtocolSelector;
         this.useSessionTickets = sslParams.useSessionTickets;
+        this.delegatePrivateKeyOperations = sslParams.delegatePrivateKeyOperations;
+        this.earlyDataEnabled = sslParams.earlyDataEnabled;
         this.useSni = sslParams.useSni;
         this.channelIdEnabled = sslParams.channelIdEnabled;
     }
@@ -437,6 +443,14 @@ final class SSLParametersImpl implements Cloneable {
         this.useSessionTickets = useSessionTickets;
     }
 
+    void setDelegatePrivateKeyOperations(boolean delegatePrivateKeyOperations) {
+        this.delegatePrivateKeyOperations = delegatePrivateKeyOperations;
+    }
+
+    void setEarlyDataEnabled(boolean earlyDataEnabled) {
+        this.earlyDataEnabled = earlyDataEnabled;
+    }
+
     /*
      * Whether connections using this SSL connection should use the TLS
      * extension Server Name Indication (SNI).
@@ -728,6 +742,10 @@ final class SSLParametersImpl implements Cloneable {
         return new ArrayList<>(sniMatchers);
     }
 
+    boolean hasSNIMatchers() {
+        return sniMatchers != null && !sniMatchers.isEmpty();
+    }
+
     void setSNIMatchers(Collection<SNIMatcher> sniMatchers) {
         this.sniMatchers = sniMatchers != null ? new ArrayList<>(sniMatchers) : null;
     }
@@ -30,6 +30,7 @@ public class ScryptKeySpec implements KeySpec {
     private final int blockSize;
     private final int parallelizationParameter;
     private final int keyOutputBits;
+    private final int maxThreads;
 
     public ScryptKeySpec(
             char[] password,
@@ -38,12 +39,30 @@ public class ScryptKeySpec implements KeySpec {
             int blockSize,
             int parallelizationParameter,
             int keyOutputBits) {
+        this(password, salt, costParameter, blockSize, parallelizationParameter, keyOutputBits,
+                0);
+    }
+
+    /**
+     * Like the other constructor, but opts into running the {@code parallelizationParameter}
+     * lanes of scrypt on up to {@code maxThreads} native worker threads. The derived key is the
+     * same. 0 keeps the default, which computes the key with BoringSSL on the calling thread.
+     */
+    public ScryptKeySpec(
+            char[] password,
+            byte[] salt,
+            int costParameter,
+            int blockSize,
+            int parallelizationParameter,
+            int keyOutputBits,
+            int maxThreads) {
         this.password = password;
         this.salt = salt;
         this.costParameter = costParameter;
         this.blockSize = blockSize;
         this.parallelizationParameter = parallelizationParameter;
         this.keyOutputBits = keyOutputBits;
+        this.maxThreads = maxThreads;
     }
 
     public char[] getPassword() {
@@ -69,4 +88,12 @@ public class ScryptKeySpec implements KeySpec {
     public int getKeyLength() {
         return keyOutputBits;
     }
+
+    /**
+     * Returns how many threads may run the scrypt lanes, or 0 to compute the key on the
+     * calling thread.
+     */
+    public int getMaxThreads() {
+        return maxThreads;
+    }
 }
@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package org.conscrypt;
+
+import java.security.InvalidKeyException;
+import java.security.PrivateKey;
+import java.security.cert.CertificateEncodingException;
+import java.security.cert.X509Certificate;
+
+/**
+ * A server certificate chain with its private key, encoded once into the form the native TLS
+ * stack uses, for {@link Conscrypt#setServerCredentials}. Servers hosting many names can hand
+ * these out per SNI host name without a {@link javax.net.ssl.X509KeyManager} call on every
+ * handshake.
+ *
+ * <p>Instances are immutable and may be shared by any number of contexts.
+ */
+@ExperimentalApi
+public final class ServerCredential {
+    private final X509Certificate[] chain;
+    private final NativeRef.SERVER_CREDENTIAL credential;
+
+    private ServerCredential(X509Certificate[] chain, NativeRef.SERVER_CREDENTIAL credential) {
+        this.chain = chain;
+        this.credential = credential;
+    }
+
+    /**
+     * Creates a credential for {@code chain}, leaf first, and its {@code privateKey}.
+     *
+     * @param chain the certificate chain to send, leaf first
+     * @param privateKey the private key of {@code chain[0]}
+     * @param ocspResponse the DER-encoded OCSP response to staple, or {@code null}
+     * @param signedCertificateTimestamps the SignedCertificateTimestampList extension to send,
+     *        or {@code null}
+     */
+    public static ServerCredential create(X509Certificate[] chain, PrivateKey privateKey,
+            byte[] ocspResponse, byte[] signedCertificateTimestamps) throws InvalidKeyException {
+        if (chain == null) {
+            throw new NullPointerException("chain == null");
+        }
+        if (chain.length == 0) {
+            throw new IllegalArgumentException("chain.length == 0");
+        }
+        if (privateKey == null) {
+            throw new NullPointerException("privateKey == null");
+        }
+        X509Certificate[] copy = chain.clone();
+        byte[][] encoded = new byte[copy.length][];
+        try {
+            for (int i = 0; i < copy.length; i++) {
+                encoded[i] = copy[i].getEncoded();
+            }
+        } catch (CertificateEncodingException e) {
+            throw new IllegalArgumentException("Cannot encode chain", e);
+        }
+        OpenSSLKey key =
+                OpenSSLKey.fromPrivateKeyForTLSStackOnly(privateKey, copy[0].getPublicKey());
+        return new ServerCredential(copy,
+                new NativeRef.SERVER_CREDENTIAL(NativeCrypto.SERVER_CREDENTIAL_new(
+                        encoded, key.getNativeRef(), ocspResponse, signedCertificateTimestamps)));
+    }
+
+    /**
+     * Returns the certificate chain, leaf first.
+     */
+    public X509Certificate[] getCertificateChain() {
+        return chain.clone();
+    }
+
+    NativeRef.SERVER_CREDENTIAL getNativeRef() {
+        return credential;
+    }
+}
@@ -16,6 +16,9 @@
 
 package org.conscrypt;
 
+import java.util.Arrays;
+import java.util.LinkedHashMap;
+import java.util.Map;
 import javax.net.ssl.SSLContext;
 
 /**
@@ -24,7 +27,11 @@ import javax.net.ssl.SSLContext;
  */
 @Internal
 public final class ServerSessionContext extends AbstractSessionContext {
+    /** Length of one session ticket key, see {@link #setTicketKeys(byte[][])}. */
+    static final int TICKET_KEY_LENGTH = 48;
+
     private SSLServerSessionCache persistentCache;
+    private volatile Map<String, ServerCredential> serverCredentials;
 
     ServerSessionContext() {
         super(100);
@@ -53,6 +60,72 @@ public final class ServerSessionContext extends AbstractSessionContext {
         this.persistentCache = persistentCache;
     }
 
+    /**
+     * Applications should not use this method. Instead use {@link
+     * Conscrypt#setServerSessionTicketKeys(SSLContext, byte[][])}.
+     */
+    public void setTicketKeys(byte[][] keys) {
+        if (keys == null) {
+            throw new NullPointerException("keys == null");
+        }
+        if (keys.length == 0) {
+            throw new IllegalArgumentException("keys.length == 0");
+        }
+        byte[] packed = new byte[keys.length * TICKET_KEY_LENGTH];
+        for (int i = 0; i < keys.length; i++) {
+            if (keys[i] == null || keys[i].length != TICKET_KEY_LENGTH) {
+                throw new IllegalArgumentException(
+                        "keys[" + i + "] must be " + TICKET_KEY_LENGTH + " bytes");
+            }
+            System.arraycopy(keys[i], 0, packed, i * TICKET_KEY_LENGTH, TICKET_KEY_LENGTH);
+        }
+        try {
+            installTicketKeys(packed);
+        } finally {
+            Arrays.fill(packed, (byte) 0);
+        }
+    }
+
+    /**
+     * Applications should not use this method. Instead use {@link
+     * Conscrypt#setServerCredentials(SSLContext, Map)}.
+     */
+    public void setServerCredentials(Map<String, ServerCredential> credentials) {
+        if (credentials == null) {
+            throw new NullPointerException("credentials == null");
+        }
+        Map<String, ServerCredential> copy = new LinkedHashMap<>(credentials);
+        String[] hostNames = new String[copy.size()];
+        long[] nativeCredentials = new long[copy.size()];
+        int i = 0;
+        for (Map.Entry<String, ServerCredential> entry : copy.entrySet()) {
+            if (entry.getKey() == null || entry.getValue() == null) {
+                throw new NullPointerException("credentials contains a null host name or value");
+            }
+            hostNames[i] = entry.getKey();
+            nativeCredentials[i] = entry.getValue().getNativeRef().address;
+            i++;
+        }
+        installCertificateMap(hostNames, nativeCredentials);
+        // The native map holds its own references; keeping the copy just ensures none of the
+        // credentials is finalized while it is being installed.
+        serverCredentials = copy;
+    }
+
+    /**
+     * Applications should not use this method. Instead use {@link
+     * Conscrypt#setServerSessionCacheParameters(SSLContext, int, int)}.
+     */
+    public void setNativeSessionCacheParameters(int maxEntries, int timeoutSeconds) {
+        if (maxEntries < 0) {
+            throw new IllegalArgumentException("maxEntries < 0");
+        }
+        if (timeoutSeconds < 0) {
+            throw new IllegalArgumentException("timeoutSeconds < 0");
+        }
+        configureNativeSessionCache(maxEntries, timeoutSeconds);
+    }
+
     @Override
     NativeSslSession getSessionFromPersistentCache(byte[] sessionId) {
         if (persistentCache != null) {
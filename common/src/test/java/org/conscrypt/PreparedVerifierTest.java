@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package org.conscrypt;
+
+import static org.conscrypt.TestUtils.decodeHex;
+import static org.junit.Assert.assertEquals;
+import static org.junit.Assert.assertFalse;
+import static org.junit.Assert.assertThrows;
+import static org.junit.Assert.assertTrue;
+
+import java.nio.charset.StandardCharsets;
+import java.security.InvalidKeyException;
+import java.security.KeyPair;
+import java.security.KeyPairGenerator;
+import java.security.MessageDigest;
+import java.security.Provider;
+import java.security.Signature;
+import java.util.BitSet;
+import org.junit.Test;
+import org.junit.runner.RunWith;
+import org.junit.runners.JUnit4;
+
+@RunWith(JUnit4.class)
+public class PreparedVerifierTest {
+    // RFC 8032 section 7.1, test 2.
+    private static final byte[] ED25519_SPKI = decodeHex("302a300506032b6570032100"
+            + "3d4017c3e843895a92b70aa74d1b7ebc9c982ccf2ec4968cc0cd55f12af4660c");
+    private static final byte[] ED25519_MESSAGE = decodeHex("72");
+    private static final byte[] ED25519_SIGNATURE = decodeHex(
+            "92a009a9f0d4cab8720e820b5f642540a2b27b5416503f8fb3762223ebdb69da"
+            + "085ac1e43e15996e458f3613d0f11d8c387b2eaeb4302aeeb00d291612bb0c00");
+
+    private final Provider conscryptProvider = TestUtils.getConscryptProvider();
+
+    @Test
+    public void ed25519KnownAnswer() throws Exception {
+        PreparedVerifier verifier = PreparedVerifier.create(ED25519_SPKI);
+        assertEquals("Ed25519", verifier.getAlgorithm());
+        assertTrue(verifier.verify(ED25519_MESSAGE, ED25519_SIGNATURE));
+
+        byte[] corrupted = ED25519_SIGNATURE.clone();
+        corrupted[10] ^= 1;
+        assertFalse(verifier.verify(ED25519_MESSAGE, corrupted));
+        assertFalse(verifier.verify(new byte[0], ED25519_SIGNATURE));
+        assertFalse(verifier.verify(ED25519_MESSAGE, new byte[63]));
+    }
+
+    @Test
+    public void ecdsaBatch() throws Exception {
+        KeyPairGenerator generator = KeyPairGenerator.getInstance("EC", conscryptProvider);
+        generator.initialize(256);
+        KeyPair keyPair = generator.generateKeyPair();
+        Signature signer = Signature.getInstance("SHA256withECDSA", conscryptProvider);
+        MessageDigest digest = MessageDigest.getInstance("SHA-256", conscryptProvider);
+
+        // Large enough to go through the worker pool, with every third signature broken.
+        int count = 100;
+        byte[][] digests = new byte[count][];
+        byte[][] signatures = new byte[count][];
+        BitSet expected = new BitSet();
+        for (int i = 0; i < count; i++) {
+            byte[] message = ("message " + i).getBytes(StandardCharsets.UTF_8);
+            signer.initSign(keyPair.getPrivate());
+            signer.update(message);
+            signatures[i] = signer.sign();
+            digests[i] = digest.digest(message);
+            if (i % 3 == 0) {
+                digests[i][0] ^= 1;
+            } else {
+                expected.set(i);
+            }
+        }
+
+        PreparedVerifier verifier = PreparedVerifier.create(keyPair.getPublic());
+        assertEquals("EC", verifier.getAlgorithm());
+        assertEquals(expected, verifier.verify(digests, signatures));
+        assertTrue(verifier.verify(digests[1], signatures[1]));
+        assertFalse(verifier.verify(digests[1], new byte[] {0x30, 0x00}));
+        assertEquals(new BitSet(), verifier.verify(new byte[0][], new byte[0][]));
+    }
+
+    @Test
+    public void invalidArguments() throws Exception {
+        assertThrows(InvalidKeyException.class, () -> PreparedVerifier.create((byte[]) null));
+        assertThrows(InvalidKeyException.class, () -> PreparedVerifier.create(new byte[10]));
+
+        KeyPairGenerator generator = KeyPairGenerator.getInstance("RSA", conscryptProvider);
+        generator.initialize(2048);
+        KeyPair rsa = generator.generateKeyPair();
+        assertThrows(InvalidKeyException.class, () -> PreparedVerifier.create(rsa.getPublic()));
+
+        PreparedVerifier verifier = PreparedVerifier.create(ED25519_SPKI);
+        assertThrows(IllegalArgumentException.class,
+                () -> verifier.verify(new byte[2][0], new byte[1][0]));
+    }
+}
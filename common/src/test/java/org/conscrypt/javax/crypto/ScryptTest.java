@@ -97,6 +97,17 @@ public final class ScryptTest {
         checkKeyIsUsableWithAes(aesKey);
     }
 
+    @Test
+    public void parallelLanesGiveTheSameKey() throws Exception {
+        SecretKeyFactory factory = SecretKeyFactory.getInstance(alias);
+
+        ScryptKeySpec spec = new ScryptKeySpec(TEST_PASSWORD, TEST_SALT,
+                TEST_COST, TEST_BLOCKSIZE, TEST_PARALLELIZATION, TEST_KEY_SIZE, 4);
+        assertEquals(4, spec.getMaxThreads());
+        SecretKey key = factory.generateSecret(spec);
+        assertArrayEquals(TEST_KEY, key.getEncoded());
+    }
+
     @Test
     public void duckTypingTest() throws Exception {
         SecretKeyFactory factory = SecretKeyFactory.getInstance(alias);
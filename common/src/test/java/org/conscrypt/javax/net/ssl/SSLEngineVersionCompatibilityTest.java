@@ -808,12 +808,12 @@ public class SSLEngineVersionCompatibilityTest {
     }
 
     // Splits a ByteArray into an array of ByteBuffers each no bigger than the specified size.
-    private ByteBuffer[] splitDataIntoBuffers(byte[] sourceData, int size) {
+    private ByteBuffer[] splitDataIntoBuffers(byte[] sourceData, int size, boolean direct) {
         int nbuf = ((sourceData.length - 1) / size) + 1;
         ByteBuffer[] buffers = new ByteBuffer[nbuf];
         int buffer = 0;
         for (int offset = 0; offset < sourceData.length; offset += size, buffer++) {
-            buffers[buffer] = ByteBuffer.allocate(size);
+            buffers[buffer] = direct ? ByteBuffer.allocateDirect(size) : ByteBuffer.allocate(size);
             int remaining = sourceData.length - offset;
             buffers[buffer].put(sourceData, offset, Math.min( remaining, size));
             buffers[buffer].flip();
@@ -826,14 +826,14 @@ public class SSLEngineVersionCompatibilityTest {
     // additional invalid buffers will be added to the start and end of the buffer array
     // in order to test the offset and length arguments of wrap().
     private void sendAppDataInMultipleBuffers(
-            SSLEngine src, SSLEngine dst, int dataSize, int bufferSize)
+            SSLEngine src, SSLEngine dst, int dataSize, int bufferSize, boolean direct)
             throws SSLException {
 
         // Generate random data and split into multiple.
         byte[] sourceData = new byte[dataSize];
         Random random = new Random(System.currentTimeMillis());
         random.nextBytes(sourceData);
-        ByteBuffer[] sourceBuffers = splitDataIntoBuffers(sourceData, bufferSize);
+        ByteBuffer[] sourceBuffers = splitDataIntoBuffers(sourceData, bufferSize, direct);
         int length = sourceBuffers.length;
 
         // Ensure there is no pending outbound data or encrypted data and handshaking is complete.
@@ -897,10 +897,30 @@ public class SSLEngineVersionCompatibilityTest {
 	    { 53, 512, 8192, appBufSize, appBufSize - 53, appBufSize + 53, 5 * appBufSize};
         for (int dataSize : dataSizes) {
             for (int bufSize : bufferSizes) {
-                sendAppDataInMultipleBuffers(pair.client, pair.server, dataSize, bufSize);
-                sendAppDataInMultipleBuffers(pair.server, pair.client, dataSize, bufSize);
-                sendAppDataInMultipleBuffers(pair.client, pair.server, dataSize, bufSize);
-                sendAppDataInMultipleBuffers(pair.server, pair.client, dataSize, bufSize);
+                sendAppDataInMultipleBuffers(pair.client, pair.server, dataSize, bufSize, false);
+                sendAppDataInMultipleBuffers(pair.server, pair.client, dataSize, bufSize, false);
+                sendAppDataInMultipleBuffers(pair.client, pair.server, dataSize, bufSize, false);
+                sendAppDataInMultipleBuffers(pair.server, pair.client, dataSize, bufSize, false);
+            }
+        }
+    }
+
+    /**
+     * Same as {@link #multipleBuffersOfDifferentSizes} but with direct buffers, which are
+     * gathered into a single record natively rather than copied first.
+     */
+    @Test
+    public void multipleDirectBuffersOfDifferentSizes() throws Exception {
+        TestSSLEnginePair pair = TestSSLEnginePair.create();
+        SSLSession session = pair.client.getSession();
+        int appBufSize = session.getApplicationBufferSize();
+
+        int[] dataSizes = new int[] { 12, 512, 555, 1500, 8192, appBufSize, 5 * appBufSize};
+        int[] bufferSizes = new int[] { 7, 53, 512, 8192, appBufSize - 53, appBufSize + 53};
+        for (int dataSize : dataSizes) {
+            for (int bufSize : bufferSizes) {
+                sendAppDataInMultipleBuffers(pair.client, pair.server, dataSize, bufSize, true);
+                sendAppDataInMultipleBuffers(pair.server, pair.client, dataSize, bufSize, true);
             }
         }
     }
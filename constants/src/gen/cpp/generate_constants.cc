@@ -61,6 +61,7 @@ int main(int argc, char **argv) {
 
   CONST(EVP_PKEY_RSA);
   CONST(EVP_PKEY_EC);
+  CONST(EVP_PKEY_ED25519);
 
   CONST(RSA_PKCS1_PADDING);
   CONST(RSA_NO_PADDING);
@@ -77,6 +78,8 @@ int main(int argc, char **argv) {
   CONST(SSL_ERROR_NONE);
   CONST(SSL_ERROR_WANT_READ);
   CONST(SSL_ERROR_WANT_WRITE);
+  CONST(SSL_ERROR_WANT_PRIVATE_KEY_OPERATION);
+  CONST(SSL_ERROR_EARLY_DATA_REJECTED);
   CONST(SSL_ERROR_ZERO_RETURN);
 
   CONST(TLS1_VERSION);
@@ -0,0 +1,162 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package org.conscrypt;
+
+import static org.conscrypt.TestUtils.readTestFile;
+import static org.junit.Assert.assertArrayEquals;
+import static org.junit.Assert.assertEquals;
+import static org.junit.Assert.assertNull;
+import static org.junit.Assert.fail;
+
+import java.io.File;
+import java.io.FileOutputStream;
+import java.io.IOException;
+import java.math.BigInteger;
+import java.nio.charset.StandardCharsets;
+import java.security.cert.CertificateParsingException;
+import java.security.cert.X509CRL;
+import java.security.cert.X509Certificate;
+import java.util.ArrayList;
+import java.util.Arrays;
+import java.util.List;
+import org.junit.After;
+import org.junit.Before;
+import org.junit.Test;
+import org.junit.runner.RunWith;
+import org.junit.runners.JUnit4;
+
+@RunWith(JUnit4.class)
+public class CertificateFileReaderTest {
+    // Revokes serial 7 at 2019-08-07T10:26:54Z.
+    private static final String CRL = "-----BEGIN X509 CRL-----\n"
+            + "MIIBUTCBuwIBATANBgkqhkiG9w0BAQsFADBVMQswCQYDVQQGEwJHQjEkMCIGA1UE\n"
+            + "ChMbQ2VydGlmaWNhdGUgVHJhbnNwYXJlbmN5IENBMQ4wDAYDVQQIEwVXYWxlczEQ\n"
+            + "MA4GA1UEBxMHRXJ3IFdlbhcNMTkwODA3MTAyNzEwWhcNMTkwOTA2MTAyNzEwWjAi\n"
+            + "MCACAQcXDTE5MDgwNzEwMjY1NFowDDAKBgNVHRUEAwoBAaAOMAwwCgYDVR0UBAMC\n"
+            + "AQIwDQYJKoZIhvcNAQELBQADgYEAzF/DLiIvZDX4FpSjNCnwKRblnhJLZ1NNBAHx\n"
+            + "cRbfFY3psobvbGGOjxzCQW/03gkngG5VrSfdVOLMmQDrAxpKqeYqFDj0HAenWugb\n"
+            + "CCHWAw8WN9XSJ4nGxdRiacG/5vEIx00ICUGCeGcnqWsSnFtagDtvry2c4MMexbSP\n"
+            + "nDN0LLg=\n"
+            + "-----END X509 CRL-----\n";
+    private static final long CRL_REVOCATION_MILLIS = 1565173614000L;
+
+    private File file;
+
+    @Before
+    public void setUp() throws Exception {
+        file = File.createTempFile("conscrypt", ".pem");
+    }
+
+    @After
+    public void tearDown() {
+        file.delete();
+    }
+
+    private void write(byte[]... parts) throws IOException {
+        try (FileOutputStream out = new FileOutputStream(file)) {
+            for (byte[] part : parts) {
+                out.write(part);
+            }
+        }
+    }
+
+    @Test
+    public void readsMixedBundle() throws Exception {
+        byte[] certPem = readTestFile("cert.pem");
+        byte[] caPem = readTestFile("ca-cert.pem");
+        OpenSSLX509Certificate cert = OpenSSLX509Certificate.fromX509PemInputStream(
+                TestUtils.openTestFile("cert.pem"));
+        OpenSSLX509Certificate ca = OpenSSLX509Certificate.fromX509PemInputStream(
+                TestUtils.openTestFile("ca-cert.pem"));
+        List<OpenSSLX509Certificate> chain = Arrays.asList(cert, ca);
+        byte[] pkcs7 = new OpenSSLX509CertPath(chain).getEncoded("PKCS7");
+
+        write("# Leading comment\n".getBytes(StandardCharsets.US_ASCII), certPem, caPem,
+                cert.getEncoded(), "\n".getBytes(StandardCharsets.US_ASCII), pkcs7);
+
+        List<X509Certificate> expected = new ArrayList<>();
+        expected.add(cert);
+        expected.add(ca);
+        expected.add(cert);
+        expected.add(cert);
+        expected.add(ca);
+        try (CertificateFileReader reader = CertificateFileReader.open(file)) {
+            assertEquals(expected, reader.readAllCertificates());
+            assertNull(reader.nextCertificate());
+        }
+    }
+
+    @Test
+    public void emptyFileHasNoEntries() throws Exception {
+        write();
+        try (CertificateFileReader reader = CertificateFileReader.open(file)) {
+            assertNull(reader.nextCertificate());
+            assertNull(reader.nextCrl());
+            assertEquals(-1, reader.visitNextCrl((serial, millis) -> true));
+        }
+    }
+
+    @Test
+    public void truncatedDerShouldFail() throws Exception {
+        byte[] der = OpenSSLX509Certificate.fromX509PemInputStream(
+                TestUtils.openTestFile("cert.pem")).getEncoded();
+        write(Arrays.copyOf(der, der.length - 1));
+        try (CertificateFileReader reader = CertificateFileReader.open(file)) {
+            reader.nextCertificate();
+            fail();
+        } catch (CertificateParsingException expected) {
+        }
+    }
+
+    @Test
+    public void readsCrlsAndVisitsEntries() throws Exception {
+        byte[] crl = CRL.getBytes(StandardCharsets.US_ASCII);
+        write(crl, crl);
+        try (CertificateFileReader reader = CertificateFileReader.open(file)) {
+            X509CRL parsed = reader.nextCrl();
+            BigInteger serial = parsed.getRevokedCertificates().iterator().next().getSerialNumber();
+
+            final List<byte[]> serials = new ArrayList<>();
+            final List<Long> dates = new ArrayList<>();
+            assertEquals(1, reader.visitNextCrl((serialNumber, revocationDateMillis) -> {
+                serials.add(serialNumber);
+                dates.add(revocationDateMillis);
+                return true;
+            }));
+            assertEquals(1, serials.size());
+            assertArrayEquals(serial.toByteArray(), serials.get(0));
+            assertEquals(CRL_REVOCATION_MILLIS, (long) dates.get(0));
+            assertEquals(parsed.getRevokedCertificates().iterator().next()
+                    .getRevocationDate().getTime(), (long) dates.get(0));
+
+            assertNull(reader.nextCrl());
+        }
+    }
+
+    @Test
+    public void closedReaderShouldFail() throws Exception {
+        write();
+        CertificateFileReader reader = CertificateFileReader.open(file);
+        reader.close();
+        reader.close();
+        try {
+            reader.nextCertificate();
+            fail();
+        } catch (IllegalStateException expected) {
+        }
+    }
+}
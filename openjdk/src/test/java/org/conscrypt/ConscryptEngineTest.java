@@ -24,6 +24,7 @@ import static org.conscrypt.TestUtils.newTextMessage;
 import static org.junit.Assert.assertArrayEquals;
 import static org.junit.Assert.assertEquals;
 import static org.junit.Assert.assertFalse;
+import static org.junit.Assert.assertNotNull;
 import static org.junit.Assert.assertNull;
 import static org.junit.Assert.assertTrue;
 import static org.mockito.ArgumentMatchers.same;
@@ -34,8 +35,10 @@ import java.io.IOException;
 import java.nio.ByteBuffer;
 import java.security.NoSuchAlgorithmException;
 import java.security.Provider;
+import java.security.SecureRandom;
 import java.util.ArrayList;
 import java.util.Arrays;
+import java.util.Collections;
 import java.util.List;
 import javax.net.ssl.SSLContext;
 import javax.net.ssl.SSLEngine;
@@ -239,6 +242,316 @@ public class ConscryptEngineTest {
                 TestKeyStore.getClient(), TestKeyStore.getClient(), ClientAuth.REQUIRED);
     }
 
+    @Test
+    public void delegatedPrivateKeyOperationShouldRunOnAnotherThread() throws Exception {
+        setupEngines(TestKeyStore.getClient(), TestKeyStore.getServer());
+        Conscrypt.setDelegatePrivateKeyOperations(serverEngine, true);
+        clientEngine.beginHandshake();
+        serverEngine.beginHandshake();
+
+        // The ClientHello is all the server needs before it has to sign.
+        ByteBuffer clientHello =
+                bufferType.newBuffer(clientEngine.getSession().getPacketBufferSize());
+        clientEngine.wrap(ByteBuffer.allocate(0), clientHello);
+        clientHello.flip();
+        ByteBuffer serverApplicationBuffer =
+                bufferType.newBuffer(serverEngine.getSession().getApplicationBufferSize());
+        SSLEngineResult result = serverEngine.unwrap(clientHello, serverApplicationBuffer);
+        assertEquals(HandshakeStatus.NEED_TASK, result.getHandshakeStatus());
+        assertEquals(HandshakeStatus.NEED_TASK, serverEngine.getHandshakeStatus());
+
+        Runnable task = serverEngine.getDelegatedTask();
+        assertNotNull(task);
+        // Only one task is handed out per operation.
+        assertNull(serverEngine.getDelegatedTask());
+        Thread thread = new Thread(task);
+        thread.start();
+        thread.join();
+        assertNull(serverEngine.getDelegatedTask());
+        assertTrue(serverEngine.getHandshakeStatus() != HandshakeStatus.NEED_TASK);
+
+        doHandshake(false);
+        assertEquals(HandshakeStatus.NOT_HANDSHAKING, clientEngine.getHandshakeStatus());
+        assertEquals(HandshakeStatus.NOT_HANDSHAKING, serverEngine.getHandshakeStatus());
+        exchangeMessage(newMessage(MESSAGE_SIZE), clientEngine, serverEngine);
+    }
+
+    @Test
+    public void delegatedPrivateKeyOperationsWithClientAuthShouldSucceed() throws Exception {
+        setupEngines(TestKeyStore.getServer(), TestKeyStore.getServer());
+        ClientAuth.REQUIRED.apply(serverEngine);
+        Conscrypt.setDelegatePrivateKeyOperations(clientEngine, true);
+        Conscrypt.setDelegatePrivateKeyOperations(serverEngine, true);
+        doHandshake(true);
+        assertEquals(HandshakeStatus.NOT_HANDSHAKING, clientEngine.getHandshakeStatus());
+        assertEquals(HandshakeStatus.NOT_HANDSHAKING, serverEngine.getHandshakeStatus());
+        exchangeMessage(newMessage(MESSAGE_SIZE), serverEngine, clientEngine);
+    }
+
+    @Test
+    public void sharedTicketKeysShouldResumeAcrossContexts() throws Exception {
+        byte[] oldKey = newTicketKey();
+        byte[] newKey = newTicketKey();
+        SSLContext clientContext = newContext(getConscryptProvider(), TestKeyStore.getClient());
+
+        // Each server context stands in for a different server behind the same load balancer.
+        SSLContext first = newContext(getConscryptProvider(), TestKeyStore.getServer());
+        Conscrypt.setServerSessionTicketKeys(first, new byte[][] {oldKey});
+        doTls12Handshake(clientContext, first, true);
+        assertEquals(0, resumedHandshakes(first));
+
+        // A server that rotated to a new key still accepts tickets under the previous one.
+        SSLContext rotated = newContext(getConscryptProvider(), TestKeyStore.getServer());
+        Conscrypt.setServerSessionTicketKeys(rotated, new byte[][] {newKey, oldKey});
+        doTls12Handshake(clientContext, rotated, true);
+        assertEquals(1, resumedHandshakes(rotated));
+
+        SSLContext unrelated = newContext(getConscryptProvider(), TestKeyStore.getServer());
+        Conscrypt.setServerSessionTicketKeys(unrelated, new byte[][] {newTicketKey()});
+        doTls12Handshake(clientContext, unrelated, true);
+        assertEquals(0, resumedHandshakes(unrelated));
+    }
+
+    @Test(expected = IllegalArgumentException.class)
+    public void ticketKeysWithWrongLengthShouldFail() throws Exception {
+        SSLContext context = newContext(getConscryptProvider(), TestKeyStore.getServer());
+        Conscrypt.setServerSessionTicketKeys(context, new byte[][] {new byte[32]});
+    }
+
+    @Test
+    public void nativeServerSessionCacheShouldResumeWithoutJavaCache() throws Exception {
+        SSLContext clientContext = newContext(getConscryptProvider(), TestKeyStore.getClient());
+        SSLContext serverContext = newContext(getConscryptProvider(), TestKeyStore.getServer());
+        Conscrypt.setServerSessionCacheParameters(serverContext, 10, 0);
+
+        doTls12Handshake(clientContext, serverContext, false);
+        doTls12Handshake(clientContext, serverContext, false);
+        assertEquals(1, resumedHandshakes(serverContext));
+        // The session never reached the Java cache.
+        assertFalse(serverContext.getServerSessionContext().getIds().hasMoreElements());
+    }
+
+    @Test(expected = IllegalArgumentException.class)
+    public void nativeServerSessionCacheWithNegativeSizeShouldFail() throws Exception {
+        SSLContext context = newContext(getConscryptProvider(), TestKeyStore.getServer());
+        Conscrypt.setServerSessionCacheParameters(context, -1, 0);
+    }
+
+    private void doTls12Handshake(SSLContext clientContext, SSLContext serverContext,
+            boolean useSessionTickets) throws SSLException {
+        // TLS 1.2 so that tickets are issued within the handshake and session IDs are used
+        // without them.
+        String[] protocols = new String[] {"TLSv1.2"};
+        clientEngine = clientContext.createSSLEngine("localhost", 443);
+        clientEngine.setUseClientMode(true);
+        clientEngine.setEnabledProtocols(protocols);
+        Conscrypt.setUseSessionTickets(clientEngine, useSessionTickets);
+        serverEngine = serverContext.createSSLEngine();
+        serverEngine.setUseClientMode(false);
+        serverEngine.setEnabledProtocols(protocols);
+        doHandshake(true);
+    }
+
+    private static byte[] newTicketKey() {
+        byte[] key = new byte[48];
+        new SecureRandom().nextBytes(key);
+        return key;
+    }
+
+    private static long resumedHandshakes(SSLContext serverContext) {
+        AbstractSessionContext sessionContext =
+                (AbstractSessionContext) serverContext.getServerSessionContext();
+        return sessionContext.getCounters()[NativeCrypto.SSL_COUNTER_RESUMED_HANDSHAKES];
+    }
+
+    @Test
+    public void earlyDataEnabledConnectionsShouldExchangeMessages() throws Exception {
+        SSLContext clientContext = newContext(getConscryptProvider(), TestKeyStore.getClient());
+        SSLContext serverContext = newContext(getConscryptProvider(), TestKeyStore.getServer());
+        // The second connection resumes the session of the first one.
+        for (int i = 0; i < 2; i++) {
+            clientEngine = clientContext.createSSLEngine("localhost", 443);
+            clientEngine.setUseClientMode(true);
+            Conscrypt.setEarlyDataEnabled(clientEngine, true);
+            serverEngine = serverContext.createSSLEngine();
+            serverEngine.setUseClientMode(false);
+            Conscrypt.setEarlyDataEnabled(serverEngine, true);
+            doHandshake(true);
+
+            assertFalse(Conscrypt.isInEarlyData(clientEngine));
+            assertFalse(Conscrypt.isInEarlyData(serverEngine));
+            assertNotNull(Conscrypt.getEarlyDataStatus(serverEngine));
+            exchangeMessage(newMessage(MESSAGE_SIZE), serverEngine, clientEngine);
+            exchangeMessage(newMessage(MESSAGE_SIZE), clientEngine, serverEngine);
+        }
+    }
+
+    @Test
+    public void earlyDataShouldBeAcceptedOnResumption() throws Exception {
+        SSLContext clientContext = newContext(getConscryptProvider(), TestKeyStore.getClient());
+        SSLContext serverContext = newContext(getConscryptProvider(), TestKeyStore.getServer());
+        establishEarlyDataSession(clientContext, serverContext);
+
+        EarlyDataListener listener = setupEarlyDataEngines(clientContext, serverContext, true);
+        ByteBuffer earlyData = newMessage(MESSAGE_SIZE);
+        byte[] earlyDataBytes = toArray(earlyData);
+        ByteBuffer clientPacketBuffer = wrapEarlyData(earlyData);
+        ByteBuffer serverApplicationBuffer =
+                bufferType.newBuffer(serverEngine.getSession().getApplicationBufferSize());
+        finishEarlyDataHandshake(clientPacketBuffer, serverApplicationBuffer);
+
+        // The server handed out the early data before the client's Finished arrived.
+        serverApplicationBuffer.flip();
+        assertArrayEquals(earlyDataBytes, toArray(serverApplicationBuffer));
+        assertEquals(Collections.singletonList(true), listener.resolutions);
+        assertEquals("accepted", Conscrypt.getEarlyDataStatus(clientEngine));
+        assertEquals("accepted", Conscrypt.getEarlyDataStatus(serverEngine));
+        exchangeMessage(newMessage(MESSAGE_SIZE), serverEngine, clientEngine);
+    }
+
+    @Test
+    public void rejectedEarlyDataShouldBeReportedAndDiscarded() throws Exception {
+        SSLContext clientContext = newContext(getConscryptProvider(), TestKeyStore.getClient());
+        SSLContext serverContext = newContext(getConscryptProvider(), TestKeyStore.getServer());
+        establishEarlyDataSession(clientContext, serverContext);
+
+        // The ticket allows early data, but this server no longer accepts it.
+        EarlyDataListener listener = setupEarlyDataEngines(clientContext, serverContext, false);
+        ByteBuffer earlyData = newMessage(MESSAGE_SIZE);
+        ByteBuffer clientPacketBuffer = wrapEarlyData(earlyData);
+        ByteBuffer serverApplicationBuffer =
+                bufferType.newBuffer(serverEngine.getSession().getApplicationBufferSize());
+        finishEarlyDataHandshake(clientPacketBuffer, serverApplicationBuffer);
+
+        assertEquals(0, serverApplicationBuffer.position());
+        assertEquals(Collections.singletonList(false), listener.resolutions);
+        assertEquals("peer_declined", Conscrypt.getEarlyDataStatus(clientEngine));
+        // Written again after the rejection, the data arrives as ordinary application data.
+        earlyData.rewind();
+        exchangeMessage(earlyData, clientEngine, serverEngine);
+    }
+
+    @Test
+    public void replayedEarlyDataShouldBeMarkedAsEarlyData() throws Exception {
+        SSLContext clientContext = newContext(getConscryptProvider(), TestKeyStore.getClient());
+        SSLContext serverContext = newContext(getConscryptProvider(), TestKeyStore.getServer());
+        establishEarlyDataSession(clientContext, serverContext);
+
+        setupEarlyDataEngines(clientContext, serverContext, true);
+        ByteBuffer earlyData = newMessage(MESSAGE_SIZE);
+        byte[] earlyDataBytes = toArray(earlyData);
+        ByteBuffer clientFlight = wrapEarlyData(earlyData);
+        clientFlight.flip();
+
+        // An attacker replaying the client's first flight to another server gets the early
+        // data processed again. The server can't tell, which is why it is flagged.
+        for (int i = 0; i < 2; i++) {
+            SSLEngine replayServer = serverContext.createSSLEngine();
+            replayServer.setUseClientMode(false);
+            Conscrypt.setEarlyDataEnabled(replayServer, true);
+            replayServer.beginHandshake();
+            ByteBuffer replay = clientFlight.duplicate();
+            ByteBuffer applicationBuffer =
+                    bufferType.newBuffer(replayServer.getSession().getApplicationBufferSize());
+            ByteBuffer sink = bufferType.newBuffer(replayServer.getSession().getPacketBufferSize());
+            while (replay.hasRemaining()) {
+                SSLEngineResult result = replayServer.unwrap(replay, applicationBuffer);
+                assertEquals(SSLEngineResult.Status.OK, result.getStatus());
+                if (result.getHandshakeStatus() == HandshakeStatus.NEED_WRAP) {
+                    sink.clear();
+                    replayServer.wrap(ByteBuffer.allocate(0), sink);
+                } else {
+                    assertTrue(result.bytesConsumed() > 0);
+                }
+            }
+            assertTrue(Conscrypt.isInEarlyData(replayServer));
+            applicationBuffer.flip();
+            assertArrayEquals(earlyDataBytes, toArray(applicationBuffer));
+        }
+    }
+
+    /**
+     * Runs a full handshake with early data enabled on both sides, so that the client's session
+     * context holds a ticket that allows early data.
+     */
+    private void establishEarlyDataSession(SSLContext clientContext, SSLContext serverContext)
+            throws Exception {
+        setupEarlyDataEngines(clientContext, serverContext, true);
+        doHandshake(true);
+        assertEquals("no_session_offered", Conscrypt.getEarlyDataStatus(clientEngine));
+        // The TLS 1.3 ticket arrives after the handshake, with the first server data.
+        exchangeMessage(newMessage(MESSAGE_SIZE), serverEngine, clientEngine);
+    }
+
+    private EarlyDataListener setupEarlyDataEngines(
+            SSLContext clientContext, SSLContext serverContext, boolean serverEarlyData) {
+        clientEngine = clientContext.createSSLEngine("localhost", 443);
+        clientEngine.setUseClientMode(true);
+        Conscrypt.setEarlyDataEnabled(clientEngine, true);
+        EarlyDataListener listener = new EarlyDataListener();
+        Conscrypt.setHandshakeListener(clientEngine, listener);
+        serverEngine = serverContext.createSSLEngine();
+        serverEngine.setUseClientMode(false);
+        Conscrypt.setEarlyDataEnabled(serverEngine, serverEarlyData);
+        return listener;
+    }
+
+    /**
+     * Starts the client's handshake and wraps {@code earlyData} before the server has replied,
+     * returning the ClientHello and the early data records in a buffer ready for more writes.
+     */
+    private ByteBuffer wrapEarlyData(ByteBuffer earlyData) throws SSLException {
+        clientEngine.beginHandshake();
+        serverEngine.beginHandshake();
+        ByteBuffer clientPacketBuffer =
+                bufferType.newBuffer(clientEngine.getSession().getPacketBufferSize());
+        while (earlyData.hasRemaining()) {
+            SSLEngineResult result = clientEngine.wrap(earlyData, clientPacketBuffer);
+            assertEquals(SSLEngineResult.Status.OK, result.getStatus());
+            assertTrue(result.bytesConsumed() > 0);
+        }
+        assertTrue(Conscrypt.isInEarlyData(clientEngine));
+        return clientPacketBuffer;
+    }
+
+    private void finishEarlyDataHandshake(
+            ByteBuffer clientPacketBuffer, ByteBuffer serverApplicationBuffer) throws SSLException {
+        ByteBuffer clientApplicationBuffer =
+                bufferType.newBuffer(clientEngine.getSession().getApplicationBufferSize());
+        ByteBuffer serverPacketBuffer =
+                bufferType.newBuffer(serverEngine.getSession().getPacketBufferSize());
+        TestUtils.doEngineHandshake(clientEngine, serverEngine, clientApplicationBuffer,
+                clientPacketBuffer, serverApplicationBuffer, serverPacketBuffer, false);
+        assertFalse(Conscrypt.isInEarlyData(clientEngine));
+        assertFalse(Conscrypt.isInEarlyData(serverEngine));
+    }
+
+    private static final class EarlyDataListener extends HandshakeListener {
+        final List<Boolean> resolutions = new ArrayList<Boolean>();
+
+        @Override
+        public void onHandshakeFinished() {}
+
+        @Override
+        public void onEarlyDataResolved(boolean accepted) {
+            resolutions.add(accepted);
+        }
+    }
+
+    @Test(expected = IllegalStateException.class)
+    public void earlyDataAfterHandshakeStartShouldFail() throws Exception {
+        setupEngines(TestKeyStore.getClient(), TestKeyStore.getServer());
+        clientEngine.beginHandshake();
+        Conscrypt.setEarlyDataEnabled(clientEngine, true);
+    }
+
+    @Test(expected = IllegalStateException.class)
+    public void delegatedPrivateKeyOperationsAfterHandshakeStartShouldFail() throws Exception {
+        setupEngines(TestKeyStore.getClient(), TestKeyStore.getServer());
+        serverEngine.beginHandshake();
+        Conscrypt.setDelegatePrivateKeyOperations(serverEngine, true);
+    }
+
     @Test
     public void exchangeMessages() throws Exception {
         setupEngines(TestKeyStore.getClient(), TestKeyStore.getServer());
@@ -85,6 +85,7 @@ import org.junit.runners.Suite;
         AddressUtilsTest.class,
         ApplicationProtocolSelectorAdapterTest.class,
         ArrayUtilsTest.class,
+        CertificateFileReaderTest.class,
         CertPinManagerTest.class,
         ChainStrengthAnalyzerTest.class,
         ClientSessionContextTest.class,
@@ -106,6 +107,7 @@ import org.junit.runners.Suite;
         OpenSSLKeyTest.class,
         OpenSSLX509CertificateTest.class,
         PlatformTest.class,
+        PreparedVerifierTest.class,
         SSLUtilsTest.class,
         ServerSessionContextTest.class,
         TestSessionBuilderTest.class,
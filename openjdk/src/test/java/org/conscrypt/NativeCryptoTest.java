@@ -26,9 +26,11 @@ import static org.conscrypt.NativeConstants.SSL_VERIFY_PEER;
 import static org.conscrypt.NativeConstants.TLS1_1_VERSION;
 import static org.conscrypt.NativeConstants.TLS1_2_VERSION;
 import static org.conscrypt.NativeConstants.TLS1_VERSION;
+import static org.conscrypt.TestUtils.isLinux;
 import static org.conscrypt.TestUtils.isWindows;
 import static org.conscrypt.TestUtils.openTestFile;
 import static org.conscrypt.TestUtils.readTestFile;
+import static org.junit.Assert.assertArrayEquals;
 import static org.junit.Assert.assertEquals;
 import static org.junit.Assert.assertFalse;
 import static org.junit.Assert.assertNotEquals;
@@ -37,6 +39,7 @@ import static org.junit.Assert.assertNull;
 import static org.junit.Assert.assertTrue;
 import static org.junit.Assert.fail;
 import static org.junit.Assume.assumeFalse;
+import static org.junit.Assume.assumeTrue;
 import static org.mockito.ArgumentMatchers.same;
 import static org.mockito.Mockito.when;
 
@@ -50,11 +53,16 @@ import java.net.ServerSocket;
 import java.net.Socket;
 import java.net.SocketException;
 import java.net.SocketTimeoutException;
+import java.nio.BufferOverflowException;
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
 import java.nio.charset.StandardCharsets;
 import java.security.KeyPair;
 import java.security.KeyPairGenerator;
 import java.security.KeyStore;
 import java.security.KeyStore.PrivateKeyEntry;
+import java.security.MessageDigest;
+import java.security.NoSuchAlgorithmException;
 import java.security.cert.Certificate;
 import java.security.cert.CertificateEncodingException;
 import java.security.cert.CertificateException;
@@ -68,6 +76,8 @@ import java.util.Arrays;
 import java.util.Collections;
 import java.util.HashSet;
 import java.util.List;
+import java.util.Random;
+import java.util.Set;
 import java.util.concurrent.Callable;
 import java.util.concurrent.ExecutionException;
 import java.util.concurrent.ExecutorService;
@@ -381,6 +391,31 @@ public class NativeCryptoTest {
         NativeCrypto.SSL_CTX_free(c, null);
     }
 
+    @Test
+    public void setLocalCertsAndPrivateKey_looksUpCertificatesInSharedPool() throws Exception {
+        long c1 = NativeCrypto.SSL_CTX_new();
+        long c2 = NativeCrypto.SSL_CTX_new();
+        long s1 = NativeCrypto.SSL_new(c1, null);
+        long s2 = NativeCrypto.SSL_new(c2, null);
+        try {
+            NativeCrypto.setLocalCertsAndPrivateKey(
+                    s1, null, ENCODED_SERVER_CERTIFICATES, SERVER_PRIVATE_KEY.getNativeRef());
+            long[] before = NativeCrypto.CRYPTO_BUFFER_POOL_get_stats();
+            NativeCrypto.setLocalCertsAndPrivateKey(
+                    s2, null, ENCODED_SERVER_CERTIFICATES, SERVER_PRIVATE_KEY.getNativeRef());
+            long[] after = NativeCrypto.CRYPTO_BUFFER_POOL_get_stats();
+
+            assertEquals(ENCODED_SERVER_CERTIFICATES.length,
+                    after[NativeCrypto.CRYPTO_BUFFER_POOL_STAT_REQUESTS]
+                            - before[NativeCrypto.CRYPTO_BUFFER_POOL_STAT_REQUESTS]);
+        } finally {
+            NativeCrypto.SSL_free(s2, null);
+            NativeCrypto.SSL_free(s1, null);
+            NativeCrypto.SSL_CTX_free(c2, null);
+            NativeCrypto.SSL_CTX_free(c1, null);
+        }
+    }
+
     @Test(expected = NullPointerException.class)
     public void SSL_set1_tls_channel_id_withNullChannelShouldThrow() throws Exception {
         NativeCrypto.SSL_set1_tls_channel_id(NULL, null, null);
@@ -430,6 +465,32 @@ public class NativeCryptoTest {
         NativeCrypto.SSL_set_mode(NULL, null, 0);
     }
 
+    @Test
+    public void test_SSL_BIO_new_transportBuffer() throws Exception {
+        long c = NativeCrypto.SSL_CTX_new();
+        long s = NativeCrypto.SSL_new(c, null);
+        long bio = NativeCrypto.SSL_BIO_new(s, null);
+        assertEquals(0, NativeCrypto.SSL_pending_written_bytes_in_BIO(bio));
+
+        ByteBuffer buffer = ByteBuffer.allocateDirect(17 * 1024 + 1);
+        long address = NativeCrypto.getDirectBufferAddress(buffer);
+        // A write the transport can't hold in full is refused rather than split.
+        assertEquals(0, NativeCrypto.ENGINE_SSL_write_BIO_direct(
+                s, null, bio, address, buffer.capacity(), DUMMY_CB));
+        assertEquals(1024, NativeCrypto.ENGINE_SSL_write_BIO_direct(
+                s, null, bio, address, 1024, DUMMY_CB));
+        assertEquals(16 * 1024, NativeCrypto.ENGINE_SSL_write_BIO_direct(
+                s, null, bio, address, 16 * 1024, DUMMY_CB));
+        assertEquals(0, NativeCrypto.ENGINE_SSL_write_BIO_direct(
+                s, null, bio, address, 1024, DUMMY_CB));
+        // Nothing has been written towards the network yet.
+        assertEquals(0, NativeCrypto.SSL_pending_written_bytes_in_BIO(bio));
+
+        NativeCrypto.BIO_free_all(bio);
+        NativeCrypto.SSL_free(s, null);
+        NativeCrypto.SSL_CTX_free(c, null);
+    }
+
     @Test
     public void test_SSL_set_mode_and_clear_mode() throws Exception {
         long c = NativeCrypto.SSL_CTX_new();
@@ -997,6 +1058,43 @@ public class NativeCryptoTest {
         return future;
     }
 
+    @Test
+    public void test_SSL_poller_reportsReadiness() throws Exception {
+        assumeTrue(isLinux());
+        assumeTrue(m_Platform_getFileDescriptor != null);
+        ServerSocket listener = newServerSocket();
+        Socket client = new Socket(listener.getInetAddress(), listener.getLocalPort());
+        Socket server = listener.accept();
+        long poller = NativeCrypto.SSL_poller_new();
+        try {
+            FileDescriptor fd =
+                    (FileDescriptor) m_Platform_getFileDescriptor.invoke(null, server);
+            long[] tokens = new long[4];
+            int[] events = new int[4];
+
+            NativeCrypto.SSL_poller_arm(poller, fd, 42, NativeCrypto.SSL_POLLER_READ);
+            assertEquals(0, NativeCrypto.SSL_poller_wait(poller, tokens, events, 10));
+
+            client.getOutputStream().write(1);
+            assertEquals(1, NativeCrypto.SSL_poller_wait(poller, tokens, events, 5000));
+            assertEquals(42, tokens[0]);
+            assertTrue((events[0] & NativeCrypto.SSL_POLLER_READ) != 0);
+
+            // Registrations are one-shot until they are armed again.
+            assertEquals(0, NativeCrypto.SSL_poller_wait(poller, tokens, events, 10));
+
+            NativeCrypto.SSL_poller_wakeup(poller);
+            assertEquals(0, NativeCrypto.SSL_poller_wait(poller, tokens, events, 5000));
+
+            NativeCrypto.SSL_poller_remove(poller, fd);
+        } finally {
+            NativeCrypto.SSL_poller_free(poller);
+            client.close();
+            server.close();
+            listener.close();
+        }
+    }
+
     @Test(expected = NullPointerException.class)
     public void test_SSL_do_handshake_NULL_SSL() throws Exception {
         NativeCrypto.SSL_do_handshake(NULL, null, null, null, 0);
@@ -1058,6 +1156,234 @@ public class NativeCryptoTest {
         assertTrue(serverCallback.serverCertificateRequestedInvoked);
     }
 
+    @Test
+    public void test_SSL_do_handshake_verifiedChainCache() throws Exception {
+        final byte[] identity = new byte[] {1, 2, 3, 4};
+        NativeCrypto.setVerifiedChainCacheParameters(16, TimeUnit.MINUTES.toMillis(1));
+        try {
+            long[] before = NativeCrypto.getVerifiedChainCacheStats();
+            TestSSLHandshakeCallbacks[] clientCallbacks = new TestSSLHandshakeCallbacks[2];
+            for (int i = 0; i < clientCallbacks.length; i++) {
+                final ServerSocket listener = newServerSocket();
+                Hooks cHooks = new Hooks() {
+                    @Override
+                    public long beforeHandshake(long c) throws SSLException {
+                        long s = super.beforeHandshake(c);
+                        NativeCrypto.setVerifiedChainCacheIdentity(s, null, identity);
+                        return s;
+                    }
+                };
+                Hooks sHooks = new ServerHooks(SERVER_PRIVATE_KEY, ENCODED_SERVER_CERTIFICATES);
+                Future<TestSSLHandshakeCallbacks> client =
+                        handshake(listener, 0, true, cHooks, null, null);
+                Future<TestSSLHandshakeCallbacks> server =
+                        handshake(listener, 0, false, sHooks, null, null);
+                clientCallbacks[i] = client.get(TIMEOUT_SECONDS, TimeUnit.SECONDS);
+                server.get(TIMEOUT_SECONDS, TimeUnit.SECONDS);
+                assertTrue(clientCallbacks[i].handshakeCompletedCalled);
+            }
+            long[] after = NativeCrypto.getVerifiedChainCacheStats();
+
+            // The first handshake verifies in Java, the second one is answered by the cache.
+            assertTrue(clientCallbacks[0].verifyCertificateChainCalled);
+            assertFalse(clientCallbacks[1].verifyCertificateChainCalled);
+            assertEquals(1,
+                    after[NativeCrypto.VERIFIED_CHAIN_CACHE_STAT_HITS]
+                            - before[NativeCrypto.VERIFIED_CHAIN_CACHE_STAT_HITS]);
+
+            NativeCrypto.clearVerifiedChainCache();
+            assertEquals(0,
+                    NativeCrypto.getVerifiedChainCacheStats()
+                            [NativeCrypto.VERIFIED_CHAIN_CACHE_STAT_ENTRIES]);
+        } finally {
+            NativeCrypto.setVerifiedChainCacheParameters(0, 0);
+        }
+    }
+
+    @Test
+    public void test_SSL_get_counters() throws Exception {
+        final ServerSocket listener = newServerSocket();
+        final long[][] sslCounters = new long[2][];
+        final long[][] ctxCounters = new long[2][];
+        Hooks cHooks = new Hooks() {
+            @Override
+            public void afterHandshake(long session, long ssl, long context, Socket socket,
+                    FileDescriptor fd, SSLHandshakeCallbacks callback) throws Exception {
+                sslCounters[0] = NativeCrypto.SSL_get_counters(ssl, null);
+                ctxCounters[0] = NativeCrypto.SSL_CTX_get_counters(context, null);
+                super.afterHandshake(session, ssl, context, socket, fd, callback);
+            }
+        };
+        Hooks sHooks = new ServerHooks(SERVER_PRIVATE_KEY, ENCODED_SERVER_CERTIFICATES) {
+            @Override
+            public void afterHandshake(long session, long ssl, long context, Socket socket,
+                    FileDescriptor fd, SSLHandshakeCallbacks callback) throws Exception {
+                sslCounters[1] = NativeCrypto.SSL_get_counters(ssl, null);
+                ctxCounters[1] = NativeCrypto.SSL_CTX_get_counters(context, null);
+                super.afterHandshake(session, ssl, context, socket, fd, callback);
+            }
+        };
+        Future<TestSSLHandshakeCallbacks> client =
+                handshake(listener, 0, true, cHooks, null, null);
+        Future<TestSSLHandshakeCallbacks> server =
+                handshake(listener, 0, false, sHooks, null, null);
+        client.get(TIMEOUT_SECONDS, TimeUnit.SECONDS);
+        server.get(TIMEOUT_SECONDS, TimeUnit.SECONDS);
+
+        for (int i = 0; i < 2; i++) {
+            long[] counters = sslCounters[i];
+            assertEquals(NativeCrypto.SSL_COUNTER_COUNT, counters.length);
+            assertEquals(1, counters[NativeCrypto.SSL_COUNTER_FULL_HANDSHAKES]);
+            assertEquals(0, counters[NativeCrypto.SSL_COUNTER_RESUMED_HANDSHAKES]);
+            assertTrue(counters[NativeCrypto.SSL_COUNTER_HANDSHAKE_NANOS] > 0);
+            assertTrue(counters[NativeCrypto.SSL_COUNTER_RECORDS_SEALED] > 0);
+            assertTrue(counters[NativeCrypto.SSL_COUNTER_BYTES_SEALED] > 0);
+            assertTrue(counters[NativeCrypto.SSL_COUNTER_RECORDS_OPENED] > 0);
+            // The connection is the only one created from its context.
+            assertEquals(counters[NativeCrypto.SSL_COUNTER_FULL_HANDSHAKES],
+                    ctxCounters[i][NativeCrypto.SSL_COUNTER_FULL_HANDSHAKES]);
+        }
+        // Only the client verifies a peer chain.
+        assertEquals(1, sslCounters[0][NativeCrypto.SSL_COUNTER_CERT_VERIFY_CALLS]);
+        assertEquals(0, sslCounters[1][NativeCrypto.SSL_COUNTER_CERT_VERIFY_CALLS]);
+    }
+
+    @Test(expected = IllegalArgumentException.class)
+    public void setVerifiedChainCacheParameters_withNegativeSizeShouldThrow() throws Exception {
+        NativeCrypto.setVerifiedChainCacheParameters(-1, 1000);
+    }
+
+    @Test
+    public void test_publicKeyCache_sharesParsedKeys() throws Exception {
+        NativeRef.EC_GROUP group = new NativeRef.EC_GROUP(
+                NativeCrypto.EC_GROUP_new_by_curve_name("prime256v1"));
+        byte[] spki = NativeCrypto.EVP_marshal_public_key(
+                new NativeRef.EVP_PKEY(NativeCrypto.EC_KEY_generate_key(group)));
+        byte[] otherSpki = NativeCrypto.EVP_marshal_public_key(
+                new NativeRef.EVP_PKEY(NativeCrypto.EC_KEY_generate_key(group)));
+        byte[] spkiWithTrailingData = Arrays.copyOf(spki, spki.length + 3);
+
+        // Disabled by default.
+        NativeRef.EVP_PKEY uncached1 =
+                new NativeRef.EVP_PKEY(NativeCrypto.EVP_parse_public_key(spki));
+        NativeRef.EVP_PKEY uncached2 =
+                new NativeRef.EVP_PKEY(NativeCrypto.EVP_parse_public_key(spki));
+        assertNotEquals(uncached1.address, uncached2.address);
+
+        NativeCrypto.setPublicKeyCacheParameters(16);
+        try {
+            long[] before = NativeCrypto.getPublicKeyCacheStats();
+            NativeRef.EVP_PKEY first =
+                    new NativeRef.EVP_PKEY(NativeCrypto.EVP_parse_public_key(spki));
+            NativeRef.EVP_PKEY second =
+                    new NativeRef.EVP_PKEY(NativeCrypto.EVP_parse_public_key(spki));
+            NativeRef.EVP_PKEY trailing = new NativeRef.EVP_PKEY(
+                    NativeCrypto.EVP_parse_public_key(spkiWithTrailingData));
+            NativeRef.EVP_PKEY other =
+                    new NativeRef.EVP_PKEY(NativeCrypto.EVP_parse_public_key(otherSpki));
+            long[] after = NativeCrypto.getPublicKeyCacheStats();
+
+            assertEquals(first.address, second.address);
+            assertEquals(first.address, trailing.address);
+            assertNotEquals(first.address, other.address);
+            assertEquals(1, NativeCrypto.EVP_PKEY_cmp(first, second));
+            assertEquals(0, NativeCrypto.EVP_PKEY_cmp(first, other));
+            assertEquals(2, after[NativeCrypto.PUBLIC_KEY_CACHE_STAT_HITS]
+                            - before[NativeCrypto.PUBLIC_KEY_CACHE_STAT_HITS]);
+            assertEquals(2, after[NativeCrypto.PUBLIC_KEY_CACHE_STAT_ENTRIES]);
+            assertArrayEquals(spki, NativeCrypto.EVP_marshal_public_key(second));
+
+            // Dropping the table leaves keys already handed out usable.
+            NativeCrypto.clearPublicKeyCache();
+            long[] cleared = NativeCrypto.getPublicKeyCacheStats();
+            assertEquals(0, cleared[NativeCrypto.PUBLIC_KEY_CACHE_STAT_ENTRIES]);
+            assertArrayEquals(spki, NativeCrypto.EVP_marshal_public_key(first));
+        } finally {
+            NativeCrypto.setPublicKeyCacheParameters(0);
+        }
+    }
+
+    @Test(expected = IllegalArgumentException.class)
+    public void setPublicKeyCacheParameters_withNegativeSizeShouldThrow() throws Exception {
+        NativeCrypto.setPublicKeyCacheParameters(-1);
+    }
+
+    @Test
+    public void test_get_startup_timings() throws Exception {
+        long[] first = NativeCrypto.get_startup_timings();
+        assertEquals(NativeCrypto.STARTUP_TIMING_COUNT, first.length);
+        assertTrue(first[NativeCrypto.STARTUP_ON_LOAD_NANOS]
+                >= first[NativeCrypto.STARTUP_INIT_NANOS]
+                        + first[NativeCrypto.STARTUP_REGISTER_NANOS]);
+        assertTrue(first[NativeCrypto.STARTUP_NANOS_SINCE_LOAD]
+                >= first[NativeCrypto.STARTUP_ON_LOAD_NANOS]);
+
+        long[] second = NativeCrypto.get_startup_timings();
+        assertEquals(first[NativeCrypto.STARTUP_ON_LOAD_NANOS],
+                second[NativeCrypto.STARTUP_ON_LOAD_NANOS]);
+        assertTrue(second[NativeCrypto.STARTUP_NANOS_SINCE_LOAD]
+                >= first[NativeCrypto.STARTUP_NANOS_SINCE_LOAD]);
+        assertTrue(second[NativeCrypto.STARTUP_LAZY_RESOLUTIONS]
+                >= first[NativeCrypto.STARTUP_LAZY_RESOLUTIONS]);
+    }
+
+    @Test
+    public void test_trace_recordsSslLifecycle() throws Exception {
+        long c = NativeCrypto.SSL_CTX_new();
+        // Off by default, so nothing is recorded.
+        assertEquals(0, NativeCrypto.getTraceCategories());
+        NativeCrypto.clearTrace();
+        NativeCrypto.SSL_free(NativeCrypto.SSL_new(c, null), null);
+        assertEquals(0, ByteBuffer.wrap(NativeCrypto.dumpTrace())
+                                .order(ByteOrder.LITTLE_ENDIAN)
+                                .getInt(16));
+
+        NativeCrypto.setTraceCategories(NativeTrace.CATEGORY_SSL);
+        long s;
+        try {
+            assertEquals(NativeTrace.CATEGORY_SSL, NativeCrypto.getTraceCategories());
+            s = NativeCrypto.SSL_new(c, null);
+            NativeCrypto.SSL_free(s, null);
+        } finally {
+            NativeCrypto.setTraceCategories(0);
+            NativeCrypto.SSL_CTX_free(c, null);
+        }
+
+        ByteBuffer trace = ByteBuffer.wrap(NativeCrypto.dumpTrace()).order(ByteOrder.LITTLE_ENDIAN);
+        assertEquals("CTRC", new String(trace.array(), 0, 4, StandardCharsets.US_ASCII));
+        assertEquals(1, trace.getInt(4));
+        int count = trace.getInt(16);
+        trace.position(24);
+        boolean sawNew = false;
+        boolean sawFree = false;
+        for (int i = 0; i < count; i++) {
+            trace.getLong(); // timestamp
+            long ssl = trace.getLong();
+            trace.getInt(); // thread id
+            int event = trace.getShort();
+            int dataLength = trace.getShort();
+            long arg0 = trace.getLong();
+            trace.position(trace.position() + 24 + ((dataLength + 7) & ~7));
+            if (ssl == s && event == NativeTrace.EVENT_SSL_NEW) {
+                assertEquals(c, arg0);
+                sawNew = true;
+            } else if (ssl == s && event == NativeTrace.EVENT_SSL_FREE) {
+                sawFree = true;
+            }
+        }
+        assertTrue(sawNew);
+        assertTrue(sawFree);
+
+        NativeCrypto.clearTrace();
+        assertEquals(0, ByteBuffer.wrap(NativeCrypto.dumpTrace())
+                                .order(ByteOrder.LITTLE_ENDIAN)
+                                .getInt(16));
+        byte[] pcap = NativeCrypto.dumpTracePcap();
+        assertEquals(24, pcap.length);
+        assertArrayEquals(new byte[] {(byte) 0x4d, (byte) 0x3c, (byte) 0xb2, (byte) 0xa1},
+                Arrays.copyOf(pcap, 4));
+    }
+
     @Test
     public void test_SSL_do_handshake_reusedSession() throws Exception {
         // normal client and server case
@@ -2283,6 +2609,50 @@ public class NativeCryptoTest {
         }
     }
 
+    @Test
+    public void test_SSL_enable_ktls_withBufferedRecordKeepsBothDirectionsInUserSpace()
+            throws Exception {
+        assumeTrue(isLinux());
+        final ServerSocket listener = newServerSocket();
+
+        Hooks cHooks = new Hooks() {
+            @Override
+            public void afterHandshake(long session, long s, long c, Socket sock,
+                    FileDescriptor fd, SSLHandshakeCallbacks callback) throws Exception {
+                // Reading one byte leaves the rest of the record buffered in the SSL, so
+                // receive can't be offloaded. Send mustn't be either, or the records the SSL
+                // still writes itself would be encrypted twice.
+                byte[] in = new byte[BYTES.length];
+                assertEquals(1, NativeCrypto.SSL_read(s, null, fd, callback, in, 0, 1, 0));
+                assertEquals(0, NativeCrypto.SSL_enable_ktls(s, null, fd));
+
+                assertEquals(BYTES.length - 1, NativeCrypto.SSL_read(
+                        s, null, fd, callback, in, 1, BYTES.length - 1, 0));
+                assertArrayEquals(BYTES, in);
+                NativeCrypto.SSL_write(s, null, fd, callback, BYTES, 0, BYTES.length, 0);
+                super.afterHandshake(session, s, c, sock, fd, callback);
+            }
+        };
+        Hooks sHooks = new ServerHooks(SERVER_PRIVATE_KEY, ENCODED_SERVER_CERTIFICATES) {
+            @Override
+            public void afterHandshake(long session, long s, long c, Socket sock,
+                    FileDescriptor fd, SSLHandshakeCallbacks callback) throws Exception {
+                NativeCrypto.SSL_write(s, null, fd, callback, BYTES, 0, BYTES.length, 0);
+                byte[] in = new byte[BYTES.length];
+                assertEquals(BYTES.length,
+                        NativeCrypto.SSL_read(s, null, fd, callback, in, 0, BYTES.length, 0));
+                assertArrayEquals(BYTES, in);
+                super.afterHandshake(session, s, c, sock, fd, callback);
+            }
+        };
+        Future<TestSSLHandshakeCallbacks> client =
+                handshake(listener, 0, true, cHooks, null, null);
+        Future<TestSSLHandshakeCallbacks> server =
+                handshake(listener, 0, false, sHooks, null, null);
+        client.get(TIMEOUT_SECONDS, TimeUnit.SECONDS);
+        server.get(TIMEOUT_SECONDS, TimeUnit.SECONDS);
+    }
+
     @Test(expected = NullPointerException.class)
     public void SSL_write_withNullSslShouldThrow() throws Exception {
         NativeCrypto.SSL_write(NULL, null, null, null, null, 0, 0, 0);
@@ -2664,6 +3034,185 @@ public class NativeCryptoTest {
         NativeCrypto.RAND_bytes(null);
     }
 
+    @Test
+    public void test_RAND_bytes_smallRequestsAreDistinct() throws Exception {
+        for (boolean buffered : new boolean[] {false, true}) {
+            NativeCrypto.setRandomBufferingEnabled(buffered);
+            try {
+                // Enough 16-byte requests to run through several buffered blocks.
+                Set<String> seen = new HashSet<>();
+                for (int i = 0; i < 1000; i++) {
+                    byte[] output = new byte[16];
+                    NativeCrypto.RAND_bytes(output);
+                    assertTrue(seen.add(Arrays.toString(output)));
+                }
+
+                byte[] empty = new byte[0];
+                NativeCrypto.RAND_bytes(empty);
+            } finally {
+                NativeCrypto.setRandomBufferingEnabled(false);
+            }
+        }
+    }
+
+    @Test
+    public void test_RAND_bytes_direct() throws Exception {
+        NativeCrypto.setRandomBufferingEnabled(true);
+        try {
+            // Sizes on both sides of the buffered request limit.
+            for (int length : new int[] {0, 1, 12, 64, 65, 4096}) {
+                ByteBuffer buffer = ByteBuffer.allocateDirect(length + 2);
+                long address = NativeCrypto.getDirectBufferAddress(buffer);
+                NativeCrypto.RAND_bytes_direct(address + 1, length);
+
+                assertEquals(0, buffer.get(0));
+                assertEquals(0, buffer.get(length + 1));
+                if (length >= 16) {
+                    boolean isZero = true;
+                    for (int i = 1; i <= length; i++) {
+                        isZero &= (buffer.get(i) == 0);
+                    }
+                    assertFalse(isZero);
+                }
+            }
+        } finally {
+            NativeCrypto.setRandomBufferingEnabled(false);
+        }
+    }
+
+    @Test
+    public void test_RAND_bytes_direct_invalidArguments() throws Exception {
+        try {
+            NativeCrypto.RAND_bytes_direct(0, 16);
+            fail();
+        } catch (NullPointerException expected) {
+        }
+
+        ByteBuffer buffer = ByteBuffer.allocateDirect(16);
+        long address = NativeCrypto.getDirectBufferAddress(buffer);
+        try {
+            NativeCrypto.RAND_bytes_direct(address, -1);
+            fail();
+        } catch (IllegalArgumentException expected) {
+        }
+    }
+
+    @Test
+    public void test_EVP_AEAD_CTX_sealAndOpenWithContext() throws Exception {
+        long evpAead = NativeCrypto.EVP_aead_aes_128_gcm();
+        byte[] key = new byte[16];
+        byte[] nonce = new byte[NativeCrypto.EVP_AEAD_nonce_length(evpAead)];
+        byte[] aad = "additional data".getBytes(StandardCharsets.UTF_8);
+        byte[] plaintext = "plaintext".getBytes(StandardCharsets.UTF_8);
+        NativeCrypto.RAND_bytes(key);
+        NativeCrypto.RAND_bytes(nonce);
+
+        NativeRef.EVP_AEAD_CTX ctx =
+                new NativeRef.EVP_AEAD_CTX(NativeCrypto.EVP_AEAD_CTX_new(evpAead, key, 16));
+        int maxOverhead = NativeCrypto.EVP_AEAD_max_overhead(evpAead);
+
+        byte[] expected = new byte[plaintext.length + maxOverhead];
+        int expectedLength = NativeCrypto.EVP_AEAD_CTX_seal(evpAead, key, 16, expected, 0, nonce,
+                plaintext, 0, plaintext.length, aad);
+
+        // The same context can be used for several operations.
+        for (int i = 0; i < 3; i++) {
+            byte[] ciphertext = new byte[plaintext.length + maxOverhead];
+            int ciphertextLength = NativeCrypto.EVP_AEAD_CTX_seal_ctx(
+                    ctx, ciphertext, 0, nonce, plaintext, 0, plaintext.length, aad);
+            assertEquals(expectedLength, ciphertextLength);
+            assertArrayEquals(expected, ciphertext);
+
+            byte[] decrypted = new byte[ciphertextLength];
+            int decryptedLength = NativeCrypto.EVP_AEAD_CTX_open_ctx(
+                    ctx, decrypted, 0, nonce, ciphertext, 0, ciphertextLength, aad);
+            assertEquals(plaintext.length, decryptedLength);
+            assertArrayEquals(plaintext, Arrays.copyOf(decrypted, decryptedLength));
+        }
+    }
+
+    @Test
+    public void test_EVP_AEAD_CTX_sealAndOpenBatch() throws Exception {
+        long evpAead = NativeCrypto.EVP_aead_aes_128_gcm();
+        byte[] key = new byte[16];
+        NativeCrypto.RAND_bytes(key);
+        NativeRef.EVP_AEAD_CTX ctx =
+                new NativeRef.EVP_AEAD_CTX(NativeCrypto.EVP_AEAD_CTX_new(evpAead, key, 16));
+        int nonceLength = NativeCrypto.EVP_AEAD_nonce_length(evpAead);
+        int maxOverhead = NativeCrypto.EVP_AEAD_max_overhead(evpAead);
+
+        // Each record uses the layout [nonce | aad | plaintext | ciphertext].
+        int numRecords = 4;
+        int aadLength = 8;
+        int plaintextLength = 32;
+        int stride = nonceLength + aadLength + plaintextLength + plaintextLength + maxOverhead;
+        ByteBuffer buffer = ByteBuffer.allocateDirect(numRecords * stride);
+        byte[] data = new byte[buffer.capacity()];
+        NativeCrypto.RAND_bytes(data);
+        buffer.put(data);
+
+        int[] sealRecords = new int[numRecords * NativeCrypto.AEAD_BATCH_RECORD_SIZE];
+        int[] openRecords = new int[numRecords * NativeCrypto.AEAD_BATCH_RECORD_SIZE];
+        for (int i = 0; i < numRecords; i++) {
+            int nonceOffset = i * stride;
+            int aadOffset = nonceOffset + nonceLength;
+            int plaintextOffset = aadOffset + aadLength;
+            int ciphertextOffset = plaintextOffset + plaintextLength;
+            System.arraycopy(new int[] {plaintextOffset, plaintextLength, ciphertextOffset,
+                                     plaintextLength + maxOverhead, nonceOffset, nonceLength,
+                                     aadOffset, aadLength},
+                    0, sealRecords, i * NativeCrypto.AEAD_BATCH_RECORD_SIZE,
+                    NativeCrypto.AEAD_BATCH_RECORD_SIZE);
+            // Decrypt in place over the ciphertext.
+            System.arraycopy(new int[] {ciphertextOffset, plaintextLength + maxOverhead,
+                                     ciphertextOffset, plaintextLength + maxOverhead,
+                                     nonceOffset, nonceLength, aadOffset, aadLength},
+                    0, openRecords, i * NativeCrypto.AEAD_BATCH_RECORD_SIZE,
+                    NativeCrypto.AEAD_BATCH_RECORD_SIZE);
+        }
+
+        int[] outLengths = new int[numRecords];
+        assertEquals(numRecords,
+                NativeCrypto.EVP_AEAD_CTX_seal_batch(ctx, buffer, sealRecords, outLengths));
+        for (int i = 0; i < numRecords; i++) {
+            assertEquals(plaintextLength + maxOverhead, outLengths[i]);
+        }
+
+        // Corrupt the tag of the second record.
+        int corruptedTag = stride + nonceLength + aadLength + 2 * plaintextLength + 1;
+        buffer.put(corruptedTag, (byte) (buffer.get(corruptedTag) ^ 1));
+
+        assertEquals(numRecords - 1,
+                NativeCrypto.EVP_AEAD_CTX_open_batch(ctx, buffer, openRecords, outLengths));
+        for (int i = 0; i < numRecords; i++) {
+            if (i == 1) {
+                assertEquals(-1, outLengths[i]);
+                continue;
+            }
+            assertEquals(plaintextLength, outLengths[i]);
+            int plaintextOffset = i * stride + nonceLength + aadLength;
+            for (int j = 0; j < plaintextLength; j++) {
+                assertEquals(data[plaintextOffset + j],
+                        buffer.get(plaintextOffset + plaintextLength + j));
+            }
+        }
+    }
+
+    @Test(expected = ArrayIndexOutOfBoundsException.class)
+    public void EVP_AEAD_CTX_seal_batch_withOutOfBoundsRecordShouldThrow() throws Exception {
+        long evpAead = NativeCrypto.EVP_aead_aes_128_gcm();
+        NativeRef.EVP_AEAD_CTX ctx = new NativeRef.EVP_AEAD_CTX(
+                NativeCrypto.EVP_AEAD_CTX_new(evpAead, new byte[16], 16));
+        ByteBuffer buffer = ByteBuffer.allocateDirect(64);
+        int[] records = new int[] {0, 16, 16, 32, 48, 12, 60, 8};
+        NativeCrypto.EVP_AEAD_CTX_seal_batch(ctx, buffer, records, new int[1]);
+    }
+
+    @Test(expected = NullPointerException.class)
+    public void EVP_AEAD_CTX_new_withNullKeyShouldThrow() throws Exception {
+        NativeCrypto.EVP_AEAD_CTX_new(NativeCrypto.EVP_aead_aes_128_gcm(), null, 16);
+    }
+
     @Test(expected = NullPointerException.class)
     public void test_EVP_get_digestbyname_NullArgument() throws Exception {
         NativeCrypto.EVP_get_digestbyname(null);
@@ -2684,6 +3233,153 @@ public class NativeCryptoTest {
         assertTrue(NativeCrypto.EVP_get_digestbyname("sha256") != NULL);
     }
 
+    private static byte[] digestLargeArray(byte[] input, int offset, int length) {
+        NativeRef.EVP_MD_CTX ctx = new NativeRef.EVP_MD_CTX(NativeCrypto.EVP_MD_CTX_create());
+        NativeCrypto.EVP_DigestInit_ex(ctx, NativeCrypto.EVP_get_digestbyname("sha256"));
+        NativeCrypto.EVP_DigestUpdate(ctx, input, offset, length);
+        byte[] hash = new byte[32];
+        NativeCrypto.EVP_DigestFinal_ex(ctx, hash, 0);
+        return hash;
+    }
+
+    @Test
+    public void test_setCriticalArrayThreshold() throws Exception {
+        // Longer than one pinning window and not a multiple of it.
+        byte[] input = TestUtils.newTextMessage(3 * 256 * 1024 + 17);
+        int offset = 5;
+        int length = input.length - offset - 3;
+
+        byte[] copied = digestLargeArray(input, offset, length);
+        NativeCrypto.setCriticalArrayThreshold(1024);
+        try {
+            assertArrayEquals(copied, digestLargeArray(input, offset, length));
+        } finally {
+            NativeCrypto.setCriticalArrayThreshold(0);
+        }
+
+        try {
+            NativeCrypto.setCriticalArrayThreshold(-1);
+            fail();
+        } catch (IllegalArgumentException expected) {
+            // Expected.
+        }
+    }
+
+    private static void checkDigestBatch(String algorithm, int count, int messageSize)
+            throws Exception {
+        MessageDigest md = MessageDigest.getInstance(algorithm);
+        int mdSize = md.getDigestLength();
+        byte[] data = TestUtils.newTextMessage(count * messageSize + count);
+        int[] offsets = new int[count];
+        int[] lengths = new int[count];
+        for (int i = 0; i < count; i++) {
+            // Messages of varying length that skip a byte between each other.
+            offsets[i] = i * (messageSize + 1);
+            lengths[i] = messageSize - (i % 3);
+        }
+        ByteBuffer input = ByteBuffer.allocateDirect(data.length + 2);
+        input.position(2);
+        input.put(data);
+        input.position(2);
+        ByteBuffer output = ByteBuffer.allocateDirect(count * mdSize + 1);
+        output.position(1);
+
+        Conscrypt.digestBatch(algorithm, input, offsets, lengths, output);
+
+        assertEquals(2, input.position());
+        assertEquals(output.capacity(), output.position());
+        for (int i = 0; i < count; i++) {
+            md.update(data, offsets[i], lengths[i]);
+            byte[] actual = new byte[mdSize];
+            output.position(1 + i * mdSize);
+            output.get(actual);
+            assertArrayEquals(algorithm + " message " + i, md.digest(), actual);
+        }
+    }
+
+    @Test
+    public void test_EVP_Digest_batch() throws Exception {
+        for (String algorithm : new String[] {"SHA-1", "SHA-256", "SHA-512"}) {
+            checkDigestBatch(algorithm, 0, 16);
+            checkDigestBatch(algorithm, 7, 100);
+            // Big enough to be spread over the worker pool.
+            checkDigestBatch(algorithm, 300, 4096);
+        }
+    }
+
+    @Test
+    public void test_EVP_Digest_batch_invalidArguments() throws Exception {
+        ByteBuffer input = ByteBuffer.allocateDirect(64);
+        ByteBuffer output = ByteBuffer.allocateDirect(64);
+        try {
+            Conscrypt.digestBatch("SHA-256", input, new int[] {60}, new int[] {5}, output);
+            fail();
+        } catch (ArrayIndexOutOfBoundsException expected) {
+            // Expected.
+        }
+        try {
+            Conscrypt.digestBatch("SHA-256", input, new int[3], new int[3], output);
+            fail();
+        } catch (BufferOverflowException expected) {
+            // Expected.
+        }
+        try {
+            Conscrypt.digestBatch("SHA-256", input, new int[1], new int[2], output);
+            fail();
+        } catch (IllegalArgumentException expected) {
+            // Expected.
+        }
+        try {
+            Conscrypt.digestBatch(
+                    "SHA-256", ByteBuffer.allocate(64), new int[1], new int[1], output);
+            fail();
+        } catch (IllegalArgumentException expected) {
+            // Expected.
+        }
+        try {
+            Conscrypt.digestBatch("MD4", input, new int[1], new int[1], output);
+            fail();
+        } catch (NoSuchAlgorithmException expected) {
+            // Expected.
+        }
+        assertEquals(0, output.position());
+    }
+
+    @Test
+    public void test_Scrypt_generate_key_parallel() throws Exception {
+        byte[] password = "password".getBytes(StandardCharsets.UTF_8);
+        byte[] salt = "NaCl".getBytes(StandardCharsets.UTF_8);
+        // RFC 7914 section 12, second test vector.
+        byte[] expectedKey = TestUtils.decodeHex("fdbabe1c9d3472007856e7190d01e9fe"
+                + "7c6ad7cbc8237830e77376634b3731622eaf30d92e22a3886ff109279d9830da"
+                + "c727afb94a83ee6d8360cbdfa2cc0640");
+        assertArrayEquals(
+                expectedKey, NativeCrypto.Scrypt_generate_key(password, salt, 1024, 8, 16, 64));
+        for (int maxThreads : new int[] {0, 1, 3, 16}) {
+            assertArrayEquals(Integer.toString(maxThreads), expectedKey,
+                    NativeCrypto.Scrypt_generate_key(password, salt, 1024, 8, 16, 64, maxThreads));
+        }
+        // Later calls reuse the scratch memory of earlier ones.
+        byte[] first = NativeCrypto.Scrypt_generate_key(password, salt, 2048, 4, 3, 32, 3);
+        assertArrayEquals(NativeCrypto.Scrypt_generate_key(password, salt, 2048, 4, 3, 32),
+                first);
+        assertArrayEquals(
+                first, NativeCrypto.Scrypt_generate_key(password, salt, 2048, 4, 3, 32, 3));
+
+        try {
+            NativeCrypto.Scrypt_generate_key(password, salt, 1000, 8, 1, 32, 2);
+            fail();
+        } catch (IllegalArgumentException expected) {
+            // Expected: N isn't a power of two.
+        }
+        try {
+            NativeCrypto.Scrypt_generate_key(password, salt, 1 << 20, 8, 1, 32, 2);
+            fail();
+        } catch (IllegalArgumentException expected) {
+            // Expected: needs 1GiB, over the 512MiB limit.
+        }
+    }
+
     @Test
     public void test_EVP_DigestSignInit() throws Exception {
         RSAPrivateCrtKey privKey = TEST_RSA_KEY;
@@ -2983,6 +3679,58 @@ public class NativeCryptoTest {
         }
     }
 
+    @Test
+    public void test_BIO_InputStream_largeReads() throws Exception {
+        // Larger than the native scratch array, so the read is split into chunks.
+        byte[] actual = new byte[100 * 1024 + 7];
+        new Random(0).nextBytes(actual);
+        OpenSSLBIOInputStream bis =
+                new OpenSSLBIOInputStream(new ByteArrayInputStream(actual), true);
+        try {
+            byte[] small = new byte[10];
+            assertEquals(small.length, NativeCrypto.BIO_read(bis.getBioContext(), small));
+            byte[] rest = new byte[actual.length];
+            int numRead = NativeCrypto.BIO_read(bis.getBioContext(), rest);
+            assertEquals(actual.length - small.length, numRead);
+            assertArrayEquals(Arrays.copyOfRange(actual, small.length, actual.length),
+                    Arrays.copyOf(rest, numRead));
+        } finally {
+            bis.release();
+        }
+    }
+
+    @Test
+    public void test_BIO_OutputStream_largeWrites() throws Exception {
+        byte[] actual = new byte[100 * 1024 + 7];
+        new Random(0).nextBytes(actual);
+        ByteArrayOutputStream os = new ByteArrayOutputStream();
+
+        long ctx = NativeCrypto.create_BIO_OutputStream(os);
+        try {
+            NativeCrypto.BIO_write(ctx, actual, 0, 10);
+            NativeCrypto.BIO_write(ctx, actual, 10, actual.length - 10);
+            assertArrayEquals(actual, os.toByteArray());
+        } finally {
+            NativeCrypto.BIO_free_all(ctx);
+        }
+    }
+
+    @Test
+    public void test_PEM_read_bio_X509_leavesTrailingData() throws Exception {
+        // Lines are read exactly, so whatever follows the PEM block stays in the stream for the
+        // next parse.
+        byte[] pem = readTestFile("cert.pem");
+        byte[] trailer = "trailer".getBytes(StandardCharsets.US_ASCII);
+        byte[] input = Arrays.copyOf(pem, pem.length + trailer.length);
+        System.arraycopy(trailer, 0, input, pem.length, trailer.length);
+        ByteArrayInputStream is = new ByteArrayInputStream(input);
+
+        assertNotNull(OpenSSLX509Certificate.fromX509PemInputStream(is));
+        byte[] rest = new byte[trailer.length];
+        assertEquals(trailer.length, is.read(rest));
+        assertArrayEquals(trailer, rest);
+    }
+
     @Test
     public void test_get_ocsp_single_extension() throws Exception {
         final String OCSP_SCT_LIST_OID = "1.3.6.1.4.1.11129.2.4.5";
@@ -17,9 +17,11 @@
 package org.conscrypt;
 
 import static org.conscrypt.TestUtils.openTestFile;
+import static org.junit.Assert.assertArrayEquals;
 import static org.junit.Assert.assertEquals;
 import static org.junit.Assert.assertFalse;
 import static org.junit.Assert.assertNotNull;
+import static org.junit.Assert.assertNull;
 import static org.junit.Assert.assertTrue;
 import static org.junit.Assert.fail;
 import static org.junit.Assume.assumeFalse;
@@ -34,7 +36,10 @@ import java.lang.reflect.Field;
 import java.lang.reflect.InvocationTargetException;
 import java.lang.reflect.Method;
 import java.lang.reflect.Modifier;
+import java.math.BigInteger;
 import java.util.Arrays;
+import java.util.HashSet;
+import javax.security.auth.x500.X500Principal;
 import org.conscrypt.OpenSSLX509CertificateFactory.ParsingException;
 import org.junit.Assume;
 import org.junit.Ignore;
@@ -170,4 +175,42 @@ public class OpenSSLX509CertificateTest {
         } catch (IllegalArgumentException expected) {
         }
     }
+
+    @Test
+    public void test_bulkDecodedFieldsMatchNativeGetters() throws Exception {
+        for (String name : new String[] {"cert.pem", "cert-ct-poisoned.pem"}) {
+            OpenSSLX509Certificate cert = loadTestCertificate(name);
+            long ctx = cert.getContext();
+
+            assertEquals(NativeCrypto.X509_get_version(ctx, cert) + 1, cert.getVersion());
+            assertEquals(new BigInteger(NativeCrypto.X509_get_serialNumber(ctx, cert)),
+                    cert.getSerialNumber());
+            assertEquals(new X500Principal(NativeCrypto.X509_get_issuer_name(ctx, cert)),
+                    cert.getIssuerX500Principal());
+            assertEquals(new X500Principal(NativeCrypto.X509_get_subject_name(ctx, cert)),
+                    cert.getSubjectX500Principal());
+            assertEquals(NativeCrypto.get_X509_sig_alg_oid(ctx, cert), cert.getSigAlgOID());
+            assertEquals(new HashSet<>(Arrays.asList(NativeCrypto.get_X509_ext_oids(
+                                 ctx, cert, NativeCrypto.EXTENSION_TYPE_CRITICAL))),
+                    cert.getCriticalExtensionOIDs());
+            assertEquals(new HashSet<>(Arrays.asList(NativeCrypto.get_X509_ext_oids(
+                                 ctx, cert, NativeCrypto.EXTENSION_TYPE_NON_CRITICAL))),
+                    cert.getNonCriticalExtensionOIDs());
+
+            boolean[] keyUsage = NativeCrypto.get_X509_ex_kusage(ctx, cert);
+            if (keyUsage == null) {
+                assertNull(cert.getKeyUsage());
+            } else {
+                assertArrayEquals(Arrays.copyOf(keyUsage, Math.max(keyUsage.length, 9)),
+                        cert.getKeyUsage());
+            }
+
+            // Callers may scribble on the returned arrays without affecting the certificate.
+            boolean[] returned = cert.getKeyUsage();
+            if (returned != null) {
+                returned[0] = !returned[0];
+                assertFalse(Arrays.equals(returned, cert.getKeyUsage()));
+            }
+        }
+    }
 }
@@ -34,9 +34,18 @@ public final class CipherEncryptBenchmark {
         HEAP_HEAP,
         HEAP_DIRECT,
         DIRECT_DIRECT,
-        DIRECT_HEAP
+        DIRECT_HEAP,
+        // Large byte[] messages through the default copying path and the pinned path.
+        LARGE_ARRAY,
+        LARGE_ARRAY_PINNED,
+        // Large messages in direct buffers, between two buffers and in place within one.
+        LARGE_DIRECT,
+        LARGE_DIRECT_IN_PLACE
     }
 
+    private static final int LARGE_MESSAGE_SIZE = 4 * 1024 * 1024;
+    private static final int PINNED_ARRAY_THRESHOLD = 64 * 1024;
+
     /**
      * Provider for the benchmark configuration
      */
@@ -49,8 +58,12 @@ public final class CipherEncryptBenchmark {
     private final EncryptStrategy encryptStrategy;
 
     CipherEncryptBenchmark(Config config) throws Exception {
+        Conscrypt.setCriticalArrayThreshold(
+                config.bufferType() == BufferType.LARGE_ARRAY_PINNED ? PINNED_ARRAY_THRESHOLD : 0);
         switch (config.bufferType()) {
             case ARRAY:
+            case LARGE_ARRAY:
+            case LARGE_ARRAY_PINNED:
                 encryptStrategy = new ArrayStrategy(config);
                 break;
             default:
@@ -67,6 +80,7 @@ public final class CipherEncryptBenchmark {
         private final Key key;
         final Cipher cipher;
         final int outputSize;
+        final boolean largeMessage;
 
         EncryptStrategy(Config config) throws Exception {
             Transformation tx = config.transformation();
@@ -74,10 +88,25 @@ public final class CipherEncryptBenchmark {
             cipher = config.cipherFactory().newCipher(tx.toFormattedString());
             initCipher();
 
-            int messageSize = messageSize(tx.toFormattedString());
+            // RSA can only take one block's worth.
+            largeMessage = isLarge(config.bufferType()) && !"RSA".equals(tx.algorithm);
+            int messageSize =
+                    largeMessage ? LARGE_MESSAGE_SIZE : messageSize(tx.toFormattedString());
             outputSize = cipher.getOutputSize(messageSize);
         }
 
+        private static boolean isLarge(BufferType bufferType) {
+            switch (bufferType) {
+                case LARGE_ARRAY:
+                case LARGE_ARRAY_PINNED:
+                case LARGE_DIRECT:
+                case LARGE_DIRECT_IN_PLACE:
+                    return true;
+                default:
+                    return false;
+            }
+        }
+
         final void initCipher() throws Exception {
             cipher.init(Cipher.ENCRYPT_MODE, key);
         }
@@ -89,7 +118,8 @@ public final class CipherEncryptBenchmark {
         }
 
         final byte[] newMessage() {
-            return TestUtils.newTextMessage(cipher.getBlockSize());
+            return TestUtils.newTextMessage(
+                    largeMessage ? LARGE_MESSAGE_SIZE : cipher.getBlockSize());
         }
 
         abstract int encrypt() throws Exception;
@@ -137,6 +167,22 @@ public final class CipherEncryptBenchmark {
                     input = toDirect(newMessage());
                     output = ByteBuffer.allocate(outputSize);
                     break;
+                case LARGE_DIRECT:
+                    input = toDirect(newMessage());
+                    output = ByteBuffer.allocateDirect(outputSize);
+                    break;
+                case LARGE_DIRECT_IN_PLACE: {
+                    // Cipher rejects the same buffer object twice, so use two views of it.
+                    byte[] message = newMessage();
+                    ByteBuffer buffer =
+                            ByteBuffer.allocateDirect(Math.max(message.length, outputSize));
+                    buffer.put(message);
+                    buffer.flip();
+                    input = buffer.duplicate();
+                    output = buffer.duplicate();
+                    output.limit(output.capacity());
+                    break;
+                }
                 default: {
                     throw new IllegalStateException(
                             "Unexpected buffertype: " + config.bufferType());
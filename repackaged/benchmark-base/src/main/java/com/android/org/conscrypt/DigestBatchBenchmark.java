@@ -0,0 +1,96 @@
+/* GENERATED SOURCE. DO NOT MODIFY. */
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package com.android.org.conscrypt;
+
+import java.nio.ByteBuffer;
+import java.security.MessageDigest;
+
+/**
+ * Benchmark for hashing a batch of small independent messages, one {@link MessageDigest} call
+ * per message versus a single {@link Conscrypt#digestBatch} call.
+ * @hide This class is not part of the Android public SDK API
+ */
+public final class DigestBatchBenchmark {
+    /**
+     * @hide This class is not part of the Android public SDK API
+     */
+    public enum Mode {
+        MESSAGE_DIGEST,
+        BATCH
+    }
+
+    /**
+     * Provider for the benchmark configuration
+     */
+    interface Config {
+        String algorithm();
+        int messageSize();
+        int batchSize();
+        Mode mode();
+    }
+
+    private final Mode mode;
+    private final String algorithm;
+    private final MessageDigest md;
+    private final byte[] data;
+    private final ByteBuffer input;
+    private final ByteBuffer output;
+    private final int[] offsets;
+    private final int[] lengths;
+
+    DigestBatchBenchmark(Config config) throws Exception {
+        mode = config.mode();
+        algorithm = config.algorithm();
+        md = MessageDigest.getInstance(algorithm, TestUtils.getConscryptProvider());
+
+        int batchSize = config.batchSize();
+        int messageSize = config.messageSize();
+        data = TestUtils.newTextMessage(batchSize * messageSize);
+        offsets = new int[batchSize];
+        lengths = new int[batchSize];
+        for (int i = 0; i < batchSize; i++) {
+            offsets[i] = i * messageSize;
+            lengths[i] = messageSize;
+        }
+        input = ByteBuffer.allocateDirect(data.length);
+        input.put(data);
+        input.flip();
+        output = ByteBuffer.allocateDirect(batchSize * md.getDigestLength());
+    }
+
+    /**
+     * Hashes every message in the batch and returns the number of digest bytes produced.
+     */
+    int digest() throws Exception {
+        output.clear();
+        switch (mode) {
+            case MESSAGE_DIGEST:
+                for (int i = 0; i < offsets.length; i++) {
+                    md.update(data, offsets[i], lengths[i]);
+                    output.put(md.digest());
+                }
+                break;
+            case BATCH:
+                Conscrypt.digestBatch(algorithm, input, offsets, lengths, output);
+                break;
+            default:
+                throw new IllegalStateException("Unexpected mode: " + mode);
+        }
+        return output.position();
+    }
+}
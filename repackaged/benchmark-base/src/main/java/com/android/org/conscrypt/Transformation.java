@@ -21,7 +21,9 @@ import java.security.Key;
 import java.security.KeyPair;
 import java.security.KeyPairGenerator;
 import java.security.NoSuchAlgorithmException;
+import java.security.SecureRandom;
 import javax.crypto.KeyGenerator;
+import javax.crypto.spec.SecretKeySpec;
 import org.bouncycastle.jce.provider.BouncyCastleProvider;
 
 /**
@@ -33,6 +35,8 @@ public enum Transformation {
     AES_CBC_PKCS5("AES", "CBC", "PKCS5Padding", new AesKeyGen()),
     AES_ECB_PKCS5("AES", "ECB", "PKCS5Padding", new AesKeyGen()),
     AES_GCM_NO("AES", "GCM", "NoPadding", new AesKeyGen()),
+    AES_CTR_NO("AES", "CTR", "NoPadding", new AesKeyGen()),
+    CHACHA20("ChaCha20", "NONE", "NoPadding", new ChaCha20KeyGen()),
     RSA_ECB_PKCS1("RSA", "ECB", "PKCS1Padding", new RsaKeyGen());
 
     Transformation(String algorithm, String mode, String padding, KeyGen keyGen) {
@@ -86,4 +90,13 @@ public enum Transformation {
             }
         }
     }
+
+    private static final class ChaCha20KeyGen implements KeyGen {
+        @Override
+        public Key newEncryptKey() {
+            byte[] key = new byte[32];
+            new SecureRandom().nextBytes(key);
+            return new SecretKeySpec(key, "ChaCha20");
+        }
+    }
 }
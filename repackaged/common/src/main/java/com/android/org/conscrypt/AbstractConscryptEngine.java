@@ -135,6 +135,29 @@ abstract class AbstractConscryptEngine extends SSLEngine {
      */
     abstract void setUseSessionTickets(boolean useSessionTickets);
 
+    /**
+     * Enables handing private-key operations out as delegated tasks, see {@link
+     * Conscrypt#setDelegatePrivateKeyOperations(SSLEngine, boolean)}.
+     */
+    abstract void setDelegatePrivateKeyOperations(boolean enabled);
+
+    /**
+     * Enables TLS 1.3 early data, see {@link Conscrypt#setEarlyDataEnabled(SSLEngine, boolean)}.
+     */
+    abstract void setEarlyDataEnabled(boolean enabled);
+
+    /**
+     * Returns whether the handshake is paused for early data, see {@link
+     * Conscrypt#isInEarlyData(SSLEngine)}.
+     */
+    abstract boolean isInEarlyData();
+
+    /**
+     * Returns why early data was or wasn't used, see {@link
+     * Conscrypt#getEarlyDataStatus(SSLEngine)}.
+     */
+    abstract String getEarlyDataStatus();
+
     /**
      * Sets the list of ALPN protocols.
      *
@@ -46,6 +46,8 @@ abstract class AbstractSessionContext implements SSLSessionContext {
 
     private volatile long sslCtxNativePointer = NativeCrypto.SSL_CTX_new();
 
+    private volatile boolean hasTicketKeys;
+
     private final ReadWriteLock lock = new ReentrantReadWriteLock();
 
     private final Map<ByteArray, NativeSslSession> sessions =
@@ -173,6 +175,79 @@ abstract class AbstractSessionContext implements SSLSessionContext {
         }
     }
 
+    /**
+     * Returns the performance counters summed over every connection created from this context,
+     * indexed by the {@code NativeCrypto.SSL_COUNTER_*} constants, or {@code null} once the
+     * context has been freed.
+     */
+    long[] getCounters() {
+        lock.readLock().lock();
+        try {
+            if (!isValid()) {
+                return null;
+            }
+            return NativeCrypto.SSL_CTX_get_counters(sslCtxNativePointer, this);
+        } finally {
+            lock.readLock().unlock();
+        }
+    }
+
+    /**
+     * Installs session ticket keys for the connections of this context, see
+     * {@link NativeCrypto#SSL_CTX_set_ticket_keys}.
+     */
+    final void installTicketKeys(byte[] keys) {
+        lock.writeLock().lock();
+        try {
+            if (isValid()) {
+                NativeCrypto.SSL_CTX_set_ticket_keys(sslCtxNativePointer, this, keys);
+                hasTicketKeys = true;
+            }
+        } finally {
+            lock.writeLock().unlock();
+        }
+    }
+
+    /**
+     * Returns whether ticket keys have been installed with {@link #installTicketKeys}, in which
+     * case connections of this context issue and accept session tickets.
+     */
+    final boolean hasTicketKeys() {
+        return hasTicketKeys;
+    }
+
+    /**
+     * Replaces the SNI certificate map of this context, see
+     * {@link NativeCrypto#SSL_CTX_set_certificate_map}.
+     */
+    final void installCertificateMap(String[] hostNames, long[] credentials) {
+        lock.writeLock().lock();
+        try {
+            if (isValid()) {
+                NativeCrypto.SSL_CTX_set_certificate_map(
+                        sslCtxNativePointer, this, hostNames, credentials);
+            }
+        } finally {
+            lock.writeLock().unlock();
+        }
+    }
+
+    /**
+     * Configures the native server session cache of this context, see
+     * {@link NativeCrypto#SSL_CTX_set_server_session_cache}.
+     */
+    final void configureNativeSessionCache(int maxEntries, int timeoutSeconds) {
+        lock.writeLock().lock();
+        try {
+            if (isValid()) {
+                NativeCrypto.SSL_CTX_set_server_session_cache(
+                        sslCtxNativePointer, this, maxEntries, timeoutSeconds);
+            }
+        } finally {
+            lock.writeLock().unlock();
+        }
+    }
+
     private void setTimeout(int seconds) {
         lock.writeLock().lock();
         try {
@@ -74,6 +74,23 @@ public final class BufferUtils {
         }
     }
 
+    /**
+     * Marks {@code toConsume} bytes of data as consumed from {@code sourceBuffers[offset, end)}.
+     *
+     * @throws IllegalArgumentException if there are fewer than {@code toConsume} bytes remaining
+     */
+    public static void consume(ByteBuffer[] sourceBuffers, int offset, int end, int toConsume) {
+        for (int i = offset; i < end && toConsume > 0; i++) {
+            ByteBuffer sourceBuffer = sourceBuffers[i];
+            int amount = min(sourceBuffer.remaining(), toConsume);
+            sourceBuffer.position(sourceBuffer.position() + amount);
+            toConsume -= amount;
+        }
+        if (toConsume > 0) {
+            throw new IllegalArgumentException("toConsume > data size");
+        }
+    }
+
     /**
      * Looks for a buffer in the buffer array which EITHER is larger than {@code minSize} AND
      * has no preceding non-empty buffers OR is the only non-empty buffer in the array.
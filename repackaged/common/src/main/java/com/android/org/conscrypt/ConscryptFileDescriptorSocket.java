@@ -28,6 +28,7 @@ import com.android.org.conscrypt.ExternalSession.Provider;
 import com.android.org.conscrypt.NativeRef.SSL_SESSION;
 import com.android.org.conscrypt.metrics.StatsLog;
 
+import java.io.FileDescriptor;
 import java.io.IOException;
 import java.io.InputStream;
 import java.io.OutputStream;
@@ -107,6 +108,30 @@ class ConscryptFileDescriptorSocket extends OpenSSLSocketImpl
      * A snapshot of the active session when the engine was closed.
      */
     private SessionSnapshot closedSession;
+
+    /**
+     * Whether to hand the connection to kernel TLS once the handshake completes.
+     */
+    // @GuardedBy("ssl");
+    private boolean kernelTlsEnabled;
+
+    /**
+     * The {@code NativeCrypto.KTLS_*} directions the kernel handles, set once the handshake
+     * completes.
+     */
+    private volatile int kernelTlsDirections;
+
+    /**
+     * Whether to wait for the socket through the {@link SharedSslPoller}.
+     */
+    // @GuardedBy("ssl");
+    private boolean sharedPollerEnabled;
+
+    /**
+     * This socket's place in the {@link SharedSslPoller}, set when the handshake starts if
+     * {@link #sharedPollerEnabled}.
+     */
+    private volatile SharedSslPoller.Registration pollerRegistration;
     /**
      * The session object exposed externally from this class.
      */
@@ -203,6 +228,15 @@ class ConscryptFileDescriptorSocket extends OpenSSLSocketImpl
             // Prepare the SSL object for the handshake.
             ssl.initialize(getHostname(), channelIdPrivateKey);
 
+            boolean usePoller;
+            synchronized (ssl) {
+                usePoller = sharedPollerEnabled;
+            }
+            if (usePoller) {
+                pollerRegistration =
+                        SharedSslPoller.getDefault().register(Platform.getFileDescriptor(socket));
+            }
+
             // For clients, offer to resume a previously cached session to avoid the
             // full TLS handshake.
             if (getUseClientMode()) {
@@ -228,7 +262,11 @@ class ConscryptFileDescriptorSocket extends OpenSSLSocketImpl
             }
 
             try {
-                ssl.doHandshake(Platform.getFileDescriptor(socket), getSoTimeout());
+                if (pollerRegistration != null) {
+                    doHandshakeWithPoller(Platform.getFileDescriptor(socket), getSoTimeout());
+                } else {
+                    ssl.doHandshake(Platform.getFileDescriptor(socket), getSoTimeout());
+                }
 
                 // Update the session from the current state of the SSL object.
                 activeSession.onPeerCertificateAvailable(getHostnameOrIP(), getPort());
@@ -264,6 +302,16 @@ class ConscryptFileDescriptorSocket extends OpenSSLSocketImpl
                 setSoWriteTimeout(savedWriteTimeoutMilliseconds);
             }
 
+            // With kernel TLS, onSSLStateChange leaves the handshake completed but not ready, so
+            // that no other thread touches the connection until the keys are with the kernel.
+            boolean handshakeDoneDeferred;
+            synchronized (ssl) {
+                handshakeDoneDeferred = state == STATE_HANDSHAKE_COMPLETED;
+            }
+            if (handshakeDoneDeferred) {
+                kernelTlsDirections = ssl.enableKernelTls(Platform.getFileDescriptor(socket));
+            }
+
             synchronized (ssl) {
                 releaseResources = (state == STATE_CLOSED);
 
@@ -279,6 +327,10 @@ class ConscryptFileDescriptorSocket extends OpenSSLSocketImpl
                     ssl.notifyAll();
                 }
             }
+
+            if (handshakeDoneDeferred && !releaseResources) {
+                notifyHandshakeCompletedListeners();
+            }
         } catch (SSLProtocolException e) {
             throw(SSLHandshakeException) new SSLHandshakeException("Handshake failed").initCause(e);
         } finally {
@@ -303,6 +355,81 @@ class ConscryptFileDescriptorSocket extends OpenSSLSocketImpl
         }
     }
 
+    /**
+     * Runs the handshake with the non-blocking native, parking on the shared poller whenever
+     * the socket isn't ready. Returns early if the socket is closed meanwhile.
+     */
+    private void doHandshakeWithPoller(FileDescriptor fd, int timeoutMillis)
+            throws CertificateException, IOException {
+        int ret;
+        while ((ret = ssl.doHandshakeNonBlocking(fd)) != 0) {
+            if (!pollerRegistration.await(
+                        pollerInterest(ret), timeoutMillis, "SSL handshake timed out")) {
+                return;
+            }
+        }
+    }
+
+    /**
+     * Reads with the non-blocking native, parking on the shared poller whenever the socket
+     * isn't ready.
+     */
+    private int readWithPoller(FileDescriptor fd, byte[] buf, int offset, int byteCount)
+            throws IOException {
+        while (true) {
+            int ret = ssl.readNonBlocking(fd, buf, offset, byteCount);
+            if (ret != NativeCrypto.SSL_NONBLOCKING_WANT_READ
+                    && ret != NativeCrypto.SSL_NONBLOCKING_WANT_WRITE) {
+                return ret;
+            }
+            if (!pollerRegistration.await(pollerInterest(ret), getSoTimeout(), "Read timed out")) {
+                throw new SocketException("socket is closed");
+            }
+        }
+    }
+
+    /**
+     * Writes all of {@code buf} with the non-blocking native, parking on the shared poller
+     * whenever the socket isn't ready.
+     */
+    private void writeWithPoller(FileDescriptor fd, byte[] buf, int offset, int byteCount)
+            throws IOException {
+        while (byteCount > 0) {
+            int ret = ssl.writeNonBlocking(fd, buf, offset, byteCount);
+            if (ret == NativeCrypto.SSL_NONBLOCKING_WANT_READ
+                    || ret == NativeCrypto.SSL_NONBLOCKING_WANT_WRITE) {
+                if (!pollerRegistration.await(
+                            pollerInterest(ret), writeTimeoutMilliseconds, "Write timed out")) {
+                    throw new SocketException("socket is closed");
+                }
+                continue;
+            }
+            if (ret <= 0) {
+                // Only happens once the connection has been interrupted by close().
+                throw new SocketException("socket is closed");
+            }
+            offset += ret;
+            byteCount -= ret;
+        }
+    }
+
+    private static int pollerInterest(int wouldBlock) {
+        return wouldBlock == NativeCrypto.SSL_NONBLOCKING_WANT_READ
+                ? NativeCrypto.SSL_POLLER_READ
+                : NativeCrypto.SSL_POLLER_WRITE;
+    }
+
+    /**
+     * Wakes threads waiting on the network for this socket, wherever they wait.
+     */
+    private void interruptIo() {
+        ssl.interrupt();
+        SharedSslPoller.Registration registration = pollerRegistration;
+        if (registration != null) {
+            registration.close();
+        }
+    }
+
     @Override
     @SuppressWarnings("unused") // used by NativeCrypto.SSLHandshakeCallbacks / client_cert_cb
     public final void clientCertificateRequested(byte[] keyTypeBytes, int[] signatureAlgs,
@@ -338,6 +465,13 @@ class ConscryptFileDescriptorSocket extends OpenSSLSocketImpl
                 return;
             }
 
+            // startHandshake offloads the connection to the kernel once SSL_do_handshake
+            // returns, and only then tells waiting threads and listeners.
+            if (kernelTlsEnabled && state == STATE_HANDSHAKE_STARTED) {
+                transitionTo(STATE_HANDSHAKE_COMPLETED);
+                return;
+            }
+
             // Now that we've fixed up our state, we can tell waiting threads that
             // we're ready.
             transitionTo(STATE_READY);
@@ -546,8 +680,14 @@ class ConscryptFileDescriptorSocket extends OpenSSLSocketImpl
                     }
                 }
 
-                int ret =  ssl.read(
-                        Platform.getFileDescriptor(socket), buf, offset, byteCount, getSoTimeout());
+                int ret;
+                if (pollerRegistration != null) {
+                    ret = readWithPoller(Platform.getFileDescriptor(socket), buf, offset,
+                            byteCount);
+                } else {
+                    ret = ssl.read(Platform.getFileDescriptor(socket), buf, offset, byteCount,
+                            getSoTimeout());
+                }
                 if (ret == -1) {
                     synchronized (ssl) {
                         if (state == STATE_CLOSED) {
@@ -628,8 +768,12 @@ class ConscryptFileDescriptorSocket extends OpenSSLSocketImpl
                     }
                 }
 
-                ssl.write(Platform.getFileDescriptor(socket), buf, offset, byteCount,
-                        writeTimeoutMilliseconds);
+                if (pollerRegistration != null) {
+                    writeWithPoller(Platform.getFileDescriptor(socket), buf, offset, byteCount);
+                } else {
+                    ssl.write(Platform.getFileDescriptor(socket), buf, offset, byteCount,
+                            writeTimeoutMilliseconds);
+                }
 
                 synchronized (ssl) {
                     if (state == STATE_CLOSED) {
@@ -773,6 +917,50 @@ class ConscryptFileDescriptorSocket extends OpenSSLSocketImpl
         sslParameters.setUseSessionTickets(useSessionTickets);
     }
 
+    @Override
+    final void setEarlyDataEnabled(boolean enabled) {
+        sslParameters.setEarlyDataEnabled(enabled);
+    }
+
+    @Override
+    final boolean isInEarlyData() {
+        return ssl.isInEarlyData();
+    }
+
+    @Override
+    final String getEarlyDataStatus() {
+        return ssl.getEarlyDataStatus();
+    }
+
+    @Override
+    final void setKernelTlsEnabled(boolean enabled) {
+        synchronized (ssl) {
+            if (state != STATE_NEW) {
+                throw new IllegalStateException(
+                        "Could not enable/disable kernel TLS after the initial handshake has"
+                                + " begun.");
+            }
+            kernelTlsEnabled = enabled;
+        }
+    }
+
+    @Override
+    final boolean isKernelTlsActive() {
+        return kernelTlsDirections == (NativeCrypto.KTLS_TX | NativeCrypto.KTLS_RX);
+    }
+
+    @Override
+    final void setSharedPollerEnabled(boolean enabled) {
+        synchronized (ssl) {
+            if (state != STATE_NEW) {
+                throw new IllegalStateException(
+                        "Could not enable/disable the shared poller after the initial handshake"
+                                + " has begun.");
+            }
+            sharedPollerEnabled = enabled;
+        }
+    }
+
     /**
      * This method enables Server Name Indication.  If the hostname is not a valid SNI hostname,
      * the SNI extension will be omitted from the handshake.
@@ -1004,7 +1192,7 @@ class ConscryptFileDescriptorSocket extends OpenSSLSocketImpl
                 // We call SSL_interrupt so that we can interrupt SSL_do_handshake and then
                 // set the state to STATE_CLOSED. startHandshake will handle all cleanup
                 // after SSL_do_handshake returns, so we don't have anything to do here.
-                ssl.interrupt();
+                interruptIo();
 
                 ssl.notifyAll();
                 return;
@@ -1019,7 +1207,7 @@ class ConscryptFileDescriptorSocket extends OpenSSLSocketImpl
 
         // Don't bother interrupting unless we have something to interrupt.
         if (sslInputStream != null || sslOutputStream != null) {
-            ssl.interrupt();
+            interruptIo();
         }
 
         // Wait for the input and output streams to finish any reads they have in
@@ -1047,6 +1235,10 @@ class ConscryptFileDescriptorSocket extends OpenSSLSocketImpl
              * can happen if the underlying socket is closed.
              */
         } finally {
+            SharedSslPoller.Registration registration = pollerRegistration;
+            if (registration != null) {
+                registration.close();
+            }
             free();
             closeUnderlyingSocket();
         }
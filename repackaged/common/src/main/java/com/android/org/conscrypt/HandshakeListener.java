@@ -30,4 +30,13 @@ public abstract class HandshakeListener {
      * Called by the engine when the TLS handshake has completed.
      */
     public abstract void onHandshakeFinished() throws SSLException;
+
+    /**
+     * Called by the engine once the peer has accepted or rejected TLS 1.3 early data on a
+     * connection with early data enabled. A rejection is reported as soon as it is known, which
+     * is before the handshake finishes; everything the client wrote as early data was discarded
+     * and has to be written again. An acceptance is reported just before {@link
+     * #onHandshakeFinished()}. Nothing is reported if early data was not attempted.
+     */
+    public void onEarlyDataResolved(boolean accepted) throws SSLException {}
 }
@@ -75,6 +75,17 @@ abstract class NativeRef {
         }
     }
 
+    static final class CMAC_PREPARED_KEY extends NativeRef {
+        CMAC_PREPARED_KEY(long nativePointer) {
+            super(nativePointer);
+        }
+
+        @Override
+        void doFree(long context) {
+            NativeCrypto.CMAC_PREPARED_KEY_free(context);
+        }
+    }
+
     static final class EC_GROUP extends NativeRef {
         EC_GROUP(long ctx) {
             super(ctx);
@@ -97,6 +108,17 @@ abstract class NativeRef {
         }
     }
 
+    static final class EVP_AEAD_CTX extends NativeRef {
+        EVP_AEAD_CTX(long nativePointer) {
+            super(nativePointer);
+        }
+
+        @Override
+        void doFree(long context) {
+            NativeCrypto.EVP_AEAD_CTX_free(context);
+        }
+    }
+
     static final class EVP_CIPHER_CTX extends NativeRef {
         EVP_CIPHER_CTX(long nativePointer) {
             super(nativePointer);
@@ -163,6 +185,39 @@ abstract class NativeRef {
         }
     }
 
+    static final class HMAC_PREPARED_KEY extends NativeRef {
+        HMAC_PREPARED_KEY(long nativePointer) {
+            super(nativePointer);
+        }
+
+        @Override
+        void doFree(long context) {
+            NativeCrypto.HMAC_PREPARED_KEY_free(context);
+        }
+    }
+
+    static final class PREPARED_VERIFIER extends NativeRef {
+        PREPARED_VERIFIER(long nativePointer) {
+            super(nativePointer);
+        }
+
+        @Override
+        void doFree(long context) {
+            NativeCrypto.PREPARED_VERIFIER_free(context);
+        }
+    }
+
+    static final class SERVER_CREDENTIAL extends NativeRef {
+        SERVER_CREDENTIAL(long nativePointer) {
+            super(nativePointer);
+        }
+
+        @Override
+        void doFree(long context) {
+            NativeCrypto.SERVER_CREDENTIAL_free(context);
+        }
+    }
+
     static final class SSL_SESSION extends NativeRef {
         SSL_SESSION(long nativePointer) {
             super(nativePointer);
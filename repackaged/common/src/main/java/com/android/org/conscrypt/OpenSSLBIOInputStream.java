@@ -51,13 +51,24 @@ class OpenSSLBIOInputStream extends FilterInputStream {
      * from a {@code BIO_gets} method.
      */
     int gets(byte[] buffer) throws IOException {
-        if (buffer == null || buffer.length == 0) {
+        return gets(buffer, buffer == null ? 0 : buffer.length);
+    }
+
+    /**
+     * Like {@link #gets(byte[])} but stores at most {@code len} bytes, so that native code can
+     * reuse one buffer across calls of different sizes.
+     */
+    int gets(byte[] buffer, int len) throws IOException {
+        if (buffer == null || len <= 0) {
             return 0;
         }
+        if (len > buffer.length) {
+            throw new IndexOutOfBoundsException("Invalid bounds");
+        }
 
         int offset = 0;
         int inputByte = 0;
-        while (offset < buffer.length) {
+        while (offset < len) {
             inputByte = read();
             if (inputByte == -1) {
                 // EOF
@@ -17,6 +17,7 @@
 
 package com.android.org.conscrypt;
 
+import java.nio.ByteBuffer;
 import java.security.InvalidAlgorithmParameterException;
 import java.security.InvalidKeyException;
 import java.security.NoSuchAlgorithmException;
@@ -75,39 +76,100 @@ public class OpenSSLCipherChaCha20 extends OpenSSLCipher {
         }
         int inputLenRemaining = inputLen;
         if (currentBlockConsumedBytes > 0) {
-            // A previous operation ended with a partial block, so we need to encrypt using
-            // the remainder of that block before beginning to use the next block
-            int len = Math.min(BLOCK_SIZE_BYTES - currentBlockConsumedBytes, inputLenRemaining);
-            byte[] singleBlock = new byte[BLOCK_SIZE_BYTES];
-            byte[] singleBlockOut = new byte[BLOCK_SIZE_BYTES];
-            System.arraycopy(input, inputOffset, singleBlock, currentBlockConsumedBytes, len);
-            NativeCrypto.chacha20_encrypt_decrypt(singleBlock, 0, singleBlockOut, 0,
-                    BLOCK_SIZE_BYTES, encodedKey, iv, blockCounter);
-            System.arraycopy(singleBlockOut, currentBlockConsumedBytes, output, outputOffset, len);
-            currentBlockConsumedBytes += len;
-            if (currentBlockConsumedBytes < BLOCK_SIZE_BYTES) {
+            int len = finishPartialBlock(input, inputOffset, inputLenRemaining, output,
+                    outputOffset);
+            if (currentBlockConsumedBytes > 0) {
                 // We still didn't finish this block, so we're done.
                 return len;
             }
-            currentBlockConsumedBytes = 0;
             inputOffset += len;
             outputOffset += len;
             inputLenRemaining -= len;
-            blockCounter++;
         }
         NativeCrypto.chacha20_encrypt_decrypt(input, inputOffset, output,
                 outputOffset, inputLenRemaining, encodedKey, iv, blockCounter);
-        currentBlockConsumedBytes = inputLenRemaining % BLOCK_SIZE_BYTES;
-        blockCounter += inputLenRemaining / BLOCK_SIZE_BYTES;
+        advanceBlocks(inputLenRemaining);
         return inputLen;
     }
 
+    @Override
+    boolean supportsDirectBuffers() {
+        return true;
+    }
+
+    @Override
+    int updateInternalDirect(ByteBuffer input, ByteBuffer output) throws ShortBufferException {
+        final int inputLen = input.remaining();
+        if (inputLen > output.remaining()) {
+            throw new ShortBufferWithoutStackTraceException("Insufficient output space");
+        }
+        final int outputStart = output.position();
+        byte[] partial = null;
+        if (currentBlockConsumedBytes > 0) {
+            // The rest of the partial block is small, so it goes through an array.
+            partial = new byte[Math.min(BLOCK_SIZE_BYTES - currentBlockConsumedBytes, inputLen)];
+            input.get(partial);
+            finishPartialBlock(partial, 0, partial.length, partial, 0);
+        }
+        int inputLenRemaining = input.remaining();
+        if (inputLenRemaining > 0) {
+            int skip = partial == null ? 0 : partial.length;
+            NativeCrypto.chacha20_encrypt_decryptDirect(directAddress(input),
+                    directAddress(output) + skip, inputLenRemaining, encodedKey, iv, blockCounter);
+            input.position(input.limit());
+            advanceBlocks(inputLenRemaining);
+        }
+        if (partial != null) {
+            // Written last, since a partly overlapping output could otherwise overwrite input
+            // the native call had yet to read.
+            output.put(partial);
+        }
+        output.position(outputStart + inputLen);
+        return inputLen;
+    }
+
+    /**
+     * A previous operation ended with a partial block, so we need to encrypt using the
+     * remainder of that block before beginning to use the next block. Returns the number of
+     * bytes transformed, up to {@code inputLen}.
+     */
+    private int finishPartialBlock(byte[] input, int inputOffset, int inputLen, byte[] output,
+            int outputOffset) {
+        int len = Math.min(BLOCK_SIZE_BYTES - currentBlockConsumedBytes, inputLen);
+        byte[] singleBlock = new byte[BLOCK_SIZE_BYTES];
+        byte[] singleBlockOut = new byte[BLOCK_SIZE_BYTES];
+        System.arraycopy(input, inputOffset, singleBlock, currentBlockConsumedBytes, len);
+        NativeCrypto.chacha20_encrypt_decrypt(singleBlock, 0, singleBlockOut, 0,
+                BLOCK_SIZE_BYTES, encodedKey, iv, blockCounter);
+        System.arraycopy(singleBlockOut, currentBlockConsumedBytes, output, outputOffset, len);
+        currentBlockConsumedBytes += len;
+        if (currentBlockConsumedBytes == BLOCK_SIZE_BYTES) {
+            currentBlockConsumedBytes = 0;
+            blockCounter++;
+        }
+        return len;
+    }
+
+    /**
+     * Accounts for the keystream used by {@code len} bytes starting on a block boundary.
+     */
+    private void advanceBlocks(int len) {
+        currentBlockConsumedBytes = len % BLOCK_SIZE_BYTES;
+        blockCounter += len / BLOCK_SIZE_BYTES;
+    }
+
     @Override
     int doFinalInternal(byte[] output, int outputOffset, int maximumLen) {
         reset();
         return 0;
     }
 
+    @Override
+    int doFinalInternalDirect(ByteBuffer output) {
+        reset();
+        return 0;
+    }
+
     private void reset() {
         blockCounter = 0;
         currentBlockConsumedBytes = 0;
@@ -17,6 +17,7 @@
 
 package com.android.org.conscrypt;
 
+import java.nio.ByteBuffer;
 import java.security.InvalidAlgorithmParameterException;
 import java.security.InvalidKeyException;
 import java.security.SecureRandom;
@@ -167,6 +168,60 @@ public abstract class OpenSSLEvpCipher extends OpenSSLCipher {
         return outputOffset - initialOutputOffset;
     }
 
+    @Override
+    boolean supportsDirectBuffers() {
+        return true;
+    }
+
+    @Override
+    int updateInternalDirect(ByteBuffer input, ByteBuffer output) throws ShortBufferException {
+        final int inputLen = input.remaining();
+        final int maximumLen = getOutputSizeForUpdate(inputLen);
+        final int bytesLeft = output.remaining();
+        if (bytesLeft < maximumLen) {
+            throw new ShortBufferWithoutStackTraceException("output buffer too small during update: "
+                    + bytesLeft + " < " + maximumLen);
+        }
+
+        final int bytesWritten = NativeCrypto.EVP_CipherUpdateDirect(cipherCtx,
+                directAddress(output), bytesLeft, directAddress(input), inputLen);
+        input.position(input.limit());
+        output.position(output.position() + bytesWritten);
+
+        calledUpdate = true;
+
+        return bytesWritten;
+    }
+
+    @Override
+    int doFinalInternalDirect(ByteBuffer output)
+            throws IllegalBlockSizeException, BadPaddingException, ShortBufferException {
+        if (!isEncrypting() && !calledUpdate) {
+            return 0;
+        }
+
+        final int bytesLeft = output.remaining();
+        final int writtenBytes;
+        if (bytesLeft >= modeBlockSize) {
+            writtenBytes = NativeCrypto.EVP_CipherFinal_exDirect(cipherCtx, directAddress(output),
+                    bytesLeft);
+            output.position(output.position() + writtenBytes);
+        } else {
+            // The native call needs room for a whole block, which the output may not have.
+            final byte[] lastBlock = new byte[modeBlockSize];
+            writtenBytes = NativeCrypto.EVP_CipherFinal_ex(cipherCtx, lastBlock, 0);
+            if (writtenBytes > bytesLeft) {
+                throw new ShortBufferWithoutStackTraceException(
+                        "buffer is too short: " + writtenBytes + " > " + bytesLeft);
+            }
+            output.put(lastBlock, 0, writtenBytes);
+        }
+
+        reset();
+
+        return writtenBytes;
+    }
+
     @Override
     int getOutputSizeForFinal(int inputLen) {
         if (modeBlockSize == 1) {
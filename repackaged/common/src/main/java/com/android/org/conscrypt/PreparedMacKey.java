@@ -0,0 +1,155 @@
+/* GENERATED SOURCE. DO NOT MODIFY. */
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package com.android.org.conscrypt;
+
+import java.nio.ByteBuffer;
+import java.security.InvalidKeyException;
+import java.security.NoSuchAlgorithmException;
+import java.util.Locale;
+
+/**
+ * A MAC key whose keyed state has been computed once up front, for callers that MAC many
+ * short messages with a few long-lived keys. Where a {@link javax.crypto.Mac} derives the HMAC
+ * padded keys or the CMAC subkeys again on every {@code init}, a prepared key derives them once
+ * and each {@code mac} call starts from a private copy of that state.
+ *
+ * <p>Instances are immutable and safe for use by any number of threads at once.
+ * @hide This class is not part of the Android public SDK API
+ */
+@ExperimentalApi
+public final class PreparedMacKey {
+    private final String algorithm;
+    private final int macLength;
+    private final NativeRef.HMAC_PREPARED_KEY hmacKey;
+    private final NativeRef.CMAC_PREPARED_KEY cmacKey;
+
+    private PreparedMacKey(String algorithm, int macLength, NativeRef.HMAC_PREPARED_KEY hmacKey,
+            NativeRef.CMAC_PREPARED_KEY cmacKey) {
+        this.algorithm = algorithm;
+        this.macLength = macLength;
+        this.hmacKey = hmacKey;
+        this.cmacKey = cmacKey;
+    }
+
+    /**
+     * Prepares {@code key} for {@code algorithm}, which is one of {@code HmacMD5},
+     * {@code HmacSHA1}, {@code HmacSHA224}, {@code HmacSHA256}, {@code HmacSHA384},
+     * {@code HmacSHA512} or {@code AESCMAC}. AES-CMAC keys must be 16, 24 or 32 bytes long.
+     */
+    public static PreparedMacKey create(String algorithm, byte[] key)
+            throws NoSuchAlgorithmException, InvalidKeyException {
+        if (algorithm == null) {
+            throw new NullPointerException("algorithm == null");
+        }
+        if (key == null) {
+            throw new InvalidKeyException("key == null");
+        }
+        String algorithmUpper = algorithm.toUpperCase(Locale.US);
+        try {
+            if (algorithmUpper.equals("AESCMAC")) {
+                return new PreparedMacKey("AESCMAC", 16, null,
+                        new NativeRef.CMAC_PREPARED_KEY(NativeCrypto.CMAC_PREPARED_KEY_new(key)));
+            }
+            if (!algorithmUpper.startsWith("HMAC")) {
+                throw new NoSuchAlgorithmException("Unsupported algorithm: " + algorithm);
+            }
+            long evpMd = hmacDigest(algorithmUpper.substring(4));
+            if (evpMd == 0) {
+                throw new NoSuchAlgorithmException("Unsupported algorithm: " + algorithm);
+            }
+            return new PreparedMacKey(algorithm, NativeCrypto.EVP_MD_size(evpMd),
+                    new NativeRef.HMAC_PREPARED_KEY(NativeCrypto.HMAC_PREPARED_KEY_new(key, evpMd)),
+                    null);
+        } catch (IllegalArgumentException e) {
+            throw new InvalidKeyException("invalid key", e);
+        }
+    }
+
+    private static long hmacDigest(String digest) {
+        switch (digest) {
+            case "MD5":
+                return EvpMdRef.MD5.EVP_MD;
+            case "SHA1":
+                return EvpMdRef.SHA1.EVP_MD;
+            case "SHA224":
+                return EvpMdRef.SHA224.EVP_MD;
+            case "SHA256":
+                return EvpMdRef.SHA256.EVP_MD;
+            case "SHA384":
+                return EvpMdRef.SHA384.EVP_MD;
+            case "SHA512":
+                return EvpMdRef.SHA512.EVP_MD;
+            default:
+                return 0;
+        }
+    }
+
+    public String getAlgorithm() {
+        return algorithm;
+    }
+
+    /**
+     * Returns the length in bytes of the MACs computed with this key.
+     */
+    public int getMacLength() {
+        return macLength;
+    }
+
+    /**
+     * Returns the MAC of {@code input}.
+     */
+    public byte[] mac(byte[] input) {
+        return mac(input, 0, input.length);
+    }
+
+    /**
+     * Returns the MAC of {@code length} bytes of {@code input} starting at {@code offset}.
+     */
+    public byte[] mac(byte[] input, int offset, int length) {
+        if (hmacKey != null) {
+            return NativeCrypto.HMAC_oneshot(hmacKey, input, offset, length);
+        }
+        return NativeCrypto.CMAC_oneshot(cmacKey, input, offset, length);
+    }
+
+    /**
+     * Returns the MAC of the bytes between {@code input}'s position and limit, and advances its
+     * position to the limit. Direct buffers are read in place.
+     */
+    public byte[] mac(ByteBuffer input) {
+        int position = input.position();
+        int length = input.remaining();
+        byte[] result;
+        long address = input.isDirect() ? NativeCrypto.getDirectBufferAddress(input) : 0;
+        if (address != 0) {
+            if (hmacKey != null) {
+                result = NativeCrypto.HMAC_oneshotDirect(hmacKey, address + position, length);
+            } else {
+                result = NativeCrypto.CMAC_oneshotDirect(cmacKey, address + position, length);
+            }
+        } else if (input.hasArray()) {
+            result = mac(input.array(), input.arrayOffset() + position, length);
+        } else {
+            byte[] copy = new byte[length];
+            input.duplicate().get(copy);
+            result = mac(copy);
+        }
+        input.position(position + length);
+        return result;
+    }
+}
@@ -38,6 +38,7 @@ public class ScryptSecretKeyFactory extends SecretKeyFactorySpi {
         char[] password;
         byte[] salt;
         int n, r, p, keyOutputBits;
+        int maxThreads = 0;
 
         if (inKeySpec instanceof ScryptKeySpec) {
             ScryptKeySpec spec = (ScryptKeySpec) inKeySpec;
@@ -47,6 +48,7 @@ public class ScryptSecretKeyFactory extends SecretKeyFactorySpi {
             r = spec.getBlockSize();
             p = spec.getParallelizationParameter();
             keyOutputBits = spec.getKeyLength();
+            maxThreads = spec.getMaxThreads();
         } else {
             // Extract parameters from any `KeySpec` that has getters with the correct name. This
             // allows, for example, code to use BouncyCastle's KeySpec with the Conscrypt provider.
@@ -67,8 +69,13 @@ public class ScryptSecretKeyFactory extends SecretKeyFactorySpi {
         }
 
         try {
+            byte[] passwordBytes = new String(password).getBytes("UTF-8");
+            if (maxThreads > 0) {
+                return new ScryptKey(NativeCrypto.Scrypt_generate_key(
+                        passwordBytes, salt, n, r, p, keyOutputBits / 8, maxThreads));
+            }
             return new ScryptKey(NativeCrypto.Scrypt_generate_key(
-                    new String(password).getBytes("UTF-8"), salt, n, r, p, keyOutputBits / 8));
+                    passwordBytes, salt, n, r, p, keyOutputBits / 8));
         } catch (UnsupportedEncodingException e) {
                 // Impossible according to the Java docs: UTF-8 is always supported.
                 throw new IllegalStateException(e);
@@ -0,0 +1,270 @@
+/* GENERATED SOURCE. DO NOT MODIFY. */
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package com.android.org.conscrypt;
+
+import java.io.FileDescriptor;
+import java.io.IOException;
+import java.io.InterruptedIOException;
+import java.net.SocketTimeoutException;
+import java.util.Map;
+import java.util.concurrent.ConcurrentHashMap;
+import java.util.concurrent.TimeUnit;
+import java.util.concurrent.atomic.AtomicLong;
+import java.util.logging.Level;
+import java.util.logging.Logger;
+
+/**
+ * Readiness loop shared by the file descriptor sockets that opted into it with {@link
+ * Conscrypt#setSharedPollerEnabled}. Such sockets run the handshake, reads and writes with the
+ * non-blocking natives, and when the socket isn't ready they park on their {@link Registration}
+ * instead of in a {@code poll()} of their own. A small pool of daemon threads waits on one
+ * epoll instance for all of them and wakes the parked callers.
+ */
+final class SharedSslPoller {
+    private static final Logger logger = Logger.getLogger(SharedSslPoller.class.getName());
+
+    private static final int POLLER_THREADS = 2;
+    private static final int MAX_EVENTS = 64;
+
+    private static final Object defaultLock = new Object();
+    // @GuardedBy("defaultLock")
+    private static SharedSslPoller defaultPoller;
+
+    private final long poller;
+    private final Map<Long, Registration> registrations = new ConcurrentHashMap<>();
+    private final AtomicLong nextToken = new AtomicLong();
+    private volatile IOException failure;
+
+    /**
+     * Returns the process-wide poller, starting it on first use.
+     *
+     * @throws UnsupportedOperationException if the platform has no epoll
+     */
+    static SharedSslPoller getDefault() throws IOException {
+        synchronized (defaultLock) {
+            if (defaultPoller == null) {
+                defaultPoller = new SharedSslPoller(POLLER_THREADS);
+            }
+            return defaultPoller;
+        }
+    }
+
+    private SharedSslPoller(int threads) throws IOException {
+        poller = NativeCrypto.SSL_poller_new();
+        for (int i = 0; i < threads; i++) {
+            Thread thread = new Thread(new Runnable() {
+                @Override
+                public void run() {
+                    runLoop();
+                }
+            }, "ConscryptSslPoller-" + i);
+            thread.setDaemon(true);
+            thread.start();
+        }
+    }
+
+    /**
+     * Starts tracking {@code fd}. The returned registration must be closed before the
+     * descriptor is.
+     */
+    Registration register(FileDescriptor fd) throws IOException {
+        IOException failure = this.failure;
+        if (failure != null) {
+            throw new IOException("SSL poller failed", failure);
+        }
+        Registration registration = new Registration(fd, nextToken.incrementAndGet());
+        registrations.put(registration.token, registration);
+        return registration;
+    }
+
+    private void runLoop() {
+        long[] tokens = new long[MAX_EVENTS];
+        int[] events = new int[MAX_EVENTS];
+        while (true) {
+            int count;
+            try {
+                count = NativeCrypto.SSL_poller_wait(poller, tokens, events, -1);
+            } catch (IOException e) {
+                // epoll_wait only fails on a broken poller, so fail every connection using it
+                // rather than spin.
+                logger.log(Level.SEVERE, "SSL poller failed", e);
+                failure = e;
+                for (Registration registration : registrations.values()) {
+                    registration.fail();
+                }
+                NativeCrypto.SSL_poller_wakeup(poller);
+                return;
+            }
+            for (int i = 0; i < count; i++) {
+                Registration registration = registrations.get(tokens[i]);
+                if (registration != null) {
+                    registration.onReady(events[i]);
+                }
+            }
+        }
+    }
+
+    /**
+     * A socket tracked by the poller. Registrations are one-shot, so a reader and a writer
+     * waiting at the same time share a single arming for the union of their interests, and
+     * whichever direction didn't fire is armed again.
+     */
+    final class Registration {
+        private final FileDescriptor fd;
+        private final long token;
+
+        // @GuardedBy("this")
+        private int readWaiters;
+        // @GuardedBy("this")
+        private int writeWaiters;
+        // Bumped every time the direction is reported ready, so waiters can tell they were
+        // woken.
+        // @GuardedBy("this")
+        private long readGeneration;
+        // @GuardedBy("this")
+        private long writeGeneration;
+        // @GuardedBy("this")
+        private int armedInterest;
+        // @GuardedBy("this")
+        private boolean closed;
+
+        private Registration(FileDescriptor fd, long token) {
+            this.fd = fd;
+            this.token = token;
+        }
+
+        /**
+         * Waits until the socket is ready for {@code interest}, one of {@link
+         * NativeCrypto#SSL_POLLER_READ} and {@link NativeCrypto#SSL_POLLER_WRITE}. Returns
+         * false if the registration was closed meanwhile.
+         *
+         * @param timeoutMillis how long to wait, 0 meaning forever
+         * @param timeoutMessage the message of the {@link SocketTimeoutException} thrown when
+         *        the time is up
+         */
+        synchronized boolean await(int interest, int timeoutMillis, String timeoutMessage)
+                throws IOException {
+            boolean read = interest == NativeCrypto.SSL_POLLER_READ;
+            long generation = read ? readGeneration : writeGeneration;
+            if (read) {
+                readWaiters++;
+            } else {
+                writeWaiters++;
+            }
+            try {
+                checkFailure();
+                if (closed) {
+                    return false;
+                }
+                arm(interest);
+                long deadline = System.nanoTime() + TimeUnit.MILLISECONDS.toNanos(timeoutMillis);
+                while (!closed && generation == (read ? readGeneration : writeGeneration)) {
+                    checkFailure();
+                    if (timeoutMillis <= 0) {
+                        wait();
+                        continue;
+                    }
+                    long remainingNanos = deadline - System.nanoTime();
+                    if (remainingNanos <= 0) {
+                        throw new SocketTimeoutException(timeoutMessage);
+                    }
+                    TimeUnit.NANOSECONDS.timedWait(this, remainingNanos);
+                }
+                return !closed;
+            } catch (InterruptedException e) {
+                Thread.currentThread().interrupt();
+                throw new InterruptedIOException("Interrupted waiting for the socket");
+            } finally {
+                if (read) {
+                    readWaiters--;
+                } else {
+                    writeWaiters--;
+                }
+            }
+        }
+
+        /**
+         * Stops tracking the socket and makes pending and future {@link #await} calls return
+         * false.
+         */
+        void close() {
+            synchronized (this) {
+                if (closed) {
+                    return;
+                }
+                closed = true;
+                notifyAll();
+            }
+            registrations.remove(token);
+            try {
+                NativeCrypto.SSL_poller_remove(poller, fd);
+            } catch (IOException ignored) {
+                // Never armed, or already closed, which removed it from the epoll set.
+            }
+        }
+
+        private synchronized void onReady(int events) {
+            armedInterest = 0;
+            if ((events & NativeCrypto.SSL_POLLER_READ) != 0) {
+                readGeneration++;
+            }
+            if ((events & NativeCrypto.SSL_POLLER_WRITE) != 0) {
+                writeGeneration++;
+            }
+            notifyAll();
+
+            int remaining = 0;
+            if (readWaiters > 0 && (events & NativeCrypto.SSL_POLLER_READ) == 0) {
+                remaining |= NativeCrypto.SSL_POLLER_READ;
+            }
+            if (writeWaiters > 0 && (events & NativeCrypto.SSL_POLLER_WRITE) == 0) {
+                remaining |= NativeCrypto.SSL_POLLER_WRITE;
+            }
+            if (remaining != 0 && !closed) {
+                try {
+                    arm(remaining);
+                } catch (IOException e) {
+                    // Wake everyone so the next SSL call reports the problem.
+                    readGeneration++;
+                    writeGeneration++;
+                }
+            }
+        }
+
+        private synchronized void fail() {
+            notifyAll();
+        }
+
+        // @GuardedBy("this")
+        private void arm(int interest) throws IOException {
+            int wanted = armedInterest | interest;
+            if (wanted == armedInterest) {
+                return;
+            }
+            NativeCrypto.SSL_poller_arm(poller, fd, token, wanted);
+            armedInterest = wanted;
+        }
+
+        private void checkFailure() throws IOException {
+            IOException failure = SharedSslPoller.this.failure;
+            if (failure != null) {
+                throw new IOException("SSL poller failed", failure);
+            }
+        }
+    }
+}
@@ -0,0 +1,118 @@
+/* GENERATED SOURCE. DO NOT MODIFY. */
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package com.android.org.conscrypt;
+
+import java.io.ByteArrayOutputStream;
+import java.io.DataOutputStream;
+import java.io.IOException;
+import java.util.Map;
+import java.util.WeakHashMap;
+import javax.net.ssl.X509TrustManager;
+
+/**
+ * Opt-in cache of peer certificate chains that a trust manager has already accepted. When
+ * enabled, the native handshake code skips {@code verifyCertificateChain} for a chain it has
+ * seen accepted before with the same identity.
+ *
+ * <p>The identity of a connection covers the trust manager instance, the connection mode, the
+ * endpoint identification algorithm and the peer host. Connections that verify data which is
+ * not part of the chain, such as Certificate Transparency, never use the cache.
+ */
+final class VerifiedChainCache {
+    private static volatile boolean enabled;
+
+    // Each trust manager gets a token that is part of its identity. Invalidating a trust manager
+    // assigns a new token, so its old entries can no longer be hit and simply age out.
+    private static final Map<X509TrustManager, Long> tokens =
+            new WeakHashMap<X509TrustManager, Long>();
+    private static long nextToken = 1;
+
+    private VerifiedChainCache() {}
+
+    /**
+     * Enables the cache with at most {@code maxEntries} entries that each stay valid for
+     * {@code ttlMillis} milliseconds. Passing 0 for either value disables and empties it.
+     */
+    static void setParameters(int maxEntries, long ttlMillis) {
+        if (maxEntries < 0 || ttlMillis < 0) {
+            throw new IllegalArgumentException("maxEntries < 0 || ttlMillis < 0");
+        }
+        NativeCrypto.setVerifiedChainCacheParameters(maxEntries, ttlMillis);
+        enabled = maxEntries > 0 && ttlMillis > 0;
+    }
+
+    /**
+     * Forgets every chain accepted by {@code trustManager}, or all chains if it is {@code null}.
+     */
+    static void invalidate(X509TrustManager trustManager) {
+        if (trustManager == null) {
+            NativeCrypto.clearVerifiedChainCache();
+            return;
+        }
+        synchronized (tokens) {
+            if (tokens.containsKey(trustManager)) {
+                tokens.put(trustManager, nextToken++);
+            }
+        }
+    }
+
+    /**
+     * Returns the identity to attach to a connection, or {@code null} if the connection must
+     * always call up into Java to verify its peer.
+     */
+    static byte[] identityFor(SSLParametersImpl parameters, boolean client, String hostname) {
+        if (!enabled) {
+            return null;
+        }
+        X509TrustManager trustManager = parameters.getX509TrustManager();
+        if (trustManager == null || (client && parameters.isCTVerificationEnabled(hostname))) {
+            return null;
+        }
+
+        long token;
+        synchronized (tokens) {
+            Long existing = tokens.get(trustManager);
+            if (existing == null) {
+                existing = nextToken++;
+                tokens.put(trustManager, existing);
+            }
+            token = existing;
+        }
+
+        ByteArrayOutputStream bytes = new ByteArrayOutputStream();
+        DataOutputStream out = new DataOutputStream(bytes);
+        try {
+            out.writeLong(token);
+            out.writeBoolean(client);
+            writeOptionalString(out, parameters.getEndpointIdentificationAlgorithm());
+            writeOptionalString(out, hostname);
+        } catch (IOException e) {
+            // ByteArrayOutputStream does not throw.
+            throw new AssertionError(e);
+        }
+        return bytes.toByteArray();
+    }
+
+    private static void writeOptionalString(DataOutputStream out, String value)
+            throws IOException {
+        out.writeBoolean(value != null);
+        if (value != null) {
+            out.writeUTF(value);
+        }
+    }
+}
@@ -147,6 +147,24 @@ public class BufferUtilsTest {
         return bytes;
     }
 
+    @Test
+    public void consume_range() {
+        ByteBuffer[] buffers = bufferType.newRandomBuffers(100, 200, 300, 400);
+
+        BufferUtils.consume(buffers, 1, 3, 250);
+        assertEquals(100, buffers[0].remaining());
+        assertEquals(0, buffers[1].remaining());
+        assertEquals(250, buffers[2].remaining());
+        assertEquals(400, buffers[3].remaining());
+
+        try {
+            BufferUtils.consume(buffers, 1, 3, 251);
+            fail("Managed to consume past end of buffer range");
+        } catch (IllegalArgumentException e) {
+            // Expected
+        }
+    }
+
     @Test
     public void getBufferLargerThan_allSmall() {
         ByteBuffer[] buffers = bufferType.newRandomBuffers(100, 200, 300, 400);
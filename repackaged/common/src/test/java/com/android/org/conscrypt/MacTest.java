@@ -36,10 +36,14 @@ import java.security.KeyPairGenerator;
 import java.security.NoSuchAlgorithmException;
 import java.security.Provider;
 import java.security.spec.AlgorithmParameterSpec;
+import java.util.ArrayList;
 import java.util.HashSet;
 import java.util.List;
 import java.util.Random;
 import java.util.Set;
+import java.util.concurrent.ExecutorService;
+import java.util.concurrent.Executors;
+import java.util.concurrent.Future;
 import javax.crypto.Mac;
 import javax.crypto.spec.IvParameterSpec;
 import javax.crypto.spec.SecretKeySpec;
@@ -213,6 +217,93 @@ public class MacTest {
         assertThrows(InvalidKeyException.class, () -> mac.init(key));
     }
 
+    @Test
+    public void preparedKeyKnownAnswerTest() throws Exception {
+        for (String[] entry : testVectors) {
+            String algorithm = entry[ALGORITHM_INDEX];
+            byte[] keyBytes = decodeHex(entry[KEY_INDEX]);
+            byte[] msgBytes = decodeHex(entry[MESSAGE_INDEX]);
+            byte[] expectedBytes = decodeHex(entry[MAC_INDEX]);
+            String failMsg = String.format("Mac=%s\nKey=%s\nMsg=%s", algorithm,
+                    entry[KEY_INDEX], entry[MESSAGE_INDEX]);
+
+            PreparedMacKey key = PreparedMacKey.create(algorithm, keyBytes);
+            assertEquals(failMsg, expectedBytes.length, key.getMacLength());
+            assertArrayEquals(failMsg, expectedBytes, key.mac(msgBytes));
+            // The prepared state must not be consumed by a previous call.
+            assertArrayEquals(failMsg, expectedBytes, key.mac(msgBytes));
+
+            byte[] padded = new byte[msgBytes.length + 3];
+            System.arraycopy(msgBytes, 0, padded, 2, msgBytes.length);
+            assertArrayEquals(failMsg, expectedBytes, key.mac(padded, 2, msgBytes.length));
+
+            ByteBuffer heapBuffer = ByteBuffer.wrap(padded, 2, msgBytes.length).slice();
+            assertArrayEquals(failMsg, expectedBytes, key.mac(heapBuffer));
+            assertEquals(failMsg, heapBuffer.limit(), heapBuffer.position());
+
+            ByteBuffer directBuffer = ByteBuffer.allocateDirect(msgBytes.length);
+            directBuffer.put(msgBytes);
+            directBuffer.flip();
+            assertArrayEquals(failMsg, expectedBytes, key.mac(directBuffer));
+            assertEquals(failMsg, directBuffer.limit(), directBuffer.position());
+
+            ByteBuffer readOnlyBuffer = ByteBuffer.wrap(msgBytes).asReadOnlyBuffer();
+            assertArrayEquals(failMsg, expectedBytes, key.mac(readOnlyBuffer));
+        }
+    }
+
+    @Test
+    public void preparedKeyConcurrentUse() throws Exception {
+        byte[] keyBytes = new byte[32];
+        random.nextBytes(keyBytes);
+        for (final String algorithm : new String[] {"HmacSHA256", "AESCMAC"}) {
+            Mac mac = Mac.getInstance(algorithm, conscryptProvider);
+            mac.init(new SecretKeySpec(keyBytes, "RawBytes"));
+            final byte[][] messages = new byte[64][];
+            final byte[][] expected = new byte[messages.length][];
+            for (int i = 0; i < messages.length; i++) {
+                messages[i] = new byte[i * 7];
+                random.nextBytes(messages[i]);
+                expected[i] = mac.doFinal(messages[i]);
+            }
+
+            final PreparedMacKey key = PreparedMacKey.create(algorithm, keyBytes);
+            ExecutorService executor = Executors.newFixedThreadPool(4);
+            try {
+                List<Future<Void>> futures = new ArrayList<>();
+                for (int t = 0; t < 4; t++) {
+                    futures.add(executor.submit(() -> {
+                        for (int round = 0; round < 50; round++) {
+                            for (int i = 0; i < messages.length; i++) {
+                                assertArrayEquals(algorithm, expected[i], key.mac(messages[i]));
+                            }
+                        }
+                        return null;
+                    }));
+                }
+                for (Future<Void> future : futures) {
+                    future.get();
+                }
+            } finally {
+                executor.shutdown();
+            }
+        }
+    }
+
+    @Test
+    public void preparedKeyInvalidArguments() throws Exception {
+        assertThrows(InvalidKeyException.class, () -> PreparedMacKey.create("AESCMAC", new byte[1]));
+        assertThrows(NoSuchAlgorithmException.class,
+                () -> PreparedMacKey.create("HmacSHA3-256", new byte[16]));
+        assertThrows(NoSuchAlgorithmException.class,
+                () -> PreparedMacKey.create("Poly1305", new byte[32]));
+
+        PreparedMacKey key = PreparedMacKey.create("HmacSHA256", new byte[16]);
+        assertEquals("HmacSHA256", key.getAlgorithm());
+        assertThrows(ArrayIndexOutOfBoundsException.class, () -> key.mac(new byte[4], 2, 3));
+        assertThrows(NullPointerException.class, () -> key.mac((byte[]) null, 0, 0));
+    }
+
     @Test
     public void uninitializedMacThrows() {
         newMacServiceTester().run(new ServiceTester.Test() {
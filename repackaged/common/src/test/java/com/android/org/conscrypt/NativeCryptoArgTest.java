@@ -127,7 +127,7 @@ public class NativeCryptoArgTest {
                 .hasArg(0, long.class)
                 .hasArg(1, conscryptClass("NativeSsl"))
                 .except(nonThrowingMethods)
-                .expectSize(60)
+                .expectSize(76)
                 .build();
 
         testMethods(filter, NullPointerException.class);
@@ -138,7 +138,7 @@ public class NativeCryptoArgTest {
                 .hasPrefix("SSL_")
                 .hasArgLength(1)
                 .hasArg(0, long.class)
-                .expectSize(10)
+                .expectSize(12)
                 .build();
 
         testMethods(filter, NullPointerException.class);
@@ -161,7 +161,8 @@ public class NativeCryptoArgTest {
                 "EVP_MD_CTX_destroy",
                 "EVP_PKEY_CTX_free",
                 "EVP_PKEY_free",
-                "EVP_CIPHER_CTX_free"
+                "EVP_CIPHER_CTX_free",
+                "EVP_AEAD_CTX_free"
         };
 
         // All of the non-void EVP_ methods apart from the above should throw on a null
@@ -171,7 +172,7 @@ public class NativeCryptoArgTest {
                 .takesArguments()
                 .except(illegalArgMethods)
                 .except(nonThrowingMethods)
-                .expectSize(45)
+                .expectSize(54)
                 .build();
 
         testMethods(filter, NullPointerException.class);
@@ -192,7 +193,7 @@ public class NativeCryptoArgTest {
                 .hasArg(0, long.class)
                 .hasArg(1, conscryptClass("OpenSSLX509Certificate"),
                         conscryptClass("OpenSSLX509CRL"))
-                .expectSize(32)
+                .expectSize(33)
                 .build();
         // TODO(prb): test null second argument
         testMethods(filter, NullPointerException.class);
@@ -4671,6 +4671,64 @@ public final class CipherTest {
         assertEquals(Arrays.toString(c1.doFinal()), Arrays.toString(c2.doFinal()));
     }
 
+    /*
+     * Check that streaming through direct buffers, in place or not and with chunks that don't
+     * line up with the block size, matches the byte[] result.
+     */
+    @Test
+    public void test_directBuffers_matchArrays() throws Exception {
+        String[] transformations = { "AES/CTR/NoPadding", "AES/CBC/PKCS5Padding",
+                "AES/ECB/NoPadding", "ChaCha20" };
+        byte[] message = new byte[1024];
+        new SecureRandom().nextBytes(message);
+        for (String transformation : transformations) {
+            boolean chacha = transformation.equals("ChaCha20");
+            SecretKeySpec key = new SecretKeySpec(new byte[32], chacha ? "ChaCha20" : "AES");
+            IvParameterSpec iv = transformation.contains("/ECB/")
+                    ? null : new IvParameterSpec(new byte[chacha ? 12 : 16]);
+            Cipher cipher = Cipher.getInstance(transformation, TestUtils.getConscryptProvider());
+            cipher.init(Cipher.ENCRYPT_MODE, key, iv);
+            byte[] expected = cipher.doFinal(message);
+
+            for (boolean inPlace : new boolean[] { false, true }) {
+                String name = transformation + (inPlace ? " in place" : "");
+                ByteBuffer buffer = ByteBuffer.allocateDirect(expected.length + 64);
+                buffer.put(message).flip();
+                ByteBuffer output =
+                        inPlace ? buffer.duplicate() : ByteBuffer.allocateDirect(expected.length);
+                output.clear();
+
+                cipher.init(Cipher.ENCRYPT_MODE, key, iv);
+                int written = 0;
+                // Chunk sizes that leave partial blocks behind for both AES and ChaCha20.
+                for (int chunk : new int[] { 7, 100, 33, 64, 1 }) {
+                    ByteBuffer input = buffer.duplicate();
+                    input.limit(input.position() + chunk);
+                    written += cipher.update(input, output);
+                    buffer.position(input.position());
+                }
+                written += cipher.doFinal(buffer, output);
+                assertEquals(name, expected.length, written);
+
+                byte[] actual = new byte[written];
+                output.flip();
+                output.get(actual);
+                assertArrayEquals(name, expected, actual);
+
+                cipher.init(Cipher.DECRYPT_MODE, key, iv);
+                output.flip();
+                ByteBuffer decrypted = inPlace ? output.duplicate() : ByteBuffer.allocateDirect(
+                        cipher.getOutputSize(written));
+                decrypted.clear();
+                int decryptedLength = cipher.doFinal(output, decrypted);
+                byte[] roundTrip = new byte[decryptedLength];
+                decrypted.flip();
+                decrypted.get(roundTrip);
+                assertArrayEquals(name, message, roundTrip);
+            }
+        }
+    }
+
     private static Cipher createAesCipher(int opmode) {
         try {
             final Cipher c = Cipher.getInstance("AES/ECB/NoPadding");
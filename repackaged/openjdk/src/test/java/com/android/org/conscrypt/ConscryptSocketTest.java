@@ -48,6 +48,8 @@ import java.net.InetAddress;
 import java.net.InetSocketAddress;
 import java.net.ServerSocket;
 import java.net.Socket;
+import java.net.SocketException;
+import java.net.SocketTimeoutException;
 import java.nio.channels.ServerSocketChannel;
 import java.nio.channels.SocketChannel;
 import java.security.KeyManagementException;
@@ -55,6 +57,9 @@ import java.security.KeyStore;
 import java.security.PrivateKey;
 import java.security.cert.CertificateException;
 import java.security.cert.X509Certificate;
+import java.util.Collection;
+import java.util.Collections;
+import java.util.Map;
 import java.util.Random;
 import java.util.concurrent.Callable;
 import java.util.concurrent.ExecutionException;
@@ -67,6 +72,8 @@ import javax.net.ssl.HandshakeCompletedEvent;
 import javax.net.ssl.HandshakeCompletedListener;
 import javax.net.ssl.KeyManager;
 import javax.net.ssl.KeyManagerFactory;
+import javax.net.ssl.SNIHostName;
+import javax.net.ssl.SNIMatcher;
 import javax.net.ssl.SSLHandshakeException;
 import javax.net.ssl.SSLSession;
 import javax.net.ssl.SSLSocket;
@@ -298,6 +305,8 @@ public class ConscryptSocketTest {
         KeyManager[] keyManagers;
         TrustManager[] trustManagers;
         String[] alpnProtocols;
+        boolean kernelTls;
+        boolean sharedPoller;
 
         abstract AbstractConscryptSocket createSocket(ServerSocket listener) throws IOException;
 
@@ -343,6 +352,8 @@ public class ConscryptSocketTest {
             AbstractConscryptSocket socket =
                     socketType.newClientSocket(createContext(), listener, underlyingSocketType);
             socket.setHostname(hostname);
+            Conscrypt.setKernelTlsEnabled(socket, kernelTls);
+            Conscrypt.setSharedPollerEnabled(socket, sharedPoller);
             // getApplicationProtocol should initially return null and not trigger handshake:
             // b/146235331
             assertNull(Conscrypt.getApplicationProtocol(socket));
@@ -357,6 +368,8 @@ public class ConscryptSocketTest {
         byte[] sctTLSExtension;
         byte[] ocspResponse;
         ApplicationProtocolSelector alpnProtocolSelector;
+        Map<String, ServerCredential> credentials;
+        Collection<SNIMatcher> sniMatchers;
 
         @Override
         public OpenSSLContextImpl createContext() throws IOException {
@@ -365,6 +378,11 @@ public class ConscryptSocketTest {
                 SSLParametersImpl sslParameters = getContextSSLParameters(context);
                 sslParameters.setSCTExtension(sctTLSExtension);
                 sslParameters.setOCSPResponse(ocspResponse);
+                sslParameters.setSNIMatchers(sniMatchers);
+                if (credentials != null) {
+                    ((ServerSessionContext) context.engineGetServerSessionContext())
+                            .setServerCredentials(credentials);
+                }
                 return context;
             } catch (IllegalAccessException e) {
                 throw new IOException(e);
@@ -375,6 +393,8 @@ public class ConscryptSocketTest {
         AbstractConscryptSocket createSocket(ServerSocket listener) throws IOException {
             AbstractConscryptSocket socket =
                     socketType.newServerSocket(createContext(), listener, underlyingSocketType);
+            Conscrypt.setKernelTlsEnabled(socket, kernelTls);
+            Conscrypt.setSharedPollerEnabled(socket, sharedPoller);
             if (alpnProtocols != null) {
                 Conscrypt.setApplicationProtocols(socket, alpnProtocols);
             }
@@ -757,6 +777,158 @@ public class ConscryptSocketTest {
         }
     }
 
+    @Test
+    public void dataFlowsWithKernelTls() throws Exception {
+        final TestConnection connection =
+                new TestConnection(new X509Certificate[] {cert, ca}, certKey);
+        connection.clientHooks.kernelTls = true;
+        connection.serverHooks.kernelTls = true;
+        connection.doHandshakeSuccess();
+        assertTrue(connection.clientHooks.isHandshakeCompleted);
+        assertTrue(connection.serverHooks.isHandshakeCompleted);
+
+        // Offload depends on the kernel, so either path must carry the data.
+        if (Conscrypt.isKernelTlsActive(connection.client)) {
+            assertEquals(SocketType.FILE_DESCRIPTOR, socketType);
+        }
+        for (int i = 0; i < 20; i++) {
+            sendData(connection.client, connection.server, randomBuffer());
+            sendData(connection.server, connection.client, randomBuffer());
+        }
+
+        connection.client.close();
+        assertEquals(-1, connection.server.getInputStream().read());
+    }
+
+    @Test
+    public void dataFlowsWithSharedPoller() throws Exception {
+        assumeTrue(TestUtils.isLinux());
+        final TestConnection connection =
+                new TestConnection(new X509Certificate[] {cert, ca}, certKey);
+        connection.clientHooks.sharedPoller = true;
+        connection.serverHooks.sharedPoller = true;
+        connection.doHandshakeSuccess();
+        assertTrue(connection.clientHooks.isHandshakeCompleted);
+        assertTrue(connection.serverHooks.isHandshakeCompleted);
+
+        // Large buffers need several writes, each waiting for the reader to drain the socket.
+        for (int i = 0; i < 20; i++) {
+            sendData(connection.client, connection.server, randomBuffer());
+            sendData(connection.server, connection.client, randomBuffer());
+        }
+        byte[] large = new byte[1024 * 1024];
+        random.nextBytes(large);
+        Future<byte[]> received = executor.submit(() -> {
+            byte[] buffer = new byte[large.length];
+            int offset = 0;
+            while (offset < buffer.length) {
+                int read = connection.server.getInputStream().read(
+                        buffer, offset, buffer.length - offset);
+                assertTrue(read > 0);
+                offset += read;
+            }
+            return buffer;
+        });
+        connection.client.getOutputStream().write(large);
+        assertArrayEquals(large, received.get(TIMEOUT_SECONDS, TimeUnit.SECONDS));
+
+        connection.client.close();
+        assertEquals(-1, connection.server.getInputStream().read());
+    }
+
+    @Test
+    public void sharedPollerReadTimesOutAndCloseWakesReader() throws Exception {
+        assumeTrue(TestUtils.isLinux());
+        // Engine sockets ignore the setting.
+        assumeTrue(socketType == SocketType.FILE_DESCRIPTOR);
+        final TestConnection connection =
+                new TestConnection(new X509Certificate[] {cert, ca}, certKey);
+        connection.clientHooks.sharedPoller = true;
+        connection.serverHooks.sharedPoller = true;
+        connection.doHandshakeSuccess();
+
+        connection.server.setSoTimeout(100);
+        try {
+            connection.server.getInputStream().read();
+            fail();
+        } catch (SocketTimeoutException expected) {
+            // Expected.
+        }
+
+        connection.server.setSoTimeout(0);
+        Future<Integer> read = executor.submit(() -> connection.server.getInputStream().read());
+        Thread.sleep(100);
+        connection.server.close();
+        try {
+            read.get(TIMEOUT_SECONDS, TimeUnit.SECONDS);
+            fail();
+        } catch (ExecutionException expected) {
+            assertTrue(expected.getCause() instanceof SocketException);
+        }
+    }
+
+    @Test
+    public void handshakeUsesMappedCredentialWithoutKeyManager() throws Exception {
+        X509Certificate[] chain = new X509Certificate[] {cert, ca};
+        TestConnection connection = new TestConnection(chain, certKey);
+        connection.serverHooks.keyManagers = null;
+        connection.serverHooks.credentials = Collections.singletonMap(
+                "example.com", ServerCredential.create(chain, certKey, null, null));
+        connection.doHandshakeSuccess();
+
+        assertTrue(connection.clientHooks.isHandshakeCompleted);
+        assertTrue(connection.serverHooks.isHandshakeCompleted);
+        assertArrayEquals(chain, connection.server.getSession().getLocalCertificates());
+        assertArrayEquals(chain, connection.client.getSession().getPeerCertificates());
+    }
+
+    @Test
+    public void sniMatchersRejectMappedHostName() throws Exception {
+        X509Certificate[] chain = new X509Certificate[] {cert, ca};
+        TestConnection connection = new TestConnection(chain, certKey);
+        connection.serverHooks.credentials = Collections.singletonMap(
+                "example.com", ServerCredential.create(chain, certKey, null, null));
+        connection.serverHooks.sniMatchers =
+                Collections.singletonList(SNIHostName.createSNIMatcher("other\\.test"));
+        connection.doHandshake();
+
+        assertTrue(connection.serverException instanceof SSLHandshakeException);
+    }
+
+    @Test
+    public void handshakeUsesWildcardCredential() throws Exception {
+        X509Certificate[] chain = new X509Certificate[] {cert, ca};
+        TestConnection connection = new TestConnection(chain, certKey);
+        connection.clientHooks.hostname = "WWW.Example.com";
+        connection.serverHooks.keyManagers = null;
+        connection.serverHooks.credentials = Collections.singletonMap(
+                "*.example.com", ServerCredential.create(chain, certKey, null, null));
+        connection.doHandshakeSuccess();
+
+        assertArrayEquals(chain, connection.server.getSession().getLocalCertificates());
+    }
+
+    @Test
+    public void handshakeFallsBackToKeyManagerForUnmappedName() throws Exception {
+        X509Certificate[] chain = new X509Certificate[] {cert, ca};
+        TestConnection connection = new TestConnection(chain, certKey);
+        connection.clientHooks.hostname = "other.test";
+        connection.serverHooks.credentials = Collections.singletonMap(
+                "*.example.com", ServerCredential.create(chain, certKey, null, null));
+        connection.doHandshakeSuccess();
+
+        assertTrue(connection.serverHooks.isHandshakeCompleted);
+    }
+
+    @Test(expected = IllegalArgumentException.class)
+    public void setServerCredentialsRejectsMisplacedWildcard() throws Exception {
+        X509Certificate[] chain = new X509Certificate[] {cert, ca};
+        ServerSessionContext context = (ServerSessionContext) OpenSSLContextImpl.getPreferred()
+                .engineGetServerSessionContext();
+        context.setServerCredentials(Collections.singletonMap(
+                "www.*.example.com", ServerCredential.create(chain, certKey, null, null)));
+    }
+
     private void sendData(SSLSocket source, final SSLSocket destination, byte[] data)
             throws Exception {
         final byte[] received = new byte[data.length];